@@ -0,0 +1,605 @@
+#include <destoer.h>
+#include <albion/lib.h>
+#include <albion/emulator.h>
+#include <albion/scheduler.h>
+#include <frontend/audio_mixer.h>
+#include <cinttypes>
+
+#ifdef GB_ENABLED
+#include <gb/gb.h>
+#endif
+
+#ifdef GBA_ENABLED
+#include <gba/gba.h>
+#endif
+
+#ifdef N64_ENABLED
+#include <n64/n64.h>
+#endif
+
+// microbenchmarks, run with -b <roms...>
+// roms are used to capture real workloads that are then replayed
+
+using bench_clock = std::chrono::steady_clock;
+
+double bench_seconds(bench_clock::time_point start)
+{
+    return std::chrono::duration<double>(bench_clock::now() - start).count();
+}
+
+// replay a recorded event trace against an event list backend
+// returns ns per operation
+template<typename EVENT_LIST,typename event_type>
+double replay_event_trace(const std::vector<EventTraceEntry<event_type>> &trace, u32 passes)
+{
+    EVENT_LIST list;
+
+    // keep the peeks from being optimised out
+    volatile u64 sink = 0;
+    u64 acc = 0;
+
+    const auto start = bench_clock::now();
+
+    for(u32 p = 0; p < passes; p++)
+    {
+        list.clear();
+
+        for(const auto &entry : trace)
+        {
+            switch(entry.op)
+            {
+                case event_op::insert: list.insert(entry.node); break;
+                case event_op::remove: list.remove(entry.node.type); break;
+
+                // backends may break ties differently so the lists can drift slightly
+                case event_op::pop:
+                {
+                    if(list.size())
+                    {
+                        list.pop();
+                    }
+                    break;
+                }
+            }
+
+            // scheduler always reads the new min after an operation
+            acc += list.peek().end;
+        }
+    }
+
+    sink = acc;
+    UNUSED(sink);
+
+    return (bench_seconds(start) * 1e9) / (double(trace.size()) * passes);
+}
+
+// replay a trace once and count the pops that came out in a different order
+// to the ones the core actually serviced, events due on the same cycle can
+// be ordered differently by each backend
+template<typename EVENT_LIST,typename event_type>
+u32 count_pop_mismatch(const std::vector<EventTraceEntry<event_type>> &trace)
+{
+    EVENT_LIST list;
+    u32 mismatch = 0;
+
+    for(const auto &entry : trace)
+    {
+        switch(entry.op)
+        {
+            case event_op::insert: list.insert(entry.node); break;
+            case event_op::remove: list.remove(entry.node.type); break;
+
+            // pop what the core popped so one difference doesnt knock the rest out of step
+            case event_op::pop:
+            {
+                mismatch += !list.size() || list.peek().type != entry.node.type;
+                list.remove(entry.node.type);
+                break;
+            }
+        }
+    }
+
+    return mismatch;
+}
+
+template<size_t SIZE,typename event_type>
+void bench_event_trace(const char *name, const std::vector<EventTraceEntry<event_type>> &trace)
+{
+    if(!trace.size())
+    {
+        printf("%s: empty event trace\n",name);
+        return;
+    }
+
+    // aim for roughly 50M operations
+    const u32 passes = std::max<u32>(1,50'000'000 / trace.size());
+
+    const double heap = replay_event_trace<MinHeap<SIZE,event_type>>(trace,passes);
+    const double scan = replay_event_trace<MinScan<SIZE,event_type>>(trace,passes);
+
+    printf("%s scheduler: %zu ops x %d passes\n",name,trace.size(),passes);
+    printf("  MinHeap: %.2f ns/op\n",heap);
+    printf("  MinScan: %.2f ns/op (%.2fx)\n",scan,heap / scan);
+
+    const u32 pops = std::count_if(trace.begin(),trace.end(),[](const EventTraceEntry<event_type> &entry)
+    {
+        return entry.op == event_op::pop;
+    });
+
+    printf("  pop order differs from the core: MinHeap %u, MinScan %u of %u\n",
+        count_pop_mismatch<MinHeap<SIZE,event_type>>(trace),count_pop_mismatch<MinScan<SIZE,event_type>>(trace),pops);
+}
+
+// mix and resample a few seconds of square waves at the rate the gba apu feeds the mixer
+void bench_audio_mixer()
+{
+    constexpr u32 CHANNELS = 6;
+    constexpr u32 IN_RATE = 65536;
+    constexpr u32 SECONDS = 60;
+
+    auto mixer = std::make_unique<AudioMixer>();
+    mixer->init(CHANNELS,IN_RATE,44100);
+
+    for(u32 c = 0; c < CHANNELS; c++)
+    {
+        mixer->set_gain(c,0.1f,0.1f);
+    }
+
+    u64 frames = 0;
+    float sum = 0.0f;
+
+    const auto start = bench_clock::now();
+
+    for(u32 i = 0; i < IN_RATE * SECONDS; i++)
+    {
+        float values[CHANNELS];
+
+        for(u32 c = 0; c < CHANNELS; c++)
+        {
+            values[c] = ((i >> (c + 4)) & 1)? 1.0f : -1.0f;
+        }
+
+        if(mixer->push(values))
+        {
+            const u32 mixed = mixer->mix();
+            sum += mixer->left()[0] + mixer->right()[mixed - 1];
+            frames += mixed;
+        }
+    }
+
+    const double seconds = bench_seconds(start);
+
+    printf("audio mixer: %d channels, %" PRIu64 " frames out (checksum %f)\n",CHANNELS,frames,sum);
+    printf("  %.1f ns/input frame (%.0fx realtime)\n",(seconds * 1e9) / (IN_RATE * SECONDS),SECONDS / seconds);
+}
+
+#ifdef GB_ENABLED
+// render every line of the current frame with both scanline renderers
+// checks they match and reports lines per second for each
+void bench_gb_scanline(gameboy::GB &gb)
+{
+    auto &ppu = gb.ppu;
+    constexpr u32 PASSES = 200;
+
+    // rendering a line updates some ppu state, keep it the same for each renderer
+    const auto window_y_line = ppu.window_y_line;
+    const auto window_x_line = ppu.window_x_line;
+    const auto window_x_triggered = ppu.window_x_triggered;
+    const auto current_line = ppu.current_line;
+    const bool reference_renderer = ppu.reference_renderer;
+
+    const auto render_line = [&](u32 line, bool reference)
+    {
+        ppu.current_line = line;
+        ppu.window_x_line = window_x_line;
+        ppu.window_x_triggered = window_x_triggered;
+        ppu.read_sprites();
+        ppu.reference_renderer = reference;
+        ppu.render_scanline();
+    };
+
+    u32 mismatch = 0;
+    std::vector<u32> reference_line(gameboy::SCREEN_WIDTH);
+
+    for(u32 line = 0; line < gameboy::SCREEN_HEIGHT; line++)
+    {
+        const u32 offset = line * gameboy::SCREEN_WIDTH;
+
+        render_line(line,true);
+        std::copy(&ppu.screen[offset],&ppu.screen[offset + gameboy::SCREEN_WIDTH],reference_line.begin());
+
+        render_line(line,false);
+        mismatch += !std::equal(reference_line.begin(),reference_line.end(),&ppu.screen[offset]);
+    }
+
+    double lines_per_sec[2];
+
+    for(u32 reference = 0; reference < 2; reference++)
+    {
+        const auto start = bench_clock::now();
+
+        for(u32 p = 0; p < PASSES; p++)
+        {
+            for(u32 line = 0; line < gameboy::SCREEN_HEIGHT; line++)
+            {
+                render_line(line,reference);
+            }
+        }
+
+        lines_per_sec[reference] = (PASSES * gameboy::SCREEN_HEIGHT) / bench_seconds(start);
+    }
+
+    ppu.window_y_line = window_y_line;
+    ppu.window_x_line = window_x_line;
+    ppu.window_x_triggered = window_x_triggered;
+    ppu.current_line = current_line;
+    ppu.reference_renderer = reference_renderer;
+    ppu.read_sprites();
+
+    printf("  scanline: %d of %d lines differ from the reference\n",mismatch,gameboy::SCREEN_HEIGHT);
+    printf("    reference: %.0f lines/s\n",lines_per_sec[1]);
+    printf("    compositor: %.0f lines/s (%.2fx)\n",lines_per_sec[0],lines_per_sec[0] / lines_per_sec[1]);
+}
+
+void bench_gb(const std::string &rom)
+{
+    constexpr u32 FRAMES = 300;
+
+    auto gb = std::make_unique<gameboy::GB>();
+    gb->reset(rom);
+    gb->apu.playback.stop();
+    gb->throttle_emu = false;
+
+    printf("gb: %s\n",rom.c_str());
+
+    // plain throughput with nothing recording
+    const auto start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gb->run();
+    }
+
+    const double seconds = bench_seconds(start);
+    printf("  %d frames in %.3fs (%.1f fps)\n",FRAMES,seconds,FRAMES / seconds);
+
+    const u64 skipped = gb->cpu.idle_cycles_skipped;
+    const u64 total = gb->scheduler.get_timestamp();
+    printf("  idle loops skipped %" PRIu64 " of %" PRIu64 " cycles (%.1f%%)\n",skipped,total,total? (skipped * 100.0) / total : 0.0);
+
+    bench_gb_scanline(*gb);
+
+    // same again recording a rewind snapshot every frame
+    gb->reset(rom);
+    gb->apu.playback.stop();
+    gb->throttle_emu = false;
+    gb->enable_rewind(10);
+
+    const auto rewind_start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gb->run();
+    }
+
+    const double rewind_seconds = bench_seconds(rewind_start);
+
+    printf("  rewind: %.1f fps (%.1f%% overhead), %zu frames in %.1f KB\n",FRAMES / rewind_seconds,
+        ((rewind_seconds / seconds) - 1.0) * 100.0,gb->rewind.size(),gb->rewind.memory_usage() / 1024.0);
+
+    const auto restore_start = bench_clock::now();
+    u32 restored = 0;
+
+    while(gb->rewind_frame())
+    {
+        restored++;
+    }
+
+    const double restore_seconds = bench_seconds(restore_start);
+    printf("    restored %d frames at %.1f us each\n",restored,restored? (restore_seconds * 1000000.0) / restored : 0.0);
+
+    // zero seconds turns it back off
+    gb->enable_rewind(0);
+
+#ifdef SCHEDULER_TRACE
+    gb->reset(rom);
+    gb->apu.playback.stop();
+
+    std::vector<EventTraceEntry<gameboy::gameboy_event>> trace;
+    gb->scheduler.trace = &trace;
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gb->run();
+    }
+
+    gb->scheduler.trace = nullptr;
+
+    bench_event_trace<gameboy::EVENT_SIZE>("gb",trace);
+#else
+    puts("gb scheduler: build with SCHEDULER_TRACE to record an event trace");
+#endif
+}
+#endif
+
+#ifdef GBA_ENABLED
+// composite every line of the current frame with both merge_layers paths
+// each blend mode is forced in turn so all of them get checked
+void bench_gba_merge(gameboyadvance::GBA &gba)
+{
+    using namespace gameboyadvance;
+    constexpr u32 PASSES = 200;
+    constexpr u32 EFFECTS = 4;
+
+    auto renderer = std::make_unique<Renderer>();
+
+    std::vector<u32> scalar_line(SCREEN_WIDTH);
+    std::vector<u32> simd_line(SCREEN_WIDTH);
+
+    u32 mismatch = 0;
+    double seconds[2] = {0.0,0.0};
+
+    for(u32 effect = 0; effect < EFFECTS; effect++)
+    {
+        for(u32 line = 0; line < SCREEN_HEIGHT; line++)
+        {
+            auto state = gba.disp.latch_line();
+            state.ly = line;
+            state.disp_io.bld_cnt.special_effect = effect;
+
+            // fills out the layers for the line
+            renderer->render(state,simd_line.data());
+
+            auto start = bench_clock::now();
+
+            for(u32 p = 0; p < PASSES; p++)
+            {
+                renderer->line = scalar_line.data();
+                renderer->merge_layers_scalar(0,SCREEN_WIDTH);
+            }
+
+            seconds[0] += bench_seconds(start);
+            start = bench_clock::now();
+
+            for(u32 p = 0; p < PASSES; p++)
+            {
+                renderer->line = simd_line.data();
+                const u32 done = renderer->merge_layers_simd();
+                renderer->merge_layers_scalar(done,SCREEN_WIDTH);
+            }
+
+            seconds[1] += bench_seconds(start);
+
+            mismatch += scalar_line != simd_line;
+        }
+    }
+
+    const u32 lines = EFFECTS * SCREEN_HEIGHT;
+
+    printf("  merge_layers: %d of %d lines differ from scalar\n",mismatch,lines);
+    printf("    scalar: %.1f ns/line\n",(seconds[0] * 1e9) / (lines * PASSES));
+    printf("    simd: %.1f ns/line (%.2fx)\n",(seconds[1] * 1e9) / (lines * PASSES),seconds[0] / seconds[1]);
+}
+
+void bench_gba(const std::string &rom)
+{
+    constexpr u32 FRAMES = 300;
+
+    auto gba = std::make_unique<gameboyadvance::GBA>();
+    gba->reset(rom);
+    gba->apu.playback.stop();
+    gba->throttle_emu = false;
+
+    printf("gba: %s\n",rom.c_str());
+
+    // plain throughput with nothing recording
+    const auto start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gba->run();
+    }
+
+    const double seconds = bench_seconds(start);
+    printf("  %d frames in %.3fs (%.1f fps)\n",FRAMES,seconds,FRAMES / seconds);
+
+    bench_gba_merge(*gba);
+
+#ifdef GBA_JIT_SUPPORTED
+    gba->reset(rom);
+    gba->apu.playback.stop();
+    gba->cpu.jit.enabled = true;
+
+    const auto jit_start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gba->run();
+    }
+
+    const double jit_seconds = bench_seconds(jit_start);
+    printf("  jit: %d frames in %.3fs (%.1f fps)\n",FRAMES,jit_seconds,FRAMES / jit_seconds);
+
+    gba->cpu.jit.enabled = false;
+#endif
+
+    // swi calls done natively rather than through the bios
+    gba->reset(rom);
+    gba->apu.playback.stop();
+    gba->cpu.bios_hle = true;
+
+    const auto hle_start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gba->run();
+    }
+
+    const double hle_seconds = bench_seconds(hle_start);
+    printf("  bios hle: %d frames in %.3fs (%.1f fps)\n",FRAMES,hle_seconds,FRAMES / hle_seconds);
+
+    gba->cpu.bios_hle = false;
+
+    // polling loops skipped to the next event
+    gba->reset(rom);
+    gba->apu.playback.stop();
+    gba->cpu.idle_loop.enabled = true;
+
+    const auto idle_start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gba->run();
+    }
+
+    const double idle_seconds = bench_seconds(idle_start);
+    printf("  idle loop skip: %d frames in %.3fs (%.1f fps), %" PRIu64 " skips over %" PRIu64 " cycles\n",FRAMES,idle_seconds,FRAMES / idle_seconds,
+        gba->cpu.idle_loop.skips,gba->cpu.idle_loop.skipped_cycles);
+
+    gba->cpu.idle_loop.enabled = false;
+
+    // threaded renderer, timed on its own then checked frame by frame against the serial one
+    const u32 render_threads = std::max(1u,std::min(std::thread::hardware_concurrency() - 1,3u));
+
+    gba->reset(rom);
+    gba->apu.playback.stop();
+    gba->disp.set_render_threads(render_threads);
+
+    const auto render_start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gba->run();
+    }
+
+    const double render_seconds = bench_seconds(render_start);
+    printf("  %d render threads: %d frames in %.3fs (%.1f fps)\n",render_threads,FRAMES,render_seconds,FRAMES / render_seconds);
+
+    auto serial = std::make_unique<gameboyadvance::GBA>();
+    serial->reset(rom);
+    serial->apu.playback.stop();
+    serial->throttle_emu = false;
+
+    gba->reset(rom);
+    gba->apu.playback.stop();
+
+    u32 mismatch = 0;
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gba->run();
+        serial->run();
+
+        mismatch += gba->disp.screen != serial->disp.screen;
+    }
+
+    printf("  render threads: %d of %d frames differ from serial\n",mismatch,FRAMES);
+
+    gba->disp.set_render_threads(0);
+
+#ifdef SCHEDULER_TRACE
+    gba->reset(rom);
+    gba->apu.playback.stop();
+
+    std::vector<EventTraceEntry<gameboyadvance::gba_event>> trace;
+    gba->scheduler.trace = &trace;
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        gba->run();
+    }
+
+    gba->scheduler.trace = nullptr;
+
+    bench_event_trace<gameboyadvance::EVENT_SIZE>("gba",trace);
+#else
+    puts("gba scheduler: build with SCHEDULER_TRACE to record an event trace");
+#endif
+}
+#endif
+
+#ifdef N64_ENABLED
+void bench_n64(const std::string &rom)
+{
+    constexpr u32 FRAMES = 60;
+
+    auto n64 = std::make_unique<nintendo64::N64>();
+    nintendo64::reset(*n64,rom);
+
+    printf("n64: %s\n",rom.c_str());
+
+    const auto start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        nintendo64::run(*n64);
+    }
+
+    const double seconds = bench_seconds(start);
+
+    // the cpu is modeled at 1 CPI
+    const u64 instrs = n64->scheduler.get_timestamp();
+
+    printf("  %d frames in %.3fs (%.1f fps), %.1f MIPS\n",FRAMES,seconds,FRAMES / seconds,(instrs / seconds) / 1e6);
+
+#ifdef N64_JIT_SUPPORTED
+    nintendo64::reset(*n64,rom);
+    n64->cpu.jit.enabled = true;
+
+    const auto jit_start = bench_clock::now();
+
+    for(u32 i = 0; i < FRAMES; i++)
+    {
+        nintendo64::run(*n64);
+    }
+
+    const double jit_seconds = bench_seconds(jit_start);
+    const u64 jit_instrs = n64->scheduler.get_timestamp();
+
+    printf("  jit: %d frames in %.3fs (%.1f fps), %.1f MIPS\n",FRAMES,jit_seconds,FRAMES / jit_seconds,(jit_instrs / jit_seconds) / 1e6);
+#endif
+}
+#endif
+
+int run_benchmarks(int argc, char *argv[])
+{
+    if(argc == 0)
+    {
+        puts("usage: -b <roms...>");
+        return 1;
+    }
+
+    bench_audio_mixer();
+
+    for(int i = 0; i < argc; i++)
+    {
+        const std::string rom = argv[i];
+
+        try
+        {
+            switch(get_emulator_type(rom))
+            {
+            #ifdef GB_ENABLED
+                case emu_type::gameboy: bench_gb(rom); break;
+            #endif
+
+            #ifdef GBA_ENABLED
+                case emu_type::gba: bench_gba(rom); break;
+            #endif
+
+            #ifdef N64_ENABLED
+                case emu_type::n64: bench_n64(rom); break;
+            #endif
+
+                default: printf("%s: no benchmarks for this system\n",rom.c_str()); break;
+            }
+        }
+
+        catch(std::exception &ex)
+        {
+            printf("%s: aborted %s\n",rom.c_str(),ex.what());
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,295 @@
+#include <albion/snapshot.h>
+
+void ArenaBuf::begin_write(std::vector<u8> *arena)
+{
+    out = arena;
+    out->clear();
+    setp(nullptr,nullptr);
+}
+
+void ArenaBuf::begin_read(const std::vector<u8> &data)
+{
+    out = nullptr;
+
+    // streambuf wants non const pointers even for a get area
+    char *start = reinterpret_cast<char*>(const_cast<u8*>(data.data()));
+    setg(start,start,start + data.size());
+}
+
+std::streamsize ArenaBuf::xsputn(const char *s, std::streamsize n)
+{
+    if(!out)
+    {
+        return 0;
+    }
+
+    const size_t offset = out->size();
+    out->resize(offset + n);
+    memcpy(&(*out)[offset],s,n);
+
+    return n;
+}
+
+ArenaBuf::int_type ArenaBuf::overflow(int_type c)
+{
+    if(!out)
+    {
+        return traits_type::eof();
+    }
+
+    if(!traits_type::eq_int_type(c,traits_type::eof()))
+    {
+        out->push_back(traits_type::to_char_type(c));
+    }
+
+    return traits_type::not_eof(c);
+}
+
+
+Snapshot::Snapshot()
+{
+    // the streams never open a file, just hand them the arena buffer
+    static_cast<std::ostream&>(out).rdbuf(&buf);
+    static_cast<std::istream&>(in).rdbuf(&buf);
+}
+
+std::ofstream& Snapshot::begin_write()
+{
+    buf.begin_write(&arena);
+    out.clear();
+
+    return out;
+}
+
+std::ifstream& Snapshot::begin_read(const std::vector<u8> &data)
+{
+    buf.begin_read(data);
+    in.clear();
+
+    return in;
+}
+
+std::ifstream& Snapshot::begin_read()
+{
+    return begin_read(arena);
+}
+
+
+void Rewind::init(u32 frames, u32 key_interval)
+{
+    capacity = frames;
+    this->key_interval = std::max(1u,key_interval);
+    clear();
+}
+
+void Rewind::drop_group(Group &group)
+{
+    spare_key.push_back(std::move(group.key));
+
+    for(auto &delta : group.delta)
+    {
+        spare_delta.push_back(std::move(delta));
+    }
+}
+
+void Rewind::clear()
+{
+    for(auto &group : groups)
+    {
+        drop_group(group);
+    }
+
+    groups.clear();
+    len = 0;
+}
+
+std::vector<u8> Rewind::take_spare(std::vector<std::vector<u8>> &spare)
+{
+    if(spare.empty())
+    {
+        return {};
+    }
+
+    auto buf = std::move(spare.back());
+    spare.pop_back();
+
+    return buf;
+}
+
+size_t Rewind::memory_usage() const
+{
+    size_t usage = 0;
+
+    for(const auto &group : groups)
+    {
+        usage += group.key.capacity();
+
+        for(const auto &delta : group.delta)
+        {
+            usage += delta.capacity();
+        }
+    }
+
+    for(const auto &buf : spare_key)
+    {
+        usage += buf.capacity();
+    }
+
+    for(const auto &buf : spare_delta)
+    {
+        usage += buf.capacity();
+    }
+
+    return usage;
+}
+
+// delta is a list of runs
+// u32 bytes to copy from the key, u32 bytes that follow to copy from the delta
+void Rewind::encode_delta(std::vector<u8> &delta, const std::vector<u8> &key, const std::vector<u8> &state)
+{
+    delta.clear();
+
+    const size_t size = state.size();
+    size_t i = 0;
+
+    const auto write_u32 = [&](u32 v)
+    {
+        const size_t offset = delta.size();
+        delta.resize(offset + sizeof(v));
+        memcpy(&delta[offset],&v,sizeof(v));
+    };
+
+    while(i < size)
+    {
+        // skip what matches the key, a word at a time where we can
+        const size_t same_start = i;
+
+        while(i + sizeof(u64) <= size && !memcmp(&state[i],&key[i],sizeof(u64)))
+        {
+            i += sizeof(u64);
+        }
+
+        while(i < size && state[i] == key[i])
+        {
+            i++;
+        }
+
+        const size_t diff_start = i;
+
+        // short matches in the middle of a change are cheaper to just copy
+        // than to start a new run for
+        while(i < size)
+        {
+            if(i + sizeof(u64) <= size && !memcmp(&state[i],&key[i],sizeof(u64)))
+            {
+                break;
+            }
+
+            i++;
+        }
+
+        write_u32(diff_start - same_start);
+        write_u32(i - diff_start);
+
+        const size_t offset = delta.size();
+        delta.resize(offset + (i - diff_start));
+        memcpy(&delta[offset],&state[diff_start],i - diff_start);
+    }
+}
+
+void Rewind::decode_delta(std::vector<u8> &state, const std::vector<u8> &key, const std::vector<u8> &delta)
+{
+    state.resize(key.size());
+
+    size_t pos = 0;
+    size_t i = 0;
+
+    while(i < delta.size())
+    {
+        u32 same;
+        u32 diff;
+
+        memcpy(&same,&delta[i],sizeof(same));
+        memcpy(&diff,&delta[i + sizeof(same)],sizeof(diff));
+        i += sizeof(same) + sizeof(diff);
+
+        memcpy(&state[pos],&key[pos],same);
+        pos += same;
+
+        memcpy(&state[pos],&delta[i],diff);
+        pos += diff;
+        i += diff;
+    }
+}
+
+void Rewind::push(const std::vector<u8> &state)
+{
+    if(!enabled())
+    {
+        return;
+    }
+
+    const bool new_key = groups.empty() || groups.back().delta.size() + 1 >= key_interval
+        || groups.back().key.size() != state.size();
+
+    if(new_key)
+    {
+        Group group;
+        group.key = take_spare(spare_key);
+        group.key.assign(state.begin(),state.end());
+
+        groups.push_back(std::move(group));
+    }
+
+    else
+    {
+        auto &group = groups.back();
+
+        auto delta = take_spare(spare_delta);
+        encode_delta(delta,group.key,state);
+
+        group.delta.push_back(std::move(delta));
+    }
+
+    len += 1;
+
+    // drop the oldest group, its deltas are useless without the key
+    while(len > capacity && groups.size() > 1)
+    {
+        auto &group = groups.front();
+
+        len -= 1 + group.delta.size();
+        drop_group(group);
+
+        groups.pop_front();
+    }
+}
+
+bool Rewind::pop(std::vector<u8> &state)
+{
+    if(groups.empty())
+    {
+        return false;
+    }
+
+    auto &group = groups.back();
+
+    if(group.delta.empty())
+    {
+        state.assign(group.key.begin(),group.key.end());
+
+        spare_key.push_back(std::move(group.key));
+        groups.pop_back();
+    }
+
+    else
+    {
+        decode_delta(state,group.key,group.delta.back());
+
+        spare_delta.push_back(std::move(group.delta.back()));
+        group.delta.pop_back();
+    }
+
+    len -= 1;
+    return true;
+}
@@ -0,0 +1,177 @@
+#include "audio_mixer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define AUDIO_MIXER_SIMD
+#endif
+
+void AudioMixer::init(u32 channels, double in_rate, double out_rate) noexcept
+{
+    constexpr double PI = 3.14159265358979323846;
+
+    this->channels = std::min(channels,MAX_CHANNELS);
+    step = std::max(in_rate / out_rate,1.0);
+
+    // cutoff in cycles per input frame
+    // under the output nyquist so the transition band is clear of it
+    const double cutoff = 0.4 / step;
+
+    for(u32 phase = 0; phase < PHASES; phase++)
+    {
+        const double frac = static_cast<double>(phase) / PHASES;
+        double coeff[TAPS];
+        double sum = 0.0;
+
+        for(u32 tap = 0; tap < TAPS; tap++)
+        {
+            // distance of this tap from the output point
+            const double x = static_cast<double>(tap) - ((TAPS / 2) - 1) - frac;
+            const double arg = 2.0 * PI * cutoff * x;
+            const double sinc = x == 0.0? 1.0 : std::sin(arg) / arg;
+
+            // blackman window over the length of the filter
+            const double w = (x + (TAPS / 2)) / TAPS;
+            const double window = 0.42 - (0.5 * std::cos(2.0 * PI * w)) + (0.08 * std::cos(4.0 * PI * w));
+
+            coeff[tap] = sinc * window;
+            sum += coeff[tap];
+        }
+
+        // unity gain at dc for every phase
+        for(u32 tap = 0; tap < TAPS; tap++)
+        {
+            filter[phase][tap] = static_cast<float>(coeff[tap] / sum);
+        }
+    }
+
+    reset();
+}
+
+void AudioMixer::reset() noexcept
+{
+    block_idx = 0;
+    pos = 0.0;
+
+    memset(mixed_left,0,sizeof(mixed_left));
+    memset(mixed_right,0,sizeof(mixed_right));
+}
+
+u32 AudioMixer::mix() noexcept
+{
+    mix_channels();
+    block_idx = 0;
+
+    return resample();
+}
+
+// sum every channel into the block after the filter history
+void AudioMixer::mix_channels() noexcept
+{
+    float *left = &mixed_left[TAPS];
+    float *right = &mixed_right[TAPS];
+
+#ifdef AUDIO_MIXER_SIMD
+    for(u32 i = 0; i < BLOCK_SIZE; i += 4)
+    {
+        __m128 l = _mm_setzero_ps();
+        __m128 r = _mm_setzero_ps();
+
+        for(u32 c = 0; c < channels; c++)
+        {
+            const __m128 v = _mm_load_ps(&block[c][i]);
+
+            l = _mm_add_ps(l,_mm_mul_ps(v,_mm_set1_ps(gain_left[c])));
+            r = _mm_add_ps(r,_mm_mul_ps(v,_mm_set1_ps(gain_right[c])));
+        }
+
+        _mm_store_ps(&left[i],l);
+        _mm_store_ps(&right[i],r);
+    }
+#else
+    std::fill_n(left,BLOCK_SIZE,0.0f);
+    std::fill_n(right,BLOCK_SIZE,0.0f);
+
+    for(u32 c = 0; c < channels; c++)
+    {
+        for(u32 i = 0; i < BLOCK_SIZE; i++)
+        {
+            left[i] += block[c][i] * gain_left[c];
+            right[i] += block[c][i] * gain_right[c];
+        }
+    }
+#endif
+}
+
+// run both sides through the same filter phase
+static void apply_filter(const float *left, const float *right, const float *coeff, float &out_left, float &out_right)
+{
+#ifdef AUDIO_MIXER_SIMD
+    __m128 l = _mm_setzero_ps();
+    __m128 r = _mm_setzero_ps();
+
+    for(u32 tap = 0; tap < AudioMixer::TAPS; tap += 4)
+    {
+        const __m128 c = _mm_load_ps(&coeff[tap]);
+
+        l = _mm_add_ps(l,_mm_mul_ps(_mm_loadu_ps(&left[tap]),c));
+        r = _mm_add_ps(r,_mm_mul_ps(_mm_loadu_ps(&right[tap]),c));
+    }
+
+    // horizontal add, left ends up in lane 0 and right in lane 1
+    const __m128 lo = _mm_unpacklo_ps(l,r);
+    const __m128 hi = _mm_unpackhi_ps(l,r);
+    const __m128 sum = _mm_add_ps(lo,hi);
+    const __m128 total = _mm_add_ps(sum,_mm_movehl_ps(sum,sum));
+
+    out_left = _mm_cvtss_f32(total);
+    out_right = _mm_cvtss_f32(_mm_shuffle_ps(total,total,_MM_SHUFFLE(1,1,1,1)));
+#else
+    out_left = 0.0f;
+    out_right = 0.0f;
+
+    for(u32 tap = 0; tap < AudioMixer::TAPS; tap++)
+    {
+        out_left += left[tap] * coeff[tap];
+        out_right += right[tap] * coeff[tap];
+    }
+#endif
+}
+
+u32 AudioMixer::resample() noexcept
+{
+    u32 frames = 0;
+
+    for(;;)
+    {
+        const u32 idx = static_cast<u32>(pos);
+
+        // filter would run past the end of the block
+        if(idx > BLOCK_SIZE)
+        {
+            break;
+        }
+
+        const u32 phase = static_cast<u32>((pos - idx) * PHASES);
+
+        float l;
+        float r;
+        apply_filter(&mixed_left[idx],&mixed_right[idx],filter[phase],l,r);
+
+        out_left[frames] = std::clamp(l,-1.0f,1.0f);
+        out_right[frames] = std::clamp(r,-1.0f,1.0f);
+
+        frames++;
+        pos += step;
+    }
+
+    // the end of this block is the history for the next
+    memmove(mixed_left,&mixed_left[BLOCK_SIZE],TAPS * sizeof(float));
+    memmove(mixed_right,&mixed_right[BLOCK_SIZE],TAPS * sizeof(float));
+
+    pos -= BLOCK_SIZE;
+
+    return frames;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <destoer.h>
+
+// mixes a core's channels and resamples them to the playback rate
+// channels are pushed a frame at a time at the core's internal rate
+// and only touched again once a whole block is buffered
+// where they are mixed down to stereo and put through a windowed sinc filter
+// so nothing above the output nyquist aliases back down
+class AudioMixer
+{
+public:
+    static constexpr u32 MAX_CHANNELS = 8;
+    static constexpr u32 BLOCK_SIZE = 256;
+
+    // only downsamples, in_rate must be at least out_rate
+    void init(u32 channels, double in_rate, double out_rate) noexcept;
+
+    // gains are applied when the block is mixed
+    // so a change lands at most a block late
+    void set_gain(u32 chan, float left, float right) noexcept
+    {
+        gain_left[chan] = left;
+        gain_right[chan] = right;
+    }
+
+    // one value per channel, true once the block is full and needs a mix()
+    bool push(const float *values) noexcept
+    {
+        for(u32 c = 0; c < channels; c++)
+        {
+            block[c][block_idx] = values[c];
+        }
+
+        return ++block_idx == BLOCK_SIZE;
+    }
+
+    // mix and resample the buffered block
+    // returns the number of output frames written to left() and right()
+    u32 mix() noexcept;
+
+    const float *left() const noexcept { return out_left; }
+    const float *right() const noexcept { return out_right; }
+
+    // drop anything buffered and the filter history
+    void reset() noexcept;
+
+    // length of the filter in input frames, output lags the input by half of it
+    static constexpr u32 TAPS = 32;
+
+    // sub sample positions the filter is precomputed for
+    static constexpr u32 PHASES = 256;
+
+private:
+    void mix_channels() noexcept;
+    u32 resample() noexcept;
+
+    u32 channels = 0;
+
+    float gain_left[MAX_CHANNELS] = {0};
+    float gain_right[MAX_CHANNELS] = {0};
+
+    alignas(16) float block[MAX_CHANNELS][BLOCK_SIZE];
+    u32 block_idx = 0;
+
+    // mixed input, the last TAPS frames of the previous block are kept in front
+    // as history for the filter
+    alignas(16) float mixed_left[TAPS + BLOCK_SIZE];
+    alignas(16) float mixed_right[TAPS + BLOCK_SIZE];
+
+    // read position into mixed in input frames, and the input step per output frame
+    double pos = 0.0;
+    double step = 1.0;
+
+    alignas(16) float filter[PHASES][TAPS];
+
+    // most frames a block can resample to, 1 extra for the fractional position
+    static constexpr u32 OUT_SIZE = BLOCK_SIZE + 1;
+    float out_left[OUT_SIZE];
+    float out_right[OUT_SIZE];
+};
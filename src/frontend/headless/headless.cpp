@@ -0,0 +1,691 @@
+#ifdef FRONTEND_HEADLESS
+#include "headless.h"
+#include <thread>
+#include <atomic>
+#include <charconv>
+#include <cinttypes>
+
+#ifdef GB_ENABLED
+#include <gb/gb.h>
+#endif
+
+#ifdef GBA_ENABLED
+#include <gba/gba.h>
+#endif
+
+#ifdef N64_ENABLED
+#include <n64/n64.h>
+#endif
+
+struct ScriptEvent
+{
+    u32 frame;
+    InputEvent event;
+};
+
+// input scripts are fed through the same controller interface the windowed
+// frontends use so each core gets its input through handle_input
+struct InputScript
+{
+    void push_frame(u32 frame, Controller& controller)
+    {
+        while(idx < events.size() && events[idx].frame <= frame)
+        {
+            controller.add_event(events[idx].event);
+            idx++;
+        }
+    }
+
+    std::vector<ScriptEvent> events;
+    size_t idx = 0;
+};
+
+static const std::pair<const char*,controller_input> INPUT_NAMES[] =
+{
+    {"a",controller_input::a},
+    {"x",controller_input::x},
+    {"b",controller_input::x},
+    {"start",controller_input::start},
+    {"select",controller_input::select},
+    {"right",controller_input::right},
+    {"left",controller_input::left},
+    {"up",controller_input::up},
+    {"down",controller_input::down},
+    {"r",controller_input::right_trigger},
+    {"l",controller_input::left_trigger},
+};
+
+InputScript read_input_script(const std::string& filename)
+{
+    InputScript script;
+
+    if(filename.empty())
+    {
+        return script;
+    }
+
+    std::ifstream fp(filename);
+    if(!fp)
+    {
+        throw std::runtime_error(fmt::format("could not open input script: {}",filename));
+    }
+
+    std::string line;
+    while(std::getline(fp,line))
+    {
+        std::stringstream ss(line);
+
+        u32 frame = 0;
+        std::string name;
+        std::string state;
+
+        if(line.empty() || line[0] == '#' || !(ss >> frame >> name >> state))
+        {
+            continue;
+        }
+
+        b32 found = false;
+
+        for(const auto& [input_name,input] : INPUT_NAMES)
+        {
+            if(name == input_name)
+            {
+                script.events.push_back({frame,make_input_event(input,state == "down")});
+                found = true;
+                break;
+            }
+        }
+
+        if(!found)
+        {
+            throw std::runtime_error(fmt::format("unknown input in script {}: {}",filename,name));
+        }
+    }
+
+    std::stable_sort(script.events.begin(),script.events.end(),[](const ScriptEvent& v1, const ScriptEvent& v2)
+    {
+        return v1.frame < v2.frame;
+    });
+
+    return script;
+}
+
+
+std::vector<BatchJob> read_batch_manifest(const std::string& filename, u32 default_frames)
+{
+    std::vector<BatchJob> jobs;
+
+    // run an entire directory of roms
+    if(std::filesystem::is_directory(filename))
+    {
+        const auto [tree,error] = read_dir_tree(filename);
+
+        if(error)
+        {
+            throw std::runtime_error(fmt::format("could not read rom directory: {}",filename));
+        }
+
+        for(const auto& rom : tree)
+        {
+            if(get_emulator_type(rom) != emu_type::none)
+            {
+                BatchJob job;
+                job.rom = rom;
+                job.frames = default_frames;
+
+                jobs.push_back(job);
+            }
+        }
+
+        std::sort(jobs.begin(),jobs.end(),[](const BatchJob& v1, const BatchJob& v2)
+        {
+            return v1.rom < v2.rom;
+        });
+
+        return jobs;
+    }
+
+    std::ifstream fp(filename);
+    if(!fp)
+    {
+        throw std::runtime_error(fmt::format("could not open manifest: {}",filename));
+    }
+
+    std::string line;
+    while(std::getline(fp,line))
+    {
+        std::stringstream ss(line);
+
+        BatchJob job;
+        job.frames = default_frames;
+
+        if(line.empty() || line[0] == '#' || !(ss >> job.rom))
+        {
+            continue;
+        }
+
+        ss >> job.frames >> job.input_script;
+
+        jobs.push_back(job);
+    }
+
+    return jobs;
+}
+
+#ifdef GB_ENABLED
+std::string run_gb(const BatchJob& job, InputScript& script, u32& frames)
+{
+    // too big for the stack of a worker thread
+    auto gb = std::make_unique<gameboy::GB>();
+    gb->reset(job.rom);
+    gb->apu.playback.stop();
+    gb->throttle_emu = false;
+
+    Controller controller;
+
+    while(frames < job.frames)
+    {
+        script.push_frame(frames,controller);
+        gb->handle_input(controller);
+        controller.input_events.clear();
+
+        gb->run();
+        frames++;
+
+        if(gb->mem.test_result == emu_test::fail)
+        {
+            return "fail";
+        }
+
+        else if(gb->mem.test_result == emu_test::pass)
+        {
+            return "pass";
+        }
+    }
+
+    return "ok";
+}
+#endif
+
+#ifdef GBA_ENABLED
+// registers the jit and interpreter must agree on between blocks
+std::string gba_cpu_diff(const gameboyadvance::GBA& jit, const gameboyadvance::GBA& ref)
+{
+    const auto& a = jit.cpu;
+    const auto& b = ref.cpu;
+
+    for(u32 i = 0; i < 16; i++)
+    {
+        if(a.regs[i] != b.regs[i])
+        {
+            return fmt::format("r{} {:08x} != {:08x} at {:08x}",i,a.regs[i],b.regs[i],b.pc_actual);
+        }
+    }
+
+    if(a.get_cpsr() != b.get_cpsr())
+    {
+        return fmt::format("cpsr {:08x} != {:08x} at {:08x}",a.get_cpsr(),b.get_cpsr(),b.pc_actual);
+    }
+
+    if(jit.scheduler.get_timestamp() != ref.scheduler.get_timestamp())
+    {
+        return fmt::format("cycles {} != {} at {:08x}",jit.scheduler.get_timestamp(),ref.scheduler.get_timestamp(),b.pc_actual);
+    }
+
+    return "";
+}
+
+// same loop as GBA::run on two instances
+// after each block the jit runs the interpreter is stepped an instr at a time until it catches up
+std::string run_gba_diff(const BatchJob& job, InputScript& script, u32& frames)
+{
+    auto jit = std::make_unique<gameboyadvance::GBA>();
+    auto ref = std::make_unique<gameboyadvance::GBA>();
+
+    for(auto* gba : {jit.get(),ref.get()})
+    {
+        gba->reset(job.rom);
+        gba->apu.playback.stop();
+        gba->throttle_emu = false;
+        gba->cpu.bios_hle = job.bios_hle;
+    }
+
+    // translate everything straight away so as much code as possible goes through it
+    jit->cpu.jit.enabled = true;
+    jit->cpu.jit.hot_threshold = 1;
+
+    Controller controller;
+
+    while(frames < job.frames)
+    {
+        script.push_frame(frames,controller);
+        jit->handle_input(controller);
+        ref->handle_input(controller);
+        controller.input_events.clear();
+
+        jit->disp.new_vblank = false;
+        ref->disp.new_vblank = false;
+
+        while(!jit->disp.new_vblank)
+        {
+            while(!jit->scheduler.event_ready() && !jit->cpu.interrupt_ready())
+            {
+                jit->cpu.exec_block();
+
+                while(ref->scheduler.get_timestamp() < jit->scheduler.get_timestamp() && 
+                    !ref->scheduler.event_ready() && !ref->cpu.interrupt_ready())
+                {
+                    ref->cpu.exec_instr_no_debug();
+                }
+
+                const auto diff = gba_cpu_diff(*jit,*ref);
+
+                if(!diff.empty())
+                {
+                    return fmt::format("diverged ({})",diff);
+                }
+            }
+
+            jit->scheduler.service_events();
+            jit->cpu.do_interrupts();
+
+            ref->scheduler.service_events();
+            ref->cpu.do_interrupts();
+        }
+
+        frames++;
+    }
+
+    return "ok";
+}
+
+std::string run_gba(const BatchJob& job, InputScript& script, u32& frames, u64& idle_cycles)
+{
+    if(job.jit_diff)
+    {
+        return run_gba_diff(job,script,frames);
+    }
+
+    auto gba = std::make_unique<gameboyadvance::GBA>();
+
+    // read before reset so it can pick this rom out of them
+    if(!job.idle_overrides.empty())
+    {
+        gba->cpu.idle_loop.load_overrides(job.idle_overrides);
+    }
+
+    gba->reset(job.rom);
+    gba->apu.playback.stop();
+    gba->throttle_emu = false;
+    gba->cpu.jit.enabled = job.jit;
+    gba->cpu.bios_hle = job.bios_hle;
+    gba->cpu.idle_loop.enabled = job.idle_skip;
+
+    Controller controller;
+
+    while(frames < job.frames)
+    {
+        script.push_frame(frames,controller);
+        gba->handle_input(controller);
+        controller.input_events.clear();
+
+        gba->run();
+        frames++;
+
+        idle_cycles = gba->cpu.idle_loop.skipped_cycles;
+    }
+
+    return "ok";
+}
+#endif
+
+#ifdef N64_ENABLED
+// registers the jit and interpreter must agree on between blocks
+std::string n64_cpu_diff(const nintendo64::N64& jit, const nintendo64::N64& ref)
+{
+    const auto& a = jit.cpu;
+    const auto& b = ref.cpu;
+
+    for(u32 i = 0; i < 32; i++)
+    {
+        if(a.regs[i] != b.regs[i])
+        {
+            return fmt::format("{} {:016x} != {:016x} at {:016x}",nintendo64::reg_name(i),a.regs[i],b.regs[i],b.pc);
+        }
+    }
+
+    if(a.hi != b.hi || a.lo != b.lo)
+    {
+        return fmt::format("hi:lo {:016x}:{:016x} != {:016x}:{:016x} at {:016x}",a.hi,a.lo,b.hi,b.lo,b.pc);
+    }
+
+    if(a.pc != b.pc || a.pc_next != b.pc_next)
+    {
+        return fmt::format("pc {:016x}:{:016x} != {:016x}:{:016x}",a.pc,a.pc_next,b.pc,b.pc_next);
+    }
+
+    if(jit.scheduler.get_timestamp() != ref.scheduler.get_timestamp())
+    {
+        return fmt::format("cycles {} != {} at {:016x}",jit.scheduler.get_timestamp(),ref.scheduler.get_timestamp(),b.pc);
+    }
+
+    return "";
+}
+
+// same loop as nintendo64::run on two instances
+// after each block the jit runs the interpreter is stepped an instr at a time until it catches up
+std::string run_n64_diff(const BatchJob& job, InputScript& script, u32& frames)
+{
+    auto jit = std::make_unique<nintendo64::N64>();
+    auto ref = std::make_unique<nintendo64::N64>();
+
+    nintendo64::reset(*jit,job.rom);
+    nintendo64::reset(*ref,job.rom);
+
+    // translate everything straight away so as much code as possible goes through it
+    jit->cpu.jit.enabled = true;
+    jit->cpu.jit.hot_threshold = 1;
+
+    Controller controller;
+
+    while(frames < job.frames)
+    {
+        script.push_frame(frames,controller);
+        nintendo64::handle_input(*jit,controller);
+        nintendo64::handle_input(*ref,controller);
+        controller.input_events.clear();
+
+        jit->rdp.frame_done = false;
+        ref->rdp.frame_done = false;
+
+        while(!jit->rdp.frame_done)
+        {
+            while(!jit->scheduler.event_ready())
+            {
+                nintendo64::step_jit(*jit);
+
+                while(ref->scheduler.get_timestamp() < jit->scheduler.get_timestamp() && !ref->scheduler.event_ready())
+                {
+                    nintendo64::step_cached(*ref);
+                }
+
+                const auto diff = n64_cpu_diff(*jit,*ref);
+
+                if(!diff.empty())
+                {
+                    return fmt::format("diverged ({})",diff);
+                }
+            }
+
+            jit->scheduler.service_events();
+            ref->scheduler.service_events();
+        }
+
+        frames++;
+    }
+
+    return "ok";
+}
+
+std::string run_n64(const BatchJob& job, InputScript& script, u32& frames)
+{
+    if(job.jit_diff)
+    {
+        return run_n64_diff(job,script,frames);
+    }
+
+    auto n64 = std::make_unique<nintendo64::N64>();
+    nintendo64::reset(*n64,job.rom);
+    n64->cpu.jit.enabled = job.jit;
+
+    Controller controller;
+
+    while(frames < job.frames)
+    {
+        script.push_frame(frames,controller);
+        nintendo64::handle_input(*n64,controller);
+        controller.input_events.clear();
+
+        nintendo64::run(*n64);
+        frames++;
+    }
+
+    return "ok";
+}
+#endif
+
+BatchResult run_job(const BatchJob& job)
+{
+    BatchResult result;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    try
+    {
+        auto script = read_input_script(job.input_script);
+
+        switch(get_emulator_type(job.rom))
+        {
+        #ifdef GB_ENABLED
+            case emu_type::gameboy: result.status = run_gb(job,script,result.frames); break;
+        #endif
+
+        #ifdef GBA_ENABLED
+            case emu_type::gba: result.status = run_gba(job,script,result.frames,result.idle_cycles); break;
+        #endif
+
+        #ifdef N64_ENABLED
+            case emu_type::n64: result.status = run_n64(job,script,result.frames); break;
+        #endif
+
+            default: result.status = "unsupported"; break;
+        }
+    }
+
+    catch(std::exception& ex)
+    {
+        result.status = fmt::format("aborted ({})",ex.what());
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+
+    return result;
+}
+
+std::vector<BatchResult> run_batch(const std::vector<BatchJob>& jobs, u32 threads)
+{
+    std::vector<BatchResult> results(jobs.size());
+    std::atomic<size_t> next_job = 0;
+
+    // each worker pulls jobs off the front of the queue
+    // and owns the core instance for that job
+    const auto worker = [&]()
+    {
+        for(;;)
+        {
+            const size_t idx = next_job.fetch_add(1);
+
+            if(idx >= jobs.size())
+            {
+                return;
+            }
+
+            results[idx] = run_job(jobs[idx]);
+        }
+    };
+
+    threads = std::max(1u,std::min<u32>(threads,jobs.size()));
+
+    std::vector<std::thread> workers;
+
+    for(u32 i = 0; i < threads; i++)
+    {
+        workers.emplace_back(worker);
+    }
+
+    for(auto& thread : workers)
+    {
+        thread.join();
+    }
+
+    return results;
+}
+
+// whole string must be an unsigned number, so "-1" or "12abc" are rejected
+// rather than wrapping or stopping part way through
+std::optional<u32> parse_count(const char* str)
+{
+    const char* end = str + strlen(str);
+
+    u32 count = 0;
+    const auto [ptr,error] = std::from_chars(str,end,count);
+
+    if(error != std::errc() || ptr != end)
+    {
+        return std::nullopt;
+    }
+
+    return count;
+}
+
+int headless_main(int argc, char* argv[])
+{
+    u32 threads = std::thread::hardware_concurrency();
+    u32 frames = 600;
+    std::string manifest = "";
+    b32 jit = false;
+    b32 jit_diff = false;
+    b32 bios_hle = false;
+    b32 idle_skip = false;
+    std::string idle_overrides = "";
+
+    for(int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if(arg == "-j" && i + 1 < argc)
+        {
+            const auto count = parse_count(argv[++i]);
+
+            if(!count)
+            {
+                printf("-j: thread count must be a non negative number: %s\n",argv[i]);
+                return 1;
+            }
+
+            threads = *count;
+        }
+
+        else if(arg == "-f" && i + 1 < argc)
+        {
+            const auto count = parse_count(argv[++i]);
+
+            if(!count)
+            {
+                printf("-f: frame count must be a non negative number: %s\n",argv[i]);
+                return 1;
+            }
+
+            frames = *count;
+        }
+
+        else if(arg == "-x")
+        {
+            jit = true;
+        }
+
+        else if(arg == "-xd")
+        {
+            jit_diff = true;
+        }
+
+        else if(arg == "-hle")
+        {
+            bios_hle = true;
+        }
+
+        else if(arg == "-idle")
+        {
+            idle_skip = true;
+        }
+
+        else if(arg == "-idle-list" && i + 1 < argc)
+        {
+            idle_overrides = argv[++i];
+        }
+
+        else
+        {
+            manifest = arg;
+        }
+    }
+
+    if(manifest.empty())
+    {
+        printf("usage: %s [-j threads] [-f default frames] [-x jit] [-xd jit vs interpreter] [-hle bios hle] [-idle skip idle loops] [-idle-list overrides] <manifest | rom directory>\n",argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        auto jobs = read_batch_manifest(manifest,frames);
+
+        for(auto& job : jobs)
+        {
+            job.jit = jit;
+            job.jit_diff = jit_diff;
+            job.bios_hle = bios_hle;
+            job.idle_skip = idle_skip;
+            job.idle_overrides = idle_overrides;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto results = run_batch(jobs,threads);
+        const auto end = std::chrono::steady_clock::now();
+
+        u64 total_frames = 0;
+        std::map<std::string,u32> status_count;
+
+        for(size_t i = 0; i < jobs.size(); i++)
+        {
+            const auto& result = results[i];
+            const double fps = result.seconds > 0.0? result.frames / result.seconds : 0.0;
+
+            printf("%s: %s, %u frames in %.3fs (%.1f fps)\n",
+                jobs[i].rom.c_str(),result.status.c_str(),result.frames,result.seconds,fps);
+
+            // only the gba skips idle loops
+            if(jobs[i].idle_skip && result.frames && get_emulator_type(jobs[i].rom) == emu_type::gba)
+            {
+                // gba frame is 228 lines of 1232 cycles
+                const double cycles = double(result.frames) * 228 * 1232;
+                printf("  idle loops: %" PRIu64 " cycles skipped (%.1f%%)\n",result.idle_cycles,(result.idle_cycles / cycles) * 100.0);
+            }
+
+            total_frames += result.frames;
+            status_count[result.status]++;
+        }
+
+        const double seconds = std::chrono::duration<double>(end - start).count();
+
+        printf("\ntotal: %zu jobs on %u threads\n",jobs.size(),std::max(1u,std::min<u32>(threads,jobs.size())));
+
+        for(const auto& [status,count] : status_count)
+        {
+            printf("%s: %u\n",status.c_str(),count);
+        }
+
+        printf("total time taken %f (%.1f fps)\n",seconds,seconds > 0.0? total_frames / seconds : 0.0);
+    }
+
+    catch(std::exception& ex)
+    {
+        std::cout << ex.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+#ifdef FRONTEND_HEADLESS
+#include <frontend/input.h>
+#include <albion/emulator.h>
+
+// a single rom to run for a fixed number of frames
+struct BatchJob
+{
+    std::string rom;
+    u32 frames = 0;
+
+    // optional script of "<frame> <input> <down|up>" lines
+    std::string input_script;
+
+    // use the jit where a core has one
+    b32 jit = false;
+
+    // run the jit against the interpreter and fail on the first difference
+    b32 jit_diff = false;
+
+    // do bios calls natively where a core supports it
+    b32 bios_hle = false;
+
+    // skip polling loops to the next event where a core supports it
+    b32 idle_skip = false;
+
+    // optional per game idle loop overrides, see IdleLoop::load_overrides
+    std::string idle_overrides;
+};
+
+struct BatchResult
+{
+    std::string status = "ok";
+    u32 frames = 0;
+    double seconds = 0.0;
+
+    // emulated cycles skipped over in idle loops
+    u64 idle_cycles = 0;
+};
+
+// manifest lines are "<rom> [frames] [input script]", # for comments
+// a directory instead of a manifest runs every rom inside it
+std::vector<BatchJob> read_batch_manifest(const std::string& filename, u32 default_frames);
+
+std::vector<BatchResult> run_batch(const std::vector<BatchJob>& jobs, u32 threads);
+
+int headless_main(int argc, char* argv[]);
+
+#endif
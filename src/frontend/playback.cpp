@@ -1,5 +1,6 @@
 
 #include "playback.h"
+#include <algorithm>
 #ifdef AUDIO_SDL
 
 
@@ -10,6 +11,85 @@
 #include <SDL2/SDL.h>
 #endif
 
+void AudioRing::init(size_t size) noexcept
+{
+    // round up so the indexes can just be masked
+    size_t cap = 1;
+    while(cap < size)
+    {
+        cap <<= 1;
+    }
+
+    buf.resize(cap * 2);
+    mask = cap - 1;
+
+    write_idx = 0;
+    read_idx = 0;
+}
+
+size_t AudioRing::size() const noexcept
+{
+    return write_idx.load(std::memory_order_acquire) - read_idx.load(std::memory_order_acquire);
+}
+
+size_t AudioRing::free_space() const noexcept
+{
+    return (mask + 1) - size();
+}
+
+void AudioRing::push(float l, float r) noexcept
+{
+    const size_t idx = write_idx.load(std::memory_order_relaxed);
+
+    buf[(idx & mask) * 2] = l;
+    buf[((idx & mask) * 2) + 1] = r;
+
+    write_idx.store(idx + 1,std::memory_order_release);
+}
+
+size_t AudioRing::pop(float *out, size_t frames) noexcept
+{
+    const size_t idx = read_idx.load(std::memory_order_relaxed);
+    const size_t avail = write_idx.load(std::memory_order_acquire) - idx;
+
+    frames = std::min(frames,avail);
+
+    for(size_t i = 0; i < frames; i++)
+    {
+        const size_t offset = ((idx + i) & mask) * 2;
+
+        out[i * 2] = buf[offset];
+        out[(i * 2) + 1] = buf[offset + 1];
+    }
+
+    read_idx.store(idx + frames,std::memory_order_release);
+    read_idx.notify_one();
+
+    return frames;
+}
+
+void AudioRing::wait_below(size_t limit) const noexcept
+{
+    for(;;)
+    {
+        // wait on the same read idx that was checked
+        // so a pop in between cannot be missed
+        const size_t idx = read_idx.load(std::memory_order_acquire);
+
+        if(write_idx.load(std::memory_order_relaxed) - idx < limit)
+        {
+            return;
+        }
+
+        read_idx.wait(idx,std::memory_order_acquire);
+    }
+}
+
+void AudioRing::clear() noexcept
+{
+    read_idx.store(write_idx.load());
+}
+
 void Playback::init(int playback_frequency,int sample_size) noexcept
 {
     SDL_AudioSpec audio_spec;
@@ -20,60 +100,109 @@ void Playback::init(int playback_frequency,int sample_size) noexcept
 	audio_spec.format = AUDIO_F32SYS;
 	audio_spec.channels = 2;
 	audio_spec.samples = sample_size;	
-	audio_spec.callback = NULL; // we will use SDL_QueueAudio()  rather than 
-	audio_spec.userdata = NULL; // using a callback :)
+	audio_spec.callback = audio_callback;
+	audio_spec.userdata = this;
 
+    // reset calls this again, close the old device first so the callback
+    // is not reading the ring while it is resized and the reopen cannot fail
+    if(device_open)
+    {
+        SDL_CloseAudio();
+        device_open = false;
+    }
+
+    // same amount the old queue was allowed to hold
+    latency = sample_size;
+    ring.init(latency * 2);
 
-    sample_idx = 0;
+    step = 1.0;
+    resample_pos = 0.0;
+    prev_l = 0.0;
+    prev_r = 0.0;
+    rate_cnt = 0;
 
-    audio_buf.resize(sample_size);
+    last_l = 0.0;
+    last_r = 0.0;
 
-    SDL_OpenAudio(&audio_spec,NULL);
+    // without a device nothing drains the ring, just drop samples
+    device_open = SDL_OpenAudio(&audio_spec,NULL) == 0;
 	start();
 }
 
-void Playback::mix_samples(float &f1, const float &f2, int volume) noexcept
+void Playback::update_rate() noexcept
 {
-    SDL_MixAudioFormat((Uint8*)&f1,(Uint8*)&f2,AUDIO_F32SYS,sizeof(float),volume);
-}
+    const double target = latency / 2.0;
+    const double fill = ring.size();
 
+    const double under = std::clamp((target - fill) / target,0.0,1.0);
+
+    // input frames consumed per output frame
+    step = 1.0 / (1.0 + (MAX_DELTA * under));
+}
 
 void Playback::push_sample(const float &l, const float &r) noexcept
 {
-    if(sample_idx >= audio_buf.size())
+    if(!device_open)
+    {
+        return;
+    }
+
+    if(++rate_cnt == RATE_UPDATE)
     {
-        push_samples();
-        sample_idx = 0;
+        rate_cnt = 0;
+        update_rate();
+    }
+
+    // linear resample between the last frame and this one
+    for(; resample_pos < 1.0; resample_pos += step)
+    {
+        // let the device catch up
+        ring.wait_below(latency);
+
+        const float pos = resample_pos;
+
+        ring.push(prev_l + ((l - prev_l) * pos),prev_r + ((r - prev_r) * pos));
     }
 
-    audio_buf[sample_idx] = l;
-    audio_buf[sample_idx+1] = r;
+    resample_pos -= 1.0;
 
-    sample_idx += 2;
+    prev_l = l;
+    prev_r = r;
 }
 
-#include <thread>
+void Playback::push_samples(const float *l, const float *r, size_t frames) noexcept
+{
+    for(size_t i = 0; i < frames; i++)
+    {
+        push_sample(l[i],r[i]);
+    }
+}
 
-void Playback::push_samples()
+void Playback::fill_audio(float *out, size_t frames) noexcept
 {
-    // legacy interface
-    static constexpr SDL_AudioDeviceID dev = 1;
-    
-    auto buffer_size = (audio_buf.size() * sizeof(float));
+    const size_t read = ring.pop(out,frames);
 
-    // delay execution and let the que drain
-    while(SDL_GetQueuedAudioSize(dev) > buffer_size)
+    if(read != 0)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }			
-
+        last_l = out[(read - 1) * 2];
+        last_r = out[((read - 1) * 2) + 1];
+    }
 
-    if(SDL_QueueAudio(dev,audio_buf.data(),buffer_size) < 0)
+    // ran dry hold the last frame rather than dropping to silence
+    for(size_t i = read; i < frames; i++)
     {
-        printf("%s\n",SDL_GetError()); exit(1);
+        out[i * 2] = last_l;
+        out[(i * 2) + 1] = last_r;
     }
 }
 
+void Playback::audio_callback(void *userdata, u8 *stream, int len)
+{
+    auto &playback = *static_cast<Playback*>(userdata);
+
+    playback.fill_audio(reinterpret_cast<float*>(stream),len / (sizeof(float) * 2));
+}
+
 void Playback::start() noexcept
 {
 	play_audio = true;
@@ -83,13 +212,18 @@ void Playback::start() noexcept
 void Playback::stop() noexcept
 {
 	play_audio = false;
+
+    // callback is not running once paused
     SDL_PauseAudio(1);
-	SDL_ClearQueuedAudio(1);
+	ring.clear();
 }
 
 Playback::~Playback()
 {
-    SDL_CloseAudio();
+    if(device_open)
+    {
+        SDL_CloseAudio();
+    }
 }
 
 
@@ -110,9 +244,9 @@ void Playback::init(int playback_frequency,int sample_size) noexcept
     UNUSED(playback_frequency); UNUSED(sample_size);
 }
 
-void Playback::mix_samples(float &f1, const float &f2,int volume) noexcept
+void Playback::push_samples(const float *l, const float *r, size_t frames) noexcept
 {
-    UNUSED(f1); UNUSED(f2); UNUSED(volume);
+    UNUSED(l); UNUSED(r); UNUSED(frames);
 }
 
 void Playback::push_sample(const float &l, const float &r) noexcept
@@ -134,8 +268,4 @@ Playback::~Playback()
 
 }
 
-void Playback::push_samples()
-{
-
-}
 #endif
@@ -1,6 +1,41 @@
 #pragma once
 #include <destoer.h>
 
+#include <atomic>
+
+// single producer single consumer ring of stereo samples
+// the core pushes from the emulation thread and the audio callback drains it
+class AudioRing
+{
+public:
+    void init(size_t size) noexcept;
+
+    // producer
+    size_t free_space() const noexcept;
+    void push(float l, float r) noexcept;
+
+    // consumer
+    size_t pop(float *out, size_t frames) noexcept;
+
+    // number of frames waiting
+    size_t size() const noexcept;
+
+    // block the producer until less than limit frames are waiting
+    void wait_below(size_t limit) const noexcept;
+
+    // only safe while the consumer is stopped
+    void clear() noexcept;
+
+private:
+    std::vector<float> buf;
+    size_t mask = 0;
+
+    // written by producer and consumer respectively
+    // free running, they are masked on access
+    std::atomic<size_t> write_idx = 0;
+    std::atomic<size_t> read_idx = 0;
+};
+
 // defines how to push audio samples for the gameboy
 class Playback
 {
@@ -9,20 +44,40 @@ public:
 
     bool is_playing() const noexcept { return play_audio; }
 
-    void mix_samples(float &f1, const float &f2,int volume) noexcept;
     void push_sample(const float &l, const float &r) noexcept;
+    void push_samples(const float *l, const float *r, size_t frames) noexcept;
     void start() noexcept;
     void stop() noexcept;
 
     ~Playback();
 private:
-    void push_samples();
+    void fill_audio(float *out, size_t frames) noexcept;
+    static void audio_callback(void *userdata, u8 *stream, int len);
+
+    void update_rate() noexcept;
 
     bool play_audio = false;
+    bool device_open = false;
+
+    AudioRing ring;
 
+    // how many frames the core may run ahead of the audio device
+    // pushing blocks past this point which is what throttles emulation
+    size_t latency = 0;
 
-    size_t sample_idx = 0;
+    // dynamic rate control
+    // when the core falls behind and the ring drops under half the latency
+    // output is stretched by up to MAX_DELTA to refill it before it runs dry
+    // a full ring is already held by blocking so output is never shrunk
+    static constexpr double MAX_DELTA = 0.005;
+    static constexpr u32 RATE_UPDATE = 256;
+    double step = 1.0;
+    double resample_pos = 0.0;
+    float prev_l = 0.0;
+    float prev_r = 0.0;
+    u32 rate_cnt = 0;
 
-	// sound playback
-    std::vector<float> audio_buf;
-};
\ No newline at end of file
+    // last frame output, repeated if the ring runs dry
+    float last_l = 0.0;
+    float last_r = 0.0;
+};
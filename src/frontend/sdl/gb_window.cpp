@@ -18,13 +18,17 @@ void GameboyWindow::pass_input_to_core()
 void GameboyWindow::core_quit()
 {
     gb.mem.save_cart_ram();
-    exit(0);   
+    quit = true;
 }
 
 void GameboyWindow::run_frame()
 {
     gb.run();
-    render(gb.ppu.screen.data());
+
+    if(gb.ppu.new_vblank)
+    {
+        present(gb.ppu.screen,gameboy::SCREEN_WIDTH,gameboy::SCREEN_HEIGHT,gb.ppu.frame_frozen());
+    }
 }
 
 void GameboyWindow::debug_halt()
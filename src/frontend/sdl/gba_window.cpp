@@ -5,6 +5,11 @@ void GBAWindow::init(const std::string& filename)
     init_sdl(gameboyadvance::SCREEN_WIDTH,gameboyadvance::SCREEN_HEIGHT);
     input.init();
     gba.reset(filename);	
+
+    // the emulation and present threads are already busy
+    // so draw lines on whatever is left over
+    const u32 cores = std::thread::hardware_concurrency();
+    gba.disp.set_render_threads(cores > 2? std::min(cores - 2,3u) : 0);
 }
 
 void GBAWindow::pass_input_to_core()
@@ -16,13 +21,17 @@ void GBAWindow::pass_input_to_core()
 void GBAWindow::core_quit()
 {
     gba.mem.save_cart_ram();
-    exit(0);   
+    quit = true;
 }
 
 void GBAWindow::run_frame()
 {
     gba.run();
-    render(gba.disp.screen.data());
+
+    if(gba.disp.new_vblank)
+    {
+        present(gba.disp.screen,gameboyadvance::SCREEN_WIDTH,gameboyadvance::SCREEN_HEIGHT);
+    }
 }
 
 void GBAWindow::debug_halt()
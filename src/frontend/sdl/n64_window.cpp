@@ -7,6 +7,10 @@ void N64Window::init(const std::string& filename)
     input.init();
     reset(n64,filename);
     input.controller.simulate_dpad = false;	
+
+    // same budget as the gba line renderer
+    const u32 cores = std::thread::hardware_concurrency();
+    nintendo64::set_rdp_threads(n64,cores > 2? std::min(cores - 2,3u) : 0);
 }
 
 void N64Window::pass_input_to_core()
@@ -18,20 +22,20 @@ void N64Window::pass_input_to_core()
 void N64Window::core_quit()
 {
     //n64.mem.save_cart_ram();
-    exit(0);   
+    quit = true;
 }
 
 void N64Window::run_frame()
 {
     run(n64);
 
-    if(n64.size_change)
+    // the presenter picks up size changes from the frame itself
+    n64.size_change = false;
+
+    if(n64.rdp.frame_done)
     {
-        create_texture(n64.rdp.screen_x,n64.rdp.screen_y);
-        n64.size_change = false;
+        present(n64.rdp.screen,n64.rdp.screen_x,n64.rdp.screen_y);
     }
-
-    render(n64.rdp.screen.data());
 }
 
 void N64Window::debug_halt()
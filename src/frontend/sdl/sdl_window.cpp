@@ -107,10 +107,20 @@ void SDLMainWindow::init_sdl(u32 x, u32 y)
 	SDL_GL_SetSwapInterval(1);
 }
 
-void SDLMainWindow::render(const u32* data)
+void SDLMainWindow::present(std::vector<u32> &screen, u32 x, u32 y, bool keep)
 {
+	frames.publish(screen,x,y,keep);
+}
+
+void SDLMainWindow::render(const FrameMailbox::Frame &frame)
+{
+	if(s32(frame.x) != X || s32(frame.y) != Y)
+	{
+		create_texture(frame.x,frame.y);
+	}
+
     // do our screen blit
-    SDL_UpdateTexture(texture, NULL, data,  4 * X);
+    SDL_UpdateTexture(texture, NULL, frame.buf.data(),  4 * X);
     SDL_RenderCopy(renderer, texture, NULL, NULL);
     SDL_RenderPresent(renderer);    	
 }
@@ -137,77 +147,159 @@ SDLMainWindow::~SDLMainWindow()
 }
 
 
-void SDLMainWindow::main(std::string filename, b32 start_debug)
+void SDLMainWindow::emu_main(b32 start_debug)
 {
-	SDL_GL_SetSwapInterval(1);
+	try
+	{
+		FpsCounter fps_counter;
 
-	//constexpr uint32_t fps = 60; 
-	//constexpr uint32_t screen_ticks_per_frame = 1000 / fps;
-	//uint64_t next_time = current_time() + screen_ticks_per_frame;
-	init(filename);
+		UNUSED(start_debug);
+	#ifdef DEBUG
+		if(start_debug)
+		{
+			debug_halt();
+		}
+	#endif
 
-	FpsCounter fps_counter;
+		std::vector<emu_control> pending;
 
-	UNUSED(start_debug);
-#ifdef DEBUG
-	if(start_debug)
-	{
-		debug_halt();
-	}
-#endif
+		auto next_frame = std::chrono::steady_clock::now();
 
-    for(;;)
-    {
-		fps_counter.reading_start();
-		auto control = input.handle_input(window);
-		
-		pass_input_to_core();
+		for(;;)
+		{
+			fps_counter.reading_start();
+
+			{
+				std::scoped_lock lock(input_mutex);
+				pass_input_to_core();
+				std::swap(pending,controls);
+			}
 
+			run_frame();
 
+			for(const auto control : pending)
+			{
+				switch(control)
+				{
+					case emu_control::quit_t:
+					{
+						core_quit();
+						break;
+					}
+
+					case emu_control::throttle_t:
+					{
+						throttle_emu = true;
+						next_frame = std::chrono::steady_clock::now();
+						core_throttle();
+						break;
+					}
+
+					case emu_control::unbound_t:
+					{
+						throttle_emu = false;
+						core_unbound();
+						break;
+					}
+
+					case emu_control::break_t:
+					{
+						debug_halt();
+						break;
+					}
+
+					case emu_control::none_t: break;
+				}
+			}
 
-		run_frame();
+			pending.clear();
 
-		switch(control)
-		{
-			case emu_control::quit_t:
+			if(quit)
 			{
-				core_quit();
 				break;
 			}
 
-			case emu_control::throttle_t:
+			// audio only holds the core back while the device is open
+			// so pace frames here, falling behind resets the deadline rather than
+			// racing to catch up
+			if(throttle_emu)
 			{
-				//SDL_Delay(time_left(next_time));
-				SDL_GL_SetSwapInterval(1);
-				core_throttle();
-				break;
+				next_frame += FRAME_TIME;
+
+				const auto now = std::chrono::steady_clock::now();
+
+				if(next_frame > now)
+				{
+					std::this_thread::sleep_until(next_frame);
+				}
+
+				else
+				{
+					next_frame = now;
+				}
 			}
 
-			case emu_control::unbound_t:
+			fps_counter.reading_end();
+			fps = fps_counter.get_fps();
+
+			// we hit a breakpoint go back to the prompt
+			handle_debug();
+		}
+	}
+
+	catch(...)
+	{
+		emu_error = std::current_exception();
+	}
+
+	emu_stopped = true;
+}
+
+void SDLMainWindow::main(std::string filename, b32 start_debug)
+{
+	init(filename);
+
+	// vsync only holds up the presenter now
+	SDL_GL_SetSwapInterval(1);
+
+	std::thread emu_thread(&SDLMainWindow::emu_main,this,start_debug);
+
+    for(;;)
+    {
+		{
+			std::scoped_lock lock(input_mutex);
+			const auto control = input.handle_input(window);
+
+			if(control != emu_control::none_t)
 			{
-				//SDL_Delay(time_left(next_time) / 8);
-				SDL_GL_SetSwapInterval(0);
-				core_unbound();
-				break;
+				controls.push_back(control);
 			}
+		}
+
+		if(emu_stopped)
+		{
+			emu_thread.join();
 
-			case emu_control::break_t:
+			if(emu_error)
 			{
-				debug_halt();
-				break;
+				std::rethrow_exception(emu_error);
 			}
 
-			case emu_control::none_t: break;
+			return;
 		}
 
-		fps_counter.reading_end();
+		const auto frame = frames.acquire();
+
+		// nothing new to show
+		if(!frame)
+		{
+			SDL_Delay(1);
+			continue;
+		}
 
-		SDL_SetWindowTitle(window,fmt::format("albion: {}",fps_counter.get_fps()).c_str());
+		render(*frame);
 
-		//next_time = current_time() + screen_ticks_per_frame;
-		
-		// we hit a breakpoint go back to the prompt
-		handle_debug();
+		SDL_SetWindowTitle(window,fmt::format("albion: {}",fps.load()).c_str());
     }	
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 #ifdef FRONTEND_SDL
 #include <frontend/input.h>
+#include <albion/frame_mailbox.h>
 
 #define SDL_MAIN_HANDLED
 #ifdef _WIN32
@@ -32,7 +33,11 @@ protected:
 
     void init_sdl(u32 x, u32 y);
     void create_texture(u32 x, u32 y); 
-    void render(const u32* data);
+
+    // hand a finished frame to the presenter
+    // screen is swapped for a buffer from the mailbox, the next frame is drawn into that
+    // keep carries the frame over for cores that wont redraw all of the next one
+    void present(std::vector<u32> &screen, u32 x, u32 y, bool keep = false);
 
     // sdl gfx
 	SDL_Window * window = NULL;
@@ -43,7 +48,34 @@ protected:
 
     Input input;
 
-    b32 throttle_emu;       
+    // emulation thread holds each frame to FRAME_TIME when set
+    // cores without audio backpressure rely on this for their speed
+    b32 throttle_emu = true;
+
+    // set by core_quit, the emulation thread stops after the current frame
+    // and the main thread tears down sdl once it has joined it
+    b32 quit = false;
+
+private:
+    // emulation runs on its own thread so it never waits on vsync
+    // or texture uploads, the main thread handles sdl and presents frames
+    void emu_main(b32 start_debug);
+    void render(const FrameMailbox::Frame &frame);
+
+    // what vsync used to pace the emulation thread at
+    static constexpr auto FRAME_TIME = std::chrono::nanoseconds(1'000'000'000 / 60);
+
+    FrameMailbox frames;
+
+    // input and controls from the main thread, waiting for the next frame
+    std::mutex input_mutex;
+    std::vector<emu_control> controls;
+
+    std::atomic<u32> fps = 0;
+
+    // emulation thread has returned, emu_error is set if it threw
+    std::atomic<bool> emu_stopped = false;
+    std::exception_ptr emu_error;
 };
 
 
@@ -9,6 +9,7 @@ Apu::Apu(GB &gb) : scheduler(gb.scheduler)
 {
     // init our audio playback
     playback.init(freq_playback,2048);
+    mixer.init(4,sample_rate,freq_playback);
 }
 
 void Apu::init(gameboy_psg::psg_mode mode, bool use_bios) noexcept
@@ -20,6 +21,7 @@ void Apu::init(gameboy_psg::psg_mode mode, bool use_bios) noexcept
 
 	playback.start();
 
+    mixer.reset();
     down_sample_cnt = down_sample_lim;
 
     insert_new_sample_event(); 
@@ -81,7 +83,6 @@ void Apu::push_samples(u32 cycles) noexcept
 			return; 
 		}
 
-	
 
         float output[4];
         for(int i = 0; i < 4; i++)
@@ -89,38 +90,29 @@ void Apu::push_samples(u32 cycles) noexcept
             output[i] = static_cast<float>(psg.channels[i].output) / 100;
         }
 
-		const auto sound_select = psg.read_nr51();
-        const auto nr50 = psg.read_nr50();
-
-        // left output
-        float f0 = 0;
-        int volume = 16*((nr50 & 7)+1);
-        for(int i = 0; i < 4; i++)
+        // block is full, mix it and push our samples!
+        if(mixer.push(output))
         {
-            if(is_set(sound_select,i))
-            {
-                const float f1 = output[i];
-                playback.mix_samples(f0,f1,volume);
-            }            
-        }
-        const float left = f0;
+            update_mixer_gain();
 
-		// right output
-		f0 = 0.0f;
-        volume = 16*(((nr50 >> 4) & 7)+1);
-        for(int i = 0; i < 4; i++)
-        {
-            if(is_set(sound_select,i+4))
-            {
-                const float f1 = output[i];
-                playback.mix_samples(f0,f1,volume);
-            }            
+            const u32 frames = mixer.mix();
+            playback.push_samples(mixer.left(),mixer.right(),frames);
         }
-        const float right = f0;
+    }
+}
 
+// volumes are out of 128
+void Apu::update_mixer_gain() noexcept
+{
+    const auto sound_select = psg.read_nr51();
+    const auto nr50 = psg.read_nr50();
 
-        // push our samples!
-        playback.push_sample(left,right);
+    const float left = (16 * ((nr50 & 7) + 1)) / 128.0;
+    const float right = (16 * (((nr50 >> 4) & 7) + 1)) / 128.0;
+
+    for(int i = 0; i < 4; i++)
+    {
+        mixer.set_gain(i,is_set(sound_select,i) * left,is_set(sound_select,i + 4) * right);
     }
 }
 
@@ -0,0 +1,291 @@
+#include <gb/block_cache.h>
+
+namespace gameboy
+{
+
+// opcode length in bytes (cb counts as 2)
+constexpr u8 OPCODE_SIZE[256] =
+{
+    1,3,1,1,1,1,2,1,3,1,1,1,1,1,2,1, // 0x00
+    2,3,1,1,1,1,2,1,2,1,1,1,1,1,2,1, // 0x10
+    2,3,1,1,1,1,2,1,2,1,1,1,1,1,2,1, // 0x20
+    2,3,1,1,1,1,2,1,2,1,1,1,1,1,2,1, // 0x30
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x40
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x50
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x60
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x70
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x80
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x90
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0xa0
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0xb0
+    1,1,3,3,3,1,2,1,1,1,3,2,3,3,2,1, // 0xc0
+    1,1,3,1,3,1,2,1,1,1,3,1,3,1,2,1, // 0xd0
+    2,1,1,1,1,1,2,1,2,1,3,1,1,1,2,1, // 0xe0
+    2,1,1,1,1,1,2,1,2,1,3,1,1,1,2,1, // 0xf0
+};
+
+// does this opcode end a block
+// any jump, call, ret, rst, halt, stop, ei (executes the next instr itself)
+// and undefined opcodes
+constexpr bool opcode_ends_block(u8 opcode)
+{
+    switch(opcode)
+    {
+        case 0x10: case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+        case 0x76:
+        case 0xc0: case 0xc2: case 0xc3: case 0xc4: case 0xc7: case 0xc8:
+        case 0xc9: case 0xca: case 0xcc: case 0xcd: case 0xcf:
+        case 0xd0: case 0xd2: case 0xd3: case 0xd4: case 0xd7: case 0xd8:
+        case 0xd9: case 0xda: case 0xdb: case 0xdc: case 0xdd: case 0xdf:
+        case 0xe3: case 0xe4: case 0xe7: case 0xe9: case 0xeb: case 0xec:
+        case 0xed: case 0xef:
+        case 0xf4: case 0xf7: case 0xfb: case 0xfc: case 0xfd: case 0xff:
+        {
+            return true;
+        }
+
+        default: return false;
+    }
+}
+
+void BlockCache::init(u32 rom_size)
+{
+    const u32 rom_pages = (rom_size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+    wram_page = rom_pages;
+    hram_page = wram_page + WRAM_PAGES;
+
+    pages.clear();
+    pages.resize(hram_page + 1);
+
+    blocks.clear();
+    free_list.clear();
+
+    generation++;
+}
+
+void BlockCache::flush()
+{
+    for(u32 i = 0; i < pages.size(); i++)
+    {
+        flush_page(i);
+    }
+
+    generation++;
+}
+
+void BlockCache::flush_page(u32 page)
+{
+    auto &code_page = pages[page];
+
+    for(const u32 idx : code_page.blocks)
+    {
+        free_list.push_back(idx);
+    }
+
+    code_page.blocks.clear();
+    code_page.lookup.clear();
+    code_page.code_lines = 0;
+
+    generation++;
+}
+
+u32 BlockCache::alloc_block()
+{
+    if(free_list.size())
+    {
+        const u32 idx = free_list.back();
+        free_list.pop_back();
+        return idx;
+    }
+
+    blocks.push_back({});
+    return blocks.size() - 1;
+}
+
+// check a block for a loop that only polls memory waiting for something to change
+// anything that writes memory or the stack rules it out
+// registers are allowed to change, the cpu checks each pass is identical before skipping
+void BlockCache::detect_idle(Block &block, u32 offset, u16 pc, const u8 *code, u32 limit)
+{
+    u32 idx = offset;
+    block.idle_reads = 0;
+
+    for(u32 i = 0; i < block.len; i++)
+    {
+        const u8 opcode = code[idx];
+        const u32 size = OPCODE_SIZE[opcode];
+
+        if(idx + size > limit)
+        {
+            return;
+        }
+
+        // last instr must be a jump back to the start
+        if(i == block.len - 1)
+        {
+            const u16 addr = pc + (idx - offset);
+            u16 target = 0;
+
+            switch(opcode)
+            {
+                case 0x18: case 0x20: case 0x28: case 0x30: case 0x38:
+                {
+                    target = addr + 2 + s8(code[idx + 1]);
+                    break;
+                }
+
+                case 0xc2: case 0xc3: case 0xca: case 0xd2: case 0xda:
+                {
+                    target = code[idx + 1] | (code[idx + 2] << 8);
+                    break;
+                }
+
+                default: return;
+            }
+
+            if(target != pc)
+            {
+                return;
+            }
+
+            break;
+        }
+
+        std::optional<IdleRead> read = std::nullopt;
+
+        switch(opcode)
+        {
+            // nop, ld r, n, inc r, dec r, rotates on a, daa, cpl, scf, ccf
+            case 0x00:
+            case 0x04: case 0x05: case 0x06: case 0x07: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+            case 0x14: case 0x15: case 0x16: case 0x17: case 0x1c: case 0x1d: case 0x1e: case 0x1f:
+            case 0x24: case 0x25: case 0x26: case 0x27: case 0x2c: case 0x2d: case 0x2e: case 0x2f:
+            case 0x37: case 0x3c: case 0x3d: case 0x3e: case 0x3f:
+            // alu a, n
+            case 0xc6: case 0xce: case 0xd6: case 0xde: case 0xe6: case 0xee: case 0xf6: case 0xfe:
+            {
+                break;
+            }
+
+            case 0x0a: read = IdleRead{idle_src::bc,0}; break;
+            case 0x1a: read = IdleRead{idle_src::de,0}; break;
+
+            case 0xf0: read = IdleRead{idle_src::imm,u16(0xff00 | code[idx + 1])}; break;
+            case 0xf2: read = IdleRead{idle_src::c,0}; break;
+            case 0xfa: read = IdleRead{idle_src::imm,u16(code[idx + 1] | (code[idx + 2] << 8))}; break;
+
+            case 0xcb:
+            {
+                const u8 cb = code[idx + 1];
+
+                if((cb & 7) == 6)
+                {
+                    // only bit n, (hl) leaves memory alone
+                    if(cb < 0x40 || cb >= 0x80)
+                    {
+                        return;
+                    }
+
+                    read = IdleRead{idle_src::hl,0};
+                }
+                break;
+            }
+
+            default:
+            {
+                // ld r, r' (ld (hl), r writes and 0x76 is halt)
+                // and alu a, r
+                if(opcode >= 0x40 && opcode < 0xc0 && (opcode < 0x70 || opcode > 0x77))
+                {
+                    if((opcode & 7) == 6)
+                    {
+                        read = IdleRead{idle_src::hl,0};
+                    }
+                    break;
+                }
+
+                return;
+            }
+        }
+
+        if(read)
+        {
+            if(block.idle_reads == Block::IDLE_READ_MAX)
+            {
+                return;
+            }
+
+            block.idle_read[block.idle_reads++] = *read;
+        }
+
+        idx += size;
+    }
+
+    block.idle = true;
+}
+
+const Block& BlockCache::lookup(u32 page, u32 offset, u16 addr, const u8 *code, u32 limit, const EXEC_INSTR_FPTR *table)
+{
+    auto &code_page = pages[page];
+
+    // only allocate lookup for pages we actually execute from
+    if(!code_page.lookup.size())
+    {
+        code_page.lookup.resize(PAGE_SIZE,0);
+    }
+
+    const u32 cached = code_page.lookup[offset];
+
+    if(cached)
+    {
+        return blocks[cached - 1];
+    }
+
+    const u32 idx = alloc_block();
+    auto &block = blocks[idx];
+
+    block.len = 0;
+    block.idle = false;
+
+    u32 pc = offset;
+
+    while(block.len < Block::INSTR_MAX && pc < limit)
+    {
+        const u8 opcode = code[pc];
+
+        block.handler[block.len++] = table[opcode];
+        code_page.code_lines |= u64(1) << (pc >> LINE_SHIFT);
+
+        if(opcode_ends_block(opcode))
+        {
+            break;
+        }
+
+        pc += OPCODE_SIZE[opcode];
+    }
+
+    if(block.len && pc < limit && opcode_ends_block(code[pc]))
+    {
+        detect_idle(block,offset,addr,code,limit);
+    }
+
+    // operands decide what an idle loop reads
+    // so a write to any of its bytes has to flush it
+    if(block.idle)
+    {
+        const u32 end = std::min(pc + OPCODE_SIZE[code[pc]],limit);
+
+        for(u32 i = offset; i < end; i++)
+        {
+            code_page.code_lines |= u64(1) << (i >> LINE_SHIFT);
+        }
+    }
+
+    code_page.blocks.push_back(idx);
+    code_page.lookup[offset] = idx + 1;
+
+    return block;
+}
+
+}
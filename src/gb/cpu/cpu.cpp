@@ -22,6 +22,10 @@ void Cpu::init(bool use_bios)
 
 	is_cgb = mem.rom_cgb_enabled();
 	is_sgb = mem.rom_sgb_enabled();
+
+	block_cache.init(mem.rom.size());
+	idle_loop.valid = false;
+	idle_cycles_skipped = 0;
 	//is_cgb = false;
 
 	// setup regs to skip the bios
@@ -22,6 +22,20 @@ void Cpu::exec_instr_debug()
 	}
 	exec_instr_no_debug();
 }
+
+void Cpu::exec_block_debug()
+{
+	// breakpoints have to be checked on every instr
+	if(debug.breakpoints_enabled || debug.watchpoints_enabled)
+	{
+		exec_instr_debug();
+	}
+
+	else
+	{
+		exec_block();
+	}
+}
 #endif
 
 
@@ -881,7 +895,7 @@ void Cpu::ei()
 		// caller will check opcode and handle it
 		instr_side_effect = instr_state::ei;
 
-		exec_instr(); 
+		step_instr(); 
 	}
 
 	// if last instr was a di we should not enable
@@ -1029,6 +1043,212 @@ void Cpu::exec_instr_no_debug()
 	std::invoke(opcode_table[opcode],this);
 }
 
+// find which host page we are running code from
+bool Cpu::block_page(u16 addr, u32 &page, const u8* &code, u32 &limit) const noexcept
+{
+	const u32 idx = (addr & 0xf000) >> 12;
+	const u8 *ptr = mem.page_table[idx];
+
+	limit = BlockCache::PAGE_SIZE;
+
+	switch(idx)
+	{
+		// rom, keyed on the bank that is mapped
+		case 0x0: case 0x1: case 0x2: case 0x3:
+		case 0x4: case 0x5: case 0x6: case 0x7:
+		{
+			if(!ptr)
+			{
+				return false;
+			}
+
+			code = ptr;
+			page = (ptr - mem.rom.data()) / BlockCache::PAGE_SIZE;
+			return true;
+		}
+
+		case 0xc:
+		{
+			if(!ptr)
+			{
+				return false;
+			}
+
+			code = ptr;
+			page = block_cache.wram_page;
+			return true;
+		}
+
+		// only cache the bank writes will invalidate
+		case 0xd:
+		{
+			if(ptr != mem.cgb_wram_bank[mem.cgb_wram_bank_idx].data())
+			{
+				return false;
+			}
+
+			code = ptr;
+			page = block_cache.wram_page + 1 + mem.cgb_wram_bank_idx;
+			return true;
+		}
+
+		// hram (ie is never cached)
+		case 0xf:
+		{
+			if(addr < 0xff80 || addr == 0xffff)
+			{
+				return false;
+			}
+
+			code = &mem.io[0x80];
+			page = block_cache.hram_page;
+			limit = 0x7f;
+			return true;
+		}
+
+		// echo ram, vram and cart ram are rarely executed from
+		default: return false;
+	}
+}
+
+void Cpu::exec_block()
+{
+	u32 page;
+	const u8 *code;
+	u32 limit;
+
+	if(halt_bug || !block_page(pc,page,code,limit))
+	{
+		idle_loop.valid = false;
+		exec_instr_no_debug();
+		return;
+	}
+
+	const u16 start_pc = pc;
+	const u32 offset = pc < 0xff80? pc & 0xfff : pc - 0xff80;
+	const auto &block = block_cache.lookup(page,offset,pc,code,limit,opcode_table);
+	const u32 generation = block_cache.generation;
+
+	for(u32 i = 0; i < block.len; i++)
+	{
+		// same timing as fetch_opcode
+		cycle_tick_t(2);
+		scheduler.service_events();
+		const bool fired = interrupt_fire;
+		cycle_tick_t(2);
+		scheduler.service_events();
+
+		if(fired)
+		{
+			idle_loop.valid = false;
+			oam_bug_write(pc);
+			do_interrupts();
+
+			// have to re fetch the opcode this costs a cycle
+			const auto opcode = mem.read_memt(pc++);
+			std::invoke(opcode_table[opcode],this);
+			return;
+		}
+
+		pc++;
+		std::invoke(block.handler[i],this);
+
+		// memory map or code has changed under us
+		// or the frame is done
+		if(generation != block_cache.generation || ppu.new_vblank)
+		{
+			idle_loop.valid = false;
+			return;
+		}
+	}
+
+	if(block.idle && pc == start_pc)
+	{
+		check_idle_loop(block,start_pc);
+	}
+
+	else
+	{
+		idle_loop.valid = false;
+	}
+}
+
+bool Cpu::idle_read_safe(const Block &block) const noexcept
+{
+	for(u32 i = 0; i < block.idle_reads; i++)
+	{
+		const auto &read = block.idle_read[i];
+		u16 addr = 0;
+
+		switch(read.src)
+		{
+			case idle_src::imm: addr = read.addr; break;
+			case idle_src::bc: addr = bc; break;
+			case idle_src::de: addr = de; break;
+			case idle_src::hl: addr = hl; break;
+			case idle_src::c: addr = 0xff00 | read_c(); break;
+		}
+
+		// these change without an event firing or have side effects on read
+		// cart ram (rtc), oam (oam bug), timers (div) and sound (wave ram)
+		if((addr >= 0xa000 && addr < 0xc000) || (addr >= 0xfe00 && addr < 0xff00)
+			|| (addr >= 0xff04 && addr <= 0xff07) || (addr >= 0xff10 && addr < 0xff40))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void Cpu::check_idle_loop(const Block &block, u16 start_pc)
+{
+	const u64 timestamp = scheduler.get_timestamp();
+	const u64 next_event = timestamp + scheduler.get_next_event_cycles();
+
+	IdleState state;
+	state.valid = true;
+	state.pc = start_pc;
+	state.generation = block_cache.generation;
+	state.a = a;
+	state.f = read_f();
+	state.bc = bc;
+	state.de = de;
+	state.hl = hl;
+	state.sp = sp;
+	state.timestamp = timestamp;
+	state.next_event = next_event;
+
+	const auto &last = idle_loop;
+
+	// last pass saw no events and left every register how it found it
+	// so each pass from now until the next event will do the exact same thing
+	const bool same = last.valid && last.pc == state.pc && last.generation == state.generation
+		&& last.a == state.a && last.f == state.f && last.bc == state.bc && last.de == state.de
+		&& last.hl == state.hl && last.sp == state.sp && last.next_event == state.next_event;
+
+	if(same && !ppu.emulate_pixel_fifo && !interrupt_fire && scheduler.size()
+		&& next_event > timestamp && idle_read_safe(block))
+	{
+		const u64 loop_cycles = timestamp - last.timestamp;
+
+		// only skip passes that end before the event so it still fires
+		// at the same point in the loop
+		const u64 passes = (next_event - timestamp - 1) / loop_cycles;
+
+		if(passes)
+		{
+			const u64 cycles = passes * loop_cycles;
+			cycle_tick_t(cycles);
+
+			idle_cycles_skipped += cycles;
+			state.timestamp = scheduler.get_timestamp();
+		}
+	}
+
+	idle_loop = state;
+}
+
 
 
 
@@ -27,6 +27,7 @@ void GB::reset(std::string rom_name, bool with_rom, bool use_bios)
 
 	apu.init(mode,use_bios);
 	throttle_emu = true;
+	rewind.clear();
 	if(use_bios)
 	{
 		mem.bios_enable();
@@ -58,11 +59,7 @@ try
 	}
 
 
-	cpu.save_state(fp);
-	mem.save_state(fp);
-	ppu.save_state(fp);
-	apu.save_state(fp);
-	scheduler.save_state(fp);
+	save_state(fp);
 
 	fp.close();
 }
@@ -88,25 +85,93 @@ try
 		throw std::runtime_error("could not open file");
 	}
 
+	load_state(fp);
+
+	fp.close();
+}
+
+
+catch(std::exception &ex)
+{
+	// put system back into a safe state
+	reset("",false,false);
+	std::string err = fmt::format("failed to load state: {}",ex.what());
+	debug.write_logger(err);
+	throw std::runtime_error(err);
+}
+
+}
+
+void GB::save_state(std::ofstream &fp)
+{
+	cpu.save_state(fp);
+	mem.save_state(fp);
+	ppu.save_state(fp);
+	apu.save_state(fp);
+	scheduler.save_state(fp);
+}
+
+void GB::load_state(std::ifstream &fp)
+{
 	cpu.load_state(fp);
 	mem.load_state(fp);
 	ppu.load_state(fp);
 	apu.load_state(fp);
 	scheduler.load_state(fp);
 
-	fp.close();
+	// memory has been replaced wholesale
+	cpu.block_cache.flush();
+}
+
+void GB::save_snapshot(Snapshot &snap)
+{
+	save_state(snap.begin_write());
 }
 
+void GB::load_snapshot(Snapshot &snap)
+{
+try
+{
+	load_state(snap.begin_read());
+}
 
 catch(std::exception &ex)
 {
 	// put system back into a safe state
 	reset("",false,false);
-	std::string err = fmt::format("failed to load state: {}",ex.what());
+	std::string err = fmt::format("failed to load snapshot: {}",ex.what());
 	debug.write_logger(err);
 	throw std::runtime_error(err);
 }
+}
 
+void GB::enable_rewind(u32 seconds)
+{
+	// one snapshot per frame, a keyframe every second
+	rewind.init(seconds * 60,60);
+}
+
+// state at the start of each frame
+// so popping it steps back a whole frame
+void GB::record_rewind()
+{
+	if(rewind.enabled())
+	{
+		save_snapshot(rewind_snapshot);
+		rewind.push(rewind_snapshot.arena);
+	}
+}
+
+// step back to the start of the last frame run
+bool GB::rewind_frame()
+{
+	if(!rewind.pop(rewind_snapshot.arena))
+	{
+		return false;
+	}
+
+	load_snapshot(rewind_snapshot);
+	return true;
 }
 
 void GB::handle_input(Controller& controller)
@@ -199,6 +264,8 @@ void GB::run()
 		return;
 	}
 
+	record_rewind();
+
 	// break out early if we have hit a debug event
 	while(!ppu.new_vblank) 
     {
@@ -209,6 +276,8 @@ void GB::run()
 		}
 	}
 #else 
+	record_rewind();
+
 	while(!ppu.new_vblank) // exec until a vblank hits
 	{
 		cpu.exec_instr();
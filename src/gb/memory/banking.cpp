@@ -1,4 +1,5 @@
 #include <gb/memory.h>
+#include <gb/cpu.h>
 
 namespace gameboy
 {
@@ -289,6 +290,8 @@ void Memory::update_page_table_bank()
 	{
 		page_table[i] = &rom[(cart_rom_bank * 0x4000) + ((i-4) * 0x1000)];
 	}
+
+	cpu.block_cache.remap();
 }
 
 void Memory::update_page_table_sram()
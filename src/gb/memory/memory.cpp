@@ -441,6 +441,9 @@ void Memory::raw_write_word(u16 addr, u16 v) noexcept
 
 void Memory::raw_write(u16 addr, u8 v) noexcept
 {
+	// debugger can write anywhere including rom
+	cpu.block_cache.flush();
+
 	switch((addr & 0xf000) >> 12)
 	{
 		// bank zero
@@ -461,6 +464,7 @@ void Memory::raw_write(u16 addr, u8 v) noexcept
 		case 8: case 9: 
 		{
 			vram[vram_bank][addr & 0x1fff] = v;
+			ppu.invalidate_tile(vram_bank,addr);
 			break;
 		}
 
@@ -1309,6 +1313,7 @@ void Memory::write_vram(u16 addr,u8 v) noexcept
     if(ppu.get_mode() != ppu_mode::pixel_transfer)
     {
         vram[vram_bank][addr & 0x1fff] = v;
+        ppu.invalidate_tile(vram_bank,addr);
     }
 }
 
@@ -1453,6 +1458,7 @@ void Memory::oam_dma_enable() noexcept
 	{
 		page_table[i] = nullptr;
 	}
+	cpu.block_cache.remap();
 
 }
 
@@ -1867,6 +1873,7 @@ void Memory::write_io(u16 addr,u8 v) noexcept
 				
 				io[IO_SVBK] = v | 248;
 				page_table[0xd] = &cgb_wram_bank[cgb_wram_bank_idx][0];
+				cpu.block_cache.remap();
 			}
 			
 			else
@@ -2245,6 +2252,11 @@ void Memory::write_io(u16 addr,u8 v) noexcept
         default: // hram
         {
             io[addr & 0xff] = v;
+
+            if(addr >= 0xff80)
+            {
+                cpu.block_cache.write_hram(addr - 0xff80);
+            }
             return;
         }
     }
@@ -2344,6 +2356,7 @@ void Memory::write_iot_no_debug(u16 addr,u8 v) noexcept
 void Memory::write_wram_low(u16 addr,u8 v) noexcept
 {
     wram[addr&0xfff] = v;
+    cpu.block_cache.write_wram(0,addr & 0xfff);
 }
 
 // banked wram 0xd000 - 0xe000
@@ -2351,6 +2364,7 @@ void Memory::write_wram_low(u16 addr,u8 v) noexcept
 void Memory::write_wram_high(u16 addr,u8 v) noexcept
 {
     cgb_wram_bank[cgb_wram_bank_idx][addr&0xfff] = v;
+    cpu.block_cache.write_wram(1 + cgb_wram_bank_idx,addr & 0xfff);
 }
 
 // high ram 0xf000
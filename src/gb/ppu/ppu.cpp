@@ -55,6 +55,8 @@ void Ppu::init() noexcept
 
 	glitched_oam_mode = false;
 
+	invalidate_tile_cache();
+
 	memset(bg_pal,0x00,sizeof(bg_pal)); // bg palette data
 	memset(sp_pal,0x00,sizeof(sp_pal)); // sprite pallete data 
 
@@ -39,6 +39,9 @@ void Ppu::save_state(std::ofstream &fp)
 
 void Ppu::load_state(std::ifstream &fp)
 {
+    // vram has been replaced by the memory state
+    invalidate_tile_cache();
+
     file_read_vec(fp,screen);
     file_read_var(fp,current_line);
     if(current_line > 153)
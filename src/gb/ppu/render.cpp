@@ -429,10 +429,9 @@ u32 Ppu::get_cgb_color(int color_num, int cgb_pal, pixel_source source) const no
 
 
 
-// considering taking copies and threading this
-void Ppu::render_scanline() noexcept
+// returns false if the line should not be drawn
+bool Ppu::apply_sgb_mask() noexcept
 {
-
 	// SGB: approximate mask_en only on scanline renderer
 	switch(mask_en)
 	{
@@ -440,7 +439,7 @@ void Ppu::render_scanline() noexcept
 		case mask_mode::cancel: break;
 
 		// TODO: this wont play nice on castlevania
-		case mask_mode::freeze: return;
+		case mask_mode::freeze: return false;
 		// assume white
 		case mask_mode::clear: 
 		{
@@ -461,6 +460,17 @@ void Ppu::render_scanline() noexcept
 		}	
 	}
 
+	return true;
+}
+
+// per pixel scanline renderer
+// kept as a reference for the compositor in scanline.cpp
+void Ppu::render_scanline_reference() noexcept
+{
+	if(!apply_sgb_mask())
+	{
+		return;
+	}
 
 
 	// is the window drawn on this line?
@@ -0,0 +1,334 @@
+#include <gb/gb.h>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace gameboy
+{
+
+// scanline compositor
+// same output as render_scanline_reference but tile lines come whole
+// out of the tile cache and colours are resolved through a per line lut
+
+// sources in the line buffer, the low two bits match pixel_source
+// so they can index the dmg palettes directly
+static constexpr u8 LINE_TILE = 0;
+static constexpr u8 LINE_SPRITE_ZERO = 1;
+static constexpr u8 LINE_SPRITE_ONE = 2;
+static constexpr u8 LINE_TILE_CGBD = 4;
+
+// mirrors tile_fetch, see it for the details
+void Ppu::line_tile_fetch(u32 dst, bool use_window) noexcept
+{
+	const bool is_cgb = cpu.is_cgb;
+	const u8 lcd_control = mem.io[IO_LCDC];
+
+	use_window = use_window && is_set(lcd_control,5);
+
+	// bg disabled on dmg, these pixels are colour 0
+	if(!is_cgb && !is_set(lcd_control,0))
+	{
+		memset(&line_buf.colour[dst],0,8);
+		memset(&line_buf.pal[dst],0,8);
+		memset(&line_buf.source[dst],LINE_TILE,8);
+		return;
+	}
+
+	u8 x_pos = tile_cord;
+	u8 y_pos = current_line;
+
+	u32 background_mem = 0;
+
+	if(!use_window)
+	{
+		background_mem = is_set(lcd_control,3) ? 0x1c00 : 0x1800;
+		y_pos += mem.io[IO_SCY];
+		x_pos += mem.io[IO_SCX];
+	}
+
+	else
+	{
+		background_mem = is_set(lcd_control,6) ? 0x1c00 : 0x1800;
+		y_pos = window_y_line;
+		x_pos = window_x_line;
+
+		window_x_line += 8;
+	}
+
+	const u32 tile_row = ((y_pos / 8) & 31) * 32;
+	const u32 tile_col = (x_pos / 8) & 31;
+	const u32 tile_address = background_mem + tile_row + tile_col;
+
+	const u8 tile_num = mem.vram[0][tile_address];
+	const u32 tile = is_set(lcd_control,4)? tile_num : 256 + s8(tile_num);
+
+	u8 cgb_pal = 0;
+	u8 source = LINE_TILE;
+	bool x_flip = false;
+	bool y_flip = false;
+	u32 vram_bank = 0;
+
+	if(is_cgb)
+	{
+		const u8 attr = mem.vram[1][tile_address];
+		cgb_pal = attr & 0x7;
+		source = is_set(attr,7)? LINE_TILE_CGBD : LINE_TILE;
+		x_flip = is_set(attr,5);
+		y_flip = is_set(attr,6);
+		vram_bank = is_set(attr,3);
+	}
+
+	y_pos &= 7;
+	const u32 line = y_flip? 7 - y_pos : y_pos;
+
+	const u64 colour = get_tile_line(vram_bank,tile,line,x_flip);
+
+	memcpy(&line_buf.colour[dst],&colour,sizeof(colour));
+	memset(&line_buf.pal[dst],cgb_pal,8);
+	memset(&line_buf.source[dst],source,8);
+}
+
+// mirrors the scanline half of sprite_fetch
+// each sprite line is read whole from the tile cache and merged with a per pixel mask
+void Ppu::line_sprite_fetch(u32 dst) noexcept
+{
+	const bool is_cgb = cpu.is_cgb;
+	const u8 lcd_control = mem.io[IO_LCDC];
+
+	const int y_size = is_set(lcd_control,2) ? 16 : 8;
+	const int scanline = current_line;
+
+	// in cgb if lcdc bit 0 is deset sprites draw over anything
+	const bool draw_over_everything = !is_set(lcd_control,0) && is_cgb;
+
+	for(size_t i = cur_sprite; i < no_sprites; i++)
+	{
+		u32 pixel_start = 7;
+		u8 x_pos = objects[cur_sprite].x_pos;
+
+		if(x_pos >= SCREEN_WIDTH+8)
+		{
+			continue;
+		}
+
+		if(x_pos < 8)
+		{
+			pixel_start = x_pos;
+			x_pos = 0;
+		}
+
+		else
+		{
+			x_pos -= 8;
+		}
+
+		const u16 sprite_index = objects[i].index;
+		u8 y_pos = mem.oam[sprite_index];
+		const u8 sprite_location = y_size == 16? mem.oam[(sprite_index+2)] & ~1 : mem.oam[(sprite_index+2)];
+		const u8 attributes = mem.oam[(sprite_index+3)];
+
+		const bool y_flip = is_set(attributes,6);
+		const bool x_flip = is_set(attributes,5);
+
+		if(!( scanline -(y_size - 16) < y_pos  && scanline + 16 >= y_pos ))
+		{
+			continue;
+		}
+
+		y_pos -= 16;
+		u8 line = scanline - y_pos;
+
+		if(y_flip)
+		{
+			line = y_size - (line + 1);
+		}
+
+		// 16 high sprites run into the next tile
+		const u32 tile = sprite_location + (line / 8);
+		const u32 vram_bank = (is_cgb && is_set(attributes,3))? 1 : 0;
+
+		u8 sprite_colour[8];
+		const u64 colour = get_tile_line(vram_bank,tile,line & 7,x_flip);
+		memcpy(sprite_colour,&colour,sizeof(colour));
+
+		// partially offscreen sprites start part way into the tile
+		const u8 *src_colour = &sprite_colour[7 - pixel_start];
+
+		const u8 source = is_set(attributes,4)? LINE_SPRITE_ONE : LINE_SPRITE_ZERO;
+		const u8 pal = attributes & 0x7;
+		const u8 sprite_idx = cur_sprite;
+
+		// oam priority bit, tile is drawn above the sprite
+		const bool behind_bg = is_set(objects[sprite_idx].attr,7);
+
+		// sprites already drawn with a higher priority
+		bool higher_priority[10];
+
+		for(u32 s = 0; s < 10; s++)
+		{
+			higher_priority[s] = objects[s].priority < i;
+		}
+
+		u8 *colour_line = &line_buf.colour[dst + x_pos];
+		u8 *source_line = &line_buf.source[dst + x_pos];
+		u8 *pal_line = &line_buf.pal[dst + x_pos];
+		u8 *sprite_line = &line_buf.sprite_idx[dst + x_pos];
+
+		for(u32 x = 0; x <= pixel_start; x++)
+		{
+			const u8 c = src_colour[x];
+			const u8 old_colour = colour_line[x];
+			const u8 old_source = source_line[x];
+
+			const bool is_tile = old_source == LINE_TILE || old_source == LINE_TILE_CGBD;
+
+			const bool beat_tile = draw_over_everything || old_colour == 0
+				|| (old_source != LINE_TILE_CGBD && !behind_bg);
+
+			const bool beat_sprite = !(higher_priority[sprite_line[x]] && old_colour != 0);
+
+			const bool win = c != 0 && (is_tile? beat_tile : beat_sprite);
+
+			colour_line[x] = win? c : old_colour;
+			source_line[x] = win? source : old_source;
+			pal_line[x] = win? pal : pal_line[x];
+			sprite_line[x] = win? sprite_idx : sprite_line[x];
+		}
+
+		cur_sprite += 1;
+	}
+}
+
+// turn the line buffer into screen colours
+// lut idx is colour | source << 2 | pal << 4
+void Ppu::line_resolve(u32 src) noexcept
+{
+	alignas(32) u32 lut[128];
+
+	if(cpu.is_cgb)
+	{
+		for(u32 pal = 0; pal < 8; pal++)
+		{
+			for(u32 colour = 0; colour < 4; colour++)
+			{
+				const u32 bg = get_cgb_color(colour,pal,pixel_source::tile);
+				const u32 sp = get_cgb_color(colour,pal,pixel_source::sprite_zero);
+
+				lut[(pal << 4) | (LINE_TILE << 2) | colour] = bg;
+				lut[(pal << 4) | (LINE_SPRITE_ZERO << 2) | colour] = sp;
+				lut[(pal << 4) | (LINE_SPRITE_ONE << 2) | colour] = sp;
+				lut[(pal << 4) | (3 << 2) | colour] = bg;
+			}
+		}
+	}
+
+	else
+	{
+		u32 dmg[4][4];
+
+		for(u32 colour = 0; colour < 4; colour++)
+		{
+			dmg[LINE_TILE][colour] = get_dmg_color(colour,pixel_source::tile);
+			dmg[LINE_SPRITE_ZERO][colour] = get_dmg_color(colour,pixel_source::sprite_zero);
+			dmg[LINE_SPRITE_ONE][colour] = get_dmg_color(colour,pixel_source::sprite_one);
+			dmg[3][colour] = dmg[LINE_TILE][colour];
+		}
+
+		// pal is unused in dmg, just repeat it
+		for(u32 pal = 0; pal < 8; pal++)
+		{
+			memcpy(&lut[pal << 4],dmg,sizeof(dmg));
+		}
+	}
+
+	const u8 *colour = &line_buf.colour[src];
+	const u8 *source = &line_buf.source[src];
+	const u8 *pal = &line_buf.pal[src];
+	u32 *out = &screen[current_line * SCREEN_WIDTH];
+
+#ifdef __AVX2__
+	const __m128i source_mask = _mm_set1_epi8(3);
+
+	static_assert(SCREEN_WIDTH % 16 == 0);
+
+	for(u32 x = 0; x < SCREEN_WIDTH; x += 16)
+	{
+		const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&colour[x]));
+		const __m128i s = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[x])),source_mask);
+		const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pal[x]));
+
+		// values are small enough that the 16 bit shifts never cross a byte
+		const __m128i idx = _mm_or_si128(c,_mm_or_si128(_mm_slli_epi16(s,2),_mm_slli_epi16(p,4)));
+
+		const __m256i idx_lo = _mm256_cvtepu8_epi32(idx);
+		const __m256i idx_hi = _mm256_cvtepu8_epi32(_mm_srli_si128(idx,8));
+
+		const __m256i col_lo = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut),idx_lo,4);
+		const __m256i col_hi = _mm256_i32gather_epi32(reinterpret_cast<const int*>(lut),idx_hi,4);
+
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[x]),col_lo);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(&out[x + 8]),col_hi);
+	}
+#else
+	for(u32 x = 0; x < SCREEN_WIDTH; x++)
+	{
+		out[x] = lut[colour[x] | ((source[x] & 3) << 2) | (pal[x] << 4)];
+	}
+#endif
+}
+
+void Ppu::render_scanline() noexcept
+{
+	if(reference_renderer)
+	{
+		render_scanline_reference();
+		return;
+	}
+
+	if(!apply_sgb_mask())
+	{
+		return;
+	}
+
+	// is the window drawn on this line?
+	const bool window_rendered = mem.io[IO_WX] <= 166 &&
+		window_y_triggered && is_set(mem.io[IO_LCDC],5);
+
+	window_x_triggered = window_rendered;
+
+	const u32 scx_offset = mem.io[IO_SCX] & 0x7;
+
+	if(!window_rendered)
+	{
+		for(tile_cord = 0; tile_cord < 176; tile_cord += 8)
+		{
+			line_tile_fetch(tile_cord,false);
+		}
+	}
+
+	else
+	{
+		// draw up to the window and then start re rendering from it
+		for(tile_cord = 0; tile_cord < mem.io[IO_WX]; tile_cord += 8)
+		{
+			line_tile_fetch(tile_cord,false);
+		}
+
+		const u8 win_offset = mem.io[IO_WX] < 7? 0 : mem.io[IO_WX] - 7;
+
+		for(tile_cord = win_offset; tile_cord < 176; tile_cord += 8)
+		{
+			line_tile_fetch(tile_cord+scx_offset,true);
+		}
+	}
+
+	if(is_set(mem.io[IO_LCDC],1))
+	{
+		line_sprite_fetch(scx_offset);
+	}
+
+	line_resolve(scx_offset);
+}
+
+}
@@ -0,0 +1,92 @@
+#include <gb/gb.h>
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace gameboy
+{
+
+// decoded tile cache
+// tile data only changes on vram writes so each tile is decoded once
+// and the renderers read whole lines of colour ids out of here
+
+#ifndef __BMI2__
+// byte i holds bit 7 - i of the plane
+constexpr std::array<u64,256> gen_plane_lut()
+{
+	std::array<u64,256> lut{};
+
+	for(u32 v = 0; v < 256; v++)
+	{
+		u64 bits = 0;
+
+		for(u32 i = 0; i < 8; i++)
+		{
+			bits |= u64((v >> (7 - i)) & 1) << (i * 8);
+		}
+
+		lut[v] = bits;
+	}
+
+	return lut;
+}
+
+static constexpr auto PLANE_LUT = gen_plane_lut();
+#endif
+
+static inline u64 expand_plane(u8 v) noexcept
+{
+#ifdef __BMI2__
+	return __builtin_bswap64(_pdep_u64(v,0x0101010101010101));
+#else
+	return PLANE_LUT[v];
+#endif
+}
+
+// colour ids for a line of a tile, one per byte with the leftmost pixel first
+static inline u64 decode_tile_line(u8 data1, u8 data2) noexcept
+{
+	return expand_plane(data1) | (expand_plane(data2) << 1);
+}
+
+void Ppu::invalidate_tile(u32 bank, u16 addr) noexcept
+{
+	addr &= 0x1fff;
+
+	// tile maps are not cached
+	if(addr < TileCache::TILES * 16)
+	{
+		tile_cache.dirty[bank][addr / 16] = true;
+	}
+}
+
+void Ppu::invalidate_tile_cache() noexcept
+{
+	for(auto &bank : tile_cache.dirty)
+	{
+		std::fill(std::begin(bank),std::end(bank),true);
+	}
+}
+
+u64 Ppu::get_tile_line(u32 bank, u32 tile, u32 y, bool x_flip) noexcept
+{
+	if(tile_cache.dirty[bank][tile])
+	{
+		const u8 *data = &mem.vram[bank][tile * 16];
+
+		for(u32 i = 0; i < 8; i++)
+		{
+			tile_cache.line[bank][tile][i] = decode_tile_line(data[i * 2],data[(i * 2) + 1]);
+		}
+
+		tile_cache.dirty[bank][tile] = false;
+	}
+
+	const u64 line = tile_cache.line[bank][tile][y];
+
+	// reversing the bytes mirrors the line
+	return x_flip? __builtin_bswap64(line) : line;
+}
+
+}
@@ -27,19 +27,17 @@ std::vector<u32> Ppu::render_bg(bool higher) noexcept
 		{
 			const int bg_location =  background_mem + ((tile_y*32)+tile_x);
 
-			int tile_location;
+			int tile;
 
 			// tile number is allways bank 0
 			if(is_set(lcd_control,4)) // unsigned
 			{
-				const auto tile_num =  mem.vram[0][bg_location];
-				tile_location = tile_num * 16;
+				tile = mem.vram[0][bg_location];
 			}
 			
 			else // signed tile index 0x1000 is used as base pointer relative to start of vram
 			{
-				const auto tile_num = static_cast<int8_t>(mem.vram[0][bg_location]);
-				tile_location = 0x1000 + (tile_num * 16);
+				tile = 256 + static_cast<int8_t>(mem.vram[0][bg_location]);
 			}
 
 
@@ -75,26 +73,16 @@ std::vector<u32> Ppu::render_bg(bool higher) noexcept
 			for(int y = 0; y < 8; y++)
 			{
 
-				const int line = y_flip? (7 - y) * 2 : y*2;
+				const int line = y_flip? 7 - y : y;
 
-				// 2 bytes per line in vram
-				u16 data_address = tile_location + line;
-
-				const u8 data1 = mem.vram[vram_bank][data_address];
-				const u8 data2 = mem.vram[vram_bank][data_address+1];
-
-
-				int color_bit = x_flip? 0 : 7;
-				
-				const int shift = x_flip ? 1 : -1;
+				u8 colour[8];
+				const u64 colour_line = get_tile_line(vram_bank,tile,line,x_flip);
+				memcpy(colour,&colour_line,sizeof(colour));
 
 				// for each pixel in the line of the tile
-				for(int x = 0; x < 8; x++, color_bit += shift)
+				for(int x = 0; x < 8; x++)
 				{
-
-					// rest same as tiles
-					int color_num = is_set(data2,color_bit) << 1;
-					color_num |= is_set(data1,color_bit);
+					const int color_num = colour[x];
 
 					if(!is_cgb)
 					{
@@ -201,24 +189,15 @@ std::vector<u32> Ppu::render_tiles() noexcept
 				for(int y = 0; y < 8; y++)
 				{
 
-					// 2 bytes per line in vram
-					const u16 data_address = (tile_num * 16) + (y * 2);
-
-					const u8 data1 = mem.vram[bank][data_address];
-					const u8 data2 = mem.vram[bank][data_address+1];
+					u8 colour[8];
+					const u64 colour_line = get_tile_line(bank,tile_num,y,false);
+					memcpy(colour,&colour_line,sizeof(colour));
 
 					// for each pixel in the line of the tile
-					for(int x = 7; x >= 0; x--)
+					for(int x = 0; x < 8; x++)
 					{
-
-						// rest same as tiles
-						int color_num = is_set(data2,x) << 1;
-						color_num |= is_set(data1,x);
-
-
-						const u32 full_color = get_dmg_color(color_num,pixel_source::tile);
-						tiles[buf_offset + (y * 0x80 * 2) + (7-x)] = full_color;
-										
+						const u32 full_color = get_dmg_color(colour[x],pixel_source::tile);
+						tiles[buf_offset + (y * 0x80 * 2) + x] = full_color;
 					}
 				}		
 			}
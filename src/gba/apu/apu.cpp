@@ -5,7 +5,8 @@ namespace gameboyadvance
 
 Apu::Apu(GBA &gba) : mem(gba.mem), cpu(gba.cpu), scheduler(gba.scheduler)
 {
-    playback.init(44100,sample_size);
+    playback.init(freq_playback,sample_size);
+    mixer.init(MIXER_CHANNELS,sample_rate,freq_playback);
 }
 
 void Apu::init()
@@ -14,8 +15,8 @@ void Apu::init()
 
     // sound is broken?
 	playback.start();
-    audio_buf_idx = 0;
-    down_sample_cnt = (16 * 1024 * 1024) / 44100;
+    mixer.reset();
+    down_sample_cnt = sample_cycles;
     dma_a_sample = 0;
     dma_b_sample = 0;
 
@@ -87,7 +88,7 @@ void Apu::insert_new_sample_event()
 }
 
 
-// down sample it first
+// sample every channel at the mixer rate
 // shoud sample at 16mhz / sample rate in sound bias
 void Apu::push_samples(int cycles)
 {
@@ -100,7 +101,7 @@ void Apu::push_samples(int cycles)
 
     else
     {
-        down_sample_cnt = ((16 * 1024 * 1024) / 44100);
+        down_sample_cnt = sample_cycles;
         insert_new_sample_event();
     }
 
@@ -110,89 +111,46 @@ void Apu::push_samples(int cycles)
         return; 
     }
 
-    
-    //printf("%d:%d\n",dma_a_sample,dma_b_sample);
-    
-    // volume calc
-    // (this is nice and jank and doesent handle the output properly but just roll with it for a sec)
-    // (also the audio on the one rom that works is earbleeding cause it doesent run the rom at the correct speed)
-    // (this code also aint checking if the channels are enabled)
-    // we also need to handle soundbias
-    // and eventually the internal resampling rate
-    // along with the psg sound scaling
-    // figure out how the volume and the bias works properly tomorrow lol
-    int volume = 50;
-
-
-    float output[4];
+    float values[MIXER_CHANNELS];
+
     for(int i = 0; i < 4; i++)
     {
-        output[i] = static_cast<float>(psg.channels[i].output) / 100;
+        values[i] = static_cast<float>(psg.channels[i].output) / 100;
     }
 
+    values[4] = static_cast<float>(dma_a_sample) / 128;
+    values[5] = static_cast<float>(dma_b_sample) / 128;
 
-    const auto sound_select = psg.read_nr51();
-    const auto nr50 = psg.read_nr50();
-
+    if(mixer.push(values))
+    {
+        update_mixer_gain();
 
+        const u32 frames = mixer.mix();
+        playback.push_samples(mixer.left(),mixer.right(),frames);
+    }
+}
 
-    // mix left and right channels
+// volumes are out of 128
+// TODO: handle soundbias, the dma volume bits and the psg scaling in soundcnt_h
+void Apu::update_mixer_gain()
+{
+    constexpr float DMA_VOLUME = 50.0 / 128;
 
-    // mix dma left
-    float f0 = 0.0;
+    const auto &sound_cnt = apu_io.sound_cnt;
 
-    if(apu_io.sound_cnt.enable_left_a)
-    {
-        const float f1 = static_cast<float>(dma_a_sample) / 128.0;
-        playback.mix_samples(f0,f1,volume);
-    }
+    mixer.set_gain(4,sound_cnt.enable_left_a * DMA_VOLUME,sound_cnt.enable_right_a * DMA_VOLUME);
+    mixer.set_gain(5,sound_cnt.enable_left_b * DMA_VOLUME,sound_cnt.enable_right_b * DMA_VOLUME);
 
-    if(apu_io.sound_cnt.enable_left_b)
-    {
-        const float f1 = static_cast<float>(dma_b_sample) / 128.0;
-        playback.mix_samples(f0,f1,volume);
-    }
-    
-    // mix psg left
-    int psg_volume = 20*((nr50 & 7)+1);
-    for(int i = 0; i < 4; i++)
-    {
-        if(is_set(sound_select,i))
-        {
-            const float f1 = output[i];
-            playback.mix_samples(f0,f1,psg_volume);
-        }            
-    }
-    const float left = f0;
-
-    // mix dma right
-    f0 = 0.0;
-    
-    if(apu_io.sound_cnt.enable_right_a)
-    {
-        const float f1 = static_cast<float>(dma_a_sample) / 128.0;
-        playback.mix_samples(f0,f1,volume);
-    }
+    const auto sound_select = psg.read_nr51();
+    const auto nr50 = psg.read_nr50();
 
-    if(apu_io.sound_cnt.enable_right_b)
-    {
-        const float f1 = static_cast<float>(dma_b_sample) / 128.0;
-        playback.mix_samples(f0,f1,volume);
-    }
+    const float psg_left = (16 * ((nr50 & 7) + 1)) / 128.0;
+    const float psg_right = (16 * (((nr50 >> 4) & 7) + 1)) / 128.0;
 
-    // mix psg right
-    psg_volume = 16*(((nr50 >> 4) & 7)+1);
     for(int i = 0; i < 4; i++)
     {
-        if(is_set(sound_select,i+4))
-        {
-            const float f1 = output[i];
-            playback.mix_samples(f0,f1,psg_volume);
-        }            
-    } 
-    const float right = f0;
-
-    playback.push_sample(left,right);
+        mixer.set_gain(i,is_set(sound_select,i) * psg_left,is_set(sound_select,i + 4) * psg_right);
+    }
 }
 
 
@@ -49,7 +49,16 @@ u32 Cpu::fast_arm_fetch_mem()
     memcpy(&v,&fetch_ptr[offset],sizeof(v));
     mem.open_bus_value = v;
 
-    cycle_tick(mem.sequential? mem.wait_seq_32 : mem.wait_nseq_32);
+    // rom fetches go through the prefetch buffer
+    if(execute_rom)
+    {
+        cycle_tick(mem.prefetch_fetch(regs[PC],2));
+    }
+
+    else
+    {
+        cycle_tick(mem.sequential? mem.wait_seq_32 : mem.wait_nseq_32);
+    }
     return v;
 }
 
@@ -116,6 +125,71 @@ void Cpu::exec_arm()
     }
 }
 
+void Cpu::exec_block_arm()
+{
+    is_thumb_fetch = false;
+
+    u32 page;
+    u32 offset;
+    const u8 *code;
+
+    if(!block_page(pc_actual,page,offset,code))
+    {
+        exec_arm();
+        return;
+    }
+
+    auto &block = block_cache.lookup_arm(page,offset,code,arm_opcode_table.data(),cond_lut.data());
+
+    if(idle_loop.enabled && !idle_loop.game_disabled && idle_loop_check(pc_actual,block))
+    {
+        return;
+    }
+
+#ifdef GBA_JIT_SUPPORTED
+    if(jit.enabled && exec_jit(block))
+    {
+        return;
+    }
+#endif
+
+    const u32 generation = block_cache.generation;
+
+    for(u32 i = 0; i < block.len; i++)
+    {
+        if(i && (scheduler.event_ready() || interrupt_ready()))
+        {
+            return;
+        }
+
+        const u32 pc = pc_actual;
+        const auto instr = arm_fetch_opcode();
+
+        // pipeline was filled before the code was written
+        if(instr != block.opcode[i])
+        {
+            if(cond_met((instr >> 28) & 0xf))
+            {
+                execute_arm_opcode(instr);
+            }
+            return;
+        }
+
+        const auto flags = flag_z | flag_c << 1 | flag_n << 2 | flag_v << 3;
+
+        if(is_set(block.cond[i],flags))
+        {
+            std::invoke(block.handler.arm[i],this,instr);
+        }
+
+        // branched, switched state or the code changed under us
+        if(pc_actual != pc + ARM_WORD_SIZE || is_thumb || generation != block_cache.generation)
+        {
+            return;
+        }
+    }
+}
+
 
 
 
@@ -144,8 +218,11 @@ void Cpu::arm_swi(u32 opcode)
 
     //printf("swi %08x: %08x\n",pc_actual,opcode);
 
-    // nn is ignored by hardware
-    UNUSED(opcode);
+    // nn is ignored by hardware, the bios reads it out of the instr
+    if(bios_hle && swi((opcode >> 16) & 0xff))
+    {
+        return;
+    }
 
     const auto idx = static_cast<int>(cpu_mode::supervisor);
 
@@ -164,8 +241,6 @@ void Cpu::arm_swi(u32 opcode)
 
     // branch to interrupt vector
     write_pc(0x8);
-
-    //swi((opcode & 0x00ffffff) >> 16);
 }
 
 // mul timings need to be worked on
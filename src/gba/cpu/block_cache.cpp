@@ -0,0 +1,400 @@
+#include <gba/block_cache.h>
+#include <gba/arm.h>
+
+namespace gameboyadvance
+{
+
+// does this arm instr end a block
+// branches, bx, swi, ldm with pc in the list
+// and anything that names pc as its destination
+constexpr bool arm_ends_block(u32 instr)
+{
+    // b, bl
+    if((instr & 0x0e000000) == 0x0a000000)
+    {
+        return true;
+    }
+
+    // bx
+    if((instr & 0x0ffffff0) == 0x012fff10)
+    {
+        return true;
+    }
+
+    // swi
+    if((instr & 0x0f000000) == 0x0f000000)
+    {
+        return true;
+    }
+
+    // ldm with r15
+    if((instr & 0x0e108000) == 0x08108000)
+    {
+        return true;
+    }
+
+    // data processing and single data transfer to r15
+    // (catches a few stores and compares that dont actually write it)
+    return ((instr >> 26) & 3) <= 1 && ((instr >> 12) & 0xf) == PC;
+}
+
+// does this thumb instr end a block
+// cond branch and swi, b, the second half of bl, bx
+// pop with pc and hi reg ops that write pc
+constexpr bool thumb_ends_block(u16 instr)
+{
+    if((instr & 0xf000) == 0xd000 || (instr & 0xf800) == 0xe000 || (instr & 0xf800) == 0xf800)
+    {
+        return true;
+    }
+
+    if((instr & 0xff00) == 0x4700 || (instr & 0xff00) == 0xbd00)
+    {
+        return true;
+    }
+
+    // add, mov (cmp does not write rd)
+    if((instr & 0xfc00) == 0x4400 && ((instr >> 8) & 3) != 1)
+    {
+        const u32 rd = (instr & 7) | ((instr >> 4) & 8);
+        return rd == PC;
+    }
+
+    return false;
+}
+
+// can this arm instr sit in an idle loop
+// loads and alu ops that dont write pc, nothing that stores or touches the psr
+constexpr bool arm_idle_safe(u32 instr)
+{
+    // swp, mul and halfword transfers share the 0x90 pattern
+    if((instr & 0x0e000090) == 0x00000090)
+    {
+        // mul, mull
+        if((instr & 0x0f0000f0) == 0x00000090 || (instr & 0x0f8000f0) == 0x00800090)
+        {
+            return true;
+        }
+
+        // ldrh, ldrsb, ldrsh (not swp)
+        return (instr & 0x60) && is_set(instr,20) && ((instr >> 12) & 0xf) != PC;
+    }
+
+    // data processing, not psr transfers or bx
+    if((instr & 0x0c000000) == 0x00000000)
+    {
+        const u32 op = (instr >> 21) & 0xf;
+        const bool set_flags = is_set(instr,20);
+
+        if(op >= 8 && op <= 11 && !set_flags)
+        {
+            return false;
+        }
+
+        return ((instr >> 12) & 0xf) != PC;
+    }
+
+    // ldr, ldrb
+    if((instr & 0x0c000000) == 0x04000000)
+    {
+        return is_set(instr,20) && ((instr >> 12) & 0xf) != PC;
+    }
+
+    return false;
+}
+
+// is this block a loop of idle safe instrs
+// that ends on a branch back to its first instr
+static bool arm_idle_loop(const Block &block)
+{
+    const u32 last = block.opcode[block.len - 1];
+
+    // b without link
+    if((last & 0x0f000000) != 0x0a000000)
+    {
+        return false;
+    }
+
+    // relative to the start of the block
+    const s32 offset = sign_extend<int32_t>(last & 0xffffff,24) << 2;
+    const s32 target = ((block.len - 1) * ARM_WORD_SIZE) + 8 + offset;
+
+    if(target != 0)
+    {
+        return false;
+    }
+
+    for(u32 i = 0; i < block.len - 1; i++)
+    {
+        if(!arm_idle_safe(block.opcode[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+constexpr bool thumb_idle_safe(u16 instr)
+{
+    // shifts, add, sub, mov, cmp imm, alu ops
+    if(instr < 0x4400)
+    {
+        return true;
+    }
+
+    // hi reg ops, cmp or a mov / add that doesnt write pc (not bx)
+    if(instr < 0x4800)
+    {
+        const u32 op = (instr >> 8) & 3;
+        const u32 rd = (instr & 7) | ((instr >> 4) & 8);
+
+        return op == 1 || (op != 3 && rd != PC);
+    }
+
+    // ldr pc relative
+    if(instr < 0x5000)
+    {
+        return true;
+    }
+
+    // reg offset, loads have bit 11 set, ldrh ldsb ldsh are the sign extended half with h or s set
+    if(instr < 0x6000)
+    {
+        if(is_set(instr,9))
+        {
+            return (instr & 0x0c00) != 0;
+        }
+
+        return is_set(instr,11);
+    }
+
+    // imm offset ldr, ldrb, ldrh and sp relative ldr
+    if(instr < 0xa000)
+    {
+        return is_set(instr,11);
+    }
+
+    // add to pc or sp
+    if(instr < 0xb000)
+    {
+        return true;
+    }
+
+    return false;
+}
+
+static bool thumb_idle_loop(const Block &block)
+{
+    const u16 last = block.opcode[block.len - 1];
+    const s32 pc = ((block.len - 1) * ARM_HALF_SIZE) + 4;
+
+    s32 target = -1;
+
+    // cond branch (not swi or undefined)
+    if((last & 0xf000) == 0xd000 && ((last >> 8) & 0xf) < 0xe)
+    {
+        target = pc + (sign_extend<int32_t>(last & 0xff,8) * 2);
+    }
+
+    // b
+    else if((last & 0xf800) == 0xe000)
+    {
+        target = pc + (sign_extend<int32_t>(last & 0x7ff,11) * 2);
+    }
+
+    if(target != 0)
+    {
+        return false;
+    }
+
+    for(u32 i = 0; i < block.len - 1; i++)
+    {
+        if(!thumb_idle_safe(block.opcode[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void BlockCache::init()
+{
+    pages.clear();
+    pages.resize(PAGE_COUNT);
+
+    blocks.clear();
+    free_list.clear();
+
+    generation++;
+}
+
+void BlockCache::flush()
+{
+    for(u32 i = 0; i < pages.size(); i++)
+    {
+        flush_page(i);
+    }
+
+    generation++;
+}
+
+void BlockCache::flush_page(u32 page)
+{
+    auto &code_page = pages[page];
+
+    for(const u32 idx : code_page.blocks)
+    {
+        free_list.push_back(idx);
+    }
+
+    code_page.blocks.clear();
+    code_page.lookup.clear();
+    code_page.code_lines = 0;
+
+    generation++;
+}
+
+void BlockCache::write_range(u32 base, u32 offset, u32 bytes) noexcept
+{
+    if(!bytes)
+    {
+        return;
+    }
+
+    const u32 first = offset / PAGE_SIZE;
+    const u32 last = (offset + bytes - 1) / PAGE_SIZE;
+
+    for(u32 page = first; page <= last; page++)
+    {
+        if(pages[base + page].code_lines)
+        {
+            flush_page(base + page);
+        }
+    }
+}
+
+Block& BlockCache::alloc_block(u32 page, u32 offset, bool thumb, bool &cached)
+{
+    auto &code_page = pages[page];
+
+    // only allocate lookup for pages we actually execute from
+    if(!code_page.lookup.size())
+    {
+        code_page.lookup.resize(PAGE_SIZE / ARM_HALF_SIZE,0);
+    }
+
+    u32 &slot = code_page.lookup[offset / ARM_HALF_SIZE];
+
+    if(slot)
+    {
+        auto &block = blocks[slot - 1];
+
+        // same code run in the other state just gets recompiled in place
+        cached = block.thumb == thumb;
+        return block;
+    }
+
+    u32 idx = 0;
+
+    if(free_list.size())
+    {
+        idx = free_list.back();
+        free_list.pop_back();
+    }
+
+    else
+    {
+        blocks.push_back({});
+        idx = blocks.size() - 1;
+    }
+
+    code_page.blocks.push_back(idx);
+    slot = idx + 1;
+
+    cached = false;
+    return blocks[idx];
+}
+
+Block& BlockCache::lookup_arm(u32 page, u32 offset, const u8 *code, const ARM_OPCODE_FPTR *table, const u16 *cond_lut)
+{
+    bool cached = false;
+    auto &block = alloc_block(page,offset,false,cached);
+
+    if(cached)
+    {
+        return block;
+    }
+
+    auto &code_page = pages[page];
+
+    block.len = 0;
+    block.thumb = false;
+    block.jit = nullptr;
+    block.hits = 0;
+
+    for(u32 pc = offset; block.len < Block::INSTR_MAX && pc < PAGE_SIZE; pc += ARM_WORD_SIZE)
+    {
+        u32 instr = 0;
+        memcpy(&instr,&code[pc],sizeof(instr));
+
+        block.opcode[block.len] = instr;
+        block.cond[block.len] = cond_lut[(instr >> 28) & 0xf];
+        block.handler.arm[block.len] = table[get_arm_opcode_bits(instr)];
+        block.len++;
+
+        code_page.code_lines |= u64(1) << (pc >> LINE_SHIFT);
+
+        if(arm_ends_block(instr))
+        {
+            break;
+        }
+    }
+
+    block.idle_candidate = arm_idle_loop(block);
+
+    return block;
+}
+
+Block& BlockCache::lookup_thumb(u32 page, u32 offset, const u8 *code, const THUMB_OPCODE_FPTR *table)
+{
+    bool cached = false;
+    auto &block = alloc_block(page,offset,true,cached);
+
+    if(cached)
+    {
+        return block;
+    }
+
+    auto &code_page = pages[page];
+
+    block.len = 0;
+    block.thumb = true;
+    block.jit = nullptr;
+    block.hits = 0;
+
+    for(u32 pc = offset; block.len < Block::INSTR_MAX && pc < PAGE_SIZE; pc += ARM_HALF_SIZE)
+    {
+        u16 instr = 0;
+        memcpy(&instr,&code[pc],sizeof(instr));
+
+        block.opcode[block.len] = instr;
+        block.cond[block.len] = 0xffff;
+        block.handler.thumb[block.len] = table[instr >> 6];
+        block.len++;
+
+        code_page.code_lines |= u64(1) << (pc >> LINE_SHIFT);
+
+        if(thumb_ends_block(instr))
+        {
+            break;
+        }
+    }
+
+    block.idle_candidate = thumb_idle_loop(block);
+
+    return block;
+}
+
+}
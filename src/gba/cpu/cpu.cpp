@@ -7,7 +7,8 @@ namespace gameboyadvance
 Cpu::Cpu(GBA &gba) : disp(gba.disp), mem(gba.mem), debug(gba.debug), 
     disass(gba.disass), apu(gba.apu), scheduler(gba.scheduler)
 {
-
+    // mem writes can land before init
+    block_cache.init();
 }   
 
 void Cpu::init()
@@ -54,10 +55,17 @@ void Cpu::init()
     in_bios = false;
 
     bios_hle_interrupt = false;
+    intr_wait_pending = false;
 
     cpu_io.init();
     update_intr_status();
     debug.trace.clear();
+
+    block_cache.init();
+    jit.reset();
+
+    // game code from the rom header
+    idle_loop.select_game(std::string(mem.rom.begin() + 0xac,mem.rom.begin() + 0xb0));
 }
 
 void Cpu::insert_new_timer_event(int timer)
@@ -217,6 +225,64 @@ void Cpu::exec_instr_no_debug()
 }
 
 
+void Cpu::exec_block()
+{
+    block_count++;
+
+    if(is_thumb)
+    {
+        exec_block_thumb();
+    }
+
+    else
+    {
+        exec_block_arm();
+    }
+}
+
+// bios and anything thats not wram or rom is just interpreted
+bool Cpu::block_page(u32 addr, u32 &page, u32 &offset, const u8* &code) const noexcept
+{
+    const u8 *ptr = nullptr;
+    u32 base = 0;
+
+    switch(memory_region_table[(addr >> 24) & 0xf])
+    {
+        case memory_region::wram_chip:
+        {
+            addr &= 0x7fff;
+            ptr = mem.chip_wram.data();
+            base = BlockCache::CHIP_WRAM_PAGE;
+            break;
+        }
+
+        case memory_region::wram_board:
+        {
+            addr &= 0x3ffff;
+            ptr = mem.board_wram.data();
+            base = BlockCache::BOARD_WRAM_PAGE;
+            break;
+        }
+
+        case memory_region::rom:
+        {
+            addr &= mem.rom.size() - 1;
+            ptr = mem.rom.data();
+            base = BlockCache::ROM_PAGE;
+            break;
+        }
+
+        default: return false;
+    }
+
+    page = base + (addr / BlockCache::PAGE_SIZE);
+    offset = addr & (BlockCache::PAGE_SIZE - 1);
+    code = ptr + (addr - offset);
+
+    return true;
+}
+
+
 #ifdef DEBUG
 void Cpu::exec_instr_debug()
 {
@@ -710,7 +776,8 @@ void Cpu::write_pc(u32 v)
     // after a branch the read is no longer seqential
     mem.sequential = false;
 
-    mem.prefetch_count = 0;
+    // and the prefetch buffer is flushed
+    mem.prefetch.active = false;
 
     debug.trace.add(source,pc_actual);	
 }
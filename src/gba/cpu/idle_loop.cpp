@@ -0,0 +1,148 @@
+#include <gba/gba.h>
+#include <fstream>
+#include <sstream>
+#include <charconv>
+
+namespace gameboyadvance
+{
+
+void IdleLoop::load_overrides(const std::string &filename)
+{
+    std::ifstream fp(filename);
+    if(!fp)
+    {
+        throw std::runtime_error(fmt::format("could not open idle loop overrides: {}",filename));
+    }
+
+    std::string line;
+    u32 line_num = 0;
+
+    while(std::getline(fp,line))
+    {
+        line_num++;
+        std::stringstream ss(line);
+
+        std::string code;
+        std::string setting;
+
+        if(line.empty() || line[0] == '#' || !(ss >> code >> setting))
+        {
+            continue;
+        }
+
+        auto &entry = overrides[code];
+
+        if(setting == "off")
+        {
+            entry.disable = true;
+        }
+
+        else
+        {
+            // a leading 0x is optional
+            const char *start = setting.c_str();
+            const char *end = start + setting.size();
+
+            if(setting.starts_with("0x") || setting.starts_with("0X"))
+            {
+                start += 2;
+            }
+
+            u32 addr = 0;
+            const auto [ptr,error] = std::from_chars(start,end,addr,16);
+
+            if(error != std::errc() || ptr != end)
+            {
+                throw std::runtime_error(fmt::format("{}:{}: bad idle loop address: {}",filename,line_num,setting));
+            }
+
+            entry.loops.push_back(addr);
+        }
+    }
+}
+
+void IdleLoop::select_game(const std::string &code)
+{
+    game_disabled = false;
+    forced.clear();
+
+    const auto it = overrides.find(code);
+
+    if(it != overrides.end())
+    {
+        game_disabled = it->second.disable;
+        forced = it->second.loops;
+    }
+
+    pc = 0xffffffff;
+    block_count = 0;
+    skips = 0;
+    skipped_cycles = 0;
+}
+
+// called on entry to a block, true if it skipped ahead and the block should not be run
+bool Cpu::idle_loop_check(u32 pc, const Block &block)
+{
+    auto &idle = idle_loop;
+
+    const bool forced = !block.idle_candidate &&
+        std::find(idle.forced.begin(),idle.forced.end(),pc) != idle.forced.end();
+
+    if(!block.idle_candidate && !forced)
+    {
+        return false;
+    }
+
+    const u64 timestamp = scheduler.get_timestamp();
+    const u64 next_event = timestamp + scheduler.get_next_event_cycles();
+
+    // only the loop ran since we were last here, no event fired in between
+    // and it didnt read anything that moves on its own (timers)
+    // io that only changes from an event (dispstat, vcount, if) is covered by the event check
+    bool idle_pass = idle.pc == pc && idle.block_count + 1 == block_count && !mem.volatile_read
+        && idle.next_event == next_event && timestamp > idle.timestamp;
+
+    // a proven loop must also have left every reg alone
+    if(idle_pass && !forced)
+    {
+        idle_pass = idle.cpsr == get_cpsr() && !memcmp(idle.regs,regs,sizeof(idle.regs));
+    }
+
+    mem.volatile_read = false;
+
+    if(!idle_pass)
+    {
+        idle.pc = pc;
+        idle.block_count = block_count;
+        idle.cpsr = get_cpsr();
+        idle.timestamp = timestamp;
+        idle.next_event = next_event;
+        memcpy(idle.regs,regs,sizeof(idle.regs));
+        return false;
+    }
+
+    // nothing it reads can change until an event fires
+    // so skip whole passes that end before it, the event then lands at the same point in the loop
+    const u64 loop_cycles = timestamp - idle.timestamp;
+    const u64 passes = next_event > timestamp? (next_event - timestamp - 1) / loop_cycles : 0;
+
+    if(!passes)
+    {
+        idle.block_count = block_count;
+        idle.timestamp = timestamp;
+        return false;
+    }
+
+    const u64 cycles = passes * loop_cycles;
+    scheduler.tick(cycles);
+
+    idle.skips++;
+    idle.skipped_cycles += cycles;
+
+    // the loop has to run again to see what the event did
+    idle.pc = 0xffffffff;
+
+    return true;
+}
+
+}
@@ -0,0 +1,789 @@
+#include <gba/gba.h>
+#include <gba/jit.h>
+#include <utility>
+
+#ifdef GBA_JIT_SUPPORTED
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace gameboyadvance
+{
+
+// x86-64 register numbers, r8 is prefixed so it does not clash with the arm register
+enum x64_reg : u8
+{
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3,
+    RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    X64_R8 = 8,
+};
+
+// condition codes for jcc and setcc
+enum x64_cond : u8
+{
+    CC_O = 0x0, CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4,
+    CC_NE = 0x5, CC_S = 0x8,
+};
+
+// "op r32, r/m32" forms
+enum x64_alu : u8
+{
+    ALU_ADD = 0x03, ALU_OR = 0x0b, ALU_AND = 0x23, ALU_SUB = 0x2b,
+    ALU_XOR = 0x33, ALU_MOV = 0x8b, ALU_TEST = 0x85,
+};
+
+#ifdef _WIN32
+constexpr x64_reg ARG_REG[3] = {RCX,RDX,X64_R8};
+#else
+constexpr x64_reg ARG_REG[3] = {RDI,RSI,RDX};
+#endif
+
+// just enough of an assembler for what the jit emits
+// memory operands are allways [rbx + disp32], rbx holds the cpu for the whole block
+struct Emitter
+{
+    Emitter(u8 *buf) : buf(buf) {}
+
+    size_t pos() const { return len; }
+
+    void emit8(u8 v)
+    {
+        buf[len++] = v;
+    }
+
+    void emit32(u32 v)
+    {
+        memcpy(&buf[len],&v,sizeof(v));
+        len += sizeof(v);
+    }
+
+    void emit64(u64 v)
+    {
+        memcpy(&buf[len],&v,sizeof(v));
+        len += sizeof(v);
+    }
+
+    void rex(bool w, u8 reg, u8 rm)
+    {
+        if(w || reg >= 8 || rm >= 8)
+        {
+            emit8(0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3));
+        }
+    }
+
+    void modrm_rr(u8 reg, u8 rm)
+    {
+        emit8(0xc0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    // [rbx + disp32]
+    void modrm_cpu(u8 reg, s32 disp)
+    {
+        emit8(0x80 | ((reg & 7) << 3) | RBX);
+        emit32(disp);
+    }
+
+    void push_rbx() { emit8(0x53); }
+    void pop_rbx() { emit8(0x5b); }
+    void ret() { emit8(0xc3); }
+
+    void sub_rsp(u8 imm) { emit8(0x48); emit8(0x83); emit8(0xec); emit8(imm); }
+    void add_rsp(u8 imm) { emit8(0x48); emit8(0x83); emit8(0xc4); emit8(imm); }
+
+    void mov_r64(u8 dst, u8 src)
+    {
+        rex(true,src,dst);
+        emit8(0x89);
+        modrm_rr(src,dst);
+    }
+
+    void mov_imm32(u8 reg, u32 imm)
+    {
+        rex(false,0,reg);
+        emit8(0xb8 + (reg & 7));
+        emit32(imm);
+    }
+
+    void mov_imm64(u8 reg, u64 imm)
+    {
+        rex(true,0,reg);
+        emit8(0xb8 + (reg & 7));
+        emit64(imm);
+    }
+
+    void call(const void *func)
+    {
+        mov_imm64(RAX,reinterpret_cast<u64>(func));
+
+        // call rax
+        emit8(0xff);
+        emit8(0xd0);
+    }
+
+    void load32(u8 reg, s32 disp)
+    {
+        rex(false,reg,RBX);
+        emit8(0x8b);
+        modrm_cpu(reg,disp);
+    }
+
+    void store32(s32 disp, u8 reg)
+    {
+        rex(false,reg,RBX);
+        emit8(0x89);
+        modrm_cpu(reg,disp);
+    }
+
+    void load8_zx(u8 reg, s32 disp)
+    {
+        rex(false,reg,RBX);
+        emit8(0x0f);
+        emit8(0xb6);
+        modrm_cpu(reg,disp);
+    }
+
+    void alu(x64_alu op, u8 dst, u8 src)
+    {
+        rex(false,dst,src);
+        emit8(op);
+        modrm_rr(dst,src);
+    }
+
+    void not32(u8 reg)
+    {
+        rex(false,0,reg);
+        emit8(0xf7);
+        modrm_rr(2,reg);
+    }
+
+    void shl32(u8 reg, u8 imm)
+    {
+        rex(false,0,reg);
+        emit8(0xc1);
+        modrm_rr(4,reg);
+        emit8(imm);
+    }
+
+    // cf = bit of base
+    void bt(u8 base, u8 bit)
+    {
+        rex(false,bit,base);
+        emit8(0x0f);
+        emit8(0xa3);
+        modrm_rr(bit,base);
+    }
+
+    void setcc(x64_cond cc, s32 disp)
+    {
+        emit8(0x0f);
+        emit8(0x90 | cc);
+        modrm_cpu(0,disp);
+    }
+
+    // returns the offset of the rel32 to patch
+    size_t jcc(x64_cond cc)
+    {
+        emit8(0x0f);
+        emit8(0x80 | cc);
+        emit32(0);
+
+        return len - sizeof(u32);
+    }
+
+    void patch(size_t rel, size_t target)
+    {
+        const s32 v = s32(target) - s32(rel + sizeof(u32));
+        memcpy(&buf[rel],&v,sizeof(v));
+    }
+
+    u8 *buf = nullptr;
+    size_t len = 0;
+};
+
+// where the state the emitted code touches lives inside the cpu
+struct CpuLayout
+{
+    CpuLayout(const Cpu &cpu)
+    {
+        const auto offset = [&](const void *field)
+        {
+            return s32(static_cast<const u8*>(field) - reinterpret_cast<const u8*>(&cpu));
+        };
+
+        for(u32 i = 0; i < 16; i++)
+        {
+            regs[i] = offset(&cpu.regs[i]);
+        }
+
+        flag_z = offset(&cpu.flag_z);
+        flag_c = offset(&cpu.flag_c);
+        flag_n = offset(&cpu.flag_n);
+        flag_v = offset(&cpu.flag_v);
+    }
+
+    s32 regs[16];
+    s32 flag_z;
+    s32 flag_c;
+    s32 flag_n;
+    s32 flag_v;
+};
+
+
+// helpers the emitted code calls
+// a non zero return means the block has to exit
+
+// fetch through the pipeline exactly like the interpreter
+// an instr whose code changed since it was translated is run by the interpreter instead
+static u32 jit_fetch_arm(Cpu *cpu, u32 opcode, u32 idx)
+{
+    if(idx && (cpu->scheduler.event_ready() || cpu->interrupt_ready()))
+    {
+        return true;
+    }
+
+    const u32 instr = cpu->arm_fetch_opcode();
+
+    if(instr != opcode)
+    {
+        // emitted code has no unwind info, rethrown once the block returns
+        try
+        {
+            if(cpu->cond_met((instr >> 28) & 0xf))
+            {
+                cpu->execute_arm_opcode(instr);
+            }
+        }
+
+        catch(...)
+        {
+            cpu->jit.error = std::current_exception();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+static u32 jit_fetch_thumb(Cpu *cpu, u32 opcode, u32 idx)
+{
+    if(idx && (cpu->scheduler.event_ready() || cpu->interrupt_ready()))
+    {
+        return true;
+    }
+
+    const u16 instr = cpu->thumb_fetch_opcode();
+
+    if(instr != opcode)
+    {
+        try
+        {
+            cpu->execute_thumb_opcode(instr);
+        }
+
+        catch(...)
+        {
+            cpu->jit.error = std::current_exception();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+static u32 jit_call_arm(Cpu *cpu, const Block *block, u32 idx)
+{
+    // emitted code has no unwind info, rethrown once the block returns
+    try
+    {
+        std::invoke(block->handler.arm[idx],cpu,block->opcode[idx]);
+    }
+
+    catch(...)
+    {
+        cpu->jit.error = std::current_exception();
+        return true;
+    }
+
+    const u32 next = cpu->jit.entry_pc + ((idx + 1) * ARM_WORD_SIZE);
+    return cpu->pc_actual != next || cpu->is_thumb || cpu->jit.generation != cpu->block_cache.generation;
+}
+
+static u32 jit_call_thumb(Cpu *cpu, const Block *block, u32 idx)
+{
+    try
+    {
+        std::invoke(block->handler.thumb[idx],cpu,u16(block->opcode[idx]));
+    }
+
+    catch(...)
+    {
+        cpu->jit.error = std::current_exception();
+        return true;
+    }
+
+    const u32 next = cpu->jit.entry_pc + ((idx + 1) * ARM_HALF_SIZE);
+    return cpu->pc_actual != next || !cpu->is_thumb || cpu->jit.generation != cpu->block_cache.generation;
+}
+
+
+enum class alu_kind
+{
+    and_, eor, sub, rsb, add, orr, mov, bic, mvn,
+};
+
+// op1 in eax, op2 in ecx
+// flags are only ever those the interpreter would set for the same op
+static void emit_alu(Emitter &e, const CpuLayout &layout, alu_kind kind, bool s, bool write, u32 rd)
+{
+    u8 result = RAX;
+    bool arith = false;
+    x64_cond carry = CC_B;
+
+    switch(kind)
+    {
+        case alu_kind::and_: e.alu(ALU_AND,RAX,RCX); break;
+        case alu_kind::eor: e.alu(ALU_XOR,RAX,RCX); break;
+        case alu_kind::orr: e.alu(ALU_OR,RAX,RCX); break;
+
+        case alu_kind::bic:
+        {
+            e.not32(RCX);
+            e.alu(ALU_AND,RAX,RCX);
+            break;
+        }
+
+        // x86 sets carry on borrow, arm on no borrow
+        case alu_kind::sub:
+        {
+            e.alu(ALU_SUB,RAX,RCX);
+            arith = true;
+            carry = CC_AE;
+            break;
+        }
+
+        case alu_kind::rsb:
+        {
+            e.alu(ALU_SUB,RCX,RAX);
+            result = RCX;
+            arith = true;
+            carry = CC_AE;
+            break;
+        }
+
+        case alu_kind::add:
+        {
+            e.alu(ALU_ADD,RAX,RCX);
+            arith = true;
+            carry = CC_B;
+            break;
+        }
+
+        case alu_kind::mov:
+        {
+            result = RCX;
+
+            if(s)
+            {
+                e.alu(ALU_TEST,RCX,RCX);
+            }
+            break;
+        }
+
+        case alu_kind::mvn:
+        {
+            e.not32(RCX);
+            result = RCX;
+
+            if(s)
+            {
+                e.alu(ALU_TEST,RCX,RCX);
+            }
+            break;
+        }
+    }
+
+    // setcc and mov leave the flags alone so order does not matter
+    if(s)
+    {
+        e.setcc(CC_S,layout.flag_n);
+        e.setcc(CC_E,layout.flag_z);
+
+        if(arith)
+        {
+            e.setcc(carry,layout.flag_c);
+            e.setcc(CC_O,layout.flag_v);
+        }
+    }
+
+    if(write)
+    {
+        e.store32(layout.regs[rd],result);
+    }
+}
+
+// data processing with an immediate or an unshifted register, nothing touching pc
+// and no carry in (adc, sbc, rsc) or carry out of the shifter
+static bool emit_native_arm(Emitter &e, const CpuLayout &layout, u32 instr)
+{
+    if(((instr >> 26) & 3) != 0)
+    {
+        return false;
+    }
+
+    const bool i = is_set(instr,25);
+    const u32 op = (instr >> 21) & 0xf;
+    const bool s = is_set(instr,20);
+    const u32 rn = (instr >> 16) & 0xf;
+    const u32 rd = (instr >> 12) & 0xf;
+    const u32 rm = instr & 0xf;
+
+    // psr transfers and bx live where a compare would not set flags
+    if(op >= 0x8 && op <= 0xb && !s)
+    {
+        return false;
+    }
+
+    // register must be lsl #0, this also keeps out mul, swap and halfword transfers
+    if(!i && (((instr >> 4) & 0xff) || rm == PC))
+    {
+        return false;
+    }
+
+    if(rd == PC || rn == PC)
+    {
+        return false;
+    }
+
+    static constexpr alu_kind ARM_ALU[16] =
+    {
+        alu_kind::and_, alu_kind::eor, alu_kind::sub, alu_kind::rsb,
+        alu_kind::add, alu_kind::add, alu_kind::sub, alu_kind::rsb,
+        alu_kind::and_, alu_kind::eor, alu_kind::sub, alu_kind::add,
+        alu_kind::orr, alu_kind::mov, alu_kind::bic, alu_kind::mvn,
+    };
+
+    // adc, sbc, rsc
+    if(op >= 0x5 && op <= 0x7)
+    {
+        return false;
+    }
+
+    const auto kind = ARM_ALU[op];
+    const bool arith = kind == alu_kind::sub || kind == alu_kind::rsb || kind == alu_kind::add;
+
+    if(i)
+    {
+        const u32 rot = ((instr >> 8) & 0xf) * 2;
+
+        // rotated immediates set carry on logical ops
+        if(s && !arith && rot)
+        {
+            return false;
+        }
+
+        e.mov_imm32(RCX,rotr(instr & 0xff,rot));
+    }
+
+    else
+    {
+        e.load32(RCX,layout.regs[rm]);
+    }
+
+    if(kind != alu_kind::mov && kind != alu_kind::mvn)
+    {
+        e.load32(RAX,layout.regs[rn]);
+    }
+
+    const bool write = !(op >= 0x8 && op <= 0xb);
+    emit_alu(e,layout,kind,s,write,rd);
+
+    return true;
+}
+
+// mov/cmp/add/sub imm8, add/sub reg and imm3, and the alu ops that dont shift or use carry
+static bool emit_native_thumb(Emitter &e, const CpuLayout &layout, u16 instr)
+{
+    // mov, cmp, add, sub imm8
+    if((instr & 0xe000) == 0x2000)
+    {
+        const u32 op = (instr >> 11) & 3;
+        const u32 rd = (instr >> 8) & 7;
+
+        static constexpr alu_kind MCAS[4] = {alu_kind::mov, alu_kind::sub, alu_kind::add, alu_kind::sub};
+
+        e.mov_imm32(RCX,instr & 0xff);
+
+        if(op != 0)
+        {
+            e.load32(RAX,layout.regs[rd]);
+        }
+
+        emit_alu(e,layout,MCAS[op],true,op != 1,rd);
+        return true;
+    }
+
+    // add, sub reg / imm3
+    if((instr & 0xf800) == 0x1800)
+    {
+        const u32 op = (instr >> 9) & 3;
+        const u32 rd = instr & 7;
+        const u32 rs = (instr >> 3) & 7;
+        const u32 rn = (instr >> 6) & 7;
+
+        if(op & 2)
+        {
+            e.mov_imm32(RCX,rn);
+        }
+
+        else
+        {
+            e.load32(RCX,layout.regs[rn]);
+        }
+
+        e.load32(RAX,layout.regs[rs]);
+        emit_alu(e,layout,(op & 1)? alu_kind::sub : alu_kind::add,true,true,rd);
+        return true;
+    }
+
+    // alu ops
+    if((instr & 0xfc00) == 0x4000)
+    {
+        const u32 op = (instr >> 6) & 0xf;
+        const u32 rd = instr & 7;
+        const u32 rs = (instr >> 3) & 7;
+
+        alu_kind kind;
+        bool write = true;
+
+        switch(op)
+        {
+            case 0x0: kind = alu_kind::and_; break;
+            case 0x1: kind = alu_kind::eor; break;
+            case 0x8: kind = alu_kind::and_; write = false; break;
+            case 0xa: kind = alu_kind::sub; write = false; break;
+            case 0xb: kind = alu_kind::add; write = false; break;
+            case 0xc: kind = alu_kind::orr; break;
+            case 0xe: kind = alu_kind::bic; break;
+            case 0xf: kind = alu_kind::mvn; break;
+
+            // neg is 0 - rs
+            case 0x9:
+            {
+                e.load32(RAX,layout.regs[rs]);
+                e.mov_imm32(RCX,0);
+                emit_alu(e,layout,alu_kind::rsb,true,true,rd);
+                return true;
+            }
+
+            // shifts, adc, sbc, ror, mul
+            default: return false;
+        }
+
+        e.load32(RCX,layout.regs[rs]);
+        e.load32(RAX,layout.regs[rd]);
+        emit_alu(e,layout,kind,true,write,rd);
+        return true;
+    }
+
+    return false;
+}
+
+
+u8* Jit::compile(Cpu &cpu, const Block &block)
+{
+    if(!arena)
+    {
+    #ifdef _WIN32
+        arena = static_cast<u8*>(VirtualAlloc(nullptr,ARENA_SIZE,MEM_COMMIT | MEM_RESERVE,PAGE_EXECUTE_READWRITE));
+    #else
+        void *ptr = mmap(nullptr,ARENA_SIZE,PROT_READ | PROT_WRITE | PROT_EXEC,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+        arena = ptr == MAP_FAILED? nullptr : static_cast<u8*>(ptr);
+    #endif
+
+        if(!arena)
+        {
+            throw std::runtime_error("[jit] could not allocate code arena");
+        }
+    }
+
+    if(ARENA_SIZE - arena_used < BLOCK_SIZE_MAX)
+    {
+        return nullptr;
+    }
+
+    u8 *code = arena + arena_used;
+
+    Emitter e(code);
+    const CpuLayout layout(cpu);
+
+    const auto fetch = block.thumb? reinterpret_cast<const void*>(&jit_fetch_thumb) : reinterpret_cast<const void*>(&jit_fetch_arm);
+    const auto call = block.thumb? reinterpret_cast<const void*>(&jit_call_thumb) : reinterpret_cast<const void*>(&jit_call_arm);
+
+    // rbx is callee saved, keep the stack aligned with room for win64 shadow space
+    e.push_rbx();
+    e.sub_rsp(32);
+    e.mov_r64(RBX,ARG_REG[0]);
+
+    std::vector<size_t> exits;
+
+    for(u32 i = 0; i < block.len; i++)
+    {
+        e.mov_r64(ARG_REG[0],RBX);
+        e.mov_imm32(ARG_REG[1],block.opcode[i]);
+        e.mov_imm32(ARG_REG[2],i);
+        e.call(fetch);
+        e.alu(ALU_TEST,RAX,RAX);
+        exits.push_back(e.jcc(CC_NE));
+
+        size_t skip = 0;
+
+        // test the cond in the same bitset cond_met uses
+        if(!block.thumb && block.cond[i] != 0xffff)
+        {
+            e.load8_zx(RAX,layout.flag_z);
+            e.load8_zx(RCX,layout.flag_c);
+            e.shl32(RCX,1);
+            e.alu(ALU_OR,RAX,RCX);
+            e.load8_zx(RCX,layout.flag_n);
+            e.shl32(RCX,2);
+            e.alu(ALU_OR,RAX,RCX);
+            e.load8_zx(RCX,layout.flag_v);
+            e.shl32(RCX,3);
+            e.alu(ALU_OR,RAX,RCX);
+
+            e.mov_imm32(RCX,block.cond[i]);
+            e.bt(RCX,RAX);
+            skip = e.jcc(CC_AE);
+        }
+
+        const bool native = block.thumb? emit_native_thumb(e,layout,block.opcode[i]) : emit_native_arm(e,layout,block.opcode[i]);
+
+        if(!native)
+        {
+            e.mov_r64(ARG_REG[0],RBX);
+            e.mov_imm64(ARG_REG[1],reinterpret_cast<u64>(&block));
+            e.mov_imm32(ARG_REG[2],i);
+            e.call(call);
+            e.alu(ALU_TEST,RAX,RAX);
+            exits.push_back(e.jcc(CC_NE));
+        }
+
+        if(skip)
+        {
+            e.patch(skip,e.pos());
+        }
+    }
+
+    for(const size_t exit : exits)
+    {
+        e.patch(exit,e.pos());
+    }
+
+    e.add_rsp(32);
+    e.pop_rbx();
+    e.ret();
+
+    assert(e.pos() <= BLOCK_SIZE_MAX);
+
+    arena_used += e.pos();
+
+    return code;
+}
+
+void Jit::reset()
+{
+    arena_used = 0;
+}
+
+Jit::Jit()
+{
+
+}
+
+Jit::~Jit()
+{
+    if(!arena)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualFree(arena,0,MEM_RELEASE);
+#else
+    munmap(arena,ARENA_SIZE);
+#endif
+}
+
+
+bool Cpu::exec_jit(Block &block)
+{
+    if(!block.jit)
+    {
+        if(++block.hits < jit.hot_threshold)
+        {
+            return false;
+        }
+
+        block.jit = jit.compile(*this,block);
+
+        // arena is full, start again from nothing
+        if(!block.jit)
+        {
+            jit.reset();
+            block_cache.flush();
+            return false;
+        }
+    }
+
+    jit.entry_pc = pc_actual;
+    jit.generation = block_cache.generation;
+
+    const auto func = reinterpret_cast<Jit::JIT_FUNC>(block.jit);
+    func(this);
+
+    if(jit.error)
+    {
+        std::rethrow_exception(std::exchange(jit.error,nullptr));
+    }
+
+    return true;
+}
+
+}
+
+#else
+
+namespace gameboyadvance
+{
+
+// no backend for this host, the block cache is allways interpreted
+
+u8* Jit::compile(Cpu &cpu, const Block &block)
+{
+    UNUSED(cpu); UNUSED(block);
+    return nullptr;
+}
+
+void Jit::reset()
+{
+
+}
+
+Jit::Jit()
+{
+
+}
+
+Jit::~Jit()
+{
+
+}
+
+}
+
+#endif
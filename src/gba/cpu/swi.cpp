@@ -1,11 +1,52 @@
 #include <gba/gba.h>
+#include <cmath>
+#include <bit>
+#include <numbers>
 
 namespace gameboyadvance
 {
 
-// bios hle (very unfinished - no games will boot under it)
+// bios hle
+// each call is done natively and charged roughly what the bios routine takes
+// memory is accessed untimed so waitstates are only ever charged by that cost
+// anything not handled here still goes through the real bios
 
-void Cpu::swi(u32 function)
+// rough cost of getting into and back out of the bios
+static constexpr u32 SWI_OVERHEAD = 20;
+
+// where the bios irq handler and user handlers flag serviced interrupts
+static constexpr u32 BIOS_IRQ_FLAGS = 0x03007FF8;
+
+// the bios wont read from itself
+static bool bios_source(u32 addr)
+{
+    return (addr & 0x0e000000) == 0;
+}
+
+// 256 step sine in 1.14 fixed point like the bios table
+static const std::array<s32,256> SIN_LUT = []()
+{
+    std::array<s32,256> lut{};
+
+    for(u32 i = 0; i < lut.size(); i++)
+    {
+        lut[i] = static_cast<s32>(std::lround(std::sin(i * 2.0 * std::numbers::pi / 256.0) * 0x4000));
+    }
+
+    return lut;
+}();
+
+static s32 lut_sin(u32 angle)
+{
+    return SIN_LUT[(angle >> 8) & 0xff];
+}
+
+static s32 lut_cos(u32 angle)
+{
+    return SIN_LUT[((angle >> 8) + 64) & 0xff];
+}
+
+bool Cpu::swi(u32 function)
 {
     switch(function)
     {
@@ -15,26 +56,31 @@ void Cpu::swi(u32 function)
             if(is_set(regs[R0],0))
             {
                 std::fill(mem.board_wram.begin(),mem.board_wram.end(),0);
+                block_cache.write_board_wram_range(0,mem.board_wram.size());
             }
 
             if(is_set(regs[R0],1))
             {
                 std::fill(mem.chip_wram.begin(),mem.chip_wram.end()-0x200,0);
+                block_cache.write_chip_wram_range(0,mem.chip_wram.size()-0x200);
             }
 
             if(is_set(regs[R0],2))
             {
                 std::fill(mem.pal_ram.begin(),mem.pal_ram.end(),0);
+                disp.pal_copy.dirty = true;
             }
 
             if(is_set(regs[R0],3))
             {
                 std::fill(mem.vram.begin(),mem.vram.end(),0);
+                mem.touch_vram(0,mem.vram.size());
             }
 
             if(is_set(regs[R0],4))
             {
                 std::fill(mem.oam.begin(),mem.oam.end(),0);
+                disp.oam_copy.dirty = true;
             }
 /*          clears sio regs
             if(is_set(regs[R0]),5)
@@ -47,7 +93,7 @@ void Cpu::swi(u32 function)
             {
                 for(int i = 0x04000060; i < 0x04000088; i++)
                 {
-                    mem.write_u8(i,0);
+                    mem.write_mem<u8>(i,0);
                 }
             }
 
@@ -62,55 +108,618 @@ void Cpu::swi(u32 function)
                         continue;
                     }
 
-                    mem.write_u8(i,0);
-                }   
+                    // and the power regs, a zero to haltcnt is a halt
+                    if(i == 0x04000300 || i == 0x04000301)
+                    {
+                        continue;
+                    }
+
+                    mem.write_mem<u8>(i,0);
+                }
             }
 
+            cycle_tick(SWI_OVERHEAD);
             break;
         }
 
-        // memset / memcpy
-        case 0xc:
+        case 0x2: // halt
         {
-            const auto src = regs[R0];
-            const auto dst = regs[R1];
+            cycle_tick(SWI_OVERHEAD);
+            cpu_io.halt_cnt.state = HaltCnt::power_state::halt;
+            handle_power_state();
+            break;
+        }
+
+        case 0x4: swi_intr_wait(regs[R0] & 1,regs[R1]); break;
+
+        case 0x5: swi_intr_wait(true,1); break;
+
+        case 0x6: swi_div(regs[R0],regs[R1]); break;
+
+        // div with the args swapped
+        case 0x7: swi_div(regs[R1],regs[R0]); break;
 
-            const auto cnt = (regs[R2] / 4) & ((1 << 22) - 1);
+        case 0x8: // sqrt
+        {
+            regs[R0] = static_cast<u32>(std::sqrt(static_cast<double>(regs[R0])));
+            cycle_tick(SWI_OVERHEAD + 80);
+            break;
+        }
 
-            const bool memset = is_set(regs[R2],24);
+        case 0x9: // arctan
+        {
+            regs[R0] = swi_arctan(regs[R0]);
+            cycle_tick(SWI_OVERHEAD + 40);
+            break;
+        }
 
-            
+        case 0xa: // arctan2
+        {
+            regs[R0] = swi_arctan2(regs[R0],regs[R1]);
+            cycle_tick(SWI_OVERHEAD + 80);
+            break;
+        }
+
+        case 0xb: swi_cpu_set(); break;
+
+        case 0xc: swi_cpu_fast_set(); break;
+
+        case 0xd: // bios checksum
+        {
+            regs[R0] = 0xBAAE187F;
+            cycle_tick(SWI_OVERHEAD);
+            break;
+        }
+
+        case 0xe: swi_bg_affine_set(); break;
+
+        case 0xf: swi_obj_affine_set(); break;
+
+        case 0x11: swi_lz77(false); break;
+
+        case 0x12: swi_lz77(true); break;
+
+        case 0x13: swi_huffman(); break;
+
+        case 0x14: swi_rl(false); break;
+
+        case 0x15: swi_rl(true); break;
+
+        // let the bios do it
+        default:
+            return false;
+    }
+
+    return true;
+}
+
+void Cpu::swi_intr_wait(bool discard, u32 mask)
+{
+    // this is rerun after every interrupt that doesent match,
+    // only the first call throws away flags already set
+    if(!intr_wait_pending)
+    {
+        intr_wait_pending = true;
+
+        cpu_io.ime = true;
+        update_intr_status();
+
+        if(discard)
+        {
+            mem.write_mem<u16>(BIOS_IRQ_FLAGS,mem.read_mem<u16>(BIOS_IRQ_FLAGS) & ~mask);
+        }
+
+        cycle_tick(SWI_OVERHEAD);
+    }
+
+    const u16 flags = mem.read_mem<u16>(BIOS_IRQ_FLAGS);
+
+    if(flags & mask)
+    {
+        mem.write_mem<u16>(BIOS_IRQ_FLAGS,flags & ~mask);
+        intr_wait_pending = false;
+        return;
+    }
+
+    cpu_io.halt_cnt.state = HaltCnt::power_state::halt;
+    handle_power_state();
+
+    // run the swi again once the user handler returns to it
+    write_pc(pc_actual - (is_thumb? ARM_HALF_SIZE : ARM_WORD_SIZE));
+}
+
+void Cpu::swi_div(u32 num, u32 denom)
+{
+    const auto n = static_cast<s32>(num);
+    const auto d = static_cast<s32>(denom);
 
-            if(memset)
+    // the bios hangs on a zero divide, just give back something sane
+    if(d == 0)
+    {
+        regs[R0] = n < 0? -1 : 1;
+        regs[R1] = n;
+        regs[R3] = 1;
+    }
+
+    else if(d == -1 && n == INT32_MIN)
+    {
+        regs[R0] = INT32_MIN;
+        regs[R1] = 0;
+        regs[R3] = INT32_MIN;
+    }
+
+    else
+    {
+        const s32 quot = n / d;
+
+        regs[R0] = quot;
+        regs[R1] = n % d;
+        regs[R3] = quot < 0? -quot : quot;
+    }
+
+    // one pass per bit of the quotient
+    const int loops = std::max(1,std::countl_zero(denom) - std::countl_zero(num));
+    cycle_tick(SWI_OVERHEAD + 10 + (4 * loops));
+}
+
+// 32 bit multiply then shift, wrapping like the arm would
+static s32 mul_asr(s32 a, s32 b, u32 shift)
+{
+    return static_cast<s32>(static_cast<u32>(a) * static_cast<u32>(b)) >> shift;
+}
+
+// same polynomial the bios uses, input and output are 1.14
+u32 Cpu::swi_arctan(u32 v)
+{
+    const s32 i = static_cast<s16>(v);
+
+    const s32 a = -mul_asr(i,i,14);
+    s32 b = mul_asr(0xa9,a,14) + 0x390;
+    b = mul_asr(b,a,14) + 0x91c;
+    b = mul_asr(b,a,14) + 0xfb6;
+    b = mul_asr(b,a,14) + 0x16aa;
+    b = mul_asr(b,a,14) + 0x2081;
+    b = mul_asr(b,a,14) + 0x3651;
+    b = mul_asr(b,a,14) + 0xa2f9;
+
+    regs[R1] = a;
+    regs[R3] = b;
+
+    return mul_asr(i,b,16);
+}
+
+// angle of x,y in 0 - 0xffff
+u32 Cpu::swi_arctan2(u32 x_reg, u32 y_reg)
+{
+    const s32 x = static_cast<s32>(x_reg);
+    const s32 y = static_cast<s32>(y_reg);
+
+    if(!y)
+    {
+        return x >= 0? 0 : 0x8000;
+    }
+
+    if(!x)
+    {
+        return y >= 0? 0x4000 : 0xc000;
+    }
+
+    u32 angle = 0;
+
+    if(y >= 0)
+    {
+        if(x >= 0 && x >= y)
+        {
+            angle = swi_arctan((y << 14) / x);
+        }
+
+        else if(x < 0 && -x >= y)
+        {
+            angle = swi_arctan((y << 14) / x) + 0x8000;
+        }
+
+        else
+        {
+            angle = 0x4000 - swi_arctan((x << 14) / y);
+        }
+    }
+
+    else
+    {
+        if(x <= 0 && -x > -y)
+        {
+            angle = swi_arctan((y << 14) / x) + 0x8000;
+        }
+
+        else if(x > 0 && x >= -y)
+        {
+            angle = swi_arctan((y << 14) / x) + 0x10000;
+        }
+
+        else
+        {
+            angle = 0xc000 - swi_arctan((x << 14) / y);
+        }
+    }
+
+    return angle & 0xffff;
+}
+
+// memcpy / memset in halfwords or words
+void Cpu::swi_cpu_set()
+{
+    const u32 src = regs[R0];
+    const u32 dst = regs[R1];
+    const u32 cnt = regs[R2] & 0x1fffff;
+    const bool fill = is_set(regs[R2],24);
+    const bool word = is_set(regs[R2],26);
+
+    cycle_tick(SWI_OVERHEAD);
+
+    if(bios_source(src))
+    {
+        return;
+    }
+
+    if(word)
+    {
+        // the copy charges the accesses, only the loop is left
+        if(!fill && mem.fast_memcpy<u32>(dst,src,cnt))
+        {
+            cycle_tick(cnt * 2);
+            return;
+        }
+
+        const u32 wait = mem.get_waitstates<u32>(src,true) + mem.get_waitstates<u32>(dst,true);
+
+        // tick each unit so events see the copy part way through, like a dma
+        for(u32 i = 0; i < cnt; i++)
+        {
+            const u32 offset = i * ARM_WORD_SIZE;
+            mem.write_mem<u32>(dst + offset,mem.read_mem<u32>(fill? src : src + offset));
+
+            cycle_tick(wait + 2);
+            scheduler.service_events();
+        }
+    }
+
+    else
+    {
+        // the copy charges the accesses, only the loop is left
+        if(!fill && mem.fast_memcpy<u16>(dst,src,cnt))
+        {
+            cycle_tick(cnt * 2);
+            return;
+        }
+
+        const u32 wait = mem.get_waitstates<u16>(src,true) + mem.get_waitstates<u16>(dst,true);
+
+        for(u32 i = 0; i < cnt; i++)
+        {
+            const u32 offset = i * ARM_HALF_SIZE;
+            mem.write_mem<u16>(dst + offset,mem.read_mem<u16>(fill? src : src + offset));
+
+            cycle_tick(wait + 2);
+            scheduler.service_events();
+        }
+    }
+}
+
+// memcpy / memset in blocks of 8 words
+void Cpu::swi_cpu_fast_set()
+{
+    const u32 src = regs[R0];
+    const u32 dst = regs[R1];
+
+    // rounded up to a whole block
+    const u32 cnt = ((regs[R2] & 0x1fffff) + 7) & ~7;
+    const bool fill = is_set(regs[R2],24);
+
+    cycle_tick(SWI_OVERHEAD);
+
+    if(bios_source(src))
+    {
+        return;
+    }
+
+    if(fill)
+    {
+        const u32 v = mem.read_mem<u32>(src);
+        const u32 wait = mem.get_waitstates<u32>(dst,true);
+
+        for(u32 i = 0; i < cnt; i++)
+        {
+            mem.write_mem<u32>(dst + (i * ARM_WORD_SIZE),v);
+
+            cycle_tick(wait);
+            scheduler.service_events();
+        }
+    }
+
+    else if(!mem.fast_memcpy<u32>(dst,src,cnt))
+    {
+        const u32 wait = mem.get_waitstates<u32>(src,true) + mem.get_waitstates<u32>(dst,true);
+
+        for(u32 i = 0; i < cnt; i++)
+        {
+            const u32 offset = i * ARM_WORD_SIZE;
+            mem.write_mem<u32>(dst + offset,mem.read_mem<u32>(src + offset));
+
+            cycle_tick(wait);
+            scheduler.service_events();
+        }
+    }
+}
+
+// rotate / scale into bg affine params and start pos
+void Cpu::swi_bg_affine_set()
+{
+    u32 src = regs[R0];
+    u32 dst = regs[R1];
+    const u32 cnt = regs[R2];
+
+    for(u32 i = 0; i < cnt; i++)
+    {
+        // origin in .8 fixed point, center on screen, 8.8 scale and angle
+        const s32 ox = static_cast<s32>(mem.read_mem<u32>(src + 0));
+        const s32 oy = static_cast<s32>(mem.read_mem<u32>(src + 4));
+        const s32 cx = static_cast<s16>(mem.read_mem<u16>(src + 8));
+        const s32 cy = static_cast<s16>(mem.read_mem<u16>(src + 10));
+        const s32 sx = static_cast<s16>(mem.read_mem<u16>(src + 12));
+        const s32 sy = static_cast<s16>(mem.read_mem<u16>(src + 14));
+        const u32 angle = mem.read_mem<u16>(src + 16);
+
+        const s32 sin = lut_sin(angle);
+        const s32 cos = lut_cos(angle);
+
+        const s32 pa = (sx * cos) >> 14;
+        const s32 pb = -((sx * sin) >> 14);
+        const s32 pc = (sy * sin) >> 14;
+        const s32 pd = (sy * cos) >> 14;
+
+        mem.write_mem<u16>(dst + 0,pa);
+        mem.write_mem<u16>(dst + 2,pb);
+        mem.write_mem<u16>(dst + 4,pc);
+        mem.write_mem<u16>(dst + 6,pd);
+        mem.write_mem<u32>(dst + 8,ox - (pa * cx + pb * cy));
+        mem.write_mem<u32>(dst + 12,oy - (pc * cx + pd * cy));
+
+        src += 20;
+        dst += 16;
+    }
+
+    cycle_tick(SWI_OVERHEAD + (cnt * 60));
+}
+
+// rotate / scale into obj affine params, r3 is the gap between each one
+void Cpu::swi_obj_affine_set()
+{
+    u32 src = regs[R0];
+    u32 dst = regs[R1];
+    const u32 cnt = regs[R2];
+    const u32 stride = regs[R3];
+
+    for(u32 i = 0; i < cnt; i++)
+    {
+        const s32 sx = static_cast<s16>(mem.read_mem<u16>(src + 0));
+        const s32 sy = static_cast<s16>(mem.read_mem<u16>(src + 2));
+        const u32 angle = mem.read_mem<u16>(src + 4);
+
+        const s32 sin = lut_sin(angle);
+        const s32 cos = lut_cos(angle);
+
+        mem.write_mem<u16>(dst + (stride * 0),(sx * cos) >> 14);
+        mem.write_mem<u16>(dst + (stride * 1),-((sx * sin) >> 14));
+        mem.write_mem<u16>(dst + (stride * 2),(sy * sin) >> 14);
+        mem.write_mem<u16>(dst + (stride * 3),(sy * cos) >> 14);
+
+        src += 8;
+        dst += stride * 4;
+    }
+
+    cycle_tick(SWI_OVERHEAD + (cnt * 40));
+}
+
+// write a decompressed buffer out
+// vram cant take byte writes so the vram versions only do halfwords
+void Cpu::swi_write_out(u32 dst, const std::vector<u8> &buf, bool vram)
+{
+    // wram version to an odd address has to go a byte at a time
+    if(!vram && (dst & 1))
+    {
+        for(u32 i = 0; i < buf.size(); i++)
+        {
+            mem.write_mem<u8>(dst + i,buf[i]);
+        }
+
+        return;
+    }
+
+    const u32 halfs = buf.size() / 2;
+
+    for(u32 i = 0; i < halfs; i++)
+    {
+        mem.write_mem<u16>(dst + (i * 2),buf[i * 2] | (buf[(i * 2) + 1] << 8));
+    }
+
+    if(!vram && (buf.size() & 1))
+    {
+        mem.write_mem<u8>(dst + buf.size() - 1,buf.back());
+    }
+}
+
+void Cpu::swi_lz77(bool vram)
+{
+    u32 src = regs[R0];
+    const u32 dst = regs[R1];
+
+    cycle_tick(SWI_OVERHEAD);
+
+    if(bios_source(src))
+    {
+        return;
+    }
+
+    const u32 size = mem.read_mem<u32>(src) >> 8;
+    src += 4;
+
+    auto &buf = swi_buffer;
+    buf.clear();
+
+    while(buf.size() < size)
+    {
+        const u8 flags = mem.read_mem<u8>(src++);
+
+        for(int i = 7; i >= 0 && buf.size() < size; i--)
+        {
+            // raw byte
+            if(!is_set(flags,i))
             {
-                const auto v = mem.read_u32(regs[R0]);
+                buf.push_back(mem.read_mem<u8>(src++));
+                continue;
+            }
 
-                for(size_t i = 0; i < cnt; i++)
-                {
-                    mem.write_u32(dst + (i*4),v);
-                }
+            // copy from earlier in the output
+            const u8 b0 = mem.read_mem<u8>(src++);
+            const u8 b1 = mem.read_mem<u8>(src++);
+
+            const u32 len = (b0 >> 4) + 3;
+            const u32 disp = (((b0 & 0xf) << 8) | b1) + 1;
+
+            for(u32 j = 0; j < len && buf.size() < size; j++)
+            {
+                buf.push_back(disp <= buf.size()? buf[buf.size() - disp] : 0);
             }
+        }
+    }
+
+    swi_write_out(dst,buf,vram);
+    cycle_tick(size * 10);
+}
+
+void Cpu::swi_rl(bool vram)
+{
+    u32 src = regs[R0];
+    const u32 dst = regs[R1];
 
-            else
+    cycle_tick(SWI_OVERHEAD);
+
+    if(bios_source(src))
+    {
+        return;
+    }
+
+    const u32 size = mem.read_mem<u32>(src) >> 8;
+    src += 4;
+
+    auto &buf = swi_buffer;
+    buf.clear();
+
+    while(buf.size() < size)
+    {
+        const u8 flag = mem.read_mem<u8>(src++);
+
+        // run of a single byte
+        if(is_set(flag,7))
+        {
+            const u32 len = (flag & 0x7f) + 3;
+            const u8 v = mem.read_mem<u8>(src++);
+
+            for(u32 i = 0; i < len && buf.size() < size; i++)
             {
-                if(!mem.fast_memcpy<u32>(dst,src,cnt))
-                {
-                    for(size_t i = 0; i < cnt; i++)
-                    {
-                        const auto v = mem.read_u32(src + (i * 4));
-                        mem.write_u32((dst + (i * 4)),v);
-                    }
-                }
+                buf.push_back(v);
             }
-            break;
         }
 
+        // raw bytes
+        else
+        {
+            const u32 len = (flag & 0x7f) + 1;
 
-        default:
-            printf("unknown swi: %x\n",function);
-            exit(1);
-            break;
+            for(u32 i = 0; i < len && buf.size() < size; i++)
+            {
+                buf.push_back(mem.read_mem<u8>(src++));
+            }
+        }
+    }
+
+    swi_write_out(dst,buf,vram);
+    cycle_tick(size * 8);
+}
+
+// output is always written a word at a time
+void Cpu::swi_huffman()
+{
+    u32 src = regs[R0] & ~3;
+    u32 dst = regs[R1];
+
+    cycle_tick(SWI_OVERHEAD);
+
+    if(bios_source(src))
+    {
+        return;
+    }
+
+    const u32 header = mem.read_mem<u32>(src);
+    const u32 size = header >> 8;
+    const u32 bits = (header & 0xf)? header & 0xf : 8;
+
+    // only 4 and 8 bit data is valid
+    if(bits != 4 && bits != 8)
+    {
+        return;
+    }
+
+    const u32 tree = src + 5;
+    const u32 tree_size = (mem.read_mem<u8>(src + 4) * 2) + 1;
+    src = tree + tree_size;
+
+    u32 node_addr = tree;
+    u8 node = mem.read_mem<u8>(node_addr);
+
+    u32 block = 0;
+    u32 block_bits = 0;
+    u32 written = 0;
+
+    while(written < size)
+    {
+        u32 stream = mem.read_mem<u32>(src);
+        src += 4;
+
+        for(int i = 0; i < 32 && written < size; i++, stream <<= 1)
+        {
+            // children are a pair in the tree after this node
+            const u32 next = (node_addr & ~1) + ((node & 0x3f) * 2) + 2;
+            const bool right = is_set(stream,31);
+            const bool data = is_set(node,right? 6 : 7);
+
+            node_addr = next + right;
+            node = mem.read_mem<u8>(node_addr);
+
+            if(!data)
+            {
+                continue;
+            }
+
+            block |= (node & ((1 << bits) - 1)) << block_bits;
+            block_bits += bits;
+
+            node_addr = tree;
+            node = mem.read_mem<u8>(node_addr);
+
+            if(block_bits == 32)
+            {
+                mem.write_mem<u32>(dst,block);
+                dst += 4;
+                written += 4;
+
+                block = 0;
+                block_bits = 0;
+            }
+        }
     }
+
+    cycle_tick(size * 12);
 }
 
-}
\ No newline at end of file
+}
@@ -46,7 +46,16 @@ u16 Cpu::fast_thumb_fetch_mem()
     memcpy(&v,&fetch_ptr[offset],sizeof(v));
     mem.open_bus_value = v;
 
-    cycle_tick(mem.sequential? mem.wait_seq_16 : mem.wait_nseq_16);
+    // rom fetches go through the prefetch buffer
+    if(execute_rom)
+    {
+        cycle_tick(mem.prefetch_fetch(regs[PC],1));
+    }
+
+    else
+    {
+        cycle_tick(mem.sequential? mem.wait_seq_16 : mem.wait_nseq_16);
+    }
     return v;
 }
 
@@ -106,6 +115,63 @@ void Cpu::exec_thumb()
     execute_thumb_opcode(op);
 }
 
+void Cpu::exec_block_thumb()
+{
+    is_thumb_fetch = true;
+
+    u32 page;
+    u32 offset;
+    const u8 *code;
+
+    if(!block_page(pc_actual,page,offset,code))
+    {
+        exec_thumb();
+        return;
+    }
+
+    auto &block = block_cache.lookup_thumb(page,offset,code,thumb_opcode_table.data());
+
+    if(idle_loop.enabled && !idle_loop.game_disabled && idle_loop_check(pc_actual,block))
+    {
+        return;
+    }
+
+#ifdef GBA_JIT_SUPPORTED
+    if(jit.enabled && exec_jit(block))
+    {
+        return;
+    }
+#endif
+
+    const u32 generation = block_cache.generation;
+
+    for(u32 i = 0; i < block.len; i++)
+    {
+        if(i && (scheduler.event_ready() || interrupt_ready()))
+        {
+            return;
+        }
+
+        const u32 pc = pc_actual;
+        const auto op = thumb_fetch_opcode();
+
+        // pipeline was filled before the code was written
+        if(op != block.opcode[i])
+        {
+            execute_thumb_opcode(op);
+            return;
+        }
+
+        std::invoke(block.handler.thumb[i],this,op);
+
+        // branched, switched state or the code changed under us
+        if(pc_actual != pc + ARM_HALF_SIZE || !is_thumb || generation != block_cache.generation)
+        {
+            return;
+        }
+    }
+}
+
 void Cpu::execute_thumb_opcode(u16 instr)
 {
     // get the bits that determine the kind of instr it is
@@ -158,10 +224,14 @@ void Cpu::thumb_swi(u16 opcode)
 
     //printf("swi %08x: %08x\n",read_pc(),opcode);
 
-    // nn is ignored by hardware
-    UNUSED(opcode);
+    // nn is ignored by hardware, the bios reads it out of the instr
     write_log(debug,"[cpu-thumb: {:08x}] swi {:x}",regs[PC],opcode & 0xff);
 
+    if(bios_hle && swi(opcode & 0xff))
+    {
+        return;
+    }
+
     const auto idx = static_cast<int>(cpu_mode::supervisor);
 
     // spsr for supervisor = cpsr
@@ -179,9 +249,6 @@ void Cpu::thumb_swi(u16 opcode)
 
     // branch to interrupt vector
     write_pc(0x8);
-
-    //swi(opcode & 0xff);
-
 }
 
 template<const int RD, const bool IS_PC>
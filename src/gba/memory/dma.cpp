@@ -279,48 +279,110 @@ void Dma::turn_off_video_capture()
     }
 }
 
-bool Dma::do_fast_dma(int reg_num)
+int32_t Dma::src_step(const DmaReg &r, bool word) const
 {
-    auto &r = dma_regs[reg_num];
-
+    // in rom force increment
+    if(r.src_shadow >= 0x08000000 && r.src_shadow <= 0x0e000000)
+    {
+        return addr_increment_table[word][0];
+    }
 
-    // okay for now lets just handle both src & dst incrementing
-    if(r.src_cnt != 0 || r.dst_cnt != 0)
+    // increment + reload is forbidden dont use it
+    if(r.src_cnt == 3)
     {
-        return false;
+        return 0;
     }
 
-    bool success = false;
+    return addr_increment_table[word][r.src_cnt];
+}
+
+int32_t Dma::dst_step(const DmaReg &r, bool word) const
+{
+    return addr_increment_table[word][r.dst_cnt];
+}
+
+template<typename access_type>
+void Dma::transfer_run(DmaReg &r, u32 n, int32_t src_inc, int32_t dst_inc)
+{
+    constexpr int32_t size = sizeof(access_type);
+    const u32 bytes = n * size;
+
+    const u32 src = r.src_shadow & ~(size - 1);
+    const u32 dst = r.dst_shadow & ~(size - 1);
 
-    if(r.is_word)
+    // a forward copy over itself has to repeat what it just wrote
+    const bool overlap = dst > src && dst - src < bytes;
+
+    // both incrementing through plain memory
+    if(src_inc == size && dst_inc == size && !overlap && mem.can_fast_memcpy(dst,src,bytes))
     {
-        success = mem.fast_memcpy<u32>(r.dst_shadow,r.src_shadow,r.word_count_shadow);        
+        mem.bulk_copy(dst,src,bytes);
     }
 
-    else
+    // fill from a fixed source
+    else if(src_inc == 0 && dst_inc == size && mem.can_fast_memcpy(dst,src,bytes))
     {
-        success = mem.fast_memcpy<u16>(r.dst_shadow,r.src_shadow,r.word_count_shadow); 
+        mem.bulk_fill<access_type>(dst,mem.read_mem<access_type>(src),n);
     }
 
-    if(success)
+    // io, decrementing and anything crossing a mirror go through the handlers
+    else
     {
-        // in rom force increment
-        if(r.src_shadow >= 0x08000000 && r.src_shadow <= 0x0e000000)
+        u32 src_addr = r.src_shadow;
+        u32 dst_addr = r.dst_shadow;
+
+        for(u32 i = 0; i < n; i++)
         {
-            r.src_shadow += addr_increment_table[r.is_word][0] * r.word_count_shadow;
+            mem.write_mem<access_type>(dst_addr,mem.read_mem<access_type>(src_addr));
+            src_addr += src_inc;
+            dst_addr += dst_inc;
         }
+    }
+
+    r.src_shadow += src_inc * n;
+    r.dst_shadow += dst_inc * n;
+}
+
+// a transfer takes 2N + 2(n-1)S, so its cost is known before anything is moved
+// units are copied in runs that only break where a scheduler event falls
+// so events still see the transfer part way through like they would a unit at a time
+template<typename access_type>
+void Dma::transfer(DmaReg &r, u32 count, int32_t src_inc, int32_t dst_inc)
+{
+    const u32 n_cost = mem.get_waitstates<access_type>(r.src_shadow,false) + 
+        mem.get_waitstates<access_type>(r.dst_shadow,false);
+
+    const u32 s_cost = mem.get_waitstates<access_type>(r.src_shadow,true) + 
+        mem.get_waitstates<access_type>(r.dst_shadow,true);
+
+    u32 done = 0;
+
+    while(done < count && !r.interrupted)
+    {
+        const u32 first_cost = done? s_cost : n_cost;
 
+        // units until the next event is due, at least one
+        u64 n = 1;
 
-        // increment + reload is forbidden dont use it
-        else if(r.src_cnt != 3)
+        if(!scheduler.event_ready())
         {
-            r.src_shadow += addr_increment_table[r.is_word][r.src_cnt] * r.word_count_shadow;
+            const u64 cycles = scheduler.get_next_event_cycles();
+
+            if(cycles > first_cost)
+            {
+                n += (cycles - first_cost + s_cost - 1) / s_cost;
+            }
         }
 
-        r.dst_shadow += addr_increment_table[r.is_word][r.dst_cnt] * r.word_count_shadow;
-    }
+        const u32 run = std::min<u64>(n,count - done);
 
-    return success;
+        transfer_run<access_type>(r,run,src_inc,dst_inc);
+
+        cpu.cycle_tick(first_cost + ((run - 1) * s_cost));
+        scheduler.service_events();
+
+        done += run;
+    }
 }
 
 void Dma::do_dma(int reg_num, dma_type req_type)
@@ -346,35 +408,12 @@ void Dma::do_dma(int reg_num, dma_type req_type)
     {
         // sound dma transfer 4 arm words
         // triggered by timer overflow
+        // allways in word mode and the dst is not incremented
         case dma_type::fifo_b:
         case dma_type::fifo_a:
         {
             //printf("fifo dma %x from %08x to %08x\n",reg_num,r.src_shadow,r.dst_shadow);
-
-
-            // need to rework our memory model to handle
-            // the n & s cycles implictly at some point
-            // dma takes 2N + 2(n-1)s +xI
-            for(size_t i = 0; i < 4; i++)
-            {
-                const auto v = mem.read_u32(r.src_shadow);
-                mem.write_u32(r.dst_shadow,v);
-
-                // in rom force increment
-                if(r.src_shadow >= 0x08000000 && r.src_shadow <= 0x0e000000)
-                {
-                    r.src_shadow += addr_increment_table[r.is_word][0];
-                }
-   
-                // increment + reload is forbidden dont use it
-                else if(r.src_cnt != 3)
-                {
-                    // allways in word mode here
-                    r.src_shadow += addr_increment_table[r.is_word][r.src_cnt];
-                }
-
-                // dst is not incremented when doing fifo dma
-            }
+            transfer<u32>(r,4,src_step(r,true),0);
             break;
         }
 
@@ -383,34 +422,16 @@ void Dma::do_dma(int reg_num, dma_type req_type)
         {
             write_log(debug,"dma {:x} from {:08x} to {:08x}\n",reg_num,r.src_shadow,r.dst_shadow);
             //std::cout << fmt::format("dma {:x} from {:08x} to {:08x}, {:08x} bytes\n",reg_num,r.src_shadow,r.dst_shadow,r.word_count_shadow);
-            // TODO how does internal cycles work for this?
 
             // todo check for interrupts when we actually handle dma priority
-
-            // cannot easily use a memcpy
-            if(!do_fast_dma(reg_num))
+            if(r.is_word)
             {
-                if(r.is_word)
-                {
-                    for(size_t i = 0; i < r.word_count_shadow; i++)
-                    {
-                        const auto v = mem.read_u32(r.src_shadow);
-                        mem.write_u32(r.dst_shadow,v);
-                        handle_increment(reg_num); 
-                        scheduler.service_events(); 
-                    }
-                }
+                transfer<u32>(r,r.word_count_shadow,src_step(r,true),dst_step(r,true));
+            }
 
-                else
-                {
-                    for(size_t i = 0; i < r.word_count_shadow; i++)
-                    {
-                        const auto v = mem.read_u16(r.src_shadow);
-                        mem.write_u16(r.dst_shadow,v);
-                        handle_increment(reg_num);
-                        scheduler.service_events();
-                    }
-                }
+            else
+            {
+                transfer<u16>(r,r.word_count_shadow,src_step(r,false),dst_step(r,false));
             }
             break;
         }
@@ -430,24 +451,4 @@ void Dma::do_dma(int reg_num, dma_type req_type)
     }
 }
 
-
-void Dma::handle_increment(int reg_num)
-{
-    auto &r = dma_regs[reg_num];
-
-    // in rom force increment
-    if(r.src_shadow >= 0x08000000 && r.src_shadow <= 0x0e000000)
-    {
-        r.src_shadow += addr_increment_table[r.is_word][0];
-    }
-
-    // increment + reload is forbidden dont use it
-    else if(r.src_cnt != 3)
-    {
-        r.src_shadow += addr_increment_table[r.is_word][r.src_cnt];
-    }
-
-    r.dst_shadow += addr_increment_table[r.is_word][r.dst_cnt];
-}
-
 };
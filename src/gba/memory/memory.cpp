@@ -32,6 +32,9 @@ template void Mem::write_memt_no_debug<u32>(u32 addr, u32 v);
 template bool Mem::fast_memcpy<u16>(u32 src, u32 dst, u32 n);
 template bool Mem::fast_memcpy<u32>(u32 src, u32 dst, u32 n);
 
+template void Mem::bulk_fill<u16>(u32 dst, u16 v, u32 n);
+template void Mem::bulk_fill<u32>(u32 dst, u32 v, u32 n);
+
 
 Mem::Mem(GBA &gba) : dma{gba}, debug(gba.debug), cpu(gba.cpu), 
     disp(gba.disp), apu(gba.apu), scheduler(gba.scheduler)
@@ -42,6 +45,7 @@ Mem::Mem(GBA &gba) : dma{gba}, debug(gba.debug), cpu(gba.cpu),
     chip_wram.resize(0x8000);
     pal_ram.resize(0x400);
     vram.resize(0x18000);
+    vram_tile_gen.resize(vram.size() / VRAM_TILE_SIZE);
     oam.resize(0x400); 
     sram.resize(0x8000);
     rom.resize(32*1024*1024);
@@ -79,6 +83,8 @@ void Mem::init(std::string filename)
     std::fill(oam.begin(),oam.end(),0);
     std::fill(sram.begin(),sram.end(),0);
 
+    // anything cached from the last rom is stale
+    touch_vram(0,vram.size());
     
     // read out rom info here...
 
@@ -102,11 +108,6 @@ void Mem::init(std::string filename)
 
             cart_type = save_region[i];
             save_size = save_sizes[i];
-
-            for(int i = 0; i < 3; i++)
-            {
-                wait_states[static_cast<size_t>(memory_region::cart_backup)][i] = cart_wait_states[static_cast<size_t>(cart_type)][i];
-            }
             found = true;
             break;
         }
@@ -184,7 +185,7 @@ void Mem::init(std::string filename)
     mem_io.init();
     dma.init();
     
-    memcpy(wait_states,wait_states_default,sizeof(wait_states));
+    prefetch = {};
     update_wait_states();
 
     // if we are not using the bios boot we need to set postflg
@@ -378,6 +379,8 @@ u8 Mem::read_timer_counter(int timer, int idx)
     const auto event_type = static_cast<gba_event>(timer+static_cast<int>(gba_event::timer0));
     const auto active = scheduler.is_active(event_type);
 
+    volatile_read = true;
+
     // remove and reinsert event
     scheduler.remove(event_type);
 
@@ -1771,11 +1774,25 @@ void Mem::write_oam(u32 addr,access_type v)
     {
         //oam[addr & 0x3ff] = v;
         handle_write<access_type>(oam,addr&0x3ff,v);
+        disp.oam_copy.dirty = true;
     }
 }
 
 
 
+void Mem::touch_vram(u32 offset, u32 bytes)
+{
+    disp.vram_copy.dirty = true;
+
+    const u32 first = offset / VRAM_TILE_SIZE;
+    const u32 last = (offset + bytes - 1) / VRAM_TILE_SIZE;
+
+    for(u32 tile = first; tile <= last; tile++)
+    {
+        vram_tile_gen[tile]++;
+    }
+}
+
 template<typename access_type>
 void Mem::write_vram(u32 addr,access_type v)
 {
@@ -1786,6 +1803,8 @@ void Mem::write_vram(u32 addr,access_type v)
         addr = 0x10000 + (addr & 0x7fff);
     }
 
+    touch_vram(addr,sizeof(access_type));
+
     // 8bit write does weird stuff depending on address
     if constexpr(std::is_same<access_type,u8>())
     {
@@ -1817,6 +1836,7 @@ template<typename access_type>
 void Mem::write_pal_ram(u32 addr,access_type v)
 {
     addr &= 0x3ff;
+    disp.pal_copy.dirty = true;
 
     // 8bit write causes data to wrote to both bytes
     // of the accessed halfword
@@ -1838,6 +1858,7 @@ void Mem::write_board_wram(u32 addr,access_type v)
 {
     //return board_wram[addr & 0x3ffff] = v;
     handle_write<access_type>(board_wram,addr&0x3ffff,v);
+    cpu.block_cache.write_board_wram(addr&0x3ffff);
 }
 
 template<typename access_type>
@@ -1845,6 +1866,7 @@ void Mem::write_chip_wram(u32 addr,access_type v)
 {
     //chip_wram[addr & 0x7fff] = v;
     handle_write<access_type>(chip_wram,addr&0x7fff,v);
+    cpu.block_cache.write_chip_wram(addr&0x7fff);
 }
 
 
@@ -1893,24 +1915,38 @@ bool Mem::can_fast_memcpy(u32 dst, u32 src, u32 bytes) const
     return in_range;
 }
 
-template<typename access_type>
-bool Mem::fast_memcpy(u32 dst, u32 src, u32 n)
+void Mem::bulk_written(memory_region region, u32 offset, u32 bytes)
 {
-    static_assert(sizeof(access_type) >= 2);
-
-    src = align_addr<access_type>(src);
-    dst = align_addr<access_type>(dst);
+    // bypasses the write handlers so tell the block cache directly
+    if(region == memory_region::wram_chip)
+    {
+        cpu.block_cache.write_chip_wram_range(offset,bytes);
+    }
 
-    const auto bytes = n*sizeof(access_type);
+    else if(region == memory_region::wram_board)
+    {
+        cpu.block_cache.write_board_wram_range(offset,bytes);
+    }
 
-    if(!can_fast_memcpy(dst,src,bytes))
+    // and the render thread snapshots
+    else if(region == memory_region::vram)
     {
-        return false;
+        touch_vram(offset,bytes);
     }
 
+    else if(region == memory_region::pal)
+    {
+        disp.pal_copy.dirty = true;
+    }
 
-    
+    else if(region == memory_region::oam)
+    {
+        disp.oam_copy.dirty = true;
+    }
+}
 
+void Mem::bulk_copy(u32 dst, u32 src, u32 bytes)
+{
     const auto src_reg = memory_region_table[(src >> 24) & 0xf];
     const auto dst_reg = memory_region_table[(dst >> 24) & 0xf];
 
@@ -1923,10 +1959,51 @@ bool Mem::fast_memcpy(u32 dst, u32 src, u32 n)
     const auto src_offset = align_addr_to_region(src);
     const auto dst_offset = align_addr_to_region(dst);
 
-    memcpy(dst_ptr+dst_offset,src_ptr+src_offset,bytes);  
+    // memmove as a dma can copy a region over itself
+    memmove(dst_ptr+dst_offset,src_ptr+src_offset,bytes);
+
+    bulk_written(dst_reg,dst_offset,bytes);
+}
+
+template<typename access_type>
+void Mem::bulk_fill(u32 dst, access_type v, u32 n)
+{
+    dst = align_addr<access_type>(dst);
+
+    const auto dst_reg = memory_region_table[(dst >> 24) & 0xf];
+    u8 *dst_ptr = backing_vec[static_cast<size_t>(dst_reg)];
+
+    assert(dst_ptr != nullptr);
+
+    const auto dst_offset = align_addr_to_region(dst);
+
+    for(u32 i = 0; i < n; i++)
+    {
+        memcpy(dst_ptr + dst_offset + (i * sizeof(access_type)),&v,sizeof(access_type));
+    }
+
+    bulk_written(dst_reg,dst_offset,n * sizeof(access_type));
+}
+
+template<typename access_type>
+bool Mem::fast_memcpy(u32 dst, u32 src, u32 n)
+{
+    static_assert(sizeof(access_type) >= 2);
+
+    src = align_addr<access_type>(src);
+    dst = align_addr<access_type>(dst);
+
+    const auto bytes = n*sizeof(access_type);
+
+    if(!can_fast_memcpy(dst,src,bytes))
+    {
+        return false;
+    }
+
+    bulk_copy(dst,src,bytes);
 
-    const auto src_wait = get_waitstates<access_type>(src,false,false);
-    const auto dst_wait = get_waitstates<access_type>(dst,false,false);
+    const auto src_wait = get_waitstates<access_type>(src,false);
+    const auto dst_wait = get_waitstates<access_type>(dst,false);
 
     for(size_t i = 0; i < n; i++)
     {
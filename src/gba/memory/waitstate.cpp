@@ -3,10 +3,6 @@
 namespace gameboyadvance
 {
 
-template u32 Mem::get_waitstates<u32>(u32 addr,bool seq, bool prefetch);
-template u32 Mem::get_waitstates<u16>(u32 addr,bool seq, bool prefetch);
-template u32 Mem::get_waitstates<u8>(u32 addr,bool seq, bool prefetch);
-
 // TODO: this is an approximation i think the real hardware
 // relies on what instrs were executed
 void Mem::update_seq(u32 addr)
@@ -15,149 +11,158 @@ void Mem::update_seq(u32 addr)
     last_addr = addr;
 }
 
-u32 Mem::get_rom_wait(u32 region, u32 size, bool seq, bool use_prefetch)
+// set the timings of a cart region, all in total cycles
+static void set_cart_cycles(u8 (&cycles)[3][2], u32 n, u32 s)
 {
-    // TODO: our speedhacks dont model prefetch properly at the momement
-    // need to actually impl reading out of the buffer, with prefetch_count?
-    if(mem_io.wait_cnt.prefetch && use_prefetch)
+    // byte and half are a single access
+    for(u32 size = 0; size < 2; size++)
     {
-        if(size == sizeof(u32))
-        {
-            // rom is done as two u16 reads
-            return 2;
-        }
+        cycles[size][0] = n;
+        cycles[size][1] = s;
+    }
 
-        // 16 bit or 8 bit
-        else
+    // word is two 16 bit reads, the 2nd is allways seq
+    cycles[2][0] = n + s;
+    cycles[2][1] = s + s;
+}
+
+void Mem::update_wait_states()
+{
+    static constexpr u32 wait_first_table[] = {4,3,2,8};
+    const auto &wait_cnt = mem_io.wait_cnt;
+
+    for(u32 region = 0; region < 8; region++)
+    {
+        for(u32 size = 0; size < 3; size++)
         {
-            return 1;
+            access_cycles[region][size][0] = access_cycles_default[region][size];
+            access_cycles[region][size][1] = access_cycles_default[region][size];
         }
     }
 
-    // no prefetch
-    if(size == sizeof(u32))
+    // each rom waitstate is mirrored over two regions
+    const u32 wait_first[3] = 
     {
-        return rom_wait_states[(region - 8) / 2][seq][size >> 1] + 2;        
-    }
+        wait_first_table[wait_cnt.wait01],
+        wait_first_table[wait_cnt.wait11],
+        wait_first_table[wait_cnt.wait21]
+    };
 
-    else 
+    const u32 wait_second[3] = 
     {
-        return rom_wait_states[(region - 8) / 2][seq][size >> 1] + 1;
-    }    
-}
+        wait_cnt.wait02? 1u : 2u,
+        wait_cnt.wait12? 1u : 4u,
+        wait_cnt.wait22? 1u : 8u
+    };
 
-// we also need to a test refactor using one lib, constants and compiling in one dir
-// and impl a basic timing test
-// this is completly botched...
+    for(u32 ws = 0; ws < 3; ws++)
+    {
+        set_cart_cycles(access_cycles[0x8 + (ws * 2)],wait_first[ws] + 1,wait_second[ws] + 1);
+        set_cart_cycles(access_cycles[0x9 + (ws * 2)],wait_first[ws] + 1,wait_second[ws] + 1);
+    }
 
+    // sram is only 8 bit and has no seq access
+    const u32 sram_cycles = wait_first_table[wait_cnt.sram_cnt] + 1;
 
-void set_wait_seq(int *buf, int wait)
-{
-    // waitstate + N OR S
-    buf[0] =  wait;
-    buf[1] =  wait;
+    for(u32 region = 0xe; region < 0x10; region++)
+    {
+        for(u32 size = 0; size < 3; size++)
+        {
+            access_cycles[region][size][0] = sram_cycles;
+            access_cycles[region][size][1] = sram_cycles;
+        }
+    }
 
-    // waitstate times two as there are two u16 reads
-    buf[2] =  (wait * 2);
-}
+    if(!wait_cnt.prefetch)
+    {
+        prefetch.active = false;
+    }
 
-void set_wait_nseq(int *buf, int wait, int wait_seq)
-{
-    buf[0] =  wait;
-    buf[1] =  wait;    
+#ifdef FETCH_SPEEDHACK
 
-    // 2nd of the 16 bit fetches is allways seq
-    buf[2] = wait + wait_seq;
+    // settings have changed recache waitstates
+    cache_wait_states(cpu.pc_actual);
+#endif
 }
 
 
-
-void Mem::update_wait_states()
+void Mem::cache_wait_states(u32 new_pc)
 {
-    static constexpr u32 wait_first_table[] = {4,3,2,8};
-    const auto &wait_cnt = mem_io.wait_cnt;
+    // cost of a fetch that misses the prefetch buffer
+    wait_seq_16 = get_waitstates<u16>(new_pc,true);
+    wait_seq_32 = get_waitstates<u32>(new_pc,true);
 
-    const auto wait_first0 = wait_first_table[wait_cnt.wait01];
-    const auto wait_second0 = !wait_cnt.wait02? 2 : 1;
-    set_wait_nseq(&rom_wait_states[0][0][0],wait_first0,wait_second0);
-    set_wait_seq(&rom_wait_states[0][1][0],wait_second0);
-
-    const auto wait_first1 = !wait_first_table[wait_cnt.wait11];
-    const auto wait_second1 = wait_cnt.wait12? 1 : 4;
-    set_wait_nseq(&rom_wait_states[1][0][0],wait_first1,wait_second1);
-    set_wait_seq(&rom_wait_states[1][1][0],wait_second1);
+    wait_nseq_16 = get_waitstates<u16>(new_pc,false);
+    wait_nseq_32 = get_waitstates<u32>(new_pc,false);
+}
 
+void Mem::prefetch_fill(u32 cycles)
+{
+    prefetch.cycles += cycles;
 
-    const auto wait_first2 = wait_first_table[wait_cnt.wait21];
-    const auto wait_second2 = wait_cnt.wait22? 1 : 8;
-    set_wait_nseq(&rom_wait_states[2][0][0],wait_first2,wait_second2);
-    set_wait_seq(&rom_wait_states[2][1][0],wait_second2);
-    
-    // sram is just normal state can be seen as S
-    const auto sram_wait = wait_first_table[wait_cnt.sram_cnt];
-    set_wait_seq(&wait_states[static_cast<size_t>(memory_region::cart_backup)][0],sram_wait);
+    const u32 fetched = std::min(PREFETCH_SIZE - prefetch.count,prefetch.cycles / prefetch.seq_cycles);
 
-#ifdef FETCH_SPEEDHACK
+    prefetch.count += fetched;
+    prefetch.cycles -= fetched * prefetch.seq_cycles;
 
-    // settings have changed recache waitstates
-    cache_wait_states(cpu.pc_actual);
-#endif
+    // a full buffer stops fetching
+    if(prefetch.count == PREFETCH_SIZE)
+    {
+        prefetch.cycles = 0;
+    }
 }
 
+u32 Mem::prefetch_fetch(u32 addr, u32 halfs)
+{
+    // miss, a normal access and the prefetcher starts again behind it
+    if(!prefetch.active || addr != prefetch.addr)
+    {
+        const u32 cycles = halfs == 2? get_waitstates<u32>(addr,sequential) : get_waitstates<u16>(addr,sequential);
 
+        prefetch.active = mem_io.wait_cnt.prefetch;
+        prefetch.addr = addr + (halfs * ARM_HALF_SIZE);
+        prefetch.count = 0;
+        prefetch.cycles = 0;
+        prefetch.seq_cycles = get_waitstates<u16>(addr,true);
 
-template<typename access_type>
-u32 Mem::get_waitstates(u32 addr, bool seq, bool use_prefetch)
-{
-    static_assert(sizeof(access_type) <= 4);
+        return cycles;
+    }
 
-    // need to re pull the region incase dma triggered reads
-    const int region =  (addr >> 24) & 0xf; 
-    const auto mem_region = memory_region_table[region];
-    
-    switch(mem_region)
-    {
-        case memory_region::undefined:
-        {
-            // how long should this take?
-            return 1;
-        }
+    u32 wait = 0;
 
-        // TODO: emulate N and S cycles
-        case memory_region::rom:
+    for(u32 i = 0; i < halfs; i++)
+    {
+        if(prefetch.count)
         {
-            // hardcode to sequential access!
-            return get_rom_wait(region,sizeof(access_type),seq,use_prefetch);
+            prefetch.count--;
         }
 
-        // should unmapped addresses still tick a cycle?
-        default:
+        // wait on the halfword in flight
+        else
         {
-            // access type >> 1 to get the value
-            // 4 -> 2 (word)
-            // 2 -> 1 (half)
-            // 1 -> 0 (byte)
-            return wait_states[region][sizeof(access_type) >> 1];
+            wait += prefetch.seq_cycles - prefetch.cycles;
+            prefetch.cycles = 0;
         }
     }
-}
 
+    prefetch.addr += halfs * ARM_HALF_SIZE;
 
-void Mem::cache_wait_states(u32 new_pc)
-{
-    // just assume prefetch is allways on
-    wait_seq_16 = get_waitstates<u16>(new_pc,true,true);
-    wait_seq_32 = get_waitstates<u32>(new_pc,true,true);
+    // straight out the buffer is a single cycle for either width
+    // and the prefetcher keeps going meanwhile
+    if(!wait)
+    {
+        prefetch_fill(1);
+        return 1;
+    }
 
-    wait_nseq_16 = get_waitstates<u16>(new_pc,false,true);
-    wait_nseq_32 = get_waitstates<u32>(new_pc,false,true);
+    // otherwise done when the last halfword comes off the cart
+    return wait;
 }
 
 void Mem::do_prefetch()
 {
-    // prefetch if enabled.. 
-    // TODO: i think this is supposed to actually take a couple of cycles...
-    prefetch_count += mem_io.wait_cnt.prefetch;
+    // an internal cycle leaves the cart bus free
+    prefetch_step(1);
 }
 
 }
\ No newline at end of file
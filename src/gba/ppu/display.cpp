@@ -13,17 +13,18 @@ static constexpr u32 VIS_CYC = 1006;
 Display::Display(GBA &gba) : mem(gba.mem), cpu(gba.cpu), scheduler(gba.scheduler)
 {
     screen.resize(SCREEN_WIDTH*SCREEN_HEIGHT);
-    scanline.resize(SCREEN_WIDTH);
-    
-    sprite_line.resize(SCREEN_WIDTH);
-    sprite_semi_transparent.resize(SCREEN_WIDTH);
-    window.resize(SCREEN_WIDTH);
-    oam_priority.resize(SCREEN_WIDTH);
-    sprite_priority.resize(SCREEN_WIDTH);
+
+    // viewers read straight out of memory
+    renderer.vram = &mem.vram;
+    renderer.pal_ram = &mem.pal_ram;
+    renderer.oam = &mem.oam;
+    renderer.vram_gen = &mem.vram_tile_gen;
 }
 
 void Display::init()
 {
+    finish_render();
+
     std::fill(screen.begin(),screen.end(),0);
     cyc_cnt = 0; // current number of elapsed cycles
     ly = 0;
@@ -59,6 +60,61 @@ void Display::update_vcount_compare()
     disp_stat.lyc_hit = cur;
 }
 
+LineState Display::latch_line() const
+{
+    LineState state;
+
+    state.disp_io = disp_io;
+    state.ly = ly;
+    state.window_0_y_triggered = window_0_y_triggered;
+    state.window_1_y_triggered = window_1_y_triggered;
+
+    state.vram = &mem.vram;
+    state.pal_ram = &mem.pal_ram;
+    state.oam = &mem.oam;
+    state.vram_gen = &mem.vram_tile_gen;
+
+    return state;
+}
+
+void Display::render()
+{
+    auto state = latch_line();
+    u32 *out = &screen[ly * SCREEN_WIDTH];
+
+    if(!render_pool.active())
+    {
+        renderer.render(state,out);
+        return;
+    }
+
+    // memory can be written before the line is drawn so hand it a copy
+    // most lines dont touch any of it and share the last one
+    vram_gen_copy.dirty |= vram_copy.dirty;
+    state.vram = vram_copy.take(mem.vram);
+    state.vram_gen = vram_gen_copy.take(mem.vram_tile_gen);
+    state.pal_ram = pal_copy.take(mem.pal_ram);
+    state.oam = oam_copy.take(mem.oam);
+
+    render_pool.submit(state,out);
+}
+
+void Display::finish_render()
+{
+    render_pool.wait();
+
+    vram_copy.reset();
+    vram_gen_copy.reset();
+    pal_copy.reset();
+    oam_copy.reset();
+}
+
+void Display::set_render_threads(u32 threads)
+{
+    finish_render();
+    render_pool.start(threads);
+}
+
 void Display::advance_line()
 {
     ly++;
@@ -183,6 +239,9 @@ void Display::tick(int cycles)
                 // 160 we need to enter vblank
                 if(ly == SCREEN_HEIGHT) 
                 {
+                    // frame has to be complete before anyone sees it
+                    finish_render();
+
                     mode = display_mode::vblank;
                     disp_io.disp_stat.vblank = true;
                     new_vblank = true;
@@ -1,5 +1,13 @@
 #include <gba/gba.h>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define GBA_MERGE_SIMD
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GBA_MERGE_SIMD
+#endif
+
 namespace gameboyadvance
 {
 
@@ -29,117 +37,257 @@ u32 convert_color(u16 color)
 	return COL_15BPP_LUT[deset_bit(color,15)];
 }
 
+#ifdef GBA_MERGE_SIMD
+
+// lane helpers for merge_layers_simd, one pixel per 16 bit lane
+
+#if defined(__AVX2__)
+
+struct MergeLanes
+{
+    using Vec = __m256i;
+    static constexpr u32 WIDTH = 16;
+
+    static Vec load(const void *ptr) { return _mm256_loadu_si256(static_cast<const Vec*>(ptr)); }
+    static Vec zero() { return _mm256_setzero_si256(); }
+    static Vec splat(u32 v) { return _mm256_set1_epi16(static_cast<short>(v)); }
+    static Vec mask(bool v) { return splat(v? 0xffff : 0); }
+
+    static Vec bit_and(Vec a, Vec b) { return _mm256_and_si256(a,b); }
+    static Vec bit_or(Vec a, Vec b) { return _mm256_or_si256(a,b); }
+    static Vec bit_not(Vec a) { return _mm256_xor_si256(a,_mm256_set1_epi16(-1)); }
+
+    // ~a & b
+    static Vec bit_andnot(Vec a, Vec b) { return _mm256_andnot_si256(a,b); }
+
+    static Vec eq(Vec a, Vec b) { return _mm256_cmpeq_epi16(a,b); }
+    static Vec gt(Vec a, Vec b) { return _mm256_cmpgt_epi16(a,b); }
+    static Vec select(Vec mask, Vec a, Vec b) { return _mm256_blendv_epi8(b,a,mask); }
+
+    static Vec add(Vec a, Vec b) { return _mm256_add_epi16(a,b); }
+    static Vec sub(Vec a, Vec b) { return _mm256_sub_epi16(a,b); }
+    static Vec mul(Vec a, Vec b) { return _mm256_mullo_epi16(a,b); }
+    static Vec min(Vec a, Vec b) { return _mm256_min_epi16(a,b); }
+
+    template<int N>
+    static Vec srl(Vec a) { return _mm256_srli_epi16(a,N); }
+
+    template<int N>
+    static Vec sll(Vec a) { return _mm256_slli_epi16(a,N); }
+
+    static bool any(Vec mask) { return _mm256_movemask_epi8(mask) != 0; }
+
+    // convert_color, must match pop_15bpp_color_lut
+    static Vec to_rgba(Vec c)
+    {
+        const Vec r = _mm256_slli_epi32(_mm256_and_si256(c,_mm256_set1_epi32(0x001f)),3);
+        const Vec g = _mm256_slli_epi32(_mm256_and_si256(c,_mm256_set1_epi32(0x03e0)),6);
+        const Vec b = _mm256_slli_epi32(_mm256_and_si256(c,_mm256_set1_epi32(0x7c00)),9);
+
+        return _mm256_or_si256(_mm256_or_si256(r,g),_mm256_or_si256(b,_mm256_set1_epi32(0xff000000)));
+    }
+
+    static void store_color(u32 *out, Vec c)
+    {
+        const Vec lo = _mm256_cvtepu16_epi32(_mm256_castsi256_si128(c));
+        const Vec hi = _mm256_cvtepu16_epi32(_mm256_extracti128_si256(c,1));
+
+        _mm256_storeu_si256(reinterpret_cast<Vec*>(out),to_rgba(lo));
+        _mm256_storeu_si256(reinterpret_cast<Vec*>(out + 8),to_rgba(hi));
+    }
+};
+
+#else
+
+// sse2 is all this needs and every x86-64 host has it
+struct MergeLanes
+{
+    using Vec = __m128i;
+    static constexpr u32 WIDTH = 8;
+
+    static Vec load(const void *ptr) { return _mm_loadu_si128(static_cast<const Vec*>(ptr)); }
+    static Vec zero() { return _mm_setzero_si128(); }
+    static Vec splat(u32 v) { return _mm_set1_epi16(static_cast<short>(v)); }
+    static Vec mask(bool v) { return splat(v? 0xffff : 0); }
+
+    static Vec bit_and(Vec a, Vec b) { return _mm_and_si128(a,b); }
+    static Vec bit_or(Vec a, Vec b) { return _mm_or_si128(a,b); }
+    static Vec bit_not(Vec a) { return _mm_xor_si128(a,_mm_set1_epi16(-1)); }
+
+    // ~a & b
+    static Vec bit_andnot(Vec a, Vec b) { return _mm_andnot_si128(a,b); }
+
+    static Vec eq(Vec a, Vec b) { return _mm_cmpeq_epi16(a,b); }
+    static Vec gt(Vec a, Vec b) { return _mm_cmpgt_epi16(a,b); }
+    static Vec select(Vec mask, Vec a, Vec b) { return _mm_or_si128(_mm_and_si128(mask,a),_mm_andnot_si128(mask,b)); }
+
+    static Vec add(Vec a, Vec b) { return _mm_add_epi16(a,b); }
+    static Vec sub(Vec a, Vec b) { return _mm_sub_epi16(a,b); }
+    static Vec mul(Vec a, Vec b) { return _mm_mullo_epi16(a,b); }
+    static Vec min(Vec a, Vec b) { return _mm_min_epi16(a,b); }
+
+    template<int N>
+    static Vec srl(Vec a) { return _mm_srli_epi16(a,N); }
+
+    template<int N>
+    static Vec sll(Vec a) { return _mm_slli_epi16(a,N); }
+
+    static bool any(Vec mask) { return _mm_movemask_epi8(mask) != 0; }
+
+    // convert_color, must match pop_15bpp_color_lut
+    static Vec to_rgba(Vec c)
+    {
+        const Vec r = _mm_slli_epi32(_mm_and_si128(c,_mm_set1_epi32(0x001f)),3);
+        const Vec g = _mm_slli_epi32(_mm_and_si128(c,_mm_set1_epi32(0x03e0)),6);
+        const Vec b = _mm_slli_epi32(_mm_and_si128(c,_mm_set1_epi32(0x7c00)),9);
+
+        return _mm_or_si128(_mm_or_si128(r,g),_mm_or_si128(b,_mm_set1_epi32(0xff000000)));
+    }
+
+    static void store_color(u32 *out, Vec c)
+    {
+        const Vec lo = _mm_unpacklo_epi16(c,_mm_setzero_si128());
+        const Vec hi = _mm_unpackhi_epi16(c,_mm_setzero_si128());
+
+        _mm_storeu_si128(reinterpret_cast<Vec*>(out),to_rgba(lo));
+        _mm_storeu_si128(reinterpret_cast<Vec*>(out + 4),to_rgba(hi));
+    }
+};
+
+#endif
+
+#endif
+
+Renderer::Renderer()
+{
+    oam_priority.resize(SCREEN_WIDTH);
+}
+
 // TODO: implement lazy evaluation
 
 // renderer helper functions
-u16 Display::read_bg_palette(u32 pal_num,u32 idx)
+u16 Renderer::read_bg_palette(u32 pal_num,u32 idx)
 {
-    return handle_read<u16>(mem.pal_ram,(0x20*pal_num)+idx*2);        
+    return handle_read<u16>(*pal_ram,(0x20*pal_num)+idx*2);        
 }
 
 
-u16 Display::read_obj_palette(u32 pal_num,u32 idx)
+u16 Renderer::read_obj_palette(u32 pal_num,u32 idx)
 {
     // 0x200 base for sprites into pal ram
-    return handle_read<u16>(mem.pal_ram,0x200+(0x20*pal_num)+(idx*2));        
+    return handle_read<u16>(*pal_ram,0x200+(0x20*pal_num)+(idx*2));        
 }
 
 
 // TODO: specialise this with lambda to only bother drawing 2nd target when we actually need to
 // do a blend
-void Display::draw_tile(u32 x,const TileData &p)
+void Renderer::draw_tile(u32 x,const TileData &p)
 {
     // 1st target is empty
-    if(scanline[x].t1.source == pixel_source::bd)
+    if(layer.source1[x] == pixel_source::bd)
     {
-        scanline[x].t1 = p;
+        layer.color1[x] = p.color;
+        layer.source1[x] = p.source;
     }
 
     // 2nd target is empty
-    else if(scanline[x].t2.source == pixel_source::bd)
+    else if(layer.source2[x] == pixel_source::bd)
     {
-        scanline[x].t2 = p;
+        layer.color2[x] = p.color;
+        layer.source2[x] = p.source;
     }
 }
 
-void Display::read_tile(TileData *tile,unsigned int bg,bool col_256,u32 base,u32 pal_num,u32 tile_num, 
-    u32 y,bool x_flip, bool y_flip)
+const Renderer::TileRow& Renderer::decode_row(bool col_256, u32 addr)
 {
-    u32 tile_y = y & 7;
-    tile_y = y_flip? tile_y ^ 7 : tile_y;
+    const u32 size = col_256? 8 : 4;
+
+    if(addr + size > vram->size())
+    {
+        return blank_row;
+    }
 
+    auto &rows = col_256? tile_row_8bpp : tile_row_4bpp;
 
-    const TileData DEAD_TILE(read_bg_palette(0,0),pixel_source::bd);
+    if(rows.size() != vram->size() / size)
+    {
+        rows.clear();
+        rows.resize(vram->size() / size);
+    }
+
+    auto &row = rows[addr / size];
+    const u32 gen = (*vram_gen)[addr / Mem::VRAM_TILE_SIZE];
+
+    if(row.valid && row.gen == gen)
+    {
+        return row;
+    }
 
     // 8bpp 
     if(col_256)
     {
-        // each tile accounts for 8 vertical pixels but is 64 bytes long
-        const u32 addr = base+(tile_num*0x40) + (tile_y * 8); 
-
-        int x_pix = x_flip? 7 : 0;
-        const int x_step = x_flip? -1 : +1;
-        for(int x = 0; x < 8; x++, x_pix += x_step)
+        for(u32 x = 0; x < 8; x++)
         {
-            
-            const auto tile_data = mem.vram[addr+x_pix];
-            tile[x] = DEAD_TILE;
-            if(tile_data)
-            {
-                tile[x].color = read_bg_palette(0,tile_data);
-                tile[x].source = static_cast<pixel_source>(bg);
-            }
+            row.idx[x] = (*vram)[addr+x];
         }
-
     }
 
     //4bpp
     else
     {
+        // lower x cord stored in lower nibble
+        for(u32 x = 0; x < 8; x += 2)
+        {
+            const u8 tile_data = (*vram)[addr+(x / 2)];
 
-        // each tile accounts for 8 vertical pixels but is 32 bytes long
-        const u32 addr = base+(tile_num*0x20) + (tile_y * 4); 
+            row.idx[x] = tile_data & 0xf;
+            row.idx[x+1] = tile_data >> 4;
+        }
+    }
 
-        int x_pix = x_flip? 3 : 0;
-        const int x_step = x_flip? -1 : +1;
+    row.gen = gen;
+    row.valid = true;
 
-        // depending on x flip we need to swap the nibbles
-        // ie with no xflip we need to use the lower nibble first
-        // then shift down the 2nd nibble out of the byte
-        // when we are x flipping the 1st part of the data
-        // will be in the higher part of the  byte
-        // as we are reading it backwards
-        const int shift_one = x_flip << 2;
-        const int shift_two = !x_flip << 2;
-        
-        const auto source = static_cast<pixel_source>(bg);
-        for(int x = 0; x < 8; x += 2, x_pix += x_step)
-        {
-            // read out the color indexs from the tile
-            const uint8_t tile_data = mem.vram[addr+x_pix];
+    return row;
+}
 
-            const u32 idx1 = (tile_data >> shift_one) & 0xf;
-            const u32 idx2 = (tile_data >> shift_two) & 0xf;
+void Renderer::read_tile(TileData *tile,unsigned int bg,bool col_256,u32 base,u32 pal_num,u32 tile_num, 
+    u32 y,bool x_flip, bool y_flip)
+{
+    u32 tile_y = y & 7;
+    tile_y = y_flip? tile_y ^ 7 : tile_y;
 
-            tile[x] = DEAD_TILE;
-            if(idx1)
-            {
-                tile[x].color = read_bg_palette(pal_num,idx1);
-                tile[x].source = source;
-            }
 
-            tile[x+1] = DEAD_TILE;
-            if(idx2)
-            {
-                tile[x+1].color = read_bg_palette(pal_num,idx2);
-                tile[x+1].source = source;
-            }
+    const TileData DEAD_TILE(read_bg_palette(0,0),pixel_source::bd);
+
+    // each tile accounts for 8 vertical pixels but is 64 bytes long in 8bpp
+    // and 32 in 4bpp
+    const u32 addr = col_256? base+(tile_num*0x40) + (tile_y * 8) : base+(tile_num*0x20) + (tile_y * 4);
+
+    const auto &row = decode_row(col_256,addr);
+
+    // all 256 colors are in one palette
+    pal_num = col_256? 0 : pal_num;
+
+    // x flip just reads the row backwards
+    const u32 x_mask = x_flip? 7 : 0;
+
+    const auto source = static_cast<pixel_source>(bg);
+    for(u32 x = 0; x < 8; x++)
+    {
+        const u32 idx = row.idx[x ^ x_mask];
+
+        tile[x] = DEAD_TILE;
+        if(idx)
+        {
+            tile[x].color = read_bg_palette(pal_num,idx);
+            tile[x].source = source;
         }
     }
 }
 
 
-void Display::render_affine(int id)
+void Renderer::render_affine(int id)
 {
     if(!disp_io.disp_cnt.bg_enable[id])
     {
@@ -172,6 +320,10 @@ void Display::render_affine(int id)
     auto &ref_point_x = ref_point.int_ref_point_x;
     auto &ref_point_y = ref_point.int_ref_point_y;
 
+    // neighbouring pixels usually sample the same tile row
+    u32 cur_row_key = 0xffffffff;
+    const TileRow *row = nullptr;
+
     for(u32 x = 0; x < SCREEN_WIDTH; x++)
     {
         if(!bg_window_enabled(id,x))
@@ -231,18 +383,28 @@ void Display::render_affine(int id)
             }
         }
 
-        // get tile num from bg map
-        const auto tile_num = mem.vram[bg_map_base + ((y_affine / 8) * map_size) + (x_affine / 8)];
-
         // now figure out where we are offset into the current tile and smash it into the line
         const auto tile_x = x_affine & 7;
         const auto tile_y = y_affine & 7;
 
-        // each tile accounts for 8 vertical pixels but is 64 bytes long
-        const u32 addr = bg_tile_data_base+(tile_num*0x40) + (tile_y * 8); 
-        
-        // affine is allways 8bpp
-        const uint8_t tile_data = mem.vram[addr+tile_x];
+        const u32 map_offset = ((y_affine / 8) * map_size) + (x_affine / 8);
+        const u32 row_key = (map_offset << 3) | tile_y;
+
+        // only go back to the map when we have moved onto another tile row
+        if(row_key != cur_row_key)
+        {
+            // get tile num from bg map
+            const auto tile_num = (*vram)[bg_map_base + map_offset];
+
+            // each tile accounts for 8 vertical pixels but is 64 bytes long
+            const u32 addr = bg_tile_data_base+(tile_num*0x40) + (tile_y * 8); 
+
+            // affine is allways 8bpp
+            row = &decode_row(true,addr);
+            cur_row_key = row_key;
+        }
+
+        const uint8_t tile_data = row->idx[tile_x];
         if(tile_data != 0)
         {
             const auto color = read_bg_palette(0,tile_data);
@@ -252,7 +414,7 @@ void Display::render_affine(int id)
 }
 
 // nasty optimisation
-bool Display::is_bg_window_trivial(int id)
+bool Renderer::is_bg_window_trivial(int id)
 {
     const auto &win_arr = disp_io.win_cnt.win_arr;
     const auto &disp_cnt = disp_io.disp_cnt;
@@ -289,7 +451,7 @@ bool Display::is_bg_window_trivial(int id)
     return bg_window_trivial;
 }
 
-void Display::render_text(int id)
+void Renderer::render_text(int id)
 {
     if(!disp_io.disp_cnt.bg_enable[id])
     {
@@ -379,7 +541,7 @@ void Display::render_text(int id)
         }
 
         // read out the bg entry and rip all the information we need about the tile
-        const u32 bg_map_entry = handle_read<u16>(mem.vram,bg_map_base+bg_map_offset);
+        const u32 bg_map_entry = handle_read<u16>(*vram,bg_map_base+bg_map_offset);
 
         u32 tile_offset;
         if(x == 0)
@@ -513,7 +675,7 @@ inline int32_t do_darken(int32_t evy, int32_t color)
     return r | (g << 5) | (b << 10);
 }
 
-void Display::merge_layers()
+void Renderer::merge_layers()
 {
     const auto disp_cnt = disp_io.disp_cnt;
     const auto render_mode = disp_cnt.bg_mode;
@@ -536,153 +698,335 @@ void Display::merge_layers()
         // (ideally we would not render the bitmap at all if has lost priority)
         for(unsigned int x = 0; x < SCREEN_WIDTH; x++)
         {
-            const auto s = sprite_line[x];
             // col number zero is transparent
-            if(s.source != pixel_source::bd && sprite_window_enabled(x))
+            if(layer.obj_source[x] != pixel_source::bd && sprite_window_enabled(x))
             {
-                screen[(ly*SCREEN_WIDTH) + x] = convert_color(s.color);
+                line[x] = convert_color(layer.obj_color[x]);
             }
         }
     }
 
     else
     {
+        // vector path does as much of the line as it can
+        const u32 done = merge_layers_simd();
+        merge_layers_scalar(done,SCREEN_WIDTH);
+    }
+}
+
+void Renderer::merge_layers_scalar(u32 start, u32 end)
+{
+    const auto &bld_cnt = disp_io.bld_cnt;
 
-        const auto &bld_cnt = disp_io.bld_cnt;
+    // ok so now after we find what exsacly is the first to win
+    // we can then check if 1st target
+    // and then redo the search starting from it for 2nd target
+    // and perform whatever effect if we need to :)
+    for(u32 x = start; x < end; x++)
+    {
+        const TileData s(layer.obj_color[x],layer.obj_source[x]);
+        const bool sprite_enable = sprite_window_enabled(x) && s.source == pixel_source::obj;
 
-        // ok so now after we find what exsacly is the first to win
-        // we can then check if 1st target
-        // and then redo the search starting from it for 2nd target
-        // and perform whatever effect if we need to :)
-        for(size_t x = 0; x < SCREEN_WIDTH; x++)
-        {
+        // check color1 prioritys
+        // TODO: can we push this off into the sprite rendering code?
+        // this will require a pre pass for doing the obj window
 
-            auto &s = sprite_line[x];
-            const bool sprite_enable = sprite_window_enabled(x) && s.source == pixel_source::obj;
+        const TileData b1(layer.color1[x],layer.source1[x]);
+        const TileData b2(layer.color2[x],layer.source2[x]);
 
-            // check color1 prioritys
-            // TODO: can we push this off into the sprite rendering code?
-            // this will require a pre pass for doing the obj window
+        // lower priority is higher, sprite wins even if its equal
+        const bool obj_win1 = (sprite_enable) && 
+            (b1.source == pixel_source::bd || layer.obj_priority[x] <= disp_io.bg_cnt[static_cast<u32>(b1.source)].priority);
 
-            auto &b1 = scanline[x].t1;
-            auto &b2 = scanline[x].t2;
+        auto p1 = obj_win1? s : b1;
 
-            // lower priority is higher, sprite wins even if its equal
-            const bool obj_win1 = (sprite_enable) && 
-                (b1.source == pixel_source::bd || sprite_priority[x] <= disp_io.bg_cnt[static_cast<u32>(b1.source)].priority);
 
-            auto &p1 = obj_win1? s : b1;
+        // special effects disabled dont care
+        if(!special_window_enabled(x))
+        {
+            line[x] = convert_color(p1.color);
+            continue;
+        }
 
+        // TODO:
+        // if we can trivially see that there wont be any alpha blending on this line
+        // dont bother fetching the 2nd color
+        
+        // check color2 prioritys
+        
 
-            // special effects disabled dont care
-            if(!special_window_enabled(x))
-            {
-                screen[(ly*SCREEN_WIDTH) + x] = convert_color(p1.color);
-                continue;
-            }
+        // lower priority is higher, sprite wins even if its equal
+        // if obj has allready won then we dont care
+        const bool obj_win2 = (!obj_win1 && sprite_enable) &&  
+            (b2.source == pixel_source::bd || layer.obj_priority[x] <= disp_io.bg_cnt[static_cast<u32>(b2.source)].priority);
 
-            // TODO:
-            // if we can trivially see that there wont be any alpha blending on this line
-            // dont bother fetching the 2nd color
-            
-            // check color2 prioritys
-            
+        const auto &p2 = obj_win2? s : b2;
 
-            // lower priority is higher, sprite wins even if its equal
-            // if obj has allready won then we dont care
-            const bool obj_win2 = (!obj_win1 && sprite_enable) &&  
-                (b2.source == pixel_source::bd || sprite_priority[x] <= disp_io.bg_cnt[static_cast<u32>(b2.source)].priority);
+        // TODO look at metroid save for edge case with alpha blending
+        // handle sfx 
 
-            auto &p2 = obj_win2? s : b2;
+        // if semi transparent object is 1st layer
+        // then we need to override the mode to alpha blending
+        int special_effect = bld_cnt.special_effect;
+        const bool second_target_enable = bld_cnt.second_target_enable[static_cast<int>(p2.source)];
+        // if there are overlapping layers and sprite is semi transparent
+        // do alpha blend
+        const bool semi_transparent = layer.obj_semi_transparent[x] && p1.source == pixel_source::obj
+            && second_target_enable;
 
-            // TODO look at metroid save for edge case with alpha blending
-            // handle sfx 
+        const bool first_target_enable = bld_cnt.first_target_enable[static_cast<int>(p1.source)];
 
-            // if semi transparent object is 1st layer
-            // then we need to override the mode to alpha blending
-            int special_effect = bld_cnt.special_effect;
-            const bool second_target_enable = bld_cnt.second_target_enable[static_cast<int>(p2.source)];
-            // if there are overlapping layers and sprite is semi transparent
-            // do alpha blend
-            const bool semi_transparent = sprite_semi_transparent[x] && p1.source == pixel_source::obj
-                && second_target_enable;
+        if(semi_transparent)
+        {
+            special_effect = 1;
+        }
+        
 
-            const bool first_target_enable = bld_cnt.first_target_enable[static_cast<int>(p1.source)];
+        // todo account for special effects window
+        // and split this function off
+       
 
-            if(semi_transparent)
+        switch(special_effect)
+        {
+            // no special effects just slam to screen
+            case 0:
             {
-                special_effect = 1;
+                break;
             }
-            
-
-            // todo account for special effects window
-            // and split this function off
-           
 
-            switch(special_effect)
+            // alpha blending (delayed because we handle it along with semi transparency)
+            case 1:
             {
-                // no special effects just slam to screen
-                case 0:
-                {
-                    break;
-                }
-
-                // alpha blending (delayed because we handle it along with semi transparency)
-                case 1:
+                
+                if((first_target_enable || semi_transparent) && p1.source != pixel_source::bd)
                 {
-                    
-                    if((first_target_enable || semi_transparent) && p1.source != pixel_source::bd)
+                    // we have a 1st and second target now we just need to blend them :P
+                    if(second_target_enable)
                     {
-                        // we have a 1st and second target now we just need to blend them :P
-                        if(second_target_enable)
-                        {
-                            p1.color = do_blend(disp_io.eva,disp_io.evb,p1.color,p2.color);
-                        }
+                        p1.color = do_blend(disp_io.eva,disp_io.evb,p1.color,p2.color);
                     }
-                    break;
                 }
+                break;
+            }
 
 
-                // brighness increase 
-                case 2:
+            // brighness increase 
+            case 2:
+            {
+                if(first_target_enable)
                 {
-                    if(first_target_enable)
-                    {
-                        p1.color = do_brighten(disp_io.evy,p1.color);
-                    }
-                    break;
+                    p1.color = do_brighten(disp_io.evy,p1.color);
                 }
+                break;
+            }
 
-                // brightness decrease
-                case 3:
+            // brightness decrease
+            case 3:
+            {
+                if(first_target_enable)
                 {
-                    if(first_target_enable)
-                    {
-                        p1.color = do_darken(disp_io.evy,p1.color);
-                    }
-                    break;
+                    p1.color = do_darken(disp_io.evy,p1.color);
                 }
+                break;
             }
+        }
 
-            screen[(ly*SCREEN_WIDTH) + x] = convert_color(p1.color);
-            
+        line[x] = convert_color(p1.color);
+        
+    }
+}
+
+#ifdef GBA_MERGE_SIMD
+
+// same steps as merge_layers_scalar but for a full vector of pixels at a time
+// every per pixel decision is turned into a lane mask
+u32 Renderer::merge_layers_simd()
+{
+    using V = MergeLanes;
+    using Vec = V::Vec;
+
+    const auto &bld_cnt = disp_io.bld_cnt;
+    const auto &win_arr = disp_io.win_cnt.win_arr;
+    const bool windowing = disp_io.disp_cnt.windowing_enabled;
+
+    // per line lookup tables splatted out into vectors
+    Vec obj_window[4];
+    Vec special_window[4];
+
+    for(u32 w = 0; w < 4; w++)
+    {
+        obj_window[w] = V::mask(!windowing || win_arr[w].obj_enable);
+        special_window[w] = V::mask(!windowing || win_arr[w].special_enable);
+    }
+
+    Vec bg_priority[4];
+
+    for(u32 bg = 0; bg < 4; bg++)
+    {
+        bg_priority[bg] = V::splat(disp_io.bg_cnt[bg].priority);
+    }
+
+    Vec first_target[6];
+    Vec second_target[6];
+
+    for(u32 src = 0; src < 6; src++)
+    {
+        first_target[src] = V::mask(bld_cnt.first_target_enable[src]);
+        second_target[src] = V::mask(bld_cnt.second_target_enable[src]);
+    }
+
+    // pick table[idx] for each lane
+    const auto lookup = [](Vec idx, const Vec *table, u32 size)
+    {
+        Vec v = V::zero();
+
+        for(u32 i = 0; i < size; i++)
+        {
+            v = V::bit_or(v,V::bit_and(V::eq(idx,V::splat(i)),table[i]));
+        }
+
+        return v;
+    };
+
+    const int special_effect = bld_cnt.special_effect;
+
+    const Vec effect_blend = V::mask(special_effect == 1);
+    const Vec effect_brighten = V::mask(special_effect == 2);
+    const Vec effect_darken = V::mask(special_effect == 3);
+
+    const Vec eva = V::splat(disp_io.eva);
+    const Vec evb = V::splat(disp_io.evb);
+    const Vec evy = V::splat(disp_io.evy);
+
+    const Vec obj = V::splat(static_cast<u16>(pixel_source::obj));
+    const Vec bd = V::splat(static_cast<u16>(pixel_source::bd));
+    const Vec chan_mask = V::splat(0x1f);
+    const Vec max_chan = V::splat(31);
+
+    u32 x = 0;
+
+    for(; x + V::WIDTH <= SCREEN_WIDTH; x += V::WIDTH)
+    {
+        const Vec obj_color = V::load(&layer.obj_color[x]);
+        const Vec obj_source = V::load(&layer.obj_source[x]);
+        const Vec obj_priority = V::load(&layer.obj_priority[x]);
+        const Vec obj_semi = V::load(&layer.obj_semi_transparent[x]);
+        const Vec window = V::load(&layer.window[x]);
+
+        const Vec color1 = V::load(&layer.color1[x]);
+        const Vec source1 = V::load(&layer.source1[x]);
+        const Vec color2 = V::load(&layer.color2[x]);
+        const Vec source2 = V::load(&layer.source2[x]);
+
+        const Vec sprite_enable = V::bit_and(lookup(window,obj_window,4),V::eq(obj_source,obj));
+
+        // lower priority is higher, sprite wins even if its equal
+        const Vec obj_beats1 = V::bit_or(V::eq(source1,bd),V::bit_not(V::gt(obj_priority,lookup(source1,bg_priority,4))));
+        const Vec obj_win1 = V::bit_and(sprite_enable,obj_beats1);
+
+        const Vec obj_beats2 = V::bit_or(V::eq(source2,bd),V::bit_not(V::gt(obj_priority,lookup(source2,bg_priority,4))));
+        const Vec obj_win2 = V::bit_and(V::bit_andnot(obj_win1,sprite_enable),obj_beats2);
+
+        const Vec p1_color = V::select(obj_win1,obj_color,color1);
+        const Vec p1_source = V::select(obj_win1,obj,source1);
+        const Vec p2_color = V::select(obj_win2,obj_color,color2);
+        const Vec p2_source = V::select(obj_win2,obj,source2);
+
+        const Vec special_enable = lookup(window,special_window,4);
+        const Vec first_enable = lookup(p1_source,first_target,6);
+        const Vec second_enable = lookup(p2_source,second_target,6);
+
+        const Vec semi_transparent = V::bit_and(V::bit_and(V::bit_not(V::eq(obj_semi,V::zero())),V::eq(p1_source,obj)),second_enable);
+
+        // semi transparency forces an alpha blend over whatever effect is set
+        const Vec normal_blend = V::bit_and(V::bit_and(effect_blend,first_enable),
+            V::bit_and(V::bit_not(V::eq(p1_source,bd)),second_enable));
+
+        const Vec blend = V::bit_and(special_enable,V::bit_or(semi_transparent,normal_blend));
+        const Vec adjust = V::bit_and(special_enable,V::bit_andnot(semi_transparent,first_enable));
+        const Vec brighten = V::bit_and(adjust,effect_brighten);
+        const Vec darken = V::bit_and(adjust,effect_darken);
+
+        Vec color = p1_color;
+
+        const Vec r1 = V::bit_and(p1_color,chan_mask);
+        const Vec g1 = V::bit_and(V::srl<5>(p1_color),chan_mask);
+        const Vec b1 = V::bit_and(V::srl<10>(p1_color),chan_mask);
+
+        if(V::any(blend))
+        {
+            const Vec r2 = V::bit_and(p2_color,chan_mask);
+            const Vec g2 = V::bit_and(V::srl<5>(p2_color),chan_mask);
+            const Vec b2 = V::bit_and(V::srl<10>(p2_color),chan_mask);
+
+            const auto blend_calc = [&](Vec c1, Vec c2)
+            {
+                return V::min(max_chan,V::srl<4>(V::add(V::mul(eva,c1),V::mul(evb,c2))));
+            };
+
+            const Vec r = blend_calc(r1,r2);
+            const Vec g = blend_calc(g1,g2);
+            const Vec b = blend_calc(b1,b2);
+
+            color = V::select(blend,V::bit_or(r,V::bit_or(V::sll<5>(g),V::sll<10>(b))),color);
+        }
+
+        if(V::any(brighten))
+        {
+            const auto brighten_calc = [&](Vec c)
+            {
+                return V::add(c,V::srl<4>(V::mul(V::sub(max_chan,c),evy)));
+            };
+
+            const Vec r = brighten_calc(r1);
+            const Vec g = brighten_calc(g1);
+            const Vec b = brighten_calc(b1);
+
+            color = V::select(brighten,V::bit_or(r,V::bit_or(V::sll<5>(g),V::sll<10>(b))),color);
+        }
+
+        if(V::any(darken))
+        {
+            const auto darken_calc = [&](Vec c)
+            {
+                return V::sub(c,V::srl<4>(V::mul(c,evy)));
+            };
+
+            const Vec r = darken_calc(r1);
+            const Vec g = darken_calc(g1);
+            const Vec b = darken_calc(b1);
+
+            color = V::select(darken,V::bit_or(r,V::bit_or(V::sll<5>(g),V::sll<10>(b))),color);
         }
+
+        V::store_color(&line[x],color);
     }
+
+    return x;
 }
 
+#else
+
+u32 Renderer::merge_layers_simd()
+{
+    return 0;
+}
+
+#endif
+
 
 // this will be called before sprites are drawn
 // the obj window will overwrite onto this
 // ideally we would just compute index bounds on everything
 // and do loops assuming features are off but this far simpler for now
-void Display::cache_window()
+void Renderer::cache_window()
 {
     const auto &disp_cnt = disp_io.disp_cnt;
 
     // if no windows are active then out of window is not enabled
     if(!disp_cnt.window0_enable && !disp_cnt.window1_enable)
     {
-        std::fill(window.begin(),window.end(),window_source::out);
+        std::fill(std::begin(layer.window),std::end(layer.window),window_source::out);
         return;
     }
 
@@ -695,7 +1039,7 @@ void Display::cache_window()
     // first check win0
     // if not enabled check win 1
 
-    std::fill(window.begin(),window.end(), window_source::out);
+    std::fill(std::begin(layer.window),std::end(layer.window),window_source::out);
 
 
     if(trigger_0)
@@ -706,14 +1050,14 @@ void Display::cache_window()
 
         for(u32 x = disp_io.win0h.x1; x < end; x++)
         {
-            window[x] = window_source::zero;
+            layer.window[x] = window_source::zero;
         }
 
         if(win0_wrap)
         {
             for(u32 x = 0; x < disp_io.win0h.x2; x++)
             {
-                window[x] = window_source::zero;
+                layer.window[x] = window_source::zero;
             }
         }
     }
@@ -727,9 +1071,9 @@ void Display::cache_window()
 
         for(u32 x = disp_io.win1h.x1; x < end; x++)
         {
-            if(window[x] != window_source::zero)
+            if(layer.window[x] != window_source::zero)
             {
-                window[x] = window_source::one;
+                layer.window[x] = window_source::one;
             }
         }
 
@@ -737,9 +1081,9 @@ void Display::cache_window()
         {
             for(u32 x = 0; x < disp_io.win1h.x2; x++)
             {
-                if(window[x] != window_source::zero)
+                if(layer.window[x] != window_source::zero)
                 {
-                    window[x] = window_source::one;
+                    layer.window[x] = window_source::one;
                 }
             }
         }
@@ -747,7 +1091,7 @@ void Display::cache_window()
 }
 
 
-bool Display::bg_window_enabled(unsigned int bg, unsigned int x) const
+bool Renderer::bg_window_enabled(unsigned int bg, unsigned int x) const
 {
     const auto &disp_cnt = disp_io.disp_cnt;
 
@@ -757,10 +1101,10 @@ bool Display::bg_window_enabled(unsigned int bg, unsigned int x) const
         return true;
     }
 
-    return disp_io.win_cnt.win_arr[static_cast<size_t>(window[x])].bg_enable[bg];
+    return disp_io.win_cnt.win_arr[static_cast<size_t>(layer.window[x])].bg_enable[bg];
 }
 
-bool Display::sprite_window_enabled(unsigned int x) const
+bool Renderer::sprite_window_enabled(unsigned int x) const
 {
     // check either window is enabled
     // if not bg is enabled
@@ -772,10 +1116,10 @@ bool Display::sprite_window_enabled(unsigned int x) const
         return true;
     }
 
-    return disp_io.win_cnt.win_arr[static_cast<size_t>(window[x])].obj_enable;
+    return disp_io.win_cnt.win_arr[static_cast<size_t>(layer.window[x])].obj_enable;
 }
 
-bool Display::special_window_enabled(unsigned int x) const
+bool Renderer::special_window_enabled(unsigned int x) const
 {
     // check either window is enabled
     // if not bg is enabled
@@ -787,7 +1131,7 @@ bool Display::special_window_enabled(unsigned int x) const
         return true;
     }
 
-    return disp_io.win_cnt.win_arr[static_cast<size_t>(window[x])].special_enable;
+    return disp_io.win_cnt.win_arr[static_cast<size_t>(layer.window[x])].special_enable;
 }
 
 
@@ -849,16 +1193,19 @@ int get_lim(BgPriority *bg_priority, DispIo &disp_io)
     return lim;  
 }
 
-void Display::render()
+void Renderer::render(const LineState &state, u32 *out)
 {
+    static_cast<LineState&>(*this) = state;
+    line = out;
+
     const auto render_mode = disp_io.disp_cnt.bg_mode; 
 
     const TileData lose_bg(read_bg_palette(0,0),pixel_source::bd);
-    Scanline dead_pixel;
-    dead_pixel.t1 = lose_bg;
-    dead_pixel.t2 = lose_bg;
 
-    std::fill(scanline.begin(),scanline.end(),dead_pixel);
+    std::fill(std::begin(layer.color1),std::end(layer.color1),lose_bg.color);
+    std::fill(std::begin(layer.source1),std::end(layer.source1),lose_bg.source);
+    std::fill(std::begin(layer.color2),std::end(layer.color2),lose_bg.color);
+    std::fill(std::begin(layer.source2),std::end(layer.source2),lose_bg.source);
 
     // ideally we would try to cull draws
     // that are not enabled in the window
@@ -934,8 +1281,8 @@ void Display::render()
             {
                 if(bg_window_enabled(2,x))
                 {
-                    const u32 c = convert_color(handle_read<u16>(mem.vram,(ly*SCREEN_WIDTH*2)+x*2));
-                    screen[(ly*SCREEN_WIDTH)+x] = c;
+                    const u32 c = convert_color(handle_read<u16>(*vram,(ly*SCREEN_WIDTH*2)+x*2));
+                    line[x] = c;
                 }
             }
             break;
@@ -954,10 +1301,10 @@ void Display::render()
             {
                 if(bg_window_enabled(2,x))
                 {
-                    const uint8_t idx = mem.vram[(ly*SCREEN_WIDTH)+x];
-                    const u16 color = handle_read<u16>(mem.pal_ram,(idx*2));
+                    const uint8_t idx = (*vram)[(ly*SCREEN_WIDTH)+x];
+                    const u16 color = handle_read<u16>(*pal_ram,(idx*2));
                     const u32 c = convert_color(color);
-                    screen[(ly*SCREEN_WIDTH)+x] = c;
+                    line[x] = c;
                 }
             }
             break;
@@ -968,7 +1315,7 @@ void Display::render()
         {
             for(u32 x = 0; x < SCREEN_WIDTH; x++)
             {
-                u32 c = convert_color(handle_read<u16>(mem.vram,(ly*SCREEN_WIDTH*2)+x*2));
+                u32 c = convert_color(handle_read<u16>(*vram,(ly*SCREEN_WIDTH*2)+x*2));
                 screen[ly][x] = c;
             }
             break;            
@@ -0,0 +1,152 @@
+#include <gba/gba.h>
+
+namespace gameboyadvance
+{
+
+RenderPool::~RenderPool()
+{
+    stop();
+}
+
+void RenderPool::start(u32 threads)
+{
+    stop();
+
+    if(!threads)
+    {
+        return;
+    }
+
+    jobs.resize(SCREEN_HEIGHT);
+    renderers.resize(threads);
+
+    for(u32 i = 0; i < threads; i++)
+    {
+        workers.emplace_back(&RenderPool::worker_main,this,i);
+    }
+}
+
+void RenderPool::stop()
+{
+    if(!active())
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        quit = true;
+    }
+
+    work_cv.notify_all();
+
+    for(auto &thread : workers)
+    {
+        thread.join();
+    }
+
+    workers.clear();
+    renderers.clear();
+
+    submitted = 0;
+    next = 0;
+    done = 0;
+    quit = false;
+    error = nullptr;
+}
+
+void RenderPool::submit(const LineState &state, u32 *out)
+{
+    // every line should be collected at vblank, dont overrun if it wasnt
+    if(submitted == jobs.size())
+    {
+        wait();
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+
+        auto &job = jobs[submitted];
+        job.state = state;
+        job.out = out;
+
+        submitted++;
+    }
+
+    work_cv.notify_one();
+}
+
+void RenderPool::wait()
+{
+    std::unique_lock lock(mutex);
+
+    done_cv.wait(lock,[this]()
+    {
+        return done == submitted;
+    });
+
+    submitted = 0;
+    next = 0;
+    done = 0;
+
+    if(error)
+    {
+        const auto ex = error;
+        error = nullptr;
+
+        std::rethrow_exception(ex);
+    }
+}
+
+void RenderPool::worker_main(u32 id)
+{
+    auto &renderer = renderers[id];
+
+    std::unique_lock lock(mutex);
+
+    for(;;)
+    {
+        work_cv.wait(lock,[this]()
+        {
+            return quit || next != submitted;
+        });
+
+        // finish off anything queued before quitting
+        if(next == submitted)
+        {
+            return;
+        }
+
+        const auto &job = jobs[next++];
+
+        lock.unlock();
+
+        std::exception_ptr ex = nullptr;
+
+        try
+        {
+            renderer.render(job.state,job.out);
+        }
+
+        catch(...)
+        {
+            ex = std::current_exception();
+        }
+
+        lock.lock();
+
+        if(ex && !error)
+        {
+            error = ex;
+        }
+
+        done++;
+
+        if(done == submitted)
+        {
+            done_cv.notify_all();
+        }
+    }
+}
+
+}
@@ -3,14 +3,15 @@
 namespace gameboyadvance
 {
 
-void Display::render_sprites(int mode)
+void Renderer::render_sprites(int mode)
 {
     const TileData lose_bg(read_bg_palette(0,0),pixel_source::bd);
     // make all of the line lose
     // until something is rendred over it
-    std::fill(sprite_line.begin(),sprite_line.end(),lose_bg);
-    std::fill(sprite_semi_transparent.begin(),sprite_semi_transparent.end(),false);
-    std::fill(sprite_priority.begin(),sprite_priority.end(),5);
+    std::fill(std::begin(layer.obj_color),std::end(layer.obj_color),lose_bg.color);
+    std::fill(std::begin(layer.obj_source),std::end(layer.obj_source),lose_bg.source);
+    std::fill(std::begin(layer.obj_semi_transparent),std::end(layer.obj_semi_transparent),false);
+    std::fill(std::begin(layer.obj_priority),std::end(layer.obj_priority),5);
 
     // objects aernt enabled do nothing more
     if(!disp_io.disp_cnt.obj_enable)
@@ -30,9 +31,9 @@ void Display::render_sprites(int mode)
         int obj_idx = i * 8;
         
 
-        const auto attr0 = handle_read<u16>(mem.oam,obj_idx);
-        const auto attr1 = handle_read<u16>(mem.oam,obj_idx+2);
-        const auto attr2 = handle_read<u16>(mem.oam,obj_idx+4);
+        const auto attr0 = handle_read<u16>(*oam,obj_idx);
+        const auto attr1 = handle_read<u16>(*oam,obj_idx+2);
+        const auto attr2 = handle_read<u16>(*oam,obj_idx+4);
 
         const bool affine = is_set(attr0,8);
 
@@ -198,10 +199,10 @@ void Display::render_sprites(int mode)
                 const auto base = aff_param*0x20;
 
                 // 8.8 fixed point
-                const int16_t pa = handle_read<u16>(mem.oam,base+0x6);
-                const int16_t pb = handle_read<u16>(mem.oam,base+0xe);
-                const int16_t pc = handle_read<u16>(mem.oam,base+0x16);
-                const int16_t pd = handle_read<u16>(mem.oam,base+0x1e);
+                const int16_t pa = handle_read<u16>(*oam,base+0x6);
+                const int16_t pb = handle_read<u16>(*oam,base+0xe);
+                const int16_t pc = handle_read<u16>(*oam,base+0x16);
+                const int16_t pd = handle_read<u16>(*oam,base+0x1e);
 
 
                 
@@ -252,7 +253,7 @@ void Display::render_sprites(int mode)
                 const u32 addr = 0x10000 + ((tile_offset + tile_num) * 8 * 4);
 
                 const u32 data_offset = ((x2 % 8) / 2) + ((y2 % 8) * 4);
-                const auto tile_data = mem.vram[addr+data_offset];
+                const auto tile_data = (*vram)[addr+data_offset];
 
                 // lower x cord stored in lower nibble
                 const u32 idx = ((x2 & 1)? (tile_data >> 4) : tile_data) & 0xf;
@@ -262,9 +263,9 @@ void Display::render_sprites(int mode)
                 if(idx != 0 && obj_mode == 2 && disp_cnt.obj_window_enable)
                 {
                     // window 0 and 1 have higher priority
-                    if(window[x_offset] == window_source::out)
+                    if(layer.window[x_offset] == window_source::out)
                     {
-                        window[x_offset] = window_source::obj;
+                        layer.window[x_offset] = window_source::obj;
                     }
                 }    
 
@@ -275,13 +276,13 @@ void Display::render_sprites(int mode)
                         if(idx != 0)
                         {
                             const auto color = read_obj_palette(pal,idx);
-                            sprite_line[x_offset].color = color;
-                            sprite_line[x_offset].source = pixel_source::obj;
+                            layer.obj_color[x_offset] = color;
+                            layer.obj_source[x_offset] = pixel_source::obj;
                             oam_priority[x_offset] = i;
                         }
 
                          // hardware bug priority is updated even if transparent
-                        sprite_priority[x_offset] = priority;
+                        layer.obj_priority[x_offset] = priority;
                     }
                 }
 
@@ -298,16 +299,16 @@ void Display::render_sprites(int mode)
                 const u32 addr = 0x10000 + (tile_num * 8 * 4) + (tile_offset * 8 * 8);
 
                 const u32 data_offset = (x2 % 8) + ((y2 % 8) * 8);
-                const auto tile_data = mem.vram[addr+data_offset];
+                const auto tile_data = (*vram)[addr+data_offset];
 
                 // object window obj not displayed any non zero pixels are 
                 // the object window
                 if(tile_data != 0 && obj_mode == 2 && disp_cnt.obj_window_enable)
                 {
                     // window 0 and 1 have higher priority
-                    if(window[x_offset] == window_source::out)
+                    if(layer.window[x_offset] == window_source::out)
                     {
-                        window[x_offset] = window_source::obj;
+                        layer.window[x_offset] = window_source::obj;
                     }
                 }    
 
@@ -318,13 +319,13 @@ void Display::render_sprites(int mode)
                         if(tile_data != 0)
                         {
                             const auto color = read_obj_palette(0,tile_data);
-                            sprite_line[x_offset].color = color;
-                            sprite_line[x_offset].source = pixel_source::obj;
+                            layer.obj_color[x_offset] = color;
+                            layer.obj_source[x_offset] = pixel_source::obj;
                             oam_priority[x_offset] = i;
                         }
 
                         // hardware bug priority is updated even if transparent
-                        sprite_priority[x_offset] = priority;
+                        layer.obj_priority[x_offset] = priority;
                     }
                 }
 
@@ -333,7 +334,7 @@ void Display::render_sprites(int mode)
 
             if(obj_mode == 1)
             {
-                sprite_semi_transparent[x_offset] = true;
+                layer.obj_semi_transparent[x_offset] = true;
             }
         }                
 
@@ -108,7 +108,7 @@ void Display::render_map(int id, std::vector<u32> &map)
 
 
                 // render a full tile but then just lie and say we rendered less
-                read_tile(buf,id,col_256,bg_tile_data_base,pal_num,tile_num,y,x_flip,y_flip);
+                renderer.read_tile(buf,id,col_256,bg_tile_data_base,pal_num,tile_num,y,x_flip,y_flip);
                 old_entry = bg_map_entry;
             }
 
@@ -0,0 +1,76 @@
+#pragma once
+#include <albion/lib.h>
+
+// triple buffered frame exchange between an emulation thread and a presenter
+// the core draws straight into a buffer owned by the mailbox and swaps it in when finished
+// so neither side ever waits on the other or copies a frame
+// the presenter only ever sees the newest complete frame, older ones are dropped
+class FrameMailbox
+{
+public:
+    struct Frame
+    {
+        std::vector<u32> buf;
+        u32 x = 0;
+        u32 y = 0;
+    };
+
+    // emulation thread
+    // screen is swapped for the next back buffer of x * y pixels, which holds an older frame
+    // cores that wont redraw all of the next frame (sgb freeze) pass keep
+    // to have the frame just published copied forward into it
+    void publish(std::vector<u32> &screen, u32 x, u32 y, bool keep);
+
+    // presenter thread
+    // returns nullptr if no frame has completed since the last call
+    // the frame stays valid until the next acquire
+    const Frame* acquire();
+
+private:
+    static constexpr u32 NEW_FRAME = 1 << 2;
+    static constexpr u32 IDX_MASK = NEW_FRAME - 1;
+
+    Frame frames[3];
+
+    // back is owned by the producer, front by the consumer
+    // ready holds the last published buffer
+    u32 back = 0;
+    u32 front = 1;
+    std::atomic<u32> ready = 2;
+};
+
+inline void FrameMailbox::publish(std::vector<u32> &screen, u32 x, u32 y, bool keep)
+{
+    const u32 published = back;
+    auto &frame = frames[published];
+
+    std::swap(frame.buf,screen);
+    frame.x = x;
+    frame.y = y;
+
+    back = ready.exchange(back | NEW_FRAME,std::memory_order_acq_rel) & IDX_MASK;
+
+    // the presenter only ever reads a frame, and this slot is not written
+    // again until it comes back around as the back buffer
+    if(keep)
+    {
+        screen.assign(frame.buf.begin(),frame.buf.end());
+    }
+
+    // the buffer handed back may be from before a resolution change
+    else
+    {
+        screen.resize(x * y);
+    }
+}
+
+inline const FrameMailbox::Frame* FrameMailbox::acquire()
+{
+    if(!(ready.load(std::memory_order_acquire) & NEW_FRAME))
+    {
+        return nullptr;
+    }
+
+    front = ready.exchange(front,std::memory_order_acq_rel) & IDX_MASK;
+    return &frames[front];
+}
@@ -0,0 +1,270 @@
+#pragma once
+#include <albion/min_heap.h>
+
+// flat event list indexed by type, the min is found with a linear scan
+// each core only has a handful of events so this is cheaper than
+// keeping a heap in order on every insert and remove
+// ties go to whichever event was inserted first
+template<u32 SIZE,typename event_type>
+class MinScan
+{
+public:
+    MinScan();
+
+    void save_state(std::ofstream &fp);
+    void load_state(std::ifstream &fp);
+
+    EventNode<event_type> peek() const;
+    void pop();
+    u32 size() const;
+    void clear();
+    std::optional<EventNode<event_type>> get(event_type t) const;
+
+    std::optional<EventNode<event_type>> remove(event_type t);
+    bool is_active(event_type t) const;
+	void insert(EventNode<event_type> event);
+
+    std::array<EventNode<event_type>,SIZE> buf;
+    const u32 IDX_INVALID = 0xffffffff;
+private:
+    void scan();
+
+    static constexpr u64 END_INACTIVE = 0xffff'ffff'ffff'ffff;
+
+    // end time for each type, inactive events are set to the max
+    // so the scan doesn't have to check if they are in use
+    std::array<u64,SIZE> end;
+
+    // insertion order of each type, used to break ties on end
+    std::array<u64,SIZE> seq;
+    u64 next_seq = 0;
+
+    u32 min_idx = 0;
+    u32 len = 0;
+};
+
+template<u32 SIZE,typename event_type>
+MinScan<SIZE,event_type>::MinScan()
+{
+    assert(SIZE < IDX_INVALID);
+    assert(SIZE != 0);
+    clear();
+}
+
+template<u32 SIZE,typename event_type>
+void MinScan<SIZE,event_type>::clear()
+{
+    len = 0;
+    min_idx = 0;
+    next_seq = 0;
+
+    for(u32 i = 0; i < SIZE; i++)
+    {
+        buf[i] = EventNode(0xdeadbeef,0xdeadbeef,static_cast<event_type>(i));
+        end[i] = END_INACTIVE;
+        seq[i] = 0;
+    }
+}
+
+template<u32 SIZE,typename event_type>
+void MinScan<SIZE,event_type>::scan()
+{
+    u32 idx = 0;
+    u64 min = end[0];
+    u64 min_seq = seq[0];
+
+    for(u32 i = 1; i < SIZE; i++)
+    {
+        const bool less = end[i] < min || (end[i] == min && seq[i] < min_seq);
+        min = less? end[i] : min;
+        min_seq = less? seq[i] : min_seq;
+        idx = less? i : idx;
+    }
+
+    min_idx = idx;
+}
+
+template<u32 SIZE,typename event_type>
+EventNode<event_type> MinScan<SIZE,event_type>::peek() const
+{
+    // nothing active, make sure nothing looks ready
+    if(!len)
+    {
+        return EventNode<event_type>(END_INACTIVE,END_INACTIVE,static_cast<event_type>(0));
+    }
+
+    return buf[min_idx];
+}
+
+template<u32 SIZE,typename event_type>
+u32 MinScan<SIZE,event_type>::size() const
+{
+    return len;
+}
+
+template<u32 SIZE,typename event_type>
+void MinScan<SIZE,event_type>::pop()
+{
+    if(len == 0)
+    {
+        puts("attempted to remove from empty event list");
+        exit(1);
+    }
+
+    remove(static_cast<event_type>(min_idx));
+}
+
+template<u32 SIZE,typename event_type>
+bool MinScan<SIZE,event_type>::is_active(event_type t) const
+{
+    return end[u32(t)] != END_INACTIVE;
+}
+
+template<u32 SIZE,typename event_type>
+void MinScan<SIZE,event_type>::insert(EventNode<event_type> event)
+{
+    // no cycles would be ticked this event does nothing
+    if(event.start == event.end)
+    {
+        return;
+    }
+
+    const u32 event_idx = u32(event.type);
+
+    if(!is_active(event.type))
+    {
+        len++;
+    }
+
+    buf[event_idx] = event;
+    end[event_idx] = event.end;
+    seq[event_idx] = next_seq++;
+
+    // if the min has been pushed back we have to look again
+    if(event_idx == min_idx)
+    {
+        scan();
+    }
+
+    // newest insert, so it has to be strictly earlier to take over on a tie
+    else if(event.end < end[min_idx])
+    {
+        min_idx = event_idx;
+    }
+}
+
+template<u32 SIZE,typename event_type>
+std::optional<EventNode<event_type>> MinScan<SIZE,event_type>::remove(event_type t)
+{
+    const u32 idx = u32(t);
+
+    if(!is_active(t))
+    {
+        return std::nullopt;
+    }
+
+    const auto v = buf[idx];
+
+    end[idx] = END_INACTIVE;
+    len--;
+
+    if(idx == min_idx)
+    {
+        scan();
+    }
+
+    return v;
+}
+
+template<u32 SIZE,typename event_type>
+std::optional<EventNode<event_type>> MinScan<SIZE,event_type>::get(event_type t) const
+{
+    if(is_active(t))
+    {
+        return buf[u32(t)];
+    }
+
+    return std::nullopt;
+}
+
+// written in the same layout as MinHeap
+// active events sorted by time are a valid heap so states can be shared
+template<u32 SIZE,typename event_type>
+void MinScan<SIZE,event_type>::save_state(std::ofstream &fp)
+{
+    std::array<size_t,SIZE> idx_list;
+
+    for(size_t i = 0; i < SIZE; i++)
+    {
+        idx_list[i] = i;
+    }
+
+    std::stable_sort(idx_list.begin(),idx_list.end(),[this](size_t v1, size_t v2)
+    {
+        return end[v1] < end[v2] || (end[v1] == end[v2] && seq[v1] < seq[v2]);
+    });
+
+    std::array<u32,SIZE> type_idx;
+
+    for(u32 i = 0; i < SIZE; i++)
+    {
+        const auto type = idx_list[i];
+        type_idx[type] = end[type] != END_INACTIVE? i : IDX_INVALID;
+    }
+
+    file_write_arr(fp,type_idx.data(),sizeof(type_idx[0]) * type_idx.size());
+    file_write_arr(fp,buf.data(),sizeof(buf[0]) * buf.size());
+    file_write_arr(fp,idx_list.data(),sizeof(idx_list[0]) * idx_list.size());
+    file_write_var(fp,len);
+}
+
+template<u32 SIZE,typename event_type>
+void MinScan<SIZE,event_type>::load_state(std::ifstream &fp)
+{
+    std::array<u32,SIZE> type_idx;
+    file_read_arr(fp,type_idx.data(),sizeof(type_idx[0]) * type_idx.size());
+
+    file_read_arr(fp,buf.data(),sizeof(buf[0]) * buf.size());
+
+    // heap order is not needed, just skip it
+    std::array<size_t,SIZE> idx_list;
+    file_read_arr(fp,idx_list.data(),sizeof(idx_list[0]) * idx_list.size());
+
+    file_read_var(fp,len);
+
+    if(len > SIZE)
+    {
+        throw std::runtime_error("minscan invalid len");
+    }
+
+    u32 active = 0;
+
+    for(u32 i = 0; i < SIZE; i++)
+    {
+        if(type_idx[i] != IDX_INVALID && type_idx[i] >= len)
+        {
+            throw std::runtime_error("minscan invalid type idx");
+        }
+
+        if(u32(buf[i].type) != i)
+        {
+            throw std::runtime_error("minscan invalid event type");
+        }
+
+        end[i] = type_idx[i] != IDX_INVALID? buf[i].end : END_INACTIVE;
+        active += type_idx[i] != IDX_INVALID;
+
+        // heap position is the closest thing to insertion order a state has
+        // and our own states store the tie order directly
+        seq[i] = type_idx[i] != IDX_INVALID? type_idx[i] : 0;
+    }
+
+    if(active != len)
+    {
+        throw std::runtime_error("minscan invalid len");
+    }
+
+    next_seq = len;
+
+    scan();
+}
@@ -1,8 +1,26 @@
 #pragma once
 #include<albion/min_heap.h>
+#include<albion/min_scan.h>
+
+// operation on the event list, recorded for replay in benchmarks
+enum class event_op
+{
+    insert,
+    remove,
+    pop
+};
+
+template<typename event_type>
+struct EventTraceEntry
+{
+    event_op op;
+    EventNode<event_type> node;
+};
 
 // needs a save state impl
-template<size_t EVENT_SIZE,typename event_type>
+// DERIVED is the core scheduler that implements service_event (crtp)
+// EVENT_LIST is the backend used to order events (MinHeap or MinScan)
+template<typename DERIVED,size_t EVENT_SIZE,typename event_type,template<u32,typename> class EVENT_LIST = MinHeap>
 class Scheduler
 {
 public:
@@ -11,8 +29,8 @@ public:
     void save_state(std::ofstream &fp);
     void load_state(std::ifstream &fp);    
 
-    void tick(uint32_t cycles);
-    void delay_tick(uint32_t cycles);
+    void tick(u64 cycles);
+    void delay_tick(u64 cycles);
     bool is_active(event_type t) const;
     bool event_ready() const;
     void service_events();
@@ -39,11 +57,32 @@ public:
 
     void adjust_timestamp();
 
+#ifdef SCHEDULER_TRACE
+    // when set every operation on the event list is recorded
+    std::vector<EventTraceEntry<event_type>> *trace = nullptr;
+#endif
+
 protected:
-    virtual void service_event(const EventNode<event_type> & node) = 0;
+    // statically dispatched, no vtable load per event
+    void service_event(const EventNode<event_type> & node)
+    {
+        static_cast<DERIVED*>(this)->service_event(node);
+    }
 
+    // only built for benchmarks, so normal builds dont pay for it on every op
+    void record(event_op op, const EventNode<event_type> &node)
+    {
+    #ifdef SCHEDULER_TRACE
+        if(trace)
+        {
+            trace->push_back({op,node});
+        }
+    #else
+        UNUSED(op); UNUSED(node);
+    #endif
+    }
 
-    MinHeap<EVENT_SIZE,event_type> event_list;
+    EVENT_LIST<EVENT_SIZE,event_type> event_list;
 
     // current elapsed time
     u64 timestamp = 0;
@@ -52,33 +91,33 @@ protected:
 
 
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::init()
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::init()
 {
     event_list.clear();
     timestamp = 0;
     min_timestamp = 0xffffffff;
 }
 
-template<size_t SIZE,typename event_type>
-bool Scheduler<SIZE,event_type>::is_active(event_type t) const
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+bool Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::is_active(event_type t) const
 {
     return event_list.is_active(t);
 }
-template<size_t SIZE,typename event_type>
-bool Scheduler<SIZE,event_type>::event_ready() const
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+bool Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::event_ready() const
 {
     return timestamp >= min_timestamp;
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::delay_tick(uint32_t cycles)
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::delay_tick(u64 cycles)
 {
     timestamp += cycles;
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::service_events()
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::service_events()
 {
     // if the timestamp is greater than the event fire
     // handle the event and remove it
@@ -88,14 +127,15 @@ void Scheduler<SIZE,event_type>::service_events()
     {
         // remove min event
         const auto event = event_list.peek();
+        record(event_op::pop,event);
         event_list.pop();
         min_timestamp = event_list.peek().end;
         service_event(event);
     }
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::tick(uint32_t cycles)
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::tick(u64 cycles)
 {
     timestamp += cycles;
 
@@ -104,8 +144,8 @@ void Scheduler<SIZE,event_type>::tick(uint32_t cycles)
 
 // using a 64 bit timestamp not required
 /*
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::adjust_timestamp()
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::adjust_timestamp()
 {
     // timestamp will soon overflow
     if(is_set(timestamp,31))
@@ -134,36 +174,39 @@ void Scheduler<SIZE,event_type>::adjust_timestamp()
 }
 */
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::insert(const EventNode<event_type> &node,bool tick_old)
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::insert(const EventNode<event_type> &node,bool tick_old)
 {
     remove(node.type,tick_old);
+    record(event_op::insert,node);
     event_list.insert(node);
     min_timestamp = event_list.peek().end;
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::remove(event_type type,bool tick_old)
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::remove(event_type type,bool tick_old)
 {
+    record(event_op::remove,EventNode<event_type>(0,0,type));
     const auto event = event_list.remove(type);
 
     // if it was removed and we want to tick off cycles
     if(event && tick_old)
     {
         service_event(event.value());
+        record(event_op::remove,EventNode<event_type>(0,0,type));
         event_list.remove(type);
     }
     min_timestamp = event_list.peek().end;
 }
 
-template<size_t SIZE,typename event_type>
-std::optional<EventNode<event_type>> Scheduler<SIZE,event_type>::get(event_type t) const
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+std::optional<EventNode<event_type>> Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::get(event_type t) const
 {
     return event_list.get(t);
 }
 
-template<size_t SIZE,typename event_type>
-std::optional<size_t> Scheduler<SIZE,event_type>::get_event_ticks(event_type t) const
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+std::optional<size_t> Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::get_event_ticks(event_type t) const
 {
     const auto event = get(t);
 
@@ -175,34 +218,34 @@ std::optional<size_t> Scheduler<SIZE,event_type>::get_event_ticks(event_type t)
     return timestamp - event.value().start;
 }
 
-template<size_t SIZE,typename event_type>
-uint64_t Scheduler<SIZE,event_type>::get_timestamp() const
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+uint64_t Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::get_timestamp() const
 {
     return timestamp;
 }
 
-template<size_t SIZE,typename event_type>
-uint64_t Scheduler<SIZE,event_type>::get_next_event_cycles() const
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+uint64_t Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::get_next_event_cycles() const
 {
     return min_timestamp - timestamp;
 }
 
-template<size_t SIZE,typename event_type>
-EventNode<event_type> Scheduler<SIZE,event_type>::create_event(u64 duration, event_type t) const
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+EventNode<event_type> Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::create_event(u64 duration, event_type t) const
 {
     return EventNode<event_type>(timestamp,duration+timestamp,t);
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::save_state(std::ofstream &fp)
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::save_state(std::ofstream &fp)
 {
     file_write_var(fp,min_timestamp);
     file_write_var(fp,timestamp);
     event_list.save_state(fp);
 }
 
-template<size_t SIZE,typename event_type>
-void Scheduler<SIZE,event_type>::load_state(std::ifstream &fp)
+template<typename DERIVED,size_t SIZE,typename event_type,template<u32,typename> class EVENT_LIST>
+void Scheduler<DERIVED,SIZE,event_type,EVENT_LIST>::load_state(std::ifstream &fp)
 {
     file_read_var(fp,min_timestamp);
     file_read_var(fp,timestamp);
@@ -0,0 +1,91 @@
+#pragma once
+#include <albion/lib.h>
+#include <deque>
+
+// in memory save states
+// components serialise through std::ofstream / std::ifstream
+// so rather than touching all of them the stream buffer is pointed at a byte arena
+
+class ArenaBuf : public std::streambuf
+{
+public:
+    // writing appends to arena, its capacity is kept between snapshots
+    void begin_write(std::vector<u8> *arena);
+
+    // reading walks the bytes passed in, they must outlive the read
+    void begin_read(const std::vector<u8> &data);
+
+protected:
+    std::streamsize xsputn(const char *s, std::streamsize n) override;
+    int_type overflow(int_type c) override;
+
+private:
+    std::vector<u8> *out = nullptr;
+};
+
+class Snapshot
+{
+public:
+    Snapshot();
+
+    // stream the components write into, arena is cleared first
+    std::ofstream& begin_write();
+
+    // stream over data, normally the arena of this or another snapshot
+    std::ifstream& begin_read(const std::vector<u8> &data);
+    std::ifstream& begin_read();
+
+    std::vector<u8> arena;
+
+private:
+    ArenaBuf buf;
+    std::ofstream out;
+    std::ifstream in;
+};
+
+
+// ring of the last few seconds of snapshots, one per frame
+// every KEY_INTERVAL frames a full state is kept as a keyframe
+// the frames after it only store what changed from that keyframe
+// frames are dropped a whole keyframe group at a time once over capacity
+class Rewind
+{
+public:
+    void init(u32 frames, u32 key_interval = 60);
+    void clear();
+
+    bool enabled() const { return capacity != 0; }
+
+    // record a serialised state
+    void push(const std::vector<u8> &state);
+
+    // restore the newest state into state and drop it
+    // returns false if there is nothing to rewind to
+    bool pop(std::vector<u8> &state);
+
+    size_t size() const { return len; }
+    size_t memory_usage() const;
+
+private:
+    struct Group
+    {
+        std::vector<u8> key;
+        std::vector<std::vector<u8>> delta;
+    };
+
+    static void encode_delta(std::vector<u8> &delta, const std::vector<u8> &key, const std::vector<u8> &state);
+    static void decode_delta(std::vector<u8> &state, const std::vector<u8> &key, const std::vector<u8> &delta);
+
+    std::deque<Group> groups;
+
+    // dropped buffers kept so recording doesn't hit the allocator every frame
+    // keys and deltas are pooled apart so small deltas don't hold on to full states
+    std::vector<std::vector<u8>> spare_key;
+    std::vector<std::vector<u8>> spare_delta;
+    static std::vector<u8> take_spare(std::vector<std::vector<u8>> &spare);
+    void drop_group(Group &group);
+
+    u32 capacity = 0;
+    u32 key_interval = 60;
+    size_t len = 0;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <albion/lib.h>
 #include <frontend/playback.h>
+#include <frontend/audio_mixer.h>
 #include <gb/forward_def.h>
 #include <gb/mem_constants.h>
 #include <gb/scheduler.h>
@@ -300,6 +301,7 @@ struct Apu
 	void insert_new_sample_event() noexcept;
 
 	void push_samples(u32 cycles) noexcept;
+	void update_mixer_gain() noexcept;
 
 	void init(gameboy_psg::psg_mode mode, bool use_bios) noexcept;
 
@@ -352,12 +354,17 @@ struct Apu
 
 	GameboyScheduler &scheduler;
 
-	// counter used to down sample	
+	// counter used to sample the channels for the mixer
 	int down_sample_cnt = 0; 
 
 
 	static constexpr int freq_playback = 44100;
-	static constexpr int down_sample_lim = (4 * 1024 * 1024) / freq_playback;
+
+	// channels are sampled at 64khz then resampled down to the playback rate
+	static constexpr int down_sample_lim = 64;
+	static constexpr int sample_rate = (4 * 1024 * 1024) / down_sample_lim;
+
+	AudioMixer mixer;
 
 };
 
@@ -0,0 +1,118 @@
+#pragma once
+#include <gb/forward_def.h>
+#include <albion/lib.h>
+
+namespace gameboy
+{
+
+// where an idle loop reads memory from
+enum class idle_src
+{
+    imm,
+    bc,
+    de,
+    hl,
+    c,
+};
+
+struct IdleRead
+{
+    idle_src src = idle_src::imm;
+    u16 addr = 0;
+};
+
+// straight line run of code that ends on any control flow
+// operands are still fetched by the handlers so timing is unchanged
+struct Block
+{
+    static constexpr u32 INSTR_MAX = 32;
+    static constexpr u32 IDLE_READ_MAX = 4;
+
+    u32 len = 0;
+    EXEC_INSTR_FPTR handler[INSTR_MAX];
+
+    // block is a polling loop that only reads memory and jumps back to its own start
+    // e.g. ldh a, (0x44); cp a, 0x90; jr nz, -6
+    b32 idle = false;
+
+    // memory the loop reads, checked before skipping
+    u32 idle_reads = 0;
+    IdleRead idle_read[IDLE_READ_MAX];
+};
+
+// blocks are keyed on the host page they live in, so rom banks
+// each get their own set and only ram pages ever need flushing
+struct BlockCache
+{
+    static constexpr u32 PAGE_SIZE = 0x1000;
+    static constexpr u32 WRAM_PAGES = 8;
+    static constexpr u32 LINE_SHIFT = 6;
+
+    void init(u32 rom_size);
+
+    // drop every block
+    void flush();
+
+    // drop every block in a page
+    void flush_page(u32 page);
+
+    // find the block at offset, compiling it from code if its not cached
+    // pc is the address offset is mapped at, used to spot loops
+    const Block& lookup(u32 page, u32 offset, u16 pc, const u8 *code, u32 limit, const EXEC_INSTR_FPTR *table);
+
+    // notify a write to ram that might be code
+    void write_wram(u32 bank, u32 offset) noexcept
+    {
+        write_page(wram_page + bank,offset);
+    }
+
+    void write_hram(u32 offset) noexcept
+    {
+        write_page(hram_page,offset);
+    }
+
+    // memory map has changed (bank switch, dma etc)
+    void remap() noexcept
+    {
+        generation++;
+    }
+
+    // page indexes past the rom
+    u32 wram_page = 0;
+    u32 hram_page = 0;
+
+    // bumped every time a block or the memory map goes stale
+    // so a running block knows to exit
+    u32 generation = 0;
+
+private:
+    struct CodePage
+    {
+        // block idx + 1 for each offset, zero if none
+        std::vector<u32> lookup;
+
+        // blocks owned by this page
+        std::vector<u32> blocks;
+
+        // 64 byte lines that hold the start of an opcode
+        // (or any byte of an idle loop, its operands are inspected)
+        u64 code_lines = 0;
+    };
+
+    void write_page(u32 page, u32 offset) noexcept
+    {
+        if((pages[page].code_lines >> (offset >> LINE_SHIFT)) & 1)
+        {
+            flush_page(page);
+        }
+    }
+
+    u32 alloc_block();
+    void detect_idle(Block &block, u32 offset, u16 pc, const u8 *code, u32 end);
+
+    std::vector<CodePage> pages;
+    std::vector<Block> blocks;
+    std::vector<u32> free_list;
+};
+
+}
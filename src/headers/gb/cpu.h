@@ -3,6 +3,7 @@
 #include <albion/lib.h>
 #include <gb/debug.h>
 #include <gb/scheduler.h>
+#include <gb/block_cache.h>
 
 namespace gameboy
 {
@@ -41,15 +42,27 @@ struct Cpu final
     EXEC_INSTR_FPTR exec_instr_fptr;
 
     inline void exec_instr()
+    {
+        exec_block_debug();
+    }
+
+    // exactly one instr
+    inline void step_instr()
     {
         exec_instr_debug();
     }
 
     void exec_instr_debug();
+    void exec_block_debug();
 
 #else 
 
     inline void exec_instr()
+    {
+        exec_block();
+    }
+
+    inline void step_instr()
     {
         exec_instr_no_debug();
     }
@@ -59,9 +72,39 @@ struct Cpu final
 
     void exec_instr_no_debug();
 
+    // run pre decoded straight line code from pc
+    void exec_block();
+    bool block_page(u16 addr, u32 &page, const u8* &code, u32 &limit) const noexcept;
+
+    BlockCache block_cache;
+
+    // idle loops are fast forwarded to the next event
+    // in whole passes so every read still happens on the same cycle
+    void check_idle_loop(const Block &block, u16 start_pc);
+    bool idle_read_safe(const Block &block) const noexcept;
+
+    // state after the last pass of an idle loop
+    struct IdleState
+    {
+        b32 valid = false;
+        u16 pc = 0;
+        u32 generation = 0;
+        u8 a = 0;
+        u8 f = 0;
+        u16 bc = 0;
+        u16 de = 0;
+        u16 hl = 0;
+        u16 sp = 0;
+        u64 timestamp = 0;
+        u64 next_event = 0;
+    };
+
+    IdleState idle_loop;
+    u64 idle_cycles_skipped = 0;
+
 
     void cycle_tick(u32 cycles) noexcept; 
-    void cycle_tick_t(u32 cycles) noexcept;
+    void cycle_tick_t(u64 cycles) noexcept;
     void tima_inc() noexcept;
     bool internal_tima_bit_set() const noexcept;
     bool tima_enabled() const noexcept;
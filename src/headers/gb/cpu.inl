@@ -13,7 +13,7 @@ inline void Cpu::cycle_tick(u32 cycles) noexcept
 
 
 // t cycle tick
-inline void Cpu::cycle_tick_t(u32 cycles) noexcept
+inline void Cpu::cycle_tick_t(u64 cycles) noexcept
 {
 /*
 	// timers act at constant speed
@@ -35,7 +35,9 @@ inline void Cpu::cycle_tick_t(u32 cycles) noexcept
 	if(ppu.emulate_pixel_fifo)
 	{
 		scheduler.service_events();
-		ppu.update_graphics(cycles >> is_double); // handle the lcd emulation
+
+		// idle skipping is off with the fifo, so this is never more than an event away
+		ppu.update_graphics(u32(cycles >> is_double)); // handle the lcd emulation
 	}
 
 }
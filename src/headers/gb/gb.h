@@ -7,6 +7,7 @@
 #include <gb/disass.h>
 #include <albion/lib.h>
 #include <albion/input.h>
+#include <albion/snapshot.h>
 #include <gb/debug.h>
 
 namespace gameboy
@@ -39,6 +40,14 @@ struct GB
     void save_state(std::string filename);
     void load_state(std::string filename);
 
+    // in memory states, no file io
+    void save_snapshot(Snapshot &snap);
+    void load_snapshot(Snapshot &snap);
+
+    // once enabled a snapshot is recorded at the start of every frame
+    void enable_rewind(u32 seconds);
+    bool rewind_frame();
+
 #ifdef DEBUG
     void change_breakpoint_enable(bool enabled);
 #endif
@@ -56,6 +65,14 @@ struct GB
 
     std::atomic_bool quit = false;
     bool throttle_emu = true;
+
+    Rewind rewind;
+    Snapshot rewind_snapshot;
+
+private:
+    void save_state(std::ofstream &fp);
+    void load_state(std::ifstream &fp);
+    void record_rewind();
 };
 
 }
\ No newline at end of file
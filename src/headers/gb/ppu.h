@@ -46,6 +46,9 @@ struct Ppu
 
     bool new_vblank = false;
 
+    // sgb freeze leaves the screen alone, so the last frame has to carry over
+    bool frame_frozen() const noexcept { return mask_en == mask_mode::freeze; }
+
     void update_graphics(u32 cycles) noexcept;
 
     unsigned int get_current_line() const noexcept
@@ -193,6 +196,8 @@ struct Ppu
     bool push_pixel() noexcept;
     void tick_fetcher() noexcept;
     void render_scanline() noexcept;
+    void render_scanline_reference() noexcept;
+    bool apply_sgb_mask() noexcept;
     void tile_fetch(Pixel_Obj *buf, bool use_window) noexcept;
     u32 get_cgb_color(int color_num, int cgb_pal, pixel_source source) const noexcept;
     u32 get_dmg_color(int color_num, pixel_source source) const noexcept;
@@ -233,6 +238,43 @@ struct Ppu
 	// 160 + 8 + 8 + 8 + 8
 	Pixel_Obj scanline_fifo[194];
 
+    // scanline compositor works on one byte per pixel so whole
+    // tiles can be decoded and resolved at once
+    // render_scanline_reference is the original per pixel path it must match
+    struct LineBuffer
+    {
+        static constexpr u32 SIZE = 194;
+
+        u8 colour[SIZE] = {0};
+        u8 pal[SIZE] = {0};
+        u8 source[SIZE] = {0};
+        u8 sprite_idx[SIZE] = {0};
+    };
+
+    LineBuffer line_buf;
+    bool reference_renderer = false;
+
+    // decoded tile data, one colour id per byte for each line of a tile
+    // with the leftmost pixel first, write_vram marks tiles dirty
+    // and they are decoded again on their next use
+    struct TileCache
+    {
+        static constexpr u32 TILES = 384;
+
+        u64 line[2][TILES][8] = {0};
+        bool dirty[2][TILES] = {0};
+    };
+
+    TileCache tile_cache;
+
+    void invalidate_tile(u32 bank, u16 addr) noexcept;
+    void invalidate_tile_cache() noexcept;
+    u64 get_tile_line(u32 bank, u32 tile, u32 y, bool x_flip) noexcept;
+
+    void line_tile_fetch(u32 dst, bool use_window) noexcept;
+    void line_sprite_fetch(u32 dst) noexcept;
+    void line_resolve(u32 src) noexcept;
+
 	Obj objects[10]; // sprites for the current scanline
 	unsigned int no_sprites = 0; // how many sprites
     unsigned int cur_sprite = 0; // current sprite
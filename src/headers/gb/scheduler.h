@@ -24,7 +24,7 @@ enum class gameboy_event
 
 constexpr size_t EVENT_SIZE = 10;
 
-struct GameboyScheduler final : public Scheduler<EVENT_SIZE,gameboy_event>
+struct GameboyScheduler final : public Scheduler<GameboyScheduler,EVENT_SIZE,gameboy_event>
 {
     GameboyScheduler(GB &gb);
 
@@ -37,7 +37,8 @@ struct GameboyScheduler final : public Scheduler<EVENT_SIZE,gameboy_event>
     Memory &mem;
 
 protected:
-    void service_event(const EventNode<gameboy_event> & node) override;
+    friend Scheduler;
+    void service_event(const EventNode<gameboy_event> & node);
 };
 
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <albion/lib.h>
 #include <albion/debug.h>
 #include <frontend/playback.h>
+#include <frontend/audio_mixer.h>
 #include <gba/forward_def.h>
 #include <gba/apu_io.h>
 #include <gb/apu.h>
@@ -17,6 +18,7 @@ struct Apu
     void init();
     void tick(int cylces); 
     void push_samples(int cycles);
+    void update_mixer_gain();
 
     void push_dma_a(int8_t x);
     void push_dma_b(int8_t x);
@@ -83,11 +85,16 @@ struct Apu
     
 	// sound playback
 	static constexpr int sample_size = 2048;
+	static constexpr int freq_playback = 44100;
 
-	//  internal sound playback
-	float audio_buf[sample_size] = {0};
-    int audio_buf_idx = 0;
-    int down_sample_cnt = 380;
+	// channels are sampled at 64khz then resampled down to the playback rate
+	// psg 1-4 then dma a and b
+	static constexpr int MIXER_CHANNELS = 6;
+	static constexpr int sample_cycles = 256;
+	static constexpr int sample_rate = (16 * 1024 * 1024) / sample_cycles;
+
+	AudioMixer mixer;
+    int down_sample_cnt = sample_cycles;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+#include <gba/forward_def.h>
+#include <albion/lib.h>
+#include <deque>
+
+namespace gameboyadvance
+{
+
+// straight line run of pre decoded instrs that ends on anything that obviously writes pc
+// fetches still go through the pipeline so timing is unchanged,
+// the fetched opcode is checked against the decoded one before its handler is used
+struct Block
+{
+    static constexpr u32 INSTR_MAX = 32;
+
+    u32 len = 0;
+    b32 thumb = false;
+
+    u32 opcode[INSTR_MAX];
+
+    // cond_lut entry for the instr, flags index it the same way as cond_met
+    // thumb instrs are allways executed
+    u16 cond[INSTR_MAX];
+
+    union
+    {
+        ARM_OPCODE_FPTR arm[INSTR_MAX];
+        THUMB_OPCODE_FPTR thumb[INSTR_MAX];
+    } handler;
+
+    // host code once the block is hot, see jit.h
+    u8 *jit = nullptr;
+    u32 hits = 0;
+
+    // loads and alu ops then a branch back to the start, see IdleLoop
+    b32 idle_candidate = false;
+};
+
+// blocks are keyed on the page of backing memory they live in
+// rom can never be written so only wram pages are ever flushed
+struct BlockCache
+{
+    static constexpr u32 PAGE_SIZE = 0x1000;
+    static constexpr u32 CHIP_WRAM_PAGES = 0x8000 / PAGE_SIZE;
+    static constexpr u32 BOARD_WRAM_PAGES = 0x40000 / PAGE_SIZE;
+    static constexpr u32 ROM_PAGES = (32 * 1024 * 1024) / PAGE_SIZE;
+    static constexpr u32 LINE_SHIFT = 6;
+
+    // page indexes
+    static constexpr u32 CHIP_WRAM_PAGE = 0;
+    static constexpr u32 BOARD_WRAM_PAGE = CHIP_WRAM_PAGE + CHIP_WRAM_PAGES;
+    static constexpr u32 ROM_PAGE = BOARD_WRAM_PAGE + BOARD_WRAM_PAGES;
+    static constexpr u32 PAGE_COUNT = ROM_PAGE + ROM_PAGES;
+
+    void init();
+
+    // drop every block
+    void flush();
+
+    // drop every block in a page
+    void flush_page(u32 page);
+
+    // find the block at offset into page, compiling it from code if its not cached
+    // code points at the start of the page
+    Block& lookup_arm(u32 page, u32 offset, const u8 *code, const ARM_OPCODE_FPTR *table, const u16 *cond_lut);
+    Block& lookup_thumb(u32 page, u32 offset, const u8 *code, const THUMB_OPCODE_FPTR *table);
+
+    // notify a write to wram that might be code
+    // offsets are into the backing memory
+    void write_chip_wram(u32 offset) noexcept
+    {
+        write_page(CHIP_WRAM_PAGE + (offset / PAGE_SIZE),offset & (PAGE_SIZE - 1));
+    }
+
+    void write_board_wram(u32 offset) noexcept
+    {
+        write_page(BOARD_WRAM_PAGE + (offset / PAGE_SIZE),offset & (PAGE_SIZE - 1));
+    }
+
+    // a bulk write (dma, bios calls) over a range of wram
+    void write_chip_wram_range(u32 offset, u32 bytes) noexcept
+    {
+        write_range(CHIP_WRAM_PAGE,offset,bytes);
+    }
+
+    void write_board_wram_range(u32 offset, u32 bytes) noexcept
+    {
+        write_range(BOARD_WRAM_PAGE,offset,bytes);
+    }
+
+    // bumped every time a block goes stale
+    // so a running block knows to exit
+    u32 generation = 0;
+
+private:
+    struct CodePage
+    {
+        // block idx + 1 for each halfword, zero if none
+        std::vector<u32> lookup;
+
+        // blocks owned by this page
+        std::vector<u32> blocks;
+
+        // 64 byte lines that hold an opcode
+        u64 code_lines = 0;
+    };
+
+    void write_page(u32 page, u32 offset) noexcept
+    {
+        if((pages[page].code_lines >> (offset >> LINE_SHIFT)) & 1)
+        {
+            flush_page(page);
+        }
+    }
+
+    void write_range(u32 base, u32 offset, u32 bytes) noexcept;
+
+    // find the slot for offset, reusing the block there if its for the other mode
+    Block& alloc_block(u32 page, u32 offset, bool thumb, bool &cached);
+
+    std::vector<CodePage> pages;
+
+    // translated code points back at its block so they must not move
+    std::deque<Block> blocks;
+    std::vector<u32> free_list;
+};
+
+}
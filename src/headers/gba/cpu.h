@@ -7,6 +7,9 @@
 #include <gba/dma.h>
 #include <gba/interrupt.h>
 #include <gba/scheduler.h>
+#include <gba/block_cache.h>
+#include <gba/jit.h>
+#include <gba/idle_loop.h>
 
 
 namespace gameboyadvance
@@ -80,10 +83,8 @@ constexpr bool cond_lut_helper(u32 cond, u32 flags)
 
 
 
-using ARM_OPCODE_FPTR = void (Cpu::*)(u32 opcode);
 using ARM_OPCODE_LUT = std::array<ARM_OPCODE_FPTR,4096>;
 
-using THUMB_OPCODE_FPTR = void (Cpu::*)(u16 opcode);
 using THUMB_OPCODE_LUT = std::array<THUMB_OPCODE_FPTR,1024>;
 
 struct Cpu final
@@ -98,6 +99,29 @@ struct Cpu final
 
     void exec_instr_no_debug();
 
+    // run pre decoded straight line code from pc
+    // stops early when an event or interrupt is ready, like the main loop does between instrs
+    void exec_block();
+    void exec_block_arm();
+    void exec_block_thumb();
+    bool block_page(u32 addr, u32 &page, u32 &offset, const u8* &code) const noexcept;
+
+    BlockCache block_cache;
+
+    // run the translation of a block, returns false if it isnt hot yet
+#ifdef GBA_JIT_SUPPORTED
+    bool exec_jit(Block &block);
+#endif
+
+    Jit jit;
+
+    // skip polling loops to the next event
+    IdleLoop idle_loop;
+    bool idle_loop_check(u32 pc, const Block &block);
+
+    // bumped on every exec_block so idle_loop can tell nothing else ran
+    u64 block_count = 0;
+
     bool interrupt_ready() const
     {
         return interrupt_service && !is_set(cpsr,7);    
@@ -116,7 +140,7 @@ struct Cpu final
 #ifdef DEBUG
     
 
-    EXEC_INSTR_FPTR exec_instr_fptr = &Cpu::exec_instr_no_debug;
+    EXEC_INSTR_FPTR exec_instr_fptr = &Cpu::exec_block;
 
     inline void exec_instr()
     {
@@ -129,7 +153,7 @@ struct Cpu final
 
     inline void exec_instr()
     {
-        exec_instr_no_debug();
+        exec_block();
     }
 
 #endif
@@ -191,7 +215,7 @@ struct Cpu final
 
         else
         {
-            exec_instr_fptr = &Cpu::exec_instr_no_debug; 
+            exec_instr_fptr = &Cpu::exec_block; 
         }
     }
 #endif
@@ -403,7 +427,20 @@ struct Cpu final
     void read_stack_fd(u32 reg);
 
 
-    void swi(u32 function);
+    // bios hle, false if the real bios has to do it
+    bool swi(u32 function);
+    void swi_intr_wait(bool discard, u32 mask);
+    void swi_div(u32 num, u32 denom);
+    u32 swi_arctan(u32 v);
+    u32 swi_arctan2(u32 x, u32 y);
+    void swi_cpu_set();
+    void swi_cpu_fast_set();
+    void swi_bg_affine_set();
+    void swi_obj_affine_set();
+    void swi_lz77(bool vram);
+    void swi_rl(bool vram);
+    void swi_huffman();
+    void swi_write_out(u32 dst, const std::vector<u8> &buf, bool vram);
 
     // timers
     void timer_overflow(int timer);
@@ -450,6 +487,15 @@ struct Cpu final
 
     bool bios_hle_interrupt;
 
+    // do swi calls natively rather than running the bios
+    bool bios_hle = false;
+
+    // inside an intr wait that is waiting on another interrupt
+    bool intr_wait_pending = false;
+
+    // decompression output
+    std::vector<u8> swi_buffer;
+
 
     // backup stores
     u32 user_regs[16] = {0};
@@ -50,7 +50,7 @@ struct BgCnt
 
 
 
-enum class window_source
+enum class window_source : u16
 {
     zero = 0,
     one = 1,
@@ -125,7 +125,8 @@ struct Mosaic
     int obj_v_size;
 };
 
-enum class pixel_source
+// u16 so line buffers of these can be loaded straight into vector regs
+enum class pixel_source : u16
 {
     bg0 = 0,
     bg1 = 1,
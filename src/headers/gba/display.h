@@ -2,11 +2,10 @@
 #include <albion/lib.h>
 #include <gba/forward_def.h>
 #include <gba/disp_io.h>
+#include <gba/renderer.h>
 
 namespace gameboyadvance
 {
-static constexpr u32 SCREEN_WIDTH = 240;
-static constexpr u32 SCREEN_HEIGHT = 160;
 
 enum class display_mode
 {
@@ -32,47 +31,30 @@ struct Display
     DispIo disp_io;
     display_mode mode = display_mode::visible;
 
-    struct TileData
-    {
-        TileData() {}
-
-        TileData(u16 c, pixel_source s)
-        {
-            color = c;
-            source = s;
-        }
-
-        u16 color = 0;
-        pixel_source source = pixel_source::bd;
-    };
-
     void render();
-    void render_text(int id);
-    void render_affine(int id);
     void advance_line();
-    void render_sprites(int mode);
-    void merge_layers();
 
-    // is this inside a window if so is it enabled?
-    bool bg_window_enabled(unsigned int bg, unsigned int x) const;
+    // lines are drawn on threads when this is non zero
+    // output is identical to drawing them here
+    void set_render_threads(u32 threads);
 
-    // are sprites enabled inside a window
-    bool sprite_window_enabled(unsigned int x) const;
+    // wait for any lines still being drawn
+    void finish_render();
 
-    // are special effects enabled inside a window
-    bool special_window_enabled(unsigned int x) const;
+    LineState latch_line() const;
 
-    void cache_window();
-    bool is_bg_window_trivial(int id);
+    // used for the serial path and the debug viewers
+    Renderer renderer;
 
-    // renderer helper functions
-    u16 read_bg_palette(u32 pal_num,u32 idx);
-    u16 read_obj_palette(u32 pal_num,u32 idx);
+    MemSnapshot<u8> vram_copy;
+    MemSnapshot<u8> pal_copy;
+    MemSnapshot<u8> oam_copy;
 
-    void read_tile(TileData *tile,unsigned int bg,bool col_256,u32 base,u32 pal_num,u32 tile_num, 
-        u32 y,bool x_flip, bool y_flip);
-    
-    void draw_tile(u32 x,const TileData &p);
+    // taken alongside vram
+    MemSnapshot<u32> vram_gen_copy;
+
+    // declared after the snapshots so its torn down before them
+    RenderPool render_pool;
 
     unsigned int cyc_cnt = 0; // current number of elapsed cycles
     unsigned int ly = 0; // current number of cycles
@@ -84,21 +66,6 @@ struct Display
     Cpu &cpu;
     GBAScheduler &scheduler;
 
-    struct Scanline
-    {
-        TileData t1;
-        TileData t2;
-    };
-
-    std::vector<Scanline> scanline;
-
-
-    std::vector<TileData> sprite_line;
-    std::vector<bool> sprite_semi_transparent;
-    std::vector<window_source> window;
-    std::vector<u32> oam_priority;
-    std::vector<u32> sprite_priority;
-
 };
 
 u32 convert_color(u16 color);
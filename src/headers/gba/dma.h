@@ -80,10 +80,20 @@ struct Dma
     Debug &debug;
 
     void do_dma(int reg_num,dma_type req_type);
-    void handle_increment(int reg_num);
-    bool do_fast_dma(int reg_num);
     void check_dma();
 
+    // address step for each unit of a transfer
+    int32_t src_step(const DmaReg &r, bool word) const;
+    int32_t dst_step(const DmaReg &r, bool word) const;
+
+    // move count units from the shadow addresses, timed as a whole
+    template<typename access_type>
+    void transfer(DmaReg &r, u32 count, int32_t src_inc, int32_t dst_inc);
+
+    // move n units with no timing in as few copies as possible
+    template<typename access_type>
+    void transfer_run(DmaReg &r, u32 n, int32_t src_inc, int32_t dst_inc);
+
 
     static constexpr int32_t addr_increment_table[2][4] = 
     {
@@ -1,4 +1,5 @@
 #pragma once
+#include <albion/lib.h>
 
 namespace gameboyadvance
 {
@@ -11,4 +12,7 @@ struct Disass;
 struct GBA;
 struct GBAScheduler;
 
+using ARM_OPCODE_FPTR = void (Cpu::*)(u32 opcode);
+using THUMB_OPCODE_FPTR = void (Cpu::*)(u16 opcode);
+
 }
\ No newline at end of file
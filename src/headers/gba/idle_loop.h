@@ -0,0 +1,55 @@
+#pragma once
+#include <albion/lib.h>
+#include <gba/forward_def.h>
+#include <unordered_map>
+
+namespace gameboyadvance
+{
+
+// per game settings for idle loop skipping
+struct IdleLoopOverride
+{
+    // detection misfires on this game
+    b32 disable = false;
+
+    // loops that cant be proven idle (eg they store to a flag)
+    // but are known to be safe to skip anyway
+    std::vector<u32> loops;
+};
+
+// spots polling loops that cannot make progress until an event fires
+// a candidate is a single block that branches back to its own start with only loads and alu ops,
+// if two passes in a row leave every reg the same and no event ran the cpu can skip whole passes up to the next event
+struct IdleLoop
+{
+    // lines are "<game code> off" or "<game code> <loop addr in hex>", # for comments
+    // a bad addr throws with its line number
+    void load_overrides(const std::string &filename);
+
+    // pick up the overrides for the rom just loaded, by the game code in its header
+    void select_game(const std::string &code);
+
+    b32 enabled = false;
+
+    // stats
+    u64 skips = 0;
+    u64 skipped_cycles = 0;
+
+    // for the current game
+    b32 game_disabled = false;
+    std::vector<u32> forced;
+
+    // state of the last entry into a candidate
+    u32 pc = 0xffffffff;
+    u64 block_count = 0;
+    u32 regs[15] = {0};
+    u32 cpsr = 0;
+
+    // a pass only counts if no event ran during it
+    u64 timestamp = 0;
+    u64 next_event = 0;
+
+    std::unordered_map<std::string,IdleLoopOverride> overrides;
+};
+
+}
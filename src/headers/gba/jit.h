@@ -0,0 +1,55 @@
+#pragma once
+#include <gba/forward_def.h>
+#include <gba/block_cache.h>
+#include <exception>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define GBA_JIT_SUPPORTED
+#endif
+
+namespace gameboyadvance
+{
+
+// optional x86-64 backend for the block cache
+// blocks that have run enough times are translated to host code
+// simple alu ops are emitted directly, everything else (memory, branches, psr)
+// calls the same handler the interpreter would so timing and slow paths are shared
+struct Jit
+{
+    using JIT_FUNC = void (*)(Cpu *cpu);
+
+    static constexpr size_t ARENA_SIZE = 16 * 1024 * 1024;
+
+    // largest possible translation of a single block
+    static constexpr size_t BLOCK_SIZE_MAX = Block::INSTR_MAX * 256;
+
+    Jit();
+    ~Jit();
+
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // translate a block, returns nullptr if the arena is full
+    u8* compile(Cpu &cpu, const Block &block);
+
+    // drop all translations, the block cache must be flushed alongside
+    void reset();
+
+    b32 enabled = false;
+
+    // times a block is interpreted before its translated
+    u32 hot_threshold = 16;
+
+    // state for the block being run, read by the helpers it calls
+    u32 entry_pc = 0;
+    u32 generation = 0;
+
+    // thrown by a handler, held until the block has unwound back out of emitted code
+    std::exception_ptr error;
+
+private:
+    u8 *arena = nullptr;
+    size_t arena_used = 0;
+};
+
+}
@@ -52,8 +52,18 @@ struct Mem final
     template<typename access_type>
     bool fast_memcpy(u32 dst, u32 src, u32 n);
 
+    // untimed copy / fill straight into the backing memory
+    // caller has to check can_fast_memcpy first
+    void bulk_copy(u32 dst, u32 src, u32 bytes);
+
+    template<typename access_type>
+    void bulk_fill(u32 dst, access_type v, u32 n);
+
     void save_cart_ram();
 
+    // note a write to vram for the render threads and tile caches
+    void touch_vram(u32 offset, u32 bytes);
+
     void switch_bios(bool in_bios);
 
 
@@ -91,7 +101,21 @@ struct Mem final
     {
         // only allow up to 32bit
         static_assert(sizeof(access_type) <= 4);
-        cpu.cycle_tick(get_waitstates<access_type>(addr,sequential,use_prefetch));
+
+        const u32 cycles = get_waitstates<access_type>(addr,sequential);
+
+        // the prefetcher only runs while the cart bus is free
+        if(memory_region_table[(addr >> 24) & 0xf] == memory_region::rom)
+        {
+            prefetch.active = false;
+        }
+
+        else
+        {
+            prefetch_step(cycles);
+        }
+
+        cpu.cycle_tick(cycles);
     }
 
 
@@ -219,6 +243,11 @@ struct Mem final
     // video ram
     std::vector<u8> vram; // 0x18000
 
+    // bumped on every write to a 32 byte tile of vram
+    // decoded tiles are stale once it no longer matches
+    static constexpr u32 VRAM_TILE_SIZE = 32;
+    std::vector<u32> vram_tile_gen; // 0x18000 / 32
+
     // display memory
 
     // bg/obj pallette ram
@@ -349,16 +378,45 @@ struct Mem final
 
     u8 *backing_vec[10] = {nullptr};
     bool can_fast_memcpy(u32 dst, u32 src,u32 n) const;
+
+    // set on reads of anything that changes without an event (timer counters)
+    // so idle loop detection doesent skip over it
+    bool volatile_read = false;
+
+    // tell the block cache and renderer about a write that skipped the handlers
+    void bulk_written(memory_region region, u32 offset, u32 bytes);
     u32 align_addr_to_region(u32 addr) const;
 
 
     void update_wait_states();
     void cache_wait_states(u32 new_pc);
     void update_seq(u32 addr);
-    u32 get_rom_wait(u32 region, u32 size, bool seq, bool prefetch);
 
     template<typename access_type>
-    u32 get_waitstates(u32 addr, bool seq, bool prefetch);
+    u32 get_waitstates(u32 addr, bool seq) const
+    {
+        static_assert(sizeof(access_type) <= 4);
+
+        // access type >> 1 to get the value
+        // 4 -> 2 (word)
+        // 2 -> 1 (half)
+        // 1 -> 0 (byte)
+        return access_cycles[(addr >> 24) & 0xf][sizeof(access_type) >> 1][seq];
+    }
+
+    // cycles for an opcode fetch of halfs halfwords from rom, through the prefetch buffer
+    u32 prefetch_fetch(u32 addr, u32 halfs);
+
+    // cart bus was free for cycles, let the prefetcher fill the buffer
+    void prefetch_step(u32 cycles)
+    {
+        if(prefetch.active && prefetch.count != PREFETCH_SIZE)
+        {
+            prefetch_fill(cycles);
+        }
+    }
+
+    void prefetch_fill(u32 cycles);
 
     void do_prefetch();
 
@@ -369,15 +427,6 @@ struct Mem final
         flash
     };
 
-    // pick up here and impl the lookup timings
-    // then go impl the cart detection
-    static constexpr int cart_wait_states[3][3] = 
-    {
-        {5,5,5}, // sram only 8 bit
-        {5,5,8}, // eeprom (dont know)
-        {5,5,8} // flash only 16/32 write all reads
-    };
-
     static constexpr size_t CART_TYPE_SIZE = 5;
     const std::array<std::string,CART_TYPE_SIZE> cart_magic = 
     {
@@ -419,32 +468,46 @@ struct Mem final
     int frame_count = 0;
     static constexpr int FRAME_SAVE_LIMIT = 3600;
 
-    // memory cycle timings
-    // some can be set dynamically
-    // b w h
-    int wait_states[10][3];
+    // memory cycle timings, total cycles for an access
+    // by [addr >> 24][byte, half, word][non seq, seq]
+    // rom and sram are rebuilt whenever waitcnt is written
+    u8 access_cycles[16][3][2];
 
-    static constexpr int wait_states_default[10][3]  = 
+    // fixed timings for everything off the cart, b h w
+    static constexpr u8 access_cycles_default[8][3] = 
     {
         {1,1,1}, // bios rom
-        {1,1,1}, // wram 32k
+        {1,1,1}, // unused
         {3,3,6}, // wram 256k
+        {1,1,1}, // wram 32k
         {1,1,1}, // io
         {1,1,2}, // pallete ram
         {1,1,2}, // vram
         {1,1,1}, // oam
-        {5,5,8}, // gamepak rom (in 2nd array)
-        // pretend its faster than it really is
-        // until we have prefetch
-        //{1,1,1}, 
-        {5,5,8}, // cart backup needs to be setup depending on cart type
-        // hack to undershoot timings
     };
-    
 
-    static_assert(sizeof(wait_states) == sizeof(wait_states_default));
+    // gamepak prefetch, fills while the cpu is off the cart bus
+    // so sequential opcode fetches from rom can be served in a cycle
+    static constexpr u32 PREFETCH_SIZE = 8;
+
+    struct Prefetch
+    {
+        // next halfword the cpu will fetch out of the buffer
+        u32 addr = 0;
+
+        // halfwords ready
+        u32 count = 0;
+
+        // progress on the halfword being fetched
+        u32 cycles = 0;
 
-    int rom_wait_states[3][2][3];
+        // cost of fetching each halfword
+        u32 seq_cycles = 1;
+
+        b32 active = false;
+    };
+
+    Prefetch prefetch;
 
 
 
@@ -476,10 +539,6 @@ struct Mem final
 
     u32 wait_nseq_16;
     u32 wait_nseq_32;
-    
-    u32 prefetch_count;
-    bool use_prefetch = false;
-   
 
     // external memory
 
@@ -518,8 +577,8 @@ extern template void Mem::write_memt_no_debug<u32>(u32 addr, u32 v);
 extern template bool Mem::fast_memcpy<u16>(u32 src, u32 dst, u32 n);
 extern template bool Mem::fast_memcpy<u32>(u32 src, u32 dst, u32 n);
 
+extern template void Mem::bulk_fill<u16>(u32 dst, u16 v, u32 n);
+extern template void Mem::bulk_fill<u32>(u32 dst, u32 v, u32 n);
+
 
-extern template u32 Mem::get_waitstates<u32>(u32 addr, bool seq, bool prefetch);
-extern template u32 Mem::get_waitstates<u16>(u32 addr, bool seq, bool prefetch);
-extern template u32 Mem::get_waitstates<u8>(u32 addr, bool seq, bool prefetch);
 }
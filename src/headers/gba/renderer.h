@@ -0,0 +1,226 @@
+#pragma once
+#include <albion/lib.h>
+#include <gba/forward_def.h>
+#include <gba/disp_io.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <deque>
+
+namespace gameboyadvance
+{
+
+static constexpr u32 SCREEN_WIDTH = 240;
+static constexpr u32 SCREEN_HEIGHT = 160;
+
+struct TileData
+{
+    TileData() {}
+
+    TileData(u16 c, pixel_source s)
+    {
+        color = c;
+        source = s;
+    }
+
+    u16 color = 0;
+    pixel_source source = pixel_source::bd;
+};
+
+// everything a line is drawn from, latched at hblank
+// so the line can be rendered later or on another thread
+struct LineState
+{
+    DispIo disp_io;
+    u32 ly = 0;
+
+    bool window_0_y_triggered = false;
+    bool window_1_y_triggered = false;
+
+    // either the live memory or a snapshot of it
+    const std::vector<u8> *vram = nullptr;
+    const std::vector<u8> *pal_ram = nullptr;
+    const std::vector<u8> *oam = nullptr;
+
+    // write count of each vram tile, see Mem::vram_tile_gen
+    const std::vector<u32> *vram_gen = nullptr;
+};
+
+// draws a single line, owns all the scratch buffers so
+// each render thread gets its own
+struct Renderer : public LineState
+{
+    Renderer();
+
+    // draw state.ly into out (SCREEN_WIDTH pixels)
+    void render(const LineState &state, u32 *out);
+
+    void render_text(int id);
+    void render_affine(int id);
+    void render_sprites(int mode);
+    void merge_layers();
+
+    // composite [start,end) of a non bitmap line
+    void merge_layers_scalar(u32 start, u32 end);
+    u32 merge_layers_simd();
+
+    // is this inside a window if so is it enabled?
+    bool bg_window_enabled(unsigned int bg, unsigned int x) const;
+
+    // are sprites enabled inside a window
+    bool sprite_window_enabled(unsigned int x) const;
+
+    // are special effects enabled inside a window
+    bool special_window_enabled(unsigned int x) const;
+
+    void cache_window();
+    bool is_bg_window_trivial(int id);
+
+    // renderer helper functions
+    u16 read_bg_palette(u32 pal_num,u32 idx);
+    u16 read_obj_palette(u32 pal_num,u32 idx);
+
+    void read_tile(TileData *tile,unsigned int bg,bool col_256,u32 base,u32 pal_num,u32 tile_num,
+        u32 y,bool x_flip, bool y_flip);
+
+    void draw_tile(u32 x,const TileData &p);
+
+    // a row of a bg tile decoded to palette indexes
+    // so palette writes dont make it stale
+    struct TileRow
+    {
+        u32 gen = 0;
+        b32 valid = false;
+        u8 idx[8] = {0};
+    };
+
+    // decoded row at addr, only redone when the tile its in is written
+    const TileRow& decode_row(bool col_256, u32 addr);
+
+    // per pixel layers for the line, kept as arrays rather than structs
+    // so merge_layers can load a run of pixels at once
+    struct alignas(32) LineBuffer
+    {
+        // 1st and 2nd bg target
+        u16 color1[SCREEN_WIDTH];
+        pixel_source source1[SCREEN_WIDTH];
+        u16 color2[SCREEN_WIDTH];
+        pixel_source source2[SCREEN_WIDTH];
+
+        // winning sprite pixel
+        u16 obj_color[SCREEN_WIDTH];
+        pixel_source obj_source[SCREEN_WIDTH];
+        u16 obj_priority[SCREEN_WIDTH];
+        u16 obj_semi_transparent[SCREEN_WIDTH];
+
+        window_source window[SCREEN_WIDTH];
+    };
+
+    // output for the current line
+    u32 *line = nullptr;
+
+    LineBuffer layer;
+
+    std::vector<u32> oam_priority;
+
+    // one entry for every row sized chunk of vram
+    std::vector<TileRow> tile_row_4bpp;
+    std::vector<TileRow> tile_row_8bpp;
+
+    // returned for rows past the end of vram
+    TileRow blank_row;
+};
+
+// copy of a ppu memory for the render threads
+// a new copy is only taken if the memory has been written since the last one
+template<typename T>
+struct MemSnapshot
+{
+    const std::vector<T>* take(const std::vector<T> &mem)
+    {
+        if(!dirty && cur)
+        {
+            return cur;
+        }
+
+        if(used == copies.size())
+        {
+            copies.emplace_back();
+        }
+
+        // reuses the allocation from previous frames
+        auto &copy = copies[used++];
+        copy = mem;
+
+        cur = &copy;
+        dirty = false;
+
+        return cur;
+    }
+
+    // copies can be reused once every line drawn from them is done
+    void reset()
+    {
+        used = 0;
+        cur = nullptr;
+        dirty = true;
+    }
+
+    // set by the memory write handlers
+    b32 dirty = true;
+
+private:
+    std::deque<std::vector<T>> copies;
+    u32 used = 0;
+    const std::vector<T> *cur = nullptr;
+};
+
+// draws latched lines on a small set of worker threads
+// lines only ever write their own row of the screen so they can finish in any order
+struct RenderPool
+{
+    RenderPool() = default;
+    ~RenderPool();
+
+    RenderPool(const RenderPool&) = delete;
+    RenderPool& operator=(const RenderPool&) = delete;
+
+    // zero threads shuts the pool down
+    void start(u32 threads);
+    void stop();
+
+    bool active() const { return workers.size() != 0; }
+
+    void submit(const LineState &state, u32 *out);
+
+    // block until every submitted line is drawn
+    // rethrows anything a line threw
+    void wait();
+
+private:
+    void worker_main(u32 id);
+
+    struct LineJob
+    {
+        LineState state;
+        u32 *out = nullptr;
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<Renderer> renderers;
+
+    // one frame worth of lines, cleared by wait
+    std::vector<LineJob> jobs;
+    u32 submitted = 0;
+    u32 next = 0;
+    u32 done = 0;
+    bool quit = false;
+    std::exception_ptr error = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+};
+
+}
@@ -25,7 +25,7 @@ enum class gba_event
 
 constexpr size_t EVENT_SIZE = 11;
 
-struct GBAScheduler final : public Scheduler<EVENT_SIZE,gba_event>
+struct GBAScheduler final : public Scheduler<GBAScheduler,EVENT_SIZE,gba_event>
 {
     GBAScheduler(GBA &gba);
 
@@ -38,7 +38,8 @@ struct GBAScheduler final : public Scheduler<EVENT_SIZE,gba_event>
     Mem &mem;
 
 protected:
-    void service_event(const EventNode<gba_event> & node) override;
+    friend Scheduler;
+    void service_event(const EventNode<gba_event> & node);
 };
 
 }
\ No newline at end of file
@@ -49,6 +49,22 @@ struct EntryLo
     b32 g = 0;
 };
 
+// one of the joint tlb entries, maps an even / odd pair of pages
+struct TlbEntry
+{
+    // as written to PageMask, bits of the vpn ignored for the compare
+    u32 page_mask = 0;
+    u32 vpn2 = 0;
+    u32 asid = 0;
+
+    // both halves were global when written, the asid is ignored
+    b32 g = false;
+
+    EntryLo lo[2];
+};
+
+static constexpr u32 TLB_SIZE = 32;
+
 struct Index
 {
     b32 p;
@@ -104,6 +120,8 @@ struct Cop0
     u64 bad_vaddr = 0;
     Context context;
 
+    TlbEntry tlb[TLB_SIZE];
+
     u64 epc = 0;
     u64 error_epc = 0;
 
@@ -4,11 +4,60 @@
 #include <n64/mips.h>
 #include <n64/cop0.h>
 #include <n64/cop1.h>
+#include <n64/tlb.h>
+#include <n64/jit.h>
 #include <beyond_all_repair.h>
+#include <memory>
 
 namespace nintendo64
 {
 
+using Opcode = beyond_all_repair::Opcode;
+
+using INSTR_FUNC = void (*)(N64 &n64, const Opcode &opcode);
+
+// opcode decoded along with the handler it dispatches to
+struct DecodedInstr
+{
+    Opcode opcode;
+    INSTR_FUNC handler = nullptr;
+
+    // matches the page gen when this is up to date
+    u32 gen = 0;
+
+    // jit block starting here, valid while jit_gen matches the page gen
+    // a null block with a matching gen could not be translated
+    u8 *jit = nullptr;
+    u32 jit_gen = 0;
+    u32 jit_len = 0;
+
+    // times run by the interpreter since the last translation
+    u32 hits = 0;
+};
+
+// pre decoded instructions for rdram and rom, by physical address
+// pages are only allocated once code runs in them
+// a write anywhere in a page bumps its gen so every entry gets decoded again on next use
+struct InstrCache
+{
+    static constexpr u32 PAGE_SHIFT = 12;
+    static constexpr u32 PAGE_SIZE = 1 << PAGE_SHIFT;
+    static constexpr u32 PAGE_ENTRIES = PAGE_SIZE / sizeof(u32);
+
+    // everything below the pif
+    static constexpr u32 ADDR_SPACE = 0x1FC0'0000;
+
+    struct Page
+    {
+        u32 gen = 1;
+        DecodedInstr instr[PAGE_ENTRIES];
+    };
+
+    // raw pointers so the jit can test them from emitted code
+    std::vector<Page*> pages;
+    std::vector<std::unique_ptr<Page>> storage;
+};
+
 
 struct Cpu
 {
@@ -23,12 +72,12 @@ struct Cpu
     Cop1 cop1;
 
     b32 interrupt = false;
-};
 
+    TlbCache tlb_cache;
 
-using Opcode = beyond_all_repair::Opcode;
-
-using INSTR_FUNC = void (*)(N64 &n64, const Opcode &opcode);
+    InstrCache instr_cache;
+    Jit jit;
+};
 
 void reset_cpu(Cpu &cpu);
 
@@ -37,6 +86,15 @@ void write_pc(N64 &n64, u64 pc);
 
 void cycle_tick(N64 &n64, u32 cycles);
 
+// drop any decoded instructions in the page holding this physical address
+void invalidate_instr_cache(N64 &n64, u32 addr);
+
+// one instr through the instr cache
+void step_cached(N64 &n64);
+
+// run the jit block at the pc, or a single instr if there isnt one ready
+void step_jit(N64 &n64);
+
 void write_cop0(N64 &n64, u64 v, u32 reg);
 u64 read_cop0(N64& n64, u32 reg);
 
@@ -6,5 +6,6 @@ struct Cpu;
 struct Mem;
 struct N64;
 struct Rdp;
+struct Rsp;
 
 };
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <albion/lib.h>
+#include <exception>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define N64_JIT_SUPPORTED
+#endif
+
+namespace nintendo64
+{
+
+// optional x86-64 backend on top of the instr cache
+// blocks run up to a branch and its delay slot, or the end of a cache page
+// simple alu ops and loads and stores through the page table are emitted directly,
+// everything else (branches, cop0/1, mul/div, io) calls the handler out of the instr cache
+// cycles for the emitted ops are charged before each call and at the block exit,
+// so the scheduler (and count/compare) sees the same timestamp the interpreter would
+struct Jit
+{
+    using JIT_FUNC = void (*)(N64 *n64);
+
+    static constexpr size_t ARENA_SIZE = 32 * 1024 * 1024;
+
+    static constexpr u32 BLOCK_INSTR_MAX = 64;
+
+    // largest possible translation of a single block
+    static constexpr size_t BLOCK_SIZE_MAX = BLOCK_INSTR_MAX * 192;
+
+    Jit();
+    ~Jit();
+
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // translate the block starting at pc, len is set to its length in instrs
+    // returns nullptr if it cant be translated or the arena is full (full is set)
+    u8* compile(N64 &n64, u64 pc, u32 &len, b32 &full);
+
+    // drop all translations, the instr cache must be invalidated alongside
+    void reset();
+
+    b32 enabled = false;
+
+    // times a block is interpreted before its translated
+    u32 hot_threshold = 16;
+
+    // state for the block being run, read by the helpers it calls
+    const u32 *page_gen = nullptr;
+    u32 entry_gen = 0;
+
+    // thrown by a handler, held until the block has unwound back out of emitted code
+    std::exception_ptr error;
+
+private:
+    u8 *arena = nullptr;
+    size_t arena_used = 0;
+};
+
+}
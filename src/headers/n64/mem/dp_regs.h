@@ -0,0 +1,21 @@
+#pragma once
+
+namespace nintendo64
+{
+
+struct DpRegs
+{
+    u32 start = 0;
+    u32 end = 0;
+    u32 current = 0;
+
+    // start written but not yet picked up by an end write
+    b32 start_valid = false;
+
+    // commands come from dmem rather than rdram
+    b32 xbus = false;
+    b32 freeze = false;
+    b32 flush = false;
+};
+
+}
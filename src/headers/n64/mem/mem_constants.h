@@ -74,8 +74,25 @@ static constexpr u32 DP_INTR_BIT = 5;
 
 
 // sp
-static constexpr u32 SP_PC = 0x04080000;
+static constexpr u32 SP_MEM_ADDR = 0x04040000;
+static constexpr u32 SP_DRAM_ADDR = 0x04040004;
+static constexpr u32 SP_RD_LEN = 0x04040008;
+static constexpr u32 SP_WR_LEN = 0x0404000C;
 static constexpr u32 SP_STATUS = 0x04040010;
+static constexpr u32 SP_DMA_FULL = 0x04040014;
+static constexpr u32 SP_DMA_BUSY = 0x04040018;
+static constexpr u32 SP_SEMAPHORE = 0x0404001C;
+static constexpr u32 SP_PC = 0x04080000;
+
+// dp command
+static constexpr u32 DPC_START = 0x0410'0000;
+static constexpr u32 DPC_END = 0x0410'0004;
+static constexpr u32 DPC_CURRENT = 0x0410'0008;
+static constexpr u32 DPC_STATUS = 0x0410'000C;
+static constexpr u32 DPC_CLOCK = 0x0410'0010;
+static constexpr u32 DPC_BUFBUSY = 0x0410'0014;
+static constexpr u32 DPC_PIPEBUSY = 0x0410'0018;
+static constexpr u32 DPC_TMEM = 0x0410'001C;
 
 static constexpr u32 PIF_SIZE = 0x40;
 static constexpr u32 PIF_MASK = PIF_SIZE - 1;
\ No newline at end of file
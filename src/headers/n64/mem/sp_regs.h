@@ -7,9 +7,12 @@ struct SpRegs
 {
     // sp
     u32 mem_addr = 0;
+    u32 dram_addr = 0;
+    u32 rd_len = 0;
+    u32 wr_len = 0;
 
-    u32 pc = 0;
-    b32 halt = false;
+    // rsp starts halted until the cpu loads it
+    b32 halt = true;
     b32 broke = false;
 
 
@@ -17,11 +20,13 @@ struct SpRegs
     b32 dma_full = false;
     b32 io_full = false;
     b32 single_step = false;
-    b32 clear_intr_on_break = false;
-    b32 set_intr_on_break = false;
     b32 intr_on_break = false;
     b32 signal[8] = {0};
 
+    b32 semaphore = false;
 };
 
+// halting or unhalting the rsp here settles its slice
+void write_sp_regs(N64& n64, u64 addr, u32 v);
+
 }
\ No newline at end of file
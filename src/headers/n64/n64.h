@@ -1,7 +1,9 @@
 #pragma once
 #include <n64/cpu.h>
 #include <n64/mem.h>
+#include <n64/rasterizer.h>
 #include <n64/rdp.h>
+#include <n64/rsp.h>
 #include <n64/debug.h>
 #include <n64/scheduler.h>
 #include <albion/lib.h>
@@ -16,6 +18,7 @@ struct N64
     Cpu cpu;
     Mem mem;
     Rdp rdp;
+    Rsp rsp;
     N64Debug debug{*this};
     N64Scheduler scheduler{*this};
     beyond_all_repair::Program program;
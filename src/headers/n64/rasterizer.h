@@ -0,0 +1,168 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <albion/lib.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+#include <exception>
+
+namespace nintendo64
+{
+
+struct RdpTile
+{
+    u32 format = 0;
+    u32 size = 0;
+
+    // in 64 bit words
+    u32 line = 0;
+    u32 tmem = 0;
+
+    u32 palette = 0;
+
+    b32 clamp_s = false;
+    b32 mirror_s = false;
+    u32 mask_s = 0;
+    u32 shift_s = 0;
+
+    b32 clamp_t = false;
+    b32 mirror_t = false;
+    u32 mask_t = 0;
+    u32 shift_t = 0;
+
+    // 10.2
+    u32 sl = 0;
+    u32 tl = 0;
+    u32 sh = 0;
+    u32 th = 0;
+};
+
+struct RdpImage
+{
+    u32 format = 0;
+    u32 size = 0;
+    u32 width = 0;
+    u32 addr = 0;
+};
+
+// everything a primitive is drawn with
+// each worker keeps its own copy and replays the whole command list into it
+struct RdpState
+{
+    u64 other_modes = 0;
+    u64 combine = 0;
+
+    u32 fill_color = 0;
+    u32 fog_color = 0;
+    u32 blend_color = 0;
+    u32 prim_color = 0;
+    u32 env_color = 0;
+
+    u32 prim_lod_frac = 0;
+    u32 prim_z = 0;
+    u32 prim_dz = 0;
+
+    s32 k4 = 0;
+    s32 k5 = 0;
+
+    // 10.2
+    u32 scissor_xh = 0;
+    u32 scissor_yh = 0;
+    u32 scissor_xl = 0;
+    u32 scissor_yl = 0;
+
+    RdpImage color_image;
+    RdpImage texture_image;
+    u32 z_addr = 0;
+
+    RdpTile tiles[8];
+
+    // stored in memory order, not word swapped like rdram
+    u8 tmem[4096] = {0};
+};
+
+// draws every band of scanlines where band % count == id
+struct RdpWorker
+{
+    RdpState state;
+
+    u32 id = 0;
+    u32 count = 1;
+};
+
+// software rdp, commands are queued until a full sync and then drawn by
+// every worker at once, each only touching its own scanlines
+// so the result is the same no matter how many there are
+struct Rasterizer
+{
+    static constexpr u32 BAND_SHIFT = 3;
+
+    Rasterizer();
+    ~Rasterizer();
+
+    Rasterizer(const Rasterizer&) = delete;
+    Rasterizer& operator=(const Rasterizer&) = delete;
+
+    // zero threads draws on the emulation thread
+    void set_threads(u32 threads);
+
+    // add a command, flushing early if its a load of memory the queued ones write
+    void push(N64 &n64, const u64 *cmd, u32 len);
+
+    // draw everything queued
+    void flush(N64 &n64);
+
+    void reset();
+
+    // command words that didnt make up a whole command yet
+    u64 partial[22] = {0};
+    u32 partial_len = 0;
+
+private:
+    void stop();
+    void worker_main(u32 id);
+
+    void run_worker(u32 id);
+
+    // queued commands
+    std::vector<u64> commands;
+
+    // rdram read by each queued load, copied when it was pushed
+    std::vector<u8> load_data;
+
+    // rdram written by the queued commands as [start, end)
+    u32 write_start = 0xffff'ffff;
+    u32 write_end = 0;
+
+    // enough of the state to work out the ranges above
+    RdpImage color_image;
+    RdpImage texture_image;
+    u32 z_addr = 0;
+    u32 scissor_yh = 0;
+    u32 scissor_yl = 0;
+
+    std::deque<RdpWorker> workers;
+    std::vector<std::thread> threads;
+
+    N64 *job = nullptr;
+    u32 generation = 0;
+    u32 done = 0;
+    bool quit = false;
+    std::exception_ptr error = nullptr;
+
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+};
+
+// words in a command with this id
+u32 rdp_command_len(u32 id);
+
+// pull commands between dpc current and end
+void process_dp_commands(N64 &n64);
+
+void set_rdp_threads(N64 &n64, u32 threads);
+
+}
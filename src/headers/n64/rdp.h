@@ -14,6 +14,8 @@ struct Rdp
     u32 scan_lines = 525;
 
     bool frame_done;
+
+    Rasterizer raster;
 };
 
 
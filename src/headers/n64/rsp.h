@@ -0,0 +1,71 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <albion/lib.h>
+
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define RSP_SIMD
+#endif
+
+namespace nintendo64
+{
+
+// one vector register, lane i holds element i
+// element 0 is the most significant when it goes through memory
+struct alignas(16) VReg
+{
+    u16 e[8] = {0};
+};
+
+// reality signal processor, the scalar core runs out of imem against dmem
+// with the 8 lane vector unit as cop2
+struct Rsp
+{
+    u32 regs[32] = {0};
+    u32 pc = 0;
+    u32 pc_next = 4;
+
+    VReg vr[32];
+
+    // 48 bit accumulator per lane, kept as three slices
+    VReg acc_hi;
+    VReg acc_md;
+    VReg acc_lo;
+
+    // flags, a lane is 0xffff when set so they can be used as masks
+    // vco: carry and not equal, vcc: compare and clip
+    VReg vco_lo;
+    VReg vco_hi;
+    VReg vcc_lo;
+    VReg vcc_hi;
+    VReg vce;
+
+    // vrcp / vrsq double precision state
+    s16 div_in = 0;
+    s16 div_out = 0;
+    b32 div_dp = false;
+
+    // cpu cycles not yet converted to rsp ones
+    u32 cycle_frac = 0;
+
+    // inside a slice, status writes from the rsp itself must not settle it
+    b32 running = false;
+};
+
+// the rsp is run in slices of this many cpu cycles while its not halted
+static constexpr u32 RSP_SLICE = 512;
+
+void reset_rsp(N64 &n64);
+
+// schedule the rsp after its been unhalted
+void start_rsp(N64 &n64);
+
+// run the rsp up to now before the cpu halts it
+void stop_rsp(N64 &n64);
+
+// run the rsp for the cpu cycles since its last slice
+void rsp_event(N64 &n64, u32 cycles);
+
+// one computational vector op, picks the sse or scalar path by RSP_SIMD
+void instr_rsp_vector(Rsp &rsp, u32 op);
+
+}
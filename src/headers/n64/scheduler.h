@@ -16,11 +16,12 @@ enum class n64_event
     ai_dma,
     si_dma,
     pi_dma,
+    rsp,
 };
 
-constexpr size_t EVENT_SIZE = 5;
+constexpr size_t EVENT_SIZE = 6;
 
-struct N64Scheduler final : public Scheduler<EVENT_SIZE,n64_event>
+struct N64Scheduler final : public Scheduler<N64Scheduler,EVENT_SIZE,n64_event>
 {
     N64Scheduler(N64 &n) : n64(n)
     {
@@ -31,7 +32,8 @@ struct N64Scheduler final : public Scheduler<EVENT_SIZE,n64_event>
 
     N64 &n64;
 protected:
-    void service_event(const EventNode<n64_event> & node) override;
+    friend Scheduler;
+    void service_event(const EventNode<n64_event> & node);
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include <n64/forward_def.h>
+#include <albion/lib.h>
+
+namespace nintendo64
+{
+
+// host side cache of tlb translations, direct mapped by virtual page
+// hits go straight to rdram or rom without searching the tlb,
+// it only ever holds what the tlb would return so anything that can change that flushes it
+struct TlbCache
+{
+    // smallest page the tlb can map
+    static constexpr u32 PAGE_SHIFT = 12;
+    static constexpr u32 PAGE_SIZE = 1 << PAGE_SHIFT;
+
+    static constexpr u32 SIZE = 1024;
+
+    static constexpr u32 INVALID_PAGE = 0xffff'ffff;
+
+    struct Entry
+    {
+        u32 vpage = INVALID_PAGE;
+
+        // start of the physical page
+        u32 phys = 0;
+
+        // host memory for the page, nullptr if it isnt rdram or rom
+        // write is only set once the tlb says the page is dirty
+        u8 *read = nullptr;
+        u8 *write = nullptr;
+    };
+
+    // cached translation for a virtual addr, nullptr on a miss
+    const Entry* lookup(u32 vaddr) const
+    {
+        const u32 vpage = vaddr >> PAGE_SHIFT;
+        const auto &e = entry[vpage & (SIZE - 1)];
+
+        return e.vpage == vpage? &e : nullptr;
+    }
+
+    Entry entry[SIZE];
+};
+
+// thrown out of a memory access the tlb cant translate
+// caught around the instr so its backed out before the exception is taken
+struct TlbException
+{
+    u32 code = 0;
+    u32 vaddr = 0;
+
+    // nothing matched, goes to the refill vector
+    b32 refill = false;
+};
+
+// cause code for a store to a clean page
+static constexpr u32 TLB_MOD = 1;
+
+// kuseg, ksseg and kseg3 go through the tlb
+inline b32 tlb_mapped(u32 vaddr)
+{
+    const u32 segment = vaddr >> 29;
+    return segment < 4 || segment > 5;
+}
+
+// physical addr for a mapped vaddr, refills the tlb cache
+// throws TlbException if there is no valid entry for it
+u32 translate_tlb(N64 &n64, u32 vaddr, b32 write);
+
+void flush_tlb_cache(Cpu &cpu);
+
+// take the exception for a faulting instr, pc and pc_next are as they were before it ran
+void tlb_exception(N64 &n64, const TlbException &ex, u64 pc, u64 pc_next);
+
+}
@@ -2,6 +2,7 @@
 #include <frontend/sdl/sdl_window.h>
 #include <frontend/imgui/imgui_window.h>
 #include <frontend/destoer/destoer_window.h>
+#include <frontend/headless/headless.h>
 #include <albion/lib.h>
 
 #ifdef SDL_REQUIRED
@@ -15,31 +16,38 @@
 #endif
 
 #include "test.cpp"
+#include "bench.cpp"
 #include "spdlog/spdlog.h"
 #include <cfenv>
 
 int main(int argc, char *argv[])
 {  
     UNUSED(argc); UNUSED(argv);
-#ifndef FRONTEND_HEADLESS    
-    if(argc == 2)
+
+    if(argc >= 2 && std::string(argv[1]) == "-b")
     {
-        std::string arg(argv[1]);
-        if(arg == "-t")
-        {
-            try
-            {
-                run_tests();
-            }
+        return run_benchmarks(argc - 2,argv + 2);
+    }
 
-            catch(std::exception &ex)
-            {
-                std::cout << ex.what();
-            }
+    if(argc == 2 && std::string(argv[1]) == "-t")
+    {
+        try
+        {
+            run_tests();
+        }
 
-            return 0;
+        catch(std::exception &ex)
+        {
+            std::cout << ex.what();
         }
 
+        return 0;
+    }
+
+#ifndef FRONTEND_HEADLESS    
+    if(argc == 2)
+    {
+        std::string arg(argv[1]);
         if (arg == "-dev-gen")
         {
         }
@@ -88,6 +96,10 @@ int main(int argc, char *argv[])
     destoer_ui();
 #endif
 
+#ifdef FRONTEND_HEADLESS
+    return headless_main(argc,argv);
+#endif
+
 #ifdef SDL_REQUIRED
     SDL_Quit();
 #endif
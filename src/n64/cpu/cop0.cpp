@@ -5,14 +5,26 @@ namespace nintendo64
 // NOTE: all intr handling goes here
 
 // see page 151 psuedo code of manual
-void standard_exception(N64& n64, u32 code)
+// everything but a tlb refill goes to the general vector
+void standard_exception(N64& n64, u32 code, u32 vector = 0x180)
 {
     // TODO: i think we need to run tests for this LOL
     auto& cop0 = n64.cpu.cop0;
     auto& status = cop0.status;
     auto& cause = cop0.cause;
 
-    if(!status.exl)
+    // a tlb miss inside of a handler, epc is left alone and it goes to the general vector
+    if(status.exl && (code == TLBL || code == TLBS || code == TLB_MOD))
+    {
+        cause.exception_code = code;
+
+        const u64 base = is_set(status.ds,6)? 0xFFFF'FFFF'BFC0'0200 : 0xFFFF'FFFF'8000'0000;
+
+        write_pc(n64,base + 0x180);
+        skip_instr(n64.cpu);
+    }
+
+    else if(!status.exl)
     {
         status.exl = true;
         cause.exception_code = code;
@@ -38,17 +50,6 @@ void standard_exception(N64& n64, u32 code)
         // bev goes to uncached
         const u64 base = is_set(status.ds,6)? 0xFFFF'FFFF'BFC0'0200 : 0xFFFF'FFFF'8000'0000;
 
-        u32 vector = 0;
-
-        switch(code)
-        {
-            // how do we know what kind of tlb refill it is lol
-            case TLBL: vector = 0x0; assert(false); break;
-            case TLBS: vector = 0x080; assert(false); break;
-
-            default: vector = 0x180; break;
-        }
-
         const u64 target = base + vector; 
 
         write_pc(n64,target);
@@ -315,8 +316,16 @@ void write_cop0(N64 &n64, u64 v, u32 reg)
         case ENTRY_HI:
         {
             auto& entry_hi = cop0.entry_hi;
-            entry_hi.vpn2 = (v >> 13);
-            entry_hi.asid = v & 0xff; 
+            const u32 asid = v & 0xff;
+
+            // cached translations were for the old address space
+            if(asid != entry_hi.asid)
+            {
+                flush_tlb_cache(cpu);
+            }
+
+            entry_hi.vpn2 = (v >> 13) & 0x7'ffff;
+            entry_hi.asid = asid; 
             break;
         }
 
@@ -349,11 +358,17 @@ void write_cop0(N64 &n64, u64 v, u32 reg)
 
         case WIRED:
         {
-            cop0.wired = (v >> 5) & 0b11111;
+            cop0.wired = v & 0b111'111;
             cop0.random = 31;
             break;
         }
 
+        case CONTEXT:
+        {
+            cop0.context.pte_base = v >> 23;
+            break;
+        }
+
         case INDEX:
         {
             auto& index = cop0.index;
@@ -567,8 +582,10 @@ u64 read_cop0(N64& n64, u32 reg)
     }
 }
 
+// counts down to wired so tlbwr never replaces a wired entry
 void Cop0::updateRandom() {
-    if (--random == 0) random = 31;
+    if (random <= wired) random = 31;
+    else random--;
 }
 
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <n64/cpu/cop0.cpp>
 #include <n64/cpu/cop1.cpp>
+#include <n64/cpu/tlb.cpp>
 
 namespace nintendo64
 {
@@ -25,6 +26,18 @@ void call_handler(N64& n64, const Opcode& opcode, u32 idx)
     }    
 }
 
+void reset_instr_cache(Cpu &cpu)
+{
+    auto &cache = cpu.instr_cache;
+
+    cache.pages.clear();
+    cache.pages.resize(InstrCache::ADDR_SPACE >> InstrCache::PAGE_SHIFT);
+    cache.storage.clear();
+
+    // translations bake in page table and cache pointers
+    cpu.jit.reset();
+}
+
 void reset_cpu(N64 &n64)
 {
     auto &cpu = n64.cpu;
@@ -48,6 +61,9 @@ void reset_cpu(N64 &n64)
 
     cpu.cop1 = {};
 
+    flush_tlb_cache(cpu);
+    reset_instr_cache(cpu);
+
     cpu.pc = 0xA4000040;
     cpu.pc_next = cpu.pc + 4; 
 
@@ -67,7 +83,23 @@ void cycle_tick(N64 &n64, u32 cycles)
 template<const b32 debug>
 void step(N64 &n64)
 {
-    const u32 op = read_u32<debug>(n64,n64.cpu.pc);
+    const u64 pc = n64.cpu.pc;
+    const u64 pc_next = n64.cpu.pc_next;
+
+    u32 op = 0;
+
+    // nothing has run yet if the fetch misses the tlb
+    try
+    {
+        op = read_u32<debug>(n64,n64.cpu.pc);
+    }
+
+    catch(const TlbException &ex)
+    {
+        tlb_exception(n64,ex,pc,pc_next);
+        cycle_tick(n64,1);
+        return;
+    }
 
 #ifdef DEBUG 
     if constexpr(debug)
@@ -92,7 +124,15 @@ void step(N64 &n64)
     //const u32 offset = beyond_all_repair::get_opcode_type(opcode.op);
     const u32 offset = beyond_all_repair::calc_base_table_offset(opcode);
     
-    call_handler<debug>(n64,opcode,offset);
+    try
+    {
+        call_handler<debug>(n64,opcode,offset);
+    }
+
+    catch(const TlbException &ex)
+    {
+        tlb_exception(n64,ex,pc,pc_next);
+    }
     
     // $zero is hardwired to zero, make sure writes cant touch it
     n64.cpu.regs[R0] = 0;
@@ -102,6 +142,123 @@ void step(N64 &n64)
     cycle_tick(n64,1);
 }
 
+void invalidate_instr_cache(N64 &n64, u32 addr)
+{
+    auto &pages = n64.cpu.instr_cache.pages;
+    const u32 idx = addr >> InstrCache::PAGE_SHIFT;
+
+    if(idx < pages.size() && pages[idx])
+    {
+        pages[idx]->gen++;
+    }
+}
+
+// cache page holding a physical addr, allocated on first use
+InstrCache::Page* get_instr_page(Cpu &cpu, u32 phys)
+{
+    auto &cache = cpu.instr_cache;
+    auto &page = cache.pages[phys >> InstrCache::PAGE_SHIFT];
+
+    if(!page)
+    {
+        cache.storage.push_back(std::make_unique<InstrCache::Page>());
+        page = cache.storage.back().get();
+    }
+
+    return page;
+}
+
+// decoded instr at pc, nullptr if its outside of rdram and rom
+DecodedInstr* lookup_instr(N64 &n64, u64 pc)
+{
+    const u32 addr = pc;
+    const u8* page_ptr = n64.mem.page_table_read[addr / PAGE_SIZE];
+
+    u32 phys = 0;
+    u32 offset = 0;
+
+    // the direct mapped segments are in the page table
+    // which both just mask down to the physical addr
+    if(page_ptr)
+    {
+        phys = addr & 0x1FFF'FFFF;
+        offset = addr & (PAGE_SIZE - 1);
+    }
+
+    // mapped code has to be in the tlb cache, a miss takes the slow path which fills it
+    else if(tlb_mapped(addr))
+    {
+        const auto *entry = n64.cpu.tlb_cache.lookup(addr);
+
+        if(!entry || !entry->read)
+        {
+            return nullptr;
+        }
+
+        page_ptr = entry->read;
+        offset = addr & (TlbCache::PAGE_SIZE - 1);
+        phys = entry->phys | offset;
+    }
+
+    else
+    {
+        return nullptr;
+    }
+
+    auto *page = get_instr_page(n64.cpu,phys);
+
+    auto &instr = page->instr[(phys & (InstrCache::PAGE_SIZE - 1)) / sizeof(u32)];
+
+    if(instr.gen != page->gen)
+    {
+        const u32 op = handle_read_n64<u32>(page_ptr,offset);
+
+        instr.opcode = beyond_all_repair::make_opcode(op);
+        instr.handler = INSTR_TABLE_NO_DEBUG[beyond_all_repair::calc_base_table_offset(instr.opcode)];
+        instr.gen = page->gen;
+    }
+
+    return &instr;
+}
+
+// run an instr out of the instr cache, no debug checks
+void step_decoded(N64 &n64, const DecodedInstr &instr)
+{
+    const u64 pc = n64.cpu.pc;
+    const u64 pc_next = n64.cpu.pc_next;
+
+    skip_instr(n64.cpu);
+
+    // the handler may invalidate this page, the entry stays put until its next lookup though
+    try
+    {
+        instr.handler(n64,instr.opcode);
+    }
+
+    catch(const TlbException &ex)
+    {
+        tlb_exception(n64,ex,pc,pc_next);
+    }
+
+    // $zero is hardwired to zero, make sure writes cant touch it
+    n64.cpu.regs[R0] = 0;
+
+    cycle_tick(n64,1);
+}
+
+void step_cached(N64 &n64)
+{
+    const DecodedInstr* instr = lookup_instr(n64,n64.cpu.pc);
+
+    if(!instr)
+    {
+        step<false>(n64);
+        return;
+    }
+
+    step_decoded(n64,*instr);
+}
+
 void write_pc(N64 &n64, u64 pc)
 {
     if((pc & 0b11) != 0)
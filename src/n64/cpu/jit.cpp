@@ -0,0 +1,1214 @@
+#include <n64/n64.h>
+#include <n64/jit.h>
+#include <utility>
+
+#ifdef N64_JIT_SUPPORTED
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace nintendo64
+{
+
+// x86-64 register numbers
+enum x64_reg : u8
+{
+    RAX = 0, RCX = 1, RDX = 2, RBX = 3,
+    RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+    R8 = 8, R9 = 9, R10 = 10,
+};
+
+// condition codes for jcc and setcc
+enum x64_cond : u8
+{
+    CC_B = 0x2, CC_E = 0x4, CC_NE = 0x5, CC_L = 0xc,
+};
+
+// "op r, r/m" forms
+enum x64_alu : u8
+{
+    ALU_ADD = 0x03, ALU_OR = 0x0b, ALU_AND = 0x23, ALU_SUB = 0x2b,
+    ALU_XOR = 0x33, ALU_CMP = 0x3b, ALU_MOV = 0x8b, ALU_TEST = 0x85,
+};
+
+// the /digit for "op r/m, imm32"
+enum x64_alu_imm : u8
+{
+    IMM_ADD = 0, IMM_OR = 1, IMM_AND = 4, IMM_XOR = 6, IMM_CMP = 7,
+};
+
+// the /digit for shifts
+enum x64_shift : u8
+{
+    SHIFT_ROL = 0, SHIFT_SHL = 4, SHIFT_SHR = 5, SHIFT_SAR = 7,
+};
+
+#ifdef _WIN32
+constexpr x64_reg ARG_REG[4] = {RCX,RDX,R8,R9};
+#else
+constexpr x64_reg ARG_REG[4] = {RDI,RSI,RDX,RCX};
+#endif
+
+// just enough of an assembler for what the jit emits
+// cpu state is allways [rbx + disp32], rbx holds the N64 for the whole block
+// guest memory is [base + index * scale] off a page table entry
+struct Emitter
+{
+    Emitter(u8 *buf) : buf(buf) {}
+
+    size_t pos() const { return len; }
+
+    void emit8(u8 v)
+    {
+        buf[len++] = v;
+    }
+
+    void emit32(u32 v)
+    {
+        memcpy(&buf[len],&v,sizeof(v));
+        len += sizeof(v);
+    }
+
+    void emit64(u64 v)
+    {
+        memcpy(&buf[len],&v,sizeof(v));
+        len += sizeof(v);
+    }
+
+    void rex(bool w, u8 reg, u8 rm, u8 index = 0)
+    {
+        if(w || reg >= 8 || rm >= 8 || index >= 8)
+        {
+            emit8(0x40 | (w << 3) | ((reg >> 3) << 2) | ((index >> 3) << 1) | (rm >> 3));
+        }
+    }
+
+    void modrm_rr(u8 reg, u8 rm)
+    {
+        emit8(0xc0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    // [rbx + disp32]
+    void modrm_n64(u8 reg, s32 disp)
+    {
+        emit8(0x80 | ((reg & 7) << 3) | RBX);
+        emit32(disp);
+    }
+
+    // [base + index * scale], base cant be rbp or r13
+    void modrm_sib(u8 reg, u8 base, u8 index, u8 scale)
+    {
+        static constexpr u8 SCALE_BITS[9] = {0,0,1,0,2,0,0,0,3};
+
+        emit8(((reg & 7) << 3) | RSP);
+        emit8((SCALE_BITS[scale] << 6) | ((index & 7) << 3) | (base & 7));
+    }
+
+    void push_rbx() { emit8(0x53); }
+    void pop_rbx() { emit8(0x5b); }
+    void ret() { emit8(0xc3); }
+
+    void sub_rsp(u8 imm) { emit8(0x48); emit8(0x83); emit8(0xec); emit8(imm); }
+    void add_rsp(u8 imm) { emit8(0x48); emit8(0x83); emit8(0xc4); emit8(imm); }
+
+    void mov_r64(u8 dst, u8 src)
+    {
+        rex(true,src,dst);
+        emit8(0x89);
+        modrm_rr(src,dst);
+    }
+
+    void mov_imm32(u8 reg, u32 imm)
+    {
+        rex(false,0,reg);
+        emit8(0xb8 + (reg & 7));
+        emit32(imm);
+    }
+
+    void mov_imm64(u8 reg, u64 imm)
+    {
+        rex(true,0,reg);
+        emit8(0xb8 + (reg & 7));
+        emit64(imm);
+    }
+
+    // sign extended to 64 bits
+    void mov_simm32(u8 reg, s32 imm)
+    {
+        rex(true,0,reg);
+        emit8(0xc7);
+        modrm_rr(0,reg);
+        emit32(imm);
+    }
+
+    void call(const void *func)
+    {
+        mov_imm64(RAX,reinterpret_cast<u64>(func));
+
+        // call rax
+        emit8(0xff);
+        emit8(0xd0);
+    }
+
+    void load64(u8 reg, s32 disp)
+    {
+        rex(true,reg,RBX);
+        emit8(0x8b);
+        modrm_n64(reg,disp);
+    }
+
+    void store64(s32 disp, u8 reg)
+    {
+        rex(true,reg,RBX);
+        emit8(0x89);
+        modrm_n64(reg,disp);
+    }
+
+    void alu(x64_alu op, u8 dst, u8 src, bool w)
+    {
+        rex(w,dst,src);
+        emit8(op);
+        modrm_rr(dst,src);
+    }
+
+    void alu_imm(x64_alu_imm op, u8 reg, s32 imm, bool w)
+    {
+        rex(w,0,reg);
+        emit8(0x81);
+        modrm_rr(op,reg);
+        emit32(imm);
+    }
+
+    void not64(u8 reg)
+    {
+        rex(true,0,reg);
+        emit8(0xf7);
+        modrm_rr(2,reg);
+    }
+
+    // movsxd dst, src32
+    void sign_extend32(u8 dst, u8 src)
+    {
+        rex(true,dst,src);
+        emit8(0x63);
+        modrm_rr(dst,src);
+    }
+
+    void shift_imm(x64_shift op, u8 reg, u8 imm, bool w)
+    {
+        rex(w,0,reg);
+        emit8(0xc1);
+        modrm_rr(op,reg);
+        emit8(imm);
+    }
+
+    // by cl
+    void shift_cl(x64_shift op, u8 reg, bool w)
+    {
+        rex(w,0,reg);
+        emit8(0xd3);
+        modrm_rr(op,reg);
+    }
+
+    // reg = 1 if the cond is met else 0, only for regs with a low byte without rex
+    void setcc(x64_cond cc, u8 reg)
+    {
+        emit8(0x0f);
+        emit8(0x90 | cc);
+        modrm_rr(0,reg);
+
+        // movzx reg, reg8
+        emit8(0x0f);
+        emit8(0xb6);
+        modrm_rr(reg,reg);
+    }
+
+    // zero or sign extended out to 64 bits
+    void load_mem(u32 size, bool sign, u8 reg, u8 base, u8 index, u8 scale)
+    {
+        switch(size)
+        {
+            case 1:
+            {
+                rex(sign,reg,base,index);
+                emit8(0x0f);
+                emit8(sign? 0xbe : 0xb6);
+                break;
+            }
+
+            case 2:
+            {
+                rex(sign,reg,base,index);
+                emit8(0x0f);
+                emit8(sign? 0xbf : 0xb7);
+                break;
+            }
+
+            // a 32 bit mov clears the top half
+            case 4:
+            {
+                rex(sign,reg,base,index);
+                emit8(sign? 0x63 : 0x8b);
+                break;
+            }
+
+            default:
+            {
+                rex(true,reg,base,index);
+                emit8(0x8b);
+                break;
+            }
+        }
+
+        modrm_sib(reg,base,index,scale);
+    }
+
+    // reg must have a low byte without rex for byte stores
+    void store_mem(u32 size, u8 base, u8 index, u8 reg)
+    {
+        if(size == 2)
+        {
+            emit8(0x66);
+        }
+
+        rex(size == 8,reg,base,index);
+        emit8(size == 1? 0x88 : 0x89);
+        modrm_sib(reg,base,index,1);
+    }
+
+    // returns the offset of the rel32 to patch
+    size_t jcc(x64_cond cc)
+    {
+        emit8(0x0f);
+        emit8(0x80 | cc);
+        emit32(0);
+
+        return len - sizeof(u32);
+    }
+
+    size_t jmp()
+    {
+        emit8(0xe9);
+        emit32(0);
+
+        return len - sizeof(u32);
+    }
+
+    void patch(size_t rel, size_t target)
+    {
+        const s32 v = s32(target) - s32(rel + sizeof(u32));
+        memcpy(&buf[rel],&v,sizeof(v));
+    }
+
+    u8 *buf = nullptr;
+    size_t len = 0;
+};
+
+// where the state the emitted code touches lives inside the N64
+struct CpuLayout
+{
+    CpuLayout(const N64 &n64)
+    {
+        const auto offset = [&](const void *field)
+        {
+            return s32(static_cast<const u8*>(field) - reinterpret_cast<const u8*>(&n64));
+        };
+
+        for(u32 i = 0; i < 32; i++)
+        {
+            regs[i] = offset(&n64.cpu.regs[i]);
+        }
+
+        hi = offset(&n64.cpu.hi);
+        lo = offset(&n64.cpu.lo);
+    }
+
+    s32 regs[32];
+    s32 hi;
+    s32 lo;
+};
+
+
+// what a call out of a block has to know about where it is
+// packed into a single arg
+struct CallInfo
+{
+    // emitted instrs since the last sync whose cycles are not charged yet
+    u32 pending = 0;
+
+    // instrs left in the block after this one
+    u32 remaining = 0;
+
+    // the last instr of a block ending on a branch
+    b32 delay_slot = false;
+
+    b32 branch = false;
+
+    u32 pack() const
+    {
+        return pending | (remaining << 8) | (delay_slot << 16) | (branch << 17);
+    }
+};
+
+// same as that many calls to cycle_tick
+static void jit_tick(N64 &n64, u32 cycles)
+{
+    n64.scheduler.delay_tick(cycles);
+
+    for(u32 i = 0; i < cycles; i++)
+    {
+        n64.cpu.cop0.updateRandom();
+    }
+}
+
+// helpers the emitted code calls
+// a non zero return means the block has to exit
+
+// run an instr through its handler exactly like step_cached
+static u32 jit_call(N64 *n64, const DecodedInstr *instr, u64 pc, u32 info)
+{
+    auto &cpu = n64->cpu;
+    auto &scheduler = n64->scheduler;
+
+    const u32 pending = info & 0xff;
+    const u32 remaining = (info >> 8) & 0xff;
+    const b32 delay_slot = is_set(info,16);
+    const b32 branch = is_set(info,17);
+
+    // catch the timestamp up before anything can read it
+    jit_tick(*n64,pending);
+
+    // nothing emitted touches the pc, except in a delay slot where the branch has set it up
+    if(!delay_slot)
+    {
+        cpu.pc = pc;
+        cpu.pc_next = pc + MIPS_INSTR_SIZE;
+    }
+
+    const u64 pc_next = cpu.pc_next;
+
+    skip_instr(cpu);
+
+    // emitted code has no unwind info, rethrown once the block returns
+    try
+    {
+        instr->handler(*n64,instr->opcode);
+    }
+
+    // the exception moves the pc, so this exits below
+    catch(const TlbException &ex)
+    {
+        tlb_exception(*n64,ex,pc,pc_next);
+    }
+
+    catch(...)
+    {
+        cpu.jit.error = std::current_exception();
+        return true;
+    }
+
+    // $zero is hardwired to zero, make sure writes cant touch it
+    cpu.regs[R0] = 0;
+
+    cycle_tick(*n64,1);
+
+    // exception, or a branch likely skipping its delay slot
+    if(cpu.pc != pc + MIPS_INSTR_SIZE)
+    {
+        return true;
+    }
+
+    // a jump we didnt know about
+    if(!branch && cpu.pc_next != pc + (2 * MIPS_INSTR_SIZE))
+    {
+        return true;
+    }
+
+    // code in this block was written
+    if(*cpu.jit.page_gen != cpu.jit.entry_gen)
+    {
+        return true;
+    }
+
+    // the interpreter would stop for an event before the end of the block
+    return scheduler.event_ready() || scheduler.get_next_event_cycles() < remaining;
+}
+
+// leave with the pc where the interpreter would have it
+static void jit_sync(N64 *n64, u64 next_pc, u32 info)
+{
+    auto &cpu = n64->cpu;
+
+    jit_tick(*n64,info & 0xff);
+
+    // delay slot, the branch already set up where we are going
+    if(is_set(info,16))
+    {
+        skip_instr(cpu);
+    }
+
+    else
+    {
+        cpu.pc = next_pc;
+        cpu.pc_next = next_pc + MIPS_INSTR_SIZE;
+    }
+}
+
+// store into a page the instr cache has decoded
+static u32 jit_code_write(N64 *n64, u32 phys)
+{
+    invalidate_instr_cache(*n64,phys);
+
+    return *n64->cpu.jit.page_gen != n64->cpu.jit.entry_gen;
+}
+
+
+// anything that can transfer control and so has a delay slot
+// this only decides where blocks end, jit_call still catches anything missed
+static bool is_branch(u32 op)
+{
+    const u32 primary = op >> 26;
+    const u32 rs = (op >> 21) & 0x1f;
+    const u32 rt = (op >> 16) & 0x1f;
+
+    switch(primary)
+    {
+        // jr, jalr
+        case 0x00: return (op & 0x3f) == 0x08 || (op & 0x3f) == 0x09;
+
+        // regimm branches, not the traps
+        case 0x01: return (rt & 0b01100) == 0;
+
+        // bc0, bc1, bc2
+        case 0x10: case 0x11: case 0x12: return rs == 0x08;
+
+        case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+        case 0x14: case 0x15: case 0x16: case 0x17: return true;
+
+        default: return false;
+    }
+}
+
+// result in rax to rd (or rt), sign extended from 32 bits
+static void store_result32(Emitter &e, const CpuLayout &layout, u32 reg)
+{
+    e.sign_extend32(RAX,RAX);
+    e.store64(layout.regs[reg],RAX);
+}
+
+// alu ops that cant raise an exception, the handler pointer is what picks the op
+// so this can never disagree with the interpreter on decoding
+static bool emit_native_alu(Emitter &e, const CpuLayout &layout, const DecodedInstr &instr)
+{
+    const auto &opcode = instr.opcode;
+    const auto handler = instr.handler;
+
+    const u32 rs = opcode.rs;
+    const u32 rt = opcode.rt;
+    const u32 rd = opcode.rd;
+    const u8 shamt = get_shamt(opcode.op);
+    const s32 simm = s16(opcode.imm);
+    const s32 uimm = u16(opcode.imm);
+
+    // shift by an immediate
+    struct ShiftImm
+    {
+        INSTR_FUNC handler;
+        x64_shift op;
+        u8 extra;
+        bool w;
+    };
+
+    static const ShiftImm SHIFT_IMM[] =
+    {
+        // 32 bit shifts, sra shifts all 64 bits before it truncates
+        {&instr_sll,SHIFT_SHL,0,false},
+        {&instr_srl,SHIFT_SHR,0,false},
+        {&instr_sra,SHIFT_SAR,0,true},
+
+        {&instr_dsll,SHIFT_SHL,0,true},
+        {&instr_dsrl,SHIFT_SHR,0,true},
+        {&instr_dsra,SHIFT_SAR,0,true},
+        {&instr_dsll32,SHIFT_SHL,32,true},
+        {&instr_dsrl32,SHIFT_SHR,32,true},
+        {&instr_dsra32,SHIFT_SAR,32,true},
+    };
+
+    for(const auto &shift : SHIFT_IMM)
+    {
+        if(handler != shift.handler)
+        {
+            continue;
+        }
+
+        if(rd == R0)
+        {
+            return true;
+        }
+
+        e.load64(RAX,layout.regs[rt]);
+        e.shift_imm(shift.op,RAX,shamt + shift.extra,shift.w);
+
+        const bool word = shift.handler == &instr_sll || shift.handler == &instr_srl || shift.handler == &instr_sra;
+
+        if(word)
+        {
+            store_result32(e,layout,rd);
+        }
+
+        else
+        {
+            e.store64(layout.regs[rd],RAX);
+        }
+
+        return true;
+    }
+
+    // "op rd, rs, rt"
+    struct AluReg
+    {
+        INSTR_FUNC handler;
+        x64_alu op;
+        bool word;
+    };
+
+    static const AluReg ALU_REG[] =
+    {
+        {&instr_addu,ALU_ADD,true},
+        {&instr_subu,ALU_SUB,true},
+        {&instr_daddu,ALU_ADD,false},
+        {&instr_and,ALU_AND,false},
+        {&instr_or,ALU_OR,false},
+        {&instr_xor,ALU_XOR,false},
+    };
+
+    for(const auto &alu : ALU_REG)
+    {
+        if(handler != alu.handler)
+        {
+            continue;
+        }
+
+        if(rd == R0)
+        {
+            return true;
+        }
+
+        e.load64(RAX,layout.regs[rs]);
+        e.load64(RCX,layout.regs[rt]);
+        e.alu(alu.op,RAX,RCX,true);
+
+        if(alu.word)
+        {
+            store_result32(e,layout,rd);
+        }
+
+        else
+        {
+            e.store64(layout.regs[rd],RAX);
+        }
+
+        return true;
+    }
+
+    // "op rt, rs, imm"
+    struct AluImm
+    {
+        INSTR_FUNC handler;
+        x64_alu_imm op;
+        bool sign;
+        bool word;
+    };
+
+    static const AluImm ALU_IMM[] =
+    {
+        {&instr_addiu,IMM_ADD,true,true},
+        {&instr_daddiu,IMM_ADD,true,false},
+
+        // not sign extended
+        {&instr_andi,IMM_AND,false,false},
+        {&instr_ori,IMM_OR,false,false},
+        {&instr_xori,IMM_XOR,false,false},
+    };
+
+    for(const auto &alu : ALU_IMM)
+    {
+        if(handler != alu.handler)
+        {
+            continue;
+        }
+
+        if(rt == R0)
+        {
+            return true;
+        }
+
+        e.load64(RAX,layout.regs[rs]);
+        e.alu_imm(alu.op,RAX,alu.sign? simm : uimm,true);
+
+        if(alu.word)
+        {
+            store_result32(e,layout,rt);
+        }
+
+        else
+        {
+            e.store64(layout.regs[rt],RAX);
+        }
+
+        return true;
+    }
+
+    if(handler == &instr_nor)
+    {
+        if(rd != R0)
+        {
+            e.load64(RAX,layout.regs[rs]);
+            e.load64(RCX,layout.regs[rt]);
+            e.alu(ALU_OR,RAX,RCX,true);
+            e.not64(RAX);
+            e.store64(layout.regs[rd],RAX);
+        }
+
+        return true;
+    }
+
+    if(handler == &instr_slt || handler == &instr_sltu)
+    {
+        if(rd != R0)
+        {
+            e.load64(RAX,layout.regs[rs]);
+            e.load64(RCX,layout.regs[rt]);
+            e.alu(ALU_CMP,RAX,RCX,true);
+            e.setcc(handler == &instr_slt? CC_L : CC_B,RAX);
+            e.store64(layout.regs[rd],RAX);
+        }
+
+        return true;
+    }
+
+    // imm is sign extended for both, sltiu then compares unsigned
+    if(handler == &instr_slti || handler == &instr_sltiu)
+    {
+        if(rt != R0)
+        {
+            e.load64(RAX,layout.regs[rs]);
+            e.alu_imm(IMM_CMP,RAX,simm,true);
+            e.setcc(handler == &instr_slti? CC_L : CC_B,RAX);
+            e.store64(layout.regs[rt],RAX);
+        }
+
+        return true;
+    }
+
+    if(handler == &instr_lui)
+    {
+        if(rt != R0)
+        {
+            e.mov_simm32(RAX,s32(u32(uimm) << 16));
+            e.store64(layout.regs[rt],RAX);
+        }
+
+        return true;
+    }
+
+    // shift amount in cl, the 32 bit ones mask it to 5 bits on their own
+    if(handler == &instr_sllv || handler == &instr_srlv || handler == &instr_srav || handler == &instr_dsllv)
+    {
+        if(rd != R0)
+        {
+            e.load64(RCX,layout.regs[rs]);
+            e.load64(RAX,layout.regs[rt]);
+
+            if(handler == &instr_sllv)
+            {
+                e.shift_cl(SHIFT_SHL,RAX,false);
+                store_result32(e,layout,rd);
+            }
+
+            else if(handler == &instr_srlv)
+            {
+                e.shift_cl(SHIFT_SHR,RAX,false);
+                store_result32(e,layout,rd);
+            }
+
+            // shifts all 64 bits then truncates, so mask the amount by hand
+            else if(handler == &instr_srav)
+            {
+                e.alu_imm(IMM_AND,RCX,0x1f,false);
+                e.shift_cl(SHIFT_SAR,RAX,true);
+                store_result32(e,layout,rd);
+            }
+
+            else
+            {
+                e.shift_cl(SHIFT_SHL,RAX,true);
+                e.store64(layout.regs[rd],RAX);
+            }
+        }
+
+        return true;
+    }
+
+    // hi and lo moves
+    const auto move = [&](s32 dst, s32 src)
+    {
+        e.load64(RAX,src);
+        e.store64(dst,RAX);
+        return true;
+    };
+
+    if(handler == &instr_mfhi) { return rd == R0 || move(layout.regs[rd],layout.hi); }
+    if(handler == &instr_mflo) { return rd == R0 || move(layout.regs[rd],layout.lo); }
+    if(handler == &instr_mthi) { return move(layout.hi,layout.regs[rs]); }
+    if(handler == &instr_mtlo) { return move(layout.lo,layout.regs[rs]); }
+
+    return false;
+}
+
+struct MemAccess
+{
+    INSTR_FUNC handler;
+    u32 size;
+    bool sign;
+    bool store;
+};
+
+static const MemAccess MEM_ACCESS[] =
+{
+    {&instr_lb<false>,1,true,false},
+    {&instr_lbu<false>,1,false,false},
+    {&instr_lh<false>,2,true,false},
+    {&instr_lhu<false>,2,false,false},
+    {&instr_lw<false>,4,true,false},
+    {&instr_lwu<false>,4,false,false},
+    {&instr_ld<false>,8,false,false},
+
+    {&instr_sb<false>,1,false,true},
+    {&instr_sh<false>,2,false,true},
+    {&instr_sw<false>,4,false,true},
+    {&instr_sd<false>,8,false,true},
+};
+
+static const MemAccess* get_mem_access(const DecodedInstr &instr)
+{
+    for(const auto &access : MEM_ACCESS)
+    {
+        if(instr.handler == access.handler)
+        {
+            return &access;
+        }
+    }
+
+    return nullptr;
+}
+
+// call the handler for an instr, optionally exiting the block on a non zero return
+static void emit_call(Emitter &e, const DecodedInstr *instr, u64 pc, const CallInfo &info)
+{
+    e.mov_r64(ARG_REG[0],RBX);
+    e.mov_imm64(ARG_REG[1],reinterpret_cast<u64>(instr));
+    e.mov_imm64(ARG_REG[2],pc);
+    e.mov_imm32(ARG_REG[3],info.pack());
+    e.call(reinterpret_cast<const void*>(&jit_call));
+}
+
+// loads and stores go straight through the page table like read_mem_internal and write_mem_internal,
+// anything else takes the handler and leaves the block, so it only ever sees ram and rom
+static void emit_mem(Emitter &e, N64 &n64, const CpuLayout &layout, const DecodedInstr &instr, const MemAccess &access,
+    u64 pc, const CallInfo &info, std::vector<size_t> &exits)
+{
+    const auto &opcode = instr.opcode;
+    const u32 size = access.size;
+
+    // value to store
+    if(access.store)
+    {
+        e.load64(RCX,layout.regs[opcode.rt]);
+    }
+
+    // force aligned addr in eax, page table entry in rdx
+    e.load64(RAX,layout.regs[opcode.rs]);
+    e.alu_imm(IMM_ADD,RAX,s16(opcode.imm),false);
+
+    if(size != 1)
+    {
+        e.alu_imm(IMM_AND,RAX,~s32(size - 1),false);
+    }
+
+    const auto &table = access.store? n64.mem.page_table_write : n64.mem.page_table_read;
+
+    e.alu(ALU_MOV,RDX,RAX,false);
+    e.shift_imm(SHIFT_SHR,RDX,20,false);
+    e.mov_imm64(R9,reinterpret_cast<u64>(table.data()));
+    e.load_mem(8,false,RDX,R9,RDX,8);
+    e.alu(ALU_TEST,RDX,RDX,true);
+    const size_t slow = e.jcc(CC_E);
+
+    // keep the addr for the instr cache check
+    e.alu(ALU_MOV,R8,RAX,false);
+
+    e.alu_imm(IMM_AND,RAX,PAGE_SIZE - 1,false);
+
+    // the whole of memory is byte swapped by word
+    if(size == 2)
+    {
+        e.alu_imm(IMM_XOR,RAX,2,false);
+    }
+
+    else if(size == 1)
+    {
+        e.alu_imm(IMM_XOR,RAX,3,false);
+    }
+
+    if(access.store)
+    {
+        if(size == 8)
+        {
+            e.shift_imm(SHIFT_ROL,RCX,32,true);
+        }
+
+        e.store_mem(size,RDX,RAX,RCX);
+    }
+
+    else
+    {
+        e.load_mem(size,access.sign,RAX,RDX,RAX,1);
+
+        if(size == 8)
+        {
+            e.shift_imm(SHIFT_ROL,RAX,32,true);
+        }
+
+        if(opcode.rt != R0)
+        {
+            e.store64(layout.regs[opcode.rt],RAX);
+        }
+    }
+
+    size_t done = 0;
+    size_t code_done = 0;
+
+    // stores to a page with decoded code in it have to invalidate it
+    if(access.store)
+    {
+        e.alu_imm(IMM_AND,R8,0x1FFF'FFFF,false);
+        e.alu(ALU_MOV,R9,R8,false);
+        e.shift_imm(SHIFT_SHR,R9,InstrCache::PAGE_SHIFT,false);
+        e.mov_imm64(R10,reinterpret_cast<u64>(n64.cpu.instr_cache.pages.data()));
+        e.load_mem(8,false,R9,R10,R9,8);
+        e.alu(ALU_TEST,R9,R9,true);
+        done = e.jcc(CC_E);
+
+        e.mov_r64(ARG_REG[1],R8);
+        e.mov_r64(ARG_REG[0],RBX);
+        e.call(reinterpret_cast<const void*>(&jit_code_write));
+        e.alu(ALU_TEST,RAX,RAX,false);
+        code_done = e.jcc(CC_E);
+
+        // this block got written, charge up to and including the store and leave
+        CallInfo sync = info;
+        sync.pending++;
+
+        e.mov_r64(ARG_REG[0],RBX);
+        e.mov_imm64(ARG_REG[1],pc + MIPS_INSTR_SIZE);
+        e.mov_imm32(ARG_REG[2],sync.pack());
+        e.call(reinterpret_cast<const void*>(&jit_sync));
+        exits.push_back(e.jmp());
+    }
+
+    else
+    {
+        done = e.jmp();
+    }
+
+    // the handler does the whole access, the two paths have charged a different number of cycles
+    // so there is no joining back up
+    e.patch(slow,e.pos());
+    emit_call(e,&instr,pc,info);
+    exits.push_back(e.jmp());
+
+    e.patch(done,e.pos());
+
+    if(code_done)
+    {
+        e.patch(code_done,e.pos());
+    }
+}
+
+u8* Jit::compile(N64 &n64, u64 pc, u32 &len, b32 &full)
+{
+    len = 0;
+    full = false;
+
+    if(!arena)
+    {
+    #ifdef _WIN32
+        arena = static_cast<u8*>(VirtualAlloc(nullptr,ARENA_SIZE,MEM_COMMIT | MEM_RESERVE,PAGE_EXECUTE_READWRITE));
+    #else
+        void *ptr = mmap(nullptr,ARENA_SIZE,PROT_READ | PROT_WRITE | PROT_EXEC,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+        arena = ptr == MAP_FAILED? nullptr : static_cast<u8*>(ptr);
+    #endif
+
+        if(!arena)
+        {
+            throw std::runtime_error("[jit] could not allocate code arena");
+        }
+    }
+
+    if(ARENA_SIZE - arena_used < BLOCK_SIZE_MAX)
+    {
+        full = true;
+        return nullptr;
+    }
+
+    // a block cant leave the cache page it starts in, its gen is all that guards it
+    const u32 page_left = (InstrCache::PAGE_SIZE - (u32(pc) & (InstrCache::PAGE_SIZE - 1))) / MIPS_INSTR_SIZE;
+    const u32 max_len = std::min(BLOCK_INSTR_MAX,page_left);
+
+    const DecodedInstr *instr[BLOCK_INSTR_MAX];
+    b32 delay_slot = false;
+
+    for(u32 i = 0; i < max_len; i++)
+    {
+        instr[i] = lookup_instr(n64,pc + (i * MIPS_INSTR_SIZE));
+
+        if(is_branch(instr[i]->opcode.op))
+        {
+            // the delay slot has to come along, and cant be a branch itself
+            if(i + 1 < max_len)
+            {
+                instr[i + 1] = lookup_instr(n64,pc + ((i + 1) * MIPS_INSTR_SIZE));
+
+                if(!is_branch(instr[i + 1]->opcode.op))
+                {
+                    len = i + 2;
+                    delay_slot = true;
+                }
+            }
+
+            break;
+        }
+
+        len = i + 1;
+    }
+
+    if(!len)
+    {
+        return nullptr;
+    }
+
+    u8 *code = arena + arena_used;
+
+    Emitter e(code);
+    const CpuLayout layout(n64);
+
+    // rbx is callee saved, keep the stack aligned with room for win64 shadow space
+    e.push_rbx();
+    e.sub_rsp(32);
+    e.mov_r64(RBX,ARG_REG[0]);
+
+    std::vector<size_t> exits;
+
+    CallInfo info;
+
+    for(u32 i = 0; i < len; i++)
+    {
+        const u64 addr = pc + (i * MIPS_INSTR_SIZE);
+
+        info.remaining = len - i - 1;
+        info.delay_slot = delay_slot && i == len - 1;
+        info.branch = is_branch(instr[i]->opcode.op);
+
+        if(emit_native_alu(e,layout,*instr[i]))
+        {
+            info.pending++;
+            continue;
+        }
+
+        const auto access = get_mem_access(*instr[i]);
+
+        if(access)
+        {
+            emit_mem(e,n64,layout,*instr[i],*access,addr,info,exits);
+            info.pending++;
+            continue;
+        }
+
+        emit_call(e,instr[i],addr,info);
+        e.alu(ALU_TEST,RAX,RAX,false);
+        exits.push_back(e.jcc(CC_NE));
+
+        info.pending = 0;
+    }
+
+    // ran off the end after emitted code, put the pc where the interpreter would
+    if(info.pending)
+    {
+        e.mov_r64(ARG_REG[0],RBX);
+        e.mov_imm64(ARG_REG[1],pc + (len * MIPS_INSTR_SIZE));
+        e.mov_imm32(ARG_REG[2],info.pack());
+        e.call(reinterpret_cast<const void*>(&jit_sync));
+    }
+
+    for(const size_t exit : exits)
+    {
+        e.patch(exit,e.pos());
+    }
+
+    e.add_rsp(32);
+    e.pop_rbx();
+    e.ret();
+
+    assert(e.pos() <= BLOCK_SIZE_MAX);
+
+    arena_used += e.pos();
+
+    return code;
+}
+
+void Jit::reset()
+{
+    arena_used = 0;
+}
+
+Jit::Jit()
+{
+
+}
+
+Jit::~Jit()
+{
+    if(!arena)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    VirtualFree(arena,0,MEM_RELEASE);
+#else
+    munmap(arena,ARENA_SIZE);
+#endif
+}
+
+
+void step_jit(N64 &n64)
+{
+    auto &cpu = n64.cpu;
+    auto &jit = cpu.jit;
+
+    DecodedInstr *entry = lookup_instr(n64,cpu.pc);
+
+    // a block never starts on a delay slot, its branch is allways in the block before
+    if(!entry || in_delay_slot(cpu))
+    {
+        step_cached(n64);
+        return;
+    }
+
+    // blocks are only built in the direct mapped segments, tlb mapped code stays in the instr cache
+    if(!n64.mem.page_table_read[u32(cpu.pc) / PAGE_SIZE])
+    {
+        step_decoded(n64,*entry);
+        return;
+    }
+
+    auto *page = cpu.instr_cache.pages[(u32(cpu.pc) & 0x1FFF'FFFF) >> InstrCache::PAGE_SHIFT];
+
+    if(entry->jit_gen != page->gen)
+    {
+        if(++entry->hits < jit.hot_threshold)
+        {
+            step_decoded(n64,*entry);
+            return;
+        }
+
+        entry->hits = 0;
+
+        b32 full = false;
+        u32 len = 0;
+        u8 *code = jit.compile(n64,cpu.pc,len,full);
+
+        // arena is full, start again from nothing
+        if(full)
+        {
+            jit.reset();
+
+            for(auto &cache_page : cpu.instr_cache.storage)
+            {
+                cache_page->gen++;
+            }
+
+            step_cached(n64);
+            return;
+        }
+
+        entry->jit = code;
+        entry->jit_len = len;
+        entry->jit_gen = page->gen;
+    }
+
+    // the interpreter would stop for an event part way through
+    if(!entry->jit || n64.scheduler.get_next_event_cycles() < entry->jit_len)
+    {
+        step_decoded(n64,*entry);
+        return;
+    }
+
+    jit.page_gen = &page->gen;
+    jit.entry_gen = page->gen;
+
+    const auto func = reinterpret_cast<Jit::JIT_FUNC>(entry->jit);
+    func(&n64);
+
+    if(jit.error)
+    {
+        std::rethrow_exception(std::exchange(jit.error,nullptr));
+    }
+}
+
+}
+
+#else
+
+namespace nintendo64
+{
+
+// no backend for this host, everything runs through the instr cache
+
+u8* Jit::compile(N64 &n64, u64 pc, u32 &len, b32 &full)
+{
+    UNUSED(n64); UNUSED(pc);
+
+    len = 0;
+    full = false;
+
+    return nullptr;
+}
+
+void Jit::reset()
+{
+
+}
+
+Jit::Jit()
+{
+
+}
+
+Jit::~Jit()
+{
+
+}
+
+void step_jit(N64 &n64)
+{
+    step_cached(n64);
+}
+
+}
+
+#endif
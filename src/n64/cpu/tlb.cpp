@@ -0,0 +1,115 @@
+namespace nintendo64
+{
+
+void flush_tlb_cache(Cpu &cpu)
+{
+    for(auto &entry : cpu.tlb_cache.entry)
+    {
+        entry = {};
+    }
+}
+
+static void refill_tlb_cache(N64 &n64, u32 vaddr, u32 phys, b32 dirty)
+{
+    auto &mem = n64.mem;
+
+    const u32 vpage = vaddr >> TlbCache::PAGE_SHIFT;
+    auto &entry = n64.cpu.tlb_cache.entry[vpage & (TlbCache::SIZE - 1)];
+
+    entry.vpage = vpage;
+    entry.phys = phys & ~(TlbCache::PAGE_SIZE - 1);
+    entry.read = nullptr;
+    entry.write = nullptr;
+
+    // rdram and rom are in the page table through kseg0
+    if(entry.phys < 0x2000'0000)
+    {
+        const u32 idx = (entry.phys + 0x8000'0000) / PAGE_SIZE;
+        const u32 offset = entry.phys & (PAGE_SIZE - 1);
+
+        if(mem.page_table_read[idx])
+        {
+            entry.read = mem.page_table_read[idx] + offset;
+        }
+
+        if(dirty && mem.page_table_write[idx])
+        {
+            entry.write = mem.page_table_write[idx] + offset;
+        }
+    }
+}
+
+u32 translate_tlb(N64 &n64, u32 vaddr, b32 write)
+{
+    auto &cop0 = n64.cpu.cop0;
+
+    const u32 invalid_code = write? TLBS : TLBL;
+
+    for(const auto &entry : cop0.tlb)
+    {
+        // everything under the mask is an offset into the pair of pages
+        const u32 mask = (entry.page_mask << 13) | 0x1fff;
+
+        if((vaddr & ~mask) != ((entry.vpn2 << 13) & ~mask))
+        {
+            continue;
+        }
+
+        if(!entry.g && entry.asid != cop0.entry_hi.asid)
+        {
+            continue;
+        }
+
+        // top bit of the offset picks the odd page
+        const u32 page_mask = mask >> 1;
+        const auto &lo = entry.lo[(vaddr & (page_mask + 1)) != 0];
+
+        if(!lo.v)
+        {
+            throw TlbException{invalid_code,vaddr,false};
+        }
+
+        if(write && !lo.d)
+        {
+            throw TlbException{TLB_MOD,vaddr,false};
+        }
+
+        const u32 phys = ((lo.pfn << 12) & ~page_mask) | (vaddr & page_mask);
+
+        refill_tlb_cache(n64,vaddr,phys,lo.d);
+
+        return phys;
+    }
+
+    throw TlbException{invalid_code,vaddr,true};
+}
+
+void tlb_exception(N64 &n64, const TlbException &ex, u64 pc, u64 pc_next)
+{
+    auto &cpu = n64.cpu;
+    auto &cop0 = cpu.cop0;
+    const auto &status = cop0.status;
+
+    // back the instr out, the exception is taken from its start
+    cpu.pc = pc;
+    cpu.pc_next = pc_next;
+
+    cop0.bad_vaddr = sign_extend_type<s64,s32>(ex.vaddr);
+    cop0.context.bad_vpn2 = ex.vaddr >> 13;
+    cop0.xconfig.bad_vpn = ex.vaddr >> 13;
+    cop0.entry_hi.vpn2 = ex.vaddr >> 13;
+
+    u32 vector = 0x180;
+
+    if(ex.refill)
+    {
+        // 64 bit addressing in the current mode has its own refill handler
+        const b32 extended = status.ksu == USER_MODE? status.ux : (status.ksu == SUPERVISOR_MODE? status.sx : status.kx);
+
+        vector = extended? 0x080 : 0x000;
+    }
+
+    standard_exception(n64,ex.code,vector);
+}
+
+}
@@ -64,7 +64,17 @@ void N64Debug::step(const std::vector<Token> &args)
 
 std::string N64Debug::disass_instr(u64 addr)
 {
-    const u32 opcode = read_u32<false>(n64,addr);
+    u32 opcode = 0;
+
+    try
+    {
+        opcode = read_u32<false>(n64,addr);
+    }
+
+    catch(const TlbException&)
+    {
+        return fmt::format("{:x}: unmapped",addr);
+    }
 
     const Opcode op = beyond_all_repair::make_opcode(opcode);  
 
@@ -85,14 +95,31 @@ u64 N64Debug::get_instr_size(u64 addr)
 }
 
 
+// nothing in the tlb for it, just show it as empty
 u8 N64Debug::read_mem(u64 addr)
 {
-    return read_u8<false>(n64,addr);
+    try
+    {
+        return read_u8<false>(n64,addr);
+    }
+
+    catch(const TlbException&)
+    {
+        return 0;
+    }
 }
 
 void N64Debug::write_mem(u64 addr, u8 v)
 {
-    write_u8<false>(n64,addr,v);
+    try
+    {
+        write_u8<false>(n64,addr,v);
+    }
+
+    catch(const TlbException&)
+    {
+        print_console("{:x} is not mapped\n",addr);
+    }
 }
 
 void N64Debug::change_breakpoint_enable(bool enable)
@@ -10,9 +10,22 @@ void instr_unknown_cop0(N64 &n64, const Opcode &opcode)
     throw std::runtime_error(err);    
 }
 
+void instr_tlbr(N64& n64, const Opcode &opcode);
+void instr_tlbwr(N64& n64, const Opcode &opcode);
+
 template<const b32 debug>
 void instr_COP0(N64 &n64, const Opcode &opcode)
 {
+    // tlbr and tlbwr are missing from the generated table
+    if(is_set(opcode.op,25))
+    {
+        switch(opcode.op & 0b111'111)
+        {
+            case 0b000'001: instr_tlbr(n64,opcode); return;
+            case 0b000'110: instr_tlbwr(n64,opcode); return;
+        }
+    }
+
     const u32 offset = calc_cop0_table_offset(opcode);
 
     call_handler<debug>(n64,opcode,offset);
@@ -41,15 +54,80 @@ void instr_scd(N64 &n64, const Opcode &opcode)
 }
 
 // tlb instrs
-// TODO: i think we can saftely ignore these until we actually try to access a tlb section?
+void write_tlb(N64& n64, u32 idx)
+{
+    auto& cop0 = n64.cpu.cop0;
+    auto& entry = cop0.tlb[idx & (TLB_SIZE - 1)];
+
+    entry.page_mask = cop0.page_mask;
+    entry.vpn2 = cop0.entry_hi.vpn2 & ~cop0.page_mask;
+    entry.asid = cop0.entry_hi.asid;
+    entry.g = cop0.entry_lo_zero.g && cop0.entry_lo_one.g;
+    entry.lo[0] = cop0.entry_lo_zero;
+    entry.lo[1] = cop0.entry_lo_one;
+
+    flush_tlb_cache(n64.cpu);
+}
+
 void instr_tlbwi(N64& n64, const Opcode &opcode)
 {
-    UNUSED(n64); UNUSED(opcode);
+    UNUSED(opcode);
+
+    write_tlb(n64,n64.cpu.cop0.index.idx);
+}
+
+void instr_tlbwr(N64& n64, const Opcode &opcode)
+{
+    UNUSED(opcode);
+
+    write_tlb(n64,n64.cpu.cop0.random);
+}
+
+void instr_tlbr(N64& n64, const Opcode &opcode)
+{
+    UNUSED(opcode);
+
+    auto& cop0 = n64.cpu.cop0;
+    const auto& entry = cop0.tlb[cop0.index.idx & (TLB_SIZE - 1)];
+
+    // cached translations were for the old address space
+    if(entry.asid != cop0.entry_hi.asid)
+    {
+        flush_tlb_cache(n64.cpu);
+    }
+
+    cop0.page_mask = entry.page_mask;
+    cop0.entry_hi.vpn2 = entry.vpn2;
+    cop0.entry_hi.asid = entry.asid;
+
+    cop0.entry_lo_zero = entry.lo[0];
+    cop0.entry_lo_one = entry.lo[1];
+    cop0.entry_lo_zero.g = entry.g;
+    cop0.entry_lo_one.g = entry.g;
 }
 
 void instr_tlbp(N64& n64, const Opcode &opcode)
 {
-    UNUSED(n64); UNUSED(opcode);
+    UNUSED(opcode);
+
+    auto& cop0 = n64.cpu.cop0;
+    auto& index = cop0.index;
+
+    index.p = true;
+
+    for(u32 i = 0; i < TLB_SIZE; i++)
+    {
+        const auto& entry = cop0.tlb[i];
+
+        const u32 vpn2 = cop0.entry_hi.vpn2 & ~entry.page_mask;
+
+        if(entry.vpn2 == vpn2 && (entry.g || entry.asid == cop0.entry_hi.asid))
+        {
+            index.p = false;
+            index.idx = i;
+            break;
+        }
+    }
 }
 
 void instr_eret(N64& n64, const Opcode& opcode)
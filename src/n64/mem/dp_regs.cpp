@@ -0,0 +1,93 @@
+namespace nintendo64
+{
+
+void write_dp_regs(N64& n64, u64 addr, u32 v)
+{
+    auto& dp = n64.mem.dp_regs;
+
+    switch(addr)
+    {
+        // only latched, the next end write starts from it
+        case DPC_START:
+        {
+            dp.start = v & 0xff'fff8;
+            dp.start_valid = true;
+            break;
+        }
+
+        case DPC_END:
+        {
+            dp.end = v & 0xff'fff8;
+
+            if(dp.start_valid)
+            {
+                dp.current = dp.start;
+                dp.start_valid = false;
+            }
+
+            if(!dp.freeze)
+            {
+                process_dp_commands(n64);
+            }
+            break;
+        }
+
+        case DPC_STATUS:
+        {
+            dp.xbus = deset_if_set(dp.xbus,v,0);
+            dp.xbus = set_if_set(dp.xbus,v,1);
+
+            const b32 frozen = dp.freeze;
+
+            dp.freeze = deset_if_set(dp.freeze,v,2);
+            dp.freeze = set_if_set(dp.freeze,v,3);
+
+            dp.flush = deset_if_set(dp.flush,v,4);
+            dp.flush = set_if_set(dp.flush,v,5);
+
+            // pick up anything that was submitted while frozen
+            if(frozen && !dp.freeze)
+            {
+                process_dp_commands(n64);
+            }
+            break;
+        }
+
+        // counters are not emulated
+        case DPC_CLOCK: case DPC_BUFBUSY: case DPC_PIPEBUSY: case DPC_TMEM: break;
+
+        default:
+        {
+            unimplemented("write_mem: dp regs: %08x : %08x\n",addr,v);
+            break;
+        }
+    }
+}
+
+u32 read_dp_regs(N64& n64, u64 addr)
+{
+    auto& dp = n64.mem.dp_regs;
+
+    switch(addr)
+    {
+        case DPC_START: return dp.start;
+        case DPC_END: return dp.end;
+        case DPC_CURRENT: return dp.current;
+
+        // commands are done as soon as they are submitted, so the buffer is always ready
+        case DPC_STATUS:
+        {
+            return (dp.xbus << 0) | (dp.freeze << 1) | (dp.flush << 2) | (1 << 7) | (dp.start_valid << 10);
+        }
+
+        case DPC_CLOCK: case DPC_BUFBUSY: case DPC_PIPEBUSY: case DPC_TMEM: return 0;
+
+        default:
+        {
+            unimplemented("read_mem: dp regs %8x\n",addr);
+            return 0;
+        }
+    }
+}
+
+}
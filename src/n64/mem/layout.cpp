@@ -47,8 +47,10 @@ access_type read_physical(N64 &n64, u32 addr)
         switch(idx)
         {
             case 0: return read_sp_regs(n64,addr); 
-            case 1: unimplemented("read_mem: dp command regs"); return 0;
-            case 2: unimplemented("read_mem: dp span regs"); return 0;
+            case 1: return read_dp_regs(n64,addr);
+
+            // test interface for the span buffers, nothing uses it
+            case 2: return 0;
             case 3: return read_mi(n64,addr); 
             case 4: return read_vi(n64,addr); 
             case 5: return read_ai(n64,addr);
@@ -116,6 +118,7 @@ void write_physical(N64 &n64, u32 addr, access_type v)
     if(addr < 0x0080'0000)
     {
         handle_write_n64<access_type>(n64.mem.rd_ram,addr,v);
+        invalidate_instr_cache(n64,addr);
     }
 
     // UNUSED
@@ -151,8 +154,8 @@ void write_physical(N64 &n64, u32 addr, access_type v)
         switch(idx)
         {
             case 0: write_sp_regs(n64,addr,v); break;
-            case 1: unimplemented("write_mem: dp command regs"); break;
-            case 2: unimplemented("write_mem: dp span regs"); break;
+            case 1: write_dp_regs(n64,addr,v); break;
+            case 2: break;
             case 3: write_mi(n64,addr,v); break;
             case 4: write_vi(n64,addr,v); break;
             case 5: write_ai(n64,addr,v); break;
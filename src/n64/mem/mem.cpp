@@ -174,6 +174,7 @@ void reset_mem(Mem &mem, const std::string &filename)
     mem.mi = {};
     mem.vi = {};
     mem.sp_regs = {};
+    mem.dp_regs = {};
     mem.si = {};
     mem.ai = {};
     mem.joybus.enabled = false;
@@ -193,19 +194,12 @@ void reset_mem(Mem &mem, const std::string &filename)
     write_physical_table(mem,0xA000'0000 / PAGE_SIZE);
 }
 
-u32 remap_addr(N64& n64,u32 addr)
+u32 remap_addr(N64& n64,u32 addr, b32 write)
 {
     // TODO: do we care about caching?
-    UNUSED(n64);
-
-
-    const u16 tlb_set = 0b11'11'00'00'11111111;
-    const u32 idx = (addr & 0xf000'0000) >> 28;
-
-    if(is_set(tlb_set,idx))
+    if(tlb_mapped(addr))
     {
-        assert(false);
-        return addr & 0x1FFF'FFFF;
+        return translate_tlb(n64,addr,write);
     }
 
     else
@@ -229,11 +223,25 @@ void write_mem_internal(N64& n64, u32 addr, access_type v)
 
     if(mem.page_table_write[idx])
     {
-        return handle_write_n64<access_type>(mem.page_table_write[idx],addr & (PAGE_SIZE - 1),v);
+        handle_write_n64<access_type>(mem.page_table_write[idx],addr & (PAGE_SIZE - 1),v);
+
+        // only direct mapped rdram is in the table, mask off the segment
+        invalidate_instr_cache(n64,addr & 0x1FFF'FFFF);
+        return;
+    }
+
+    // mapped page thats allready been translated
+    const auto *entry = n64.cpu.tlb_cache.lookup(addr);
+
+    if(entry && entry->write)
+    {
+        handle_write_n64<access_type>(entry->write,addr & (TlbCache::PAGE_SIZE - 1),v);
+        invalidate_instr_cache(n64,entry->phys);
+        return;
     }
 
     // if we are doing a slow access remap the addr manually
-    addr = remap_addr(n64,addr);
+    addr = remap_addr(n64,addr,true);
 
     write_physical<access_type>(n64,addr,v);    
 }
@@ -279,8 +287,16 @@ access_type read_mem_internal(N64& n64, u32 addr)
         return handle_read_n64<access_type>(mem.page_table_read[idx],addr & (PAGE_SIZE - 1));
     }
 
+    // mapped page thats allready been translated
+    const auto *entry = n64.cpu.tlb_cache.lookup(addr);
+
+    if(entry && entry->read)
+    {
+        return handle_read_n64<access_type>(entry->read,addr & (TlbCache::PAGE_SIZE - 1));
+    }
+
     // if we are doing a slow access remap the addr manually
-    addr = remap_addr(n64,addr);
+    addr = remap_addr(n64,addr,false);
 
     return read_physical<access_type>(n64,addr);    
 }
@@ -360,6 +376,7 @@ void write_u64(N64 &n64,u32 addr,u64 v)
 #include <n64/mem/mips_interface.cpp>
 #include <n64/mem/rdram.cpp>
 #include <n64/mem/sp_regs.cpp>
+#include <n64/mem/dp_regs.cpp>
 #include <n64/mem/video_interface.cpp>
 #include <n64/mem/peripheral_interface.cpp>
 #include <n64/mem/pif.cpp>
@@ -1,13 +1,101 @@
 namespace nintendo64
 {
+
+// NOTE: completes instantly, the rsp doesnt run while the cpu is accessing the regs anyways
+void do_sp_dma(N64 &n64, u32 v, b32 to_rdram)
+{
+    auto& sp = n64.mem.sp_regs;
+    auto& mem = n64.mem;
+
+    const u32 len = ((v & 0xfff) | 7) + 1;
+    const u32 count = ((v >> 12) & 0xff) + 1;
+    const u32 skip = (v >> 20) & 0xff8;
+
+    auto &sp_mem = is_set(sp.mem_addr,12)? mem.sp_imem : mem.sp_dmem;
+
+    u32 mem_addr = sp.mem_addr & 0xff8;
+    u32 dram_addr = sp.dram_addr & 0xff'fff8;
+
+    for(u32 row = 0; row < count; row++)
+    {
+        // both sides are word swapped so 8 byte chunks copy straight across
+        for(u32 i = 0; i < len; i += 8)
+        {
+            if(dram_addr + 8 <= mem.rd_ram.size())
+            {
+                u8* dram = &mem.rd_ram[dram_addr];
+                u8* spm = &sp_mem[mem_addr];
+
+                if(to_rdram)
+                {
+                    memcpy(dram,spm,8);
+                }
+
+                else
+                {
+                    memcpy(spm,dram,8);
+                }
+            }
+
+            mem_addr = (mem_addr + 8) & 0xff8;
+            dram_addr = (dram_addr + 8) & 0xff'fff8;
+        }
+
+        if(to_rdram)
+        {
+            // a row is at most 4k so it cant cover more than two cache pages
+            invalidate_instr_cache(n64,dram_addr - len);
+            invalidate_instr_cache(n64,dram_addr - 8);
+        }
+
+        dram_addr = (dram_addr + skip) & 0xff'fff8;
+    }
+
+    sp.mem_addr = (sp.mem_addr & 0x1000) | mem_addr;
+    sp.dram_addr = dram_addr;
+}
+
 void write_sp_regs(N64& n64, u64 addr ,u32 v)
 {
     auto& sp = n64.mem.sp_regs;
 
     switch(addr)
     {
+        case SP_MEM_ADDR:
+        {
+            sp.mem_addr = v & 0x1ff8;
+            break;
+        }
+
+        case SP_DRAM_ADDR:
+        {
+            sp.dram_addr = v & 0xff'fff8;
+            break;
+        }
+
+        case SP_RD_LEN:
+        {
+            sp.rd_len = v;
+            do_sp_dma(n64,v,false);
+            break;
+        }
+
+        case SP_WR_LEN:
+        {
+            sp.wr_len = v;
+            do_sp_dma(n64,v,true);
+            break;
+        }
+
         case SP_STATUS:
         {
+            if(is_set(v,1) && !sp.halt)
+            {
+                stop_rsp(n64);
+            }
+
+            const b32 was_halted = sp.halt;
+
             sp.halt = deset_if_set(sp.halt,v,0);
             sp.halt = set_if_set(sp.halt,v,1);
 
@@ -26,25 +114,36 @@ void write_sp_regs(N64& n64, u64 addr ,u32 v)
             sp.single_step = deset_if_set(sp.single_step,v,5);
             sp.single_step = set_if_set(sp.single_step,v,6);
 
-            sp.clear_intr_on_break = is_set(v,7);
-            sp.set_intr_on_break = is_set(v,8);
+            sp.intr_on_break = deset_if_set(sp.intr_on_break,v,7);
+            sp.intr_on_break = set_if_set(sp.intr_on_break,v,8);
 
-            // handle signal sets
+            // signals are in clear / set pairs
             for(u32 i = 0; i < 8; i++)
             {
-                const u32 idx = ((i + 9) * 2);
-                sp.signal[i] = set_if_set(sp.signal[i],idx,v);
+                sp.signal[i] = deset_if_set(sp.signal[i],v,9 + (i * 2));
+                sp.signal[i] = set_if_set(sp.signal[i],v,10 + (i * 2));
             }
 
-            // handle signal clear
-            for(u32 i = 0; i < 8; i++)
+            if(was_halted && !sp.halt)
             {
-                const u32 idx = ((i + 10) * 2);
-                sp.signal[i] = deset_if_set(sp.signal[i],idx,v);
+                start_rsp(n64);
             }
             break;
         }
 
+        case SP_SEMAPHORE:
+        {
+            sp.semaphore = false;
+            break;
+        }
+
+        case SP_PC:
+        {
+            n64.rsp.pc = v & 0xffc;
+            n64.rsp.pc_next = (n64.rsp.pc + 4) & 0xffc;
+            break;
+        }
+
         default:
         {
             unimplemented("write_mem: sp regs: %08x : %08x\n",addr,v);
@@ -59,9 +158,39 @@ u32 read_sp_regs(N64& n64, u64 addr)
 
     switch(addr)
     {
+        case SP_MEM_ADDR: return sp.mem_addr;
+        case SP_DRAM_ADDR: return sp.dram_addr;
+        case SP_RD_LEN: return sp.rd_len;
+        case SP_WR_LEN: return sp.wr_len;
+
+        case SP_STATUS:
+        {
+            u32 v = (sp.halt << 0) | (sp.broke << 1) | (sp.dma_busy << 2) | (sp.dma_full << 3) |
+                (sp.io_full << 4) | (sp.single_step << 5) | (sp.intr_on_break << 6);
+
+            for(u32 i = 0; i < 8; i++)
+            {
+                v |= sp.signal[i] << (7 + i);
+            }
+
+            return v;
+        }
+
+        // dmas are instant
+        case SP_DMA_FULL: return sp.dma_full;
+        case SP_DMA_BUSY: return sp.dma_busy;
+
+        // reading takes the semaphore
+        case SP_SEMAPHORE:
+        {
+            const u32 v = sp.semaphore;
+            sp.semaphore = true;
+            return v;
+        }
+
         case SP_PC:
         {
-            return sp.pc;
+            return n64.rsp.pc;
         }
     
         default:
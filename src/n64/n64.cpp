@@ -13,7 +13,10 @@ using namespace beyond_all_repair;
 #include <n64/mem/layout.cpp>
 #include <n64/instr/instr.cpp>
 #include <n64/instr/mips_lut.cpp>
+#include <n64/cpu/jit.cpp>
 #include <n64/rcp/rdp.cpp>
+#include <n64/rcp/rsp.cpp>
+#include <n64/rcp/rasterizer.cpp>
 #include <n64/debug.cpp>
 #include <n64/scheduler.cpp>
 
@@ -24,32 +27,40 @@ b32 read_func(beyond_all_repair::Program& program,u64 addr,void* out, u32 size)
 {
     auto& n64 = *(N64*)program.data;
 
-    switch(size)
+    // not in the tlb
+    try
     {
-        case 1:
+        switch(size)
         {
-            const u8 v = read_u8<false>(n64,addr);
-            memcpy(out,&v,size);
-            break;
-        }
+            case 1:
+            {
+                const u8 v = read_u8<false>(n64,addr);
+                memcpy(out,&v,size);
+                break;
+            }
 
-        case 2:
-        {
-            const u16 v = read_u16<false>(n64,addr);
-            memcpy(out,&v,size);
-            break;            
-        }
+            case 2:
+            {
+                const u16 v = read_u16<false>(n64,addr);
+                memcpy(out,&v,size);
+                break;            
+            }
 
-        case 4:
-        {
-            const u32 v = read_u32<false>(n64,addr);
-            memcpy(out,&v,size);
-            break;                    
+            case 4:
+            {
+                const u32 v = read_u32<false>(n64,addr);
+                memcpy(out,&v,size);
+                break;                    
+            }
+
+            default: return false;
         }
+    }
 
-        default: return false;
+    catch(const TlbException&)
+    {
+        return false;
     }
-    
 
     return true;
 }
@@ -65,6 +76,7 @@ void reset(N64 &n64, const std::string &filename)
     reset_mem(n64.mem,filename);
     reset_cpu(n64);
     reset_rdp(n64);
+    reset_rsp(n64);
     n64.size_change = false;
 
     // initializer external disassembler
@@ -94,7 +106,20 @@ void run_internal(N64 &n64)
                 }
             }
 #endif
-            step<debug>(n64);
+            if constexpr(debug)
+            {
+                step<debug>(n64);
+            }
+
+            else if(n64.cpu.jit.enabled)
+            {
+                step_jit(n64);
+            }
+
+            else
+            {
+                step_cached(n64);
+            }
         }
         n64.scheduler.service_events();
     }
@@ -0,0 +1,1730 @@
+#include <n64/n64.h>
+
+namespace nintendo64
+{
+
+static constexpr u32 RDP_TRIANGLE = 0x08;
+static constexpr u32 RDP_TEX_RECT = 0x24;
+static constexpr u32 RDP_TEX_RECT_FLIP = 0x25;
+static constexpr u32 RDP_SYNC_FULL = 0x29;
+static constexpr u32 RDP_SET_CONVERT = 0x2c;
+static constexpr u32 RDP_SET_SCISSOR = 0x2d;
+static constexpr u32 RDP_SET_PRIM_DEPTH = 0x2e;
+static constexpr u32 RDP_SET_OTHER_MODES = 0x2f;
+static constexpr u32 RDP_LOAD_TLUT = 0x30;
+static constexpr u32 RDP_SET_TILE_SIZE = 0x32;
+static constexpr u32 RDP_LOAD_BLOCK = 0x33;
+static constexpr u32 RDP_LOAD_TILE = 0x34;
+static constexpr u32 RDP_SET_TILE = 0x35;
+static constexpr u32 RDP_FILL_RECT = 0x36;
+static constexpr u32 RDP_SET_FILL_COLOR = 0x37;
+static constexpr u32 RDP_SET_FOG_COLOR = 0x38;
+static constexpr u32 RDP_SET_BLEND_COLOR = 0x39;
+static constexpr u32 RDP_SET_PRIM_COLOR = 0x3a;
+static constexpr u32 RDP_SET_ENV_COLOR = 0x3b;
+static constexpr u32 RDP_SET_COMBINE = 0x3c;
+static constexpr u32 RDP_SET_TEXTURE_IMAGE = 0x3d;
+static constexpr u32 RDP_SET_Z_IMAGE = 0x3e;
+static constexpr u32 RDP_SET_COLOR_IMAGE = 0x3f;
+
+static constexpr u32 CYCLE_ONE = 0;
+static constexpr u32 CYCLE_TWO = 1;
+static constexpr u32 CYCLE_COPY = 2;
+static constexpr u32 CYCLE_FILL = 3;
+
+static constexpr u32 FORMAT_RGBA = 0;
+static constexpr u32 FORMAT_CI = 2;
+static constexpr u32 FORMAT_IA = 3;
+
+static constexpr u32 RDRAM_MASK = 0x7f'ffff;
+
+inline u32 rdp_bits(u64 v, u32 shift, u32 len)
+{
+    return u32(v >> shift) & ((1 << len) - 1);
+}
+
+u32 rdp_command_len(u32 id)
+{
+    if(id >= RDP_TRIANGLE && id < RDP_TRIANGLE + 8)
+    {
+        // edges, then shade, texture and z coeffs if present
+        return 4 + (is_set(id,2) * 8) + (is_set(id,1) * 8) + (is_set(id,0) * 2);
+    }
+
+    return (id == RDP_TEX_RECT || id == RDP_TEX_RECT_FLIP)? 2 : 1;
+}
+
+struct Rgba
+{
+    s32 r = 0;
+    s32 g = 0;
+    s32 b = 0;
+    s32 a = 0;
+};
+
+inline Rgba unpack_rgba(u32 v)
+{
+    return Rgba{s32(v >> 24),s32((v >> 16) & 0xff),s32((v >> 8) & 0xff),s32(v & 0xff)};
+}
+
+inline Rgba splat(s32 v)
+{
+    return Rgba{v,v,v,v};
+}
+
+inline s32 expand5(u32 v)
+{
+    return s32((v << 3) | (v >> 2));
+}
+
+inline Rgba decode_rgba16(u16 v)
+{
+    return Rgba{expand5((v >> 11) & 0x1f),expand5((v >> 6) & 0x1f),expand5((v >> 1) & 0x1f),is_set(v,0)? 0xff : 0};
+}
+
+inline Rgba decode_ia16(u16 v)
+{
+    const s32 i = v >> 8;
+    return Rgba{i,i,i,s32(v & 0xff)};
+}
+
+// rdram a load reads, copied out in memory order when the load was queued
+struct LoadSource
+{
+    const u8 *data = nullptr;
+    u32 start = 0;
+    u32 len = 0;
+
+    u8 read(u32 addr) const
+    {
+        const u32 offset = addr - start;
+        return offset < len? data[offset] : 0;
+    }
+};
+
+inline u16 read_tmem_u16(const u8 *tmem, u32 addr)
+{
+    return (tmem[addr & 0xfff] << 8) | tmem[(addr + 1) & 0xfff];
+}
+
+// other modes that matter per pixel, pulled out once per primitive
+struct DrawModes
+{
+    u32 cycle_type = 0;
+    b32 persp = false;
+    b32 tlut = false;
+    b32 tlut_ia = false;
+
+    u32 blend_p[2] = {0};
+    u32 blend_a[2] = {0};
+    u32 blend_m[2] = {0};
+    u32 blend_b[2] = {0};
+
+    b32 force_blend = false;
+    b32 z_update = false;
+    b32 z_compare = false;
+    b32 z_prim = false;
+    u32 z_mode = 0;
+    b32 alpha_compare = false;
+    b32 dither_alpha = false;
+
+    // combiner input selects for each cycle
+    u32 rgb_a[2] = {0};
+    u32 rgb_b[2] = {0};
+    u32 rgb_c[2] = {0};
+    u32 rgb_d[2] = {0};
+    u32 alpha_a[2] = {0};
+    u32 alpha_b[2] = {0};
+    u32 alpha_c[2] = {0};
+    u32 alpha_d[2] = {0};
+};
+
+DrawModes decode_modes(const RdpState &state)
+{
+    DrawModes modes;
+
+    const u64 om = state.other_modes;
+
+    modes.cycle_type = rdp_bits(om,52,2);
+    modes.persp = is_set(om,51);
+    modes.tlut = is_set(om,47);
+    modes.tlut_ia = is_set(om,46);
+
+    for(u32 c = 0; c < 2; c++)
+    {
+        const u32 shift = 2 * (1 - c);
+
+        modes.blend_p[c] = rdp_bits(om,28 + shift,2);
+        modes.blend_a[c] = rdp_bits(om,24 + shift,2);
+        modes.blend_m[c] = rdp_bits(om,20 + shift,2);
+        modes.blend_b[c] = rdp_bits(om,16 + shift,2);
+    }
+
+    modes.force_blend = is_set(om,14);
+    modes.z_mode = rdp_bits(om,10,2);
+    modes.z_update = is_set(om,5);
+    modes.z_compare = is_set(om,4);
+    modes.z_prim = is_set(om,2);
+    modes.dither_alpha = is_set(om,1);
+    modes.alpha_compare = is_set(om,0);
+
+    const u64 cc = state.combine;
+
+    modes.rgb_a[0] = rdp_bits(cc,52,4);
+    modes.rgb_c[0] = rdp_bits(cc,47,5);
+    modes.alpha_a[0] = rdp_bits(cc,44,3);
+    modes.alpha_c[0] = rdp_bits(cc,41,3);
+    modes.rgb_a[1] = rdp_bits(cc,37,4);
+    modes.rgb_c[1] = rdp_bits(cc,32,5);
+    modes.rgb_b[0] = rdp_bits(cc,28,4);
+    modes.rgb_b[1] = rdp_bits(cc,24,4);
+    modes.alpha_a[1] = rdp_bits(cc,21,3);
+    modes.alpha_c[1] = rdp_bits(cc,18,3);
+    modes.rgb_d[0] = rdp_bits(cc,15,3);
+    modes.alpha_b[0] = rdp_bits(cc,12,3);
+    modes.alpha_d[0] = rdp_bits(cc,9,3);
+    modes.rgb_d[1] = rdp_bits(cc,6,3);
+    modes.alpha_b[1] = rdp_bits(cc,3,3);
+    modes.alpha_d[1] = rdp_bits(cc,0,3);
+
+    return modes;
+}
+
+// s10.5 texture coord to a texel inside the tile
+s32 tile_coord(s32 v, u32 shift, u32 lo, u32 hi, b32 clamp, b32 mirror, u32 mask)
+{
+    // 1-10 shift down, 11-15 shift up
+    v = shift <= 10? (v >> shift) : (v << (16 - shift));
+
+    s32 texel = (v - s32(lo << 3)) >> 5;
+
+    if(clamp || !mask)
+    {
+        const s32 max = std::max(s32(hi >> 2) - s32(lo >> 2),0);
+        texel = std::clamp(texel,0,max);
+    }
+
+    if(mask)
+    {
+        const s32 size = 1 << std::min(mask,10u);
+
+        if(mirror && (texel & size))
+        {
+            texel = ~texel;
+        }
+
+        texel &= size - 1;
+    }
+
+    return texel;
+}
+
+u16 tlut_entry(const RdpState &state, u32 idx)
+{
+    // load tlut puts every entry down four times
+    return read_tmem_u16(state.tmem,0x800 + ((idx & 0xff) * 8));
+}
+
+Rgba decode_tlut(const RdpState &state, const DrawModes &modes, u32 idx)
+{
+    const u16 v = tlut_entry(state,idx);
+    return modes.tlut_ia? decode_ia16(v) : decode_rgba16(v);
+}
+
+Rgba fetch_texel(const RdpState &state, const DrawModes &modes, const RdpTile &tile, s32 s, s32 t)
+{
+    const u8 *tmem = state.tmem;
+
+    // odd rows have their words swapped
+    const u32 row = (tile.tmem * 8) + (t * tile.line * 8);
+    const u32 swap = (t & 1)? 4 : 0;
+
+    switch(tile.size)
+    {
+        case 0:
+        {
+            const u8 b = tmem[((row + (s >> 1)) ^ swap) & 0xfff];
+            const u32 v = (s & 1)? (b & 0xf) : (b >> 4);
+
+            if(modes.tlut)
+            {
+                return decode_tlut(state,modes,(tile.palette << 4) | v);
+            }
+
+            if(tile.format == FORMAT_IA)
+            {
+                const s32 i = ((v >> 1) << 5) | ((v >> 1) << 2) | (v >> 2);
+                return Rgba{i,i,i,is_set(v,0)? 0xff : 0};
+            }
+
+            return splat(s32(v * 0x11));
+        }
+
+        case 1:
+        {
+            const u8 v = tmem[((row + s) ^ swap) & 0xfff];
+
+            if(modes.tlut)
+            {
+                return decode_tlut(state,modes,v);
+            }
+
+            if(tile.format == FORMAT_IA)
+            {
+                const s32 i = (v >> 4) * 0x11;
+                return Rgba{i,i,i,s32(v & 0xf) * 0x11};
+            }
+
+            return splat(v);
+        }
+
+        case 2:
+        {
+            const u16 v = read_tmem_u16(tmem,(row + (s * 2)) ^ swap);
+
+            if(modes.tlut)
+            {
+                return decode_tlut(state,modes,v >> 8);
+            }
+
+            return tile.format == FORMAT_IA? decode_ia16(v) : decode_rgba16(v);
+        }
+
+        // split across both halves of tmem
+        default:
+        {
+            const u32 addr = ((row + (s * 2)) ^ swap) & 0x7ff;
+
+            const u16 rg = read_tmem_u16(tmem,addr);
+            const u16 ba = read_tmem_u16(tmem,addr | 0x800);
+
+            return Rgba{rg >> 8,rg & 0xff,ba >> 8,ba & 0xff};
+        }
+    }
+}
+
+Rgba sample_tile(const RdpState &state, const DrawModes &modes, u32 tile_idx, s32 s, s32 t)
+{
+    const auto &tile = state.tiles[tile_idx & 7];
+
+    const s32 ts = tile_coord(s,tile.shift_s,tile.sl,tile.sh,tile.clamp_s,tile.mirror_s,tile.mask_s);
+    const s32 tt = tile_coord(t,tile.shift_t,tile.tl,tile.th,tile.clamp_t,tile.mirror_t,tile.mask_t);
+
+    return fetch_texel(state,modes,tile,ts,tt);
+}
+
+// raw texel for copy mode, written straight to a 16 bit framebuffer
+u16 copy_texel(const RdpState &state, const DrawModes &modes, u32 tile_idx, s32 s, s32 t)
+{
+    const auto &tile = state.tiles[tile_idx & 7];
+
+    const s32 ts = tile_coord(s,tile.shift_s,tile.sl,tile.sh,tile.clamp_s,tile.mirror_s,tile.mask_s);
+    const s32 tt = tile_coord(t,tile.shift_t,tile.tl,tile.th,tile.clamp_t,tile.mirror_t,tile.mask_t);
+
+    const u32 row = (tile.tmem * 8) + (tt * tile.line * 8);
+    const u32 swap = (tt & 1)? 4 : 0;
+
+    switch(tile.size)
+    {
+        case 0:
+        {
+            const u8 b = state.tmem[((row + (ts >> 1)) ^ swap) & 0xfff];
+            const u32 v = (ts & 1)? (b & 0xf) : (b >> 4);
+
+            return modes.tlut? tlut_entry(state,(tile.palette << 4) | v) : u16((v << 12) | (v << 4));
+        }
+
+        case 1:
+        {
+            const u8 v = state.tmem[((row + ts) ^ swap) & 0xfff];
+            return modes.tlut? tlut_entry(state,v) : u16((v << 8) | v);
+        }
+
+        default: return read_tmem_u16(state.tmem,(row + (ts * 2)) ^ swap);
+    }
+}
+
+// combiner inputs for a single pixel
+struct CombineInputs
+{
+    Rgba combined;
+    Rgba tex0;
+    Rgba tex1;
+    Rgba prim;
+    Rgba shade;
+    Rgba env;
+
+    s32 noise = 0;
+    s32 prim_lod_frac = 0;
+    s32 k4 = 0;
+    s32 k5 = 0;
+};
+
+Rgba rgb_sub_a(const CombineInputs &in, u32 sel)
+{
+    switch(sel)
+    {
+        case 0: return in.combined;
+        case 1: return in.tex0;
+        case 2: return in.tex1;
+        case 3: return in.prim;
+        case 4: return in.shade;
+        case 5: return in.env;
+        case 6: return splat(0x100);
+        case 7: return splat(in.noise);
+        default: return Rgba{};
+    }
+}
+
+Rgba rgb_sub_b(const CombineInputs &in, u32 sel)
+{
+    switch(sel)
+    {
+        case 0: return in.combined;
+        case 1: return in.tex0;
+        case 2: return in.tex1;
+        case 3: return in.prim;
+        case 4: return in.shade;
+        case 5: return in.env;
+
+        // chroma key center is not emulated
+        case 7: return splat(in.k4);
+        default: return Rgba{};
+    }
+}
+
+Rgba rgb_mul(const CombineInputs &in, u32 sel)
+{
+    switch(sel)
+    {
+        case 0: return in.combined;
+        case 1: return in.tex0;
+        case 2: return in.tex1;
+        case 3: return in.prim;
+        case 4: return in.shade;
+        case 5: return in.env;
+        case 7: return splat(in.combined.a);
+        case 8: return splat(in.tex0.a);
+        case 9: return splat(in.tex1.a);
+        case 10: return splat(in.prim.a);
+        case 11: return splat(in.shade.a);
+        case 12: return splat(in.env.a);
+
+        // no mipmapping, so the lod fraction is always zero
+        case 14: return splat(in.prim_lod_frac);
+        case 15: return splat(in.k5);
+        default: return Rgba{};
+    }
+}
+
+Rgba rgb_add(const CombineInputs &in, u32 sel)
+{
+    switch(sel)
+    {
+        case 0: return in.combined;
+        case 1: return in.tex0;
+        case 2: return in.tex1;
+        case 3: return in.prim;
+        case 4: return in.shade;
+        case 5: return in.env;
+        case 6: return splat(0x100);
+        default: return Rgba{};
+    }
+}
+
+s32 alpha_input(const CombineInputs &in, u32 sel)
+{
+    switch(sel)
+    {
+        case 0: return in.combined.a;
+        case 1: return in.tex0.a;
+        case 2: return in.tex1.a;
+        case 3: return in.prim.a;
+        case 4: return in.shade.a;
+        case 5: return in.env.a;
+        case 6: return 0x100;
+        default: return 0;
+    }
+}
+
+s32 alpha_mul(const CombineInputs &in, u32 sel)
+{
+    switch(sel)
+    {
+        case 1: return in.tex0.a;
+        case 2: return in.tex1.a;
+        case 3: return in.prim.a;
+        case 4: return in.shade.a;
+        case 5: return in.env.a;
+        case 6: return in.prim_lod_frac;
+        default: return 0;
+    }
+}
+
+inline s32 combine_channel(s32 a, s32 b, s32 c, s32 d)
+{
+    return std::clamp((((a - b) * c) + (d << 8) + 0x80) >> 8,0,0xff);
+}
+
+// (a - b) * c + d
+Rgba combine_cycle(const CombineInputs &in, const DrawModes &modes, u32 cycle)
+{
+    const Rgba a = rgb_sub_a(in,modes.rgb_a[cycle]);
+    const Rgba b = rgb_sub_b(in,modes.rgb_b[cycle]);
+    const Rgba c = rgb_mul(in,modes.rgb_c[cycle]);
+    const Rgba d = rgb_add(in,modes.rgb_d[cycle]);
+
+    Rgba out;
+
+    out.r = combine_channel(a.r,b.r,c.r,d.r);
+    out.g = combine_channel(a.g,b.g,c.g,d.g);
+    out.b = combine_channel(a.b,b.b,c.b,d.b);
+
+    out.a = combine_channel(alpha_input(in,modes.alpha_a[cycle]),alpha_input(in,modes.alpha_b[cycle]),
+        alpha_mul(in,modes.alpha_c[cycle]),alpha_input(in,modes.alpha_d[cycle]));
+
+    return out;
+}
+
+// everything fixed for the primitive being drawn
+struct DrawContext
+{
+    RdpState &state;
+    DrawModes modes;
+
+    u8 *rdram = nullptr;
+
+    Rgba prim;
+    Rgba env;
+    Rgba blend;
+    Rgba fog;
+
+    u32 tile = 0;
+    b32 textured = false;
+};
+
+DrawContext make_context(RdpWorker &worker, N64 &n64, u32 tile, b32 textured)
+{
+    auto &state = worker.state;
+
+    return DrawContext
+    {
+        state,
+        decode_modes(state),
+        n64.mem.rd_ram.data(),
+        unpack_rgba(state.prim_color),
+        unpack_rgba(state.env_color),
+        unpack_rgba(state.blend_color),
+        unpack_rgba(state.fog_color),
+        tile,
+        textured,
+    };
+}
+
+inline b32 owns_line(const RdpWorker &worker, u32 y)
+{
+    return ((y >> Rasterizer::BAND_SHIFT) % worker.count) == worker.id;
+}
+
+// stand in for the rdp noise source, has to depend only on the pixel to stay deterministic across threads
+inline s32 pixel_noise(u32 x, u32 y)
+{
+    u32 h = (x * 0x9E37'79B1) ^ (y * 0x85EB'CA77);
+    h ^= h >> 15;
+    h *= 0x2C1B'3C6D;
+    h ^= h >> 12;
+
+    return s32(h & 0xff);
+}
+
+Rgba read_memory_color(const DrawContext &ctx, u32 addr)
+{
+    if(ctx.state.color_image.size == 3)
+    {
+        return unpack_rgba(handle_read_n64<u32>(ctx.rdram,addr & RDRAM_MASK));
+    }
+
+    return decode_rgba16(handle_read_n64<u16>(ctx.rdram,addr & RDRAM_MASK));
+}
+
+void write_memory_color(const DrawContext &ctx, u32 addr, const Rgba &c)
+{
+    if(ctx.state.color_image.size == 3)
+    {
+        const u32 v = (u32(c.r) << 24) | (u32(c.g) << 16) | (u32(c.b) << 8) | u32(c.a);
+        handle_write_n64<u32>(ctx.rdram,addr & RDRAM_MASK,v);
+    }
+
+    else
+    {
+        // coverage bit always full
+        const u16 v = ((c.r >> 3) << 11) | ((c.g >> 3) << 6) | ((c.b >> 3) << 1) | 1;
+        handle_write_n64<u16>(ctx.rdram,addr & RDRAM_MASK,v);
+    }
+}
+
+Rgba blend_input(const DrawContext &ctx, u32 sel, const Rgba &in, const Rgba &memory)
+{
+    switch(sel)
+    {
+        case 0: return in;
+        case 1: return memory;
+        case 2: return ctx.blend;
+        default: return ctx.fog;
+    }
+}
+
+// (p * a + m * b) / (a + b)
+Rgba blend_cycle(const DrawContext &ctx, u32 cycle, const Rgba &in, const Rgba &memory, s32 shade_alpha)
+{
+    const auto &modes = ctx.modes;
+
+    const Rgba p = blend_input(ctx,modes.blend_p[cycle],in,memory);
+    const Rgba m = blend_input(ctx,modes.blend_m[cycle],in,memory);
+
+    s32 a = 0;
+
+    switch(modes.blend_a[cycle])
+    {
+        case 0: a = in.a; break;
+        case 1: a = ctx.fog.a; break;
+        case 2: a = shade_alpha; break;
+        default: a = 0; break;
+    }
+
+    s32 b = 0;
+
+    switch(modes.blend_b[cycle])
+    {
+        case 0: b = 0xff - a; break;
+
+        // coverage is not emulated, memory is always fully covered
+        case 1: b = 0xff; break;
+        case 2: b = 0xff; break;
+        default: b = 0; break;
+    }
+
+    const s32 sum = a + b;
+
+    if(!sum)
+    {
+        return p;
+    }
+
+    Rgba out;
+
+    out.r = std::min(((p.r * a) + (m.r * b)) / sum,0xff);
+    out.g = std::min(((p.g * a) + (m.g * b)) / sum,0xff);
+    out.b = std::min(((p.b * a) + (m.b * b)) / sum,0xff);
+    out.a = in.a;
+
+    return out;
+}
+
+// 18 bit depth, the buffer holds the top 16 bits
+b32 depth_test(const DrawContext &ctx, u32 zaddr, u32 z)
+{
+    const u32 old = u32(handle_read_n64<u16>(ctx.rdram,zaddr & RDRAM_MASK)) << 2;
+
+    switch(ctx.modes.z_mode)
+    {
+        // decal, pass on (nearly) the same depth
+        case 3: return z <= old + (ctx.state.prim_dz << 2);
+
+        default: return z < old;
+    }
+}
+
+void draw_pixel(DrawContext &ctx, u32 x, u32 y, const Rgba &shade, s32 s, s32 t, s32 w, s32 z)
+{
+    auto &state = ctx.state;
+    const auto &modes = ctx.modes;
+    const auto &image = state.color_image;
+
+    const u32 offset = (y * image.width) + x;
+    const u32 zaddr = state.z_addr + (offset * 2);
+
+    u32 depth = 0;
+
+    if(modes.z_compare || modes.z_update)
+    {
+        depth = modes.z_prim? (state.prim_z << 2) : u32(std::clamp(z >> 13,0,0x3ffff));
+
+        if(modes.z_compare && !depth_test(ctx,zaddr,depth))
+        {
+            return;
+        }
+    }
+
+    CombineInputs in;
+
+    in.shade = shade;
+    in.prim = ctx.prim;
+    in.env = ctx.env;
+    in.noise = pixel_noise(x,y);
+    in.prim_lod_frac = state.prim_lod_frac;
+    in.k4 = state.k4;
+    in.k5 = state.k5;
+
+    if(ctx.textured)
+    {
+        // w of 0x7fff is 1.0
+        if(modes.persp)
+        {
+            const s64 div = std::max(w,1);
+
+            s = s32(std::clamp((s64(s) << 15) / div,s64(-0x8000'0000ll),s64(0x7fff'ffff)));
+            t = s32(std::clamp((s64(t) << 15) / div,s64(-0x8000'0000ll),s64(0x7fff'ffff)));
+        }
+
+        s = s16(s >> 16);
+        t = s16(t >> 16);
+
+        in.tex0 = sample_tile(state,modes,ctx.tile,s,t);
+        in.tex1 = modes.cycle_type == CYCLE_TWO? sample_tile(state,modes,ctx.tile + 1,s,t) : in.tex0;
+    }
+
+    Rgba color = combine_cycle(in,modes,modes.cycle_type == CYCLE_TWO? 0 : 1);
+
+    if(modes.cycle_type == CYCLE_TWO)
+    {
+        in.combined = color;
+        color = combine_cycle(in,modes,1);
+    }
+
+    if(modes.alpha_compare)
+    {
+        const s32 threshold = modes.dither_alpha? in.noise : ctx.blend.a;
+
+        if(color.a < threshold)
+        {
+            return;
+        }
+    }
+
+    const u32 addr = image.addr + ((offset << image.size) >> 1);
+    const Rgba memory = read_memory_color(ctx,addr);
+
+    // the first cycle always blends, its only there to feed the second
+    if(modes.cycle_type == CYCLE_TWO)
+    {
+        color = blend_cycle(ctx,0,color,memory,shade.a);
+    }
+
+    // without force blend edges would be the only thing blended, and coverage isnt emulated
+    if(modes.force_blend)
+    {
+        color = blend_cycle(ctx,1,color,memory,shade.a);
+    }
+
+    else
+    {
+        color = blend_input(ctx,modes.blend_p[1],color,memory);
+    }
+
+    write_memory_color(ctx,addr,color);
+
+    if(modes.z_update)
+    {
+        handle_write_n64<u16>(ctx.rdram,zaddr & RDRAM_MASK,u16(depth >> 2));
+    }
+}
+
+void fill_pixel(DrawContext &ctx, u32 x, u32 y)
+{
+    const auto &state = ctx.state;
+    const auto &image = state.color_image;
+
+    const u32 offset = (y * image.width) + x;
+    const u32 addr = image.addr + ((offset << image.size) >> 1);
+
+    switch(image.size)
+    {
+        case 1: ctx.rdram[(addr & RDRAM_MASK) ^ 3] = u8(state.fill_color >> (8 * (3 - (x & 3)))); break;
+
+        // two pixels to the fill color
+        case 2: handle_write_n64<u16>(ctx.rdram,addr & RDRAM_MASK,u16(is_set(x,0)? state.fill_color : state.fill_color >> 16)); break;
+
+        default: handle_write_n64<u32>(ctx.rdram,addr & RDRAM_MASK,state.fill_color); break;
+    }
+}
+
+// triangle attribute in s15.16, with its step along x and down the major edge
+struct EdgeAttr
+{
+    s32 value = 0;
+    s32 dx = 0;
+    s32 de = 0;
+};
+
+enum attr_idx
+{
+    ATTR_R,
+    ATTR_G,
+    ATTR_B,
+    ATTR_A,
+    ATTR_S,
+    ATTR_T,
+    ATTR_W,
+    ATTR_Z,
+    ATTR_SIZE,
+};
+
+// shade and texture coeffs share a layout, 4 channels with the int and frac halves in separate words
+void decode_coeffs(EdgeAttr *attr, const u64 *w, u32 channels)
+{
+    for(u32 c = 0; c < channels; c++)
+    {
+        const u32 shift = 48 - (c * 16);
+
+        attr[c].value = s32((rdp_bits(w[0],shift,16) << 16) | rdp_bits(w[2],shift,16));
+        attr[c].dx = s32((rdp_bits(w[1],shift,16) << 16) | rdp_bits(w[3],shift,16));
+        attr[c].de = s32((rdp_bits(w[4],shift,16) << 16) | rdp_bits(w[6],shift,16));
+    }
+}
+
+inline s32 sign_extend14(u32 v)
+{
+    return s32(v << 18) >> 18;
+}
+
+void draw_triangle(RdpWorker &worker, N64 &n64, const u64 *cmd)
+{
+    const u32 id = rdp_bits(cmd[0],56,6);
+
+    const b32 shaded = is_set(id,2);
+    const b32 textured = is_set(id,1);
+    const b32 zbuffered = is_set(id,0);
+
+    // major edge on the left
+    const b32 left_major = is_set(cmd[0],55);
+
+    // s11.2
+    const s32 yl = sign_extend14(rdp_bits(cmd[0],32,14));
+    const s32 ym = sign_extend14(rdp_bits(cmd[0],16,14));
+    const s32 yh = sign_extend14(rdp_bits(cmd[0],0,14));
+
+    // s15.16
+    const s32 xl = s32(cmd[1] >> 32);
+    const s32 dxldy = s32(cmd[1]);
+    const s32 xh = s32(cmd[2] >> 32);
+    const s32 dxhdy = s32(cmd[2]);
+    const s32 xm = s32(cmd[3] >> 32);
+    const s32 dxmdy = s32(cmd[3]);
+
+    EdgeAttr attr[ATTR_SIZE];
+
+    u32 idx = 4;
+
+    if(shaded)
+    {
+        decode_coeffs(&attr[ATTR_R],&cmd[idx],4);
+        idx += 8;
+    }
+
+    if(textured)
+    {
+        decode_coeffs(&attr[ATTR_S],&cmd[idx],3);
+        idx += 8;
+    }
+
+    if(zbuffered)
+    {
+        attr[ATTR_Z].value = s32(cmd[idx] >> 32);
+        attr[ATTR_Z].dx = s32(cmd[idx]);
+        attr[ATTR_Z].de = s32(cmd[idx + 1] >> 32);
+    }
+
+    auto ctx = make_context(worker,n64,rdp_bits(cmd[0],48,3),textured);
+    const auto &state = worker.state;
+
+    // fill and copy mode dont shade
+    const b32 fill = ctx.modes.cycle_type == CYCLE_FILL;
+
+    if(ctx.modes.cycle_type == CYCLE_COPY)
+    {
+        return;
+    }
+
+    // attributes and xh, xm are given at the top of the scanline holding yh
+    const s32 ystart = yh & ~3;
+
+    const s32 sc_y0 = state.scissor_yh >> 2;
+    const s32 sc_y1 = state.scissor_yl >> 2;
+    const s32 sc_x0 = state.scissor_xh >> 2;
+    const s32 sc_x1 = state.scissor_xl >> 2;
+
+    const s32 y0 = std::max(yh >> 2,sc_y0);
+    const s32 y1 = std::min((yl + 3) >> 2,sc_y1);
+
+    for(s32 y = std::max(y0,0); y < y1; y++)
+    {
+        if(!owns_line(worker,y))
+        {
+            continue;
+        }
+
+        // sample in the middle of the scanline
+        const s32 k = (y << 2) + 2;
+
+        if(k < yh || k >= yl)
+        {
+            continue;
+        }
+
+        const s64 dk = k - ystart;
+
+        const s64 major = xh + ((dxhdy * dk) >> 2);
+        const s64 minor = k < ym? xm + ((dxmdy * dk) >> 2) : xl + ((dxldy * s64(k - ym)) >> 2);
+
+        const s64 left = left_major? major : minor;
+        const s64 right = left_major? minor : major;
+
+        // pixels with their centre inside the span
+        const s32 x0 = std::max(s32((left - 0x8000 + 0xffff) >> 16),std::max(sc_x0,0));
+        const s32 x1 = std::min(s32((right - 0x8000 + 0xffff) >> 16),sc_x1);
+
+        if(x0 >= x1)
+        {
+            continue;
+        }
+
+        if(fill)
+        {
+            for(s32 x = x0; x < x1; x++)
+            {
+                fill_pixel(ctx,x,y);
+            }
+
+            continue;
+        }
+
+        // attributes at the first pixel, then step along x
+        s32 value[ATTR_SIZE];
+        const s64 offset = (s64(x0) << 16) + 0x8000 - major;
+
+        for(u32 i = 0; i < ATTR_SIZE; i++)
+        {
+            value[i] = s32(attr[i].value + ((attr[i].de * dk) >> 2) + ((attr[i].dx * offset) >> 16));
+        }
+
+        for(s32 x = x0; x < x1; x++)
+        {
+            Rgba shade;
+
+            if(shaded)
+            {
+                shade.r = std::clamp(value[ATTR_R] >> 16,0,0xff);
+                shade.g = std::clamp(value[ATTR_G] >> 16,0,0xff);
+                shade.b = std::clamp(value[ATTR_B] >> 16,0,0xff);
+                shade.a = std::clamp(value[ATTR_A] >> 16,0,0xff);
+            }
+
+            draw_pixel(ctx,x,y,shade,value[ATTR_S],value[ATTR_T],value[ATTR_W] >> 16,value[ATTR_Z]);
+
+            for(u32 i = 0; i < ATTR_SIZE; i++)
+            {
+                value[i] += attr[i].dx;
+            }
+        }
+    }
+}
+
+// rect bounds in pixels as [x0, x1) and [y0, y1) clipped to the scissor
+struct RectBounds
+{
+    s32 x0 = 0;
+    s32 x1 = 0;
+    s32 y0 = 0;
+    s32 y1 = 0;
+};
+
+RectBounds rect_bounds(const RdpState &state, u32 cycle_type, u32 xh, u32 yh, u32 xl, u32 yl)
+{
+    RectBounds bounds;
+
+    // fill and copy mode include the bottom right edge
+    if(cycle_type == CYCLE_FILL || cycle_type == CYCLE_COPY)
+    {
+        bounds.x0 = xh >> 2;
+        bounds.y0 = yh >> 2;
+        bounds.x1 = (xl >> 2) + 1;
+        bounds.y1 = (yl >> 2) + 1;
+    }
+
+    else
+    {
+        bounds.x0 = (xh + 3) >> 2;
+        bounds.y0 = (yh + 3) >> 2;
+        bounds.x1 = (xl + 3) >> 2;
+        bounds.y1 = (yl + 3) >> 2;
+    }
+
+    bounds.x0 = std::max(bounds.x0,s32(state.scissor_xh >> 2));
+    bounds.y0 = std::max(bounds.y0,s32(state.scissor_yh >> 2));
+    bounds.x1 = std::min(bounds.x1,s32(state.scissor_xl >> 2));
+    bounds.y1 = std::min(bounds.y1,s32(state.scissor_yl >> 2));
+
+    return bounds;
+}
+
+void draw_fill_rect(RdpWorker &worker, N64 &n64, u64 cmd)
+{
+    auto ctx = make_context(worker,n64,0,false);
+
+    const auto bounds = rect_bounds(worker.state,ctx.modes.cycle_type,rdp_bits(cmd,12,12),rdp_bits(cmd,0,12),rdp_bits(cmd,44,12),rdp_bits(cmd,32,12));
+
+    const b32 fill = ctx.modes.cycle_type == CYCLE_FILL;
+    const s32 z = s32(worker.state.prim_z << 16) >> 3;
+
+    for(s32 y = bounds.y0; y < bounds.y1; y++)
+    {
+        if(!owns_line(worker,y))
+        {
+            continue;
+        }
+
+        for(s32 x = bounds.x0; x < bounds.x1; x++)
+        {
+            if(fill)
+            {
+                fill_pixel(ctx,x,y);
+            }
+
+            else
+            {
+                draw_pixel(ctx,x,y,Rgba{},0,0,0,z);
+            }
+        }
+    }
+}
+
+void draw_tex_rect(RdpWorker &worker, N64 &n64, const u64 *cmd)
+{
+    const b32 flip = rdp_bits(cmd[0],56,6) == RDP_TEX_RECT_FLIP;
+
+    auto ctx = make_context(worker,n64,rdp_bits(cmd[0],24,3),true);
+    auto &state = worker.state;
+
+    const u32 xh = rdp_bits(cmd[0],12,12);
+    const u32 yh = rdp_bits(cmd[0],0,12);
+
+    const auto bounds = rect_bounds(state,ctx.modes.cycle_type,xh,yh,rdp_bits(cmd[0],44,12),rdp_bits(cmd[0],32,12));
+
+    // s10.5 start, s5.10 steps
+    const s32 s0 = s16(rdp_bits(cmd[1],48,16));
+    const s32 t0 = s16(rdp_bits(cmd[1],32,16));
+    s32 dsdx = s16(rdp_bits(cmd[1],16,16));
+    const s32 dtdy = s16(rdp_bits(cmd[1],0,16));
+
+    const b32 copy = ctx.modes.cycle_type == CYCLE_COPY;
+
+    // copy mode does four pixels a clock, so the step is given four times over
+    if(copy)
+    {
+        dsdx >>= 2;
+    }
+
+    // coords are from the rect edge, not the clipped one
+    const s32 x_start = xh >> 2;
+    const s32 y_start = yh >> 2;
+
+    const s32 z = s32(state.prim_z << 16) >> 3;
+
+    for(s32 y = bounds.y0; y < bounds.y1; y++)
+    {
+        if(!owns_line(worker,y))
+        {
+            continue;
+        }
+
+        for(s32 x = bounds.x0; x < bounds.x1; x++)
+        {
+            const s32 dx = x - x_start;
+            const s32 dy = y - y_start;
+
+            const s32 s = s0 + (((flip? dy : dx) * dsdx) >> 5);
+            const s32 t = t0 + (((flip? dx : dy) * dtdy) >> 5);
+
+            if(copy)
+            {
+                const u16 texel = copy_texel(state,ctx.modes,ctx.tile,s,t);
+
+                if(ctx.modes.alpha_compare && !is_set(texel,0))
+                {
+                    continue;
+                }
+
+                const auto &image = state.color_image;
+                const u32 addr = image.addr + ((((y * image.width) + x) << image.size) >> 1);
+
+                if(image.size == 1)
+                {
+                    ctx.rdram[(addr & RDRAM_MASK) ^ 3] = u8(texel);
+                }
+
+                else
+                {
+                    handle_write_n64<u16>(ctx.rdram,addr & RDRAM_MASK,texel);
+                }
+            }
+
+            else
+            {
+                // draw_pixel wants s15.16
+                draw_pixel(ctx,x,y,Rgba{},s << 16,t << 16,0,z);
+            }
+        }
+    }
+}
+
+// bytes of the texture image in the current format, 4 bit is packed two a byte
+inline u32 image_bytes(const RdpImage &image, u32 texels)
+{
+    return (texels << image.size) >> 1;
+}
+
+// rdram a load command reads as [start, end)
+void load_range(const RdpImage &image, u64 cmd, u32 &start, u32 &end)
+{
+    const u32 id = rdp_bits(cmd,56,6);
+
+    const u32 sl = rdp_bits(cmd,44,12);
+    const u32 tl = rdp_bits(cmd,32,12);
+    const u32 sh = rdp_bits(cmd,12,12);
+    const u32 th = rdp_bits(cmd,0,12);
+
+    switch(id)
+    {
+        // block coords are in whole texels
+        case RDP_LOAD_BLOCK:
+        {
+            start = image.addr + image_bytes(image,(tl * image.width) + sl);
+            end = start + image_bytes(image,(sh - sl) + 2);
+            break;
+        }
+
+        // one row of 16 bit entries
+        case RDP_LOAD_TLUT:
+        {
+            start = image.addr + ((((tl >> 2) * image.width) + (sl >> 2)) * 2);
+            end = image.addr + ((((tl >> 2) * image.width) + (sh >> 2) + 1) * 2);
+            break;
+        }
+
+        default:
+        {
+            start = image.addr + image_bytes(image,((tl >> 2) * image.width) + (sl >> 2));
+            end = image.addr + image_bytes(image,((th >> 2) * image.width) + (sh >> 2) + 2);
+            break;
+        }
+    }
+
+    end = std::max(start,end);
+}
+
+void load_tile(RdpState &state, const LoadSource &src_data, u64 cmd)
+{
+    auto &tile = state.tiles[rdp_bits(cmd,24,3)];
+    const auto &image = state.texture_image;
+
+    tile.sl = rdp_bits(cmd,44,12);
+    tile.tl = rdp_bits(cmd,32,12);
+    tile.sh = rdp_bits(cmd,12,12);
+    tile.th = rdp_bits(cmd,0,12);
+
+    const u32 s0 = tile.sl >> 2;
+    const u32 t0 = tile.tl >> 2;
+    const u32 s1 = tile.sh >> 2;
+    const u32 t1 = tile.th >> 2;
+
+    if(s1 < s0)
+    {
+        return;
+    }
+
+    const u32 base = tile.tmem * 8;
+
+    for(u32 t = t0; t <= t1; t++)
+    {
+        const u32 row = base + ((t - t0) * tile.line * 8);
+        const u32 swap = ((t - t0) & 1)? 4 : 0;
+        const u32 src = image.addr + image_bytes(image,(t * image.width) + s0);
+
+        if(image.size == 3)
+        {
+            // 32 bit splits into red green in the low half and blue alpha in the high
+            for(u32 s = 0; s <= s1 - s0; s++)
+            {
+                const u32 addr = ((row + (s * 2)) ^ swap) & 0x7ff;
+                const u32 texel = src + (s * 4);
+
+                state.tmem[addr + 0] = src_data.read(texel + 0);
+                state.tmem[addr + 1] = src_data.read(texel + 1);
+                state.tmem[addr + 0x800] = src_data.read(texel + 2);
+                state.tmem[addr + 0x801] = src_data.read(texel + 3);
+            }
+        }
+
+        else
+        {
+            const u32 len = image_bytes(image,s1 - s0 + 1);
+
+            for(u32 i = 0; i < len; i++)
+            {
+                state.tmem[((row + i) ^ swap) & 0xfff] = src_data.read(src + i);
+            }
+        }
+    }
+}
+
+void load_block(RdpState &state, const LoadSource &src_data, u64 cmd)
+{
+    auto &tile = state.tiles[rdp_bits(cmd,24,3)];
+    const auto &image = state.texture_image;
+
+    const u32 sl = rdp_bits(cmd,44,12);
+    const u32 tl = rdp_bits(cmd,32,12);
+    const u32 sh = rdp_bits(cmd,12,12);
+    const u32 dxt = rdp_bits(cmd,0,12);
+
+    tile.sl = sl;
+    tile.tl = tl;
+    tile.sh = sh;
+    tile.th = dxt;
+
+    if(sh < sl)
+    {
+        return;
+    }
+
+    const u32 base = tile.tmem * 8;
+    const u32 src = image.addr + image_bytes(image,(tl * image.width) + sl);
+    const u32 texels = (sh - sl) + 1;
+
+    if(image.size == 3)
+    {
+        for(u32 s = 0; s < texels; s++)
+        {
+            // dxt steps a row every 2048
+            const u32 word = s >> 1;
+            const u32 swap = is_set((word * dxt) >> 11,0)? 4 : 0;
+
+            const u32 addr = ((base + (s * 2)) ^ swap) & 0x7ff;
+            const u32 texel = src + (s * 4);
+
+            state.tmem[addr + 0] = src_data.read(texel + 0);
+            state.tmem[addr + 1] = src_data.read(texel + 1);
+            state.tmem[addr + 0x800] = src_data.read(texel + 2);
+            state.tmem[addr + 0x801] = src_data.read(texel + 3);
+        }
+    }
+
+    else
+    {
+        const u32 len = image_bytes(image,texels);
+
+        for(u32 i = 0; i < len; i++)
+        {
+            const u32 word = i >> 3;
+            const u32 swap = is_set((word * dxt) >> 11,0)? 4 : 0;
+
+            state.tmem[((base + i) ^ swap) & 0xfff] = src_data.read(src + i);
+        }
+    }
+}
+
+void load_tlut(RdpState &state, const LoadSource &src_data, u64 cmd)
+{
+    auto &tile = state.tiles[rdp_bits(cmd,24,3)];
+    const auto &image = state.texture_image;
+
+    tile.sl = rdp_bits(cmd,44,12);
+    tile.tl = rdp_bits(cmd,32,12);
+    tile.sh = rdp_bits(cmd,12,12);
+    tile.th = rdp_bits(cmd,0,12);
+
+    const u32 s0 = tile.sl >> 2;
+    const u32 s1 = tile.sh >> 2;
+    const u32 t0 = tile.tl >> 2;
+
+    if(s1 < s0)
+    {
+        return;
+    }
+
+    const u32 src = image.addr + (((t0 * image.width) + s0) * 2);
+
+    for(u32 i = 0; i <= s1 - s0; i++)
+    {
+        const u8 hi = src_data.read(src + (i * 2));
+        const u8 lo = src_data.read(src + (i * 2) + 1);
+
+        // each entry goes down four times, one for each bank
+        for(u32 j = 0; j < 4; j++)
+        {
+            const u32 addr = ((tile.tmem * 8) + (i * 8) + (j * 2)) & 0xfff;
+
+            state.tmem[addr] = hi;
+            state.tmem[(addr + 1) & 0xfff] = lo;
+        }
+    }
+}
+
+RdpImage decode_image(u64 cmd)
+{
+    RdpImage image;
+
+    image.format = rdp_bits(cmd,53,3);
+    image.size = rdp_bits(cmd,51,2);
+    image.width = rdp_bits(cmd,32,10) + 1;
+    image.addr = rdp_bits(cmd,0,26);
+
+    return image;
+}
+
+void set_tile(RdpState &state, u64 cmd)
+{
+    auto &tile = state.tiles[rdp_bits(cmd,24,3)];
+
+    tile.format = rdp_bits(cmd,53,3);
+    tile.size = rdp_bits(cmd,51,2);
+    tile.line = rdp_bits(cmd,41,9);
+    tile.tmem = rdp_bits(cmd,32,9);
+    tile.palette = rdp_bits(cmd,20,4);
+    tile.clamp_t = is_set(cmd,19);
+    tile.mirror_t = is_set(cmd,18);
+    tile.mask_t = rdp_bits(cmd,14,4);
+    tile.shift_t = rdp_bits(cmd,10,4);
+    tile.clamp_s = is_set(cmd,9);
+    tile.mirror_s = is_set(cmd,8);
+    tile.mask_s = rdp_bits(cmd,4,4);
+    tile.shift_s = rdp_bits(cmd,0,4);
+
+    // ci without a tlut still reads as intensity
+    if(tile.format == FORMAT_CI && tile.size > 1)
+    {
+        tile.format = FORMAT_RGBA;
+    }
+}
+
+inline b32 is_load(u32 id)
+{
+    return id == RDP_LOAD_TLUT || id == RDP_LOAD_BLOCK || id == RDP_LOAD_TILE;
+}
+
+// loads are queued with one more word, the offset of their copied source in load_data
+inline u32 queued_len(u32 id)
+{
+    return rdp_command_len(id) + is_load(id);
+}
+
+LoadSource load_source(const RdpState &state, const u64 *cmd, const u8 *load_data)
+{
+    u32 start = 0;
+    u32 end = 0;
+    load_range(state.texture_image,cmd[0],start,end);
+
+    return LoadSource{load_data + cmd[1],start,end - start};
+}
+
+void execute_command(RdpWorker &worker, N64 &n64, const u64 *cmd, const u8 *load_data)
+{
+    auto &state = worker.state;
+
+    const u64 w = cmd[0];
+    const u32 id = rdp_bits(w,56,6);
+
+    if(id >= RDP_TRIANGLE && id < RDP_TRIANGLE + 8)
+    {
+        draw_triangle(worker,n64,cmd);
+        return;
+    }
+
+    switch(id)
+    {
+        case RDP_TEX_RECT: case RDP_TEX_RECT_FLIP: draw_tex_rect(worker,n64,cmd); break;
+        case RDP_FILL_RECT: draw_fill_rect(worker,n64,w); break;
+
+        case RDP_SET_CONVERT:
+        {
+            state.k4 = rdp_bits(w,9,9);
+            state.k5 = s32(rdp_bits(w,0,9) << 23) >> 23;
+            break;
+        }
+
+        case RDP_SET_SCISSOR:
+        {
+            state.scissor_xh = rdp_bits(w,44,12);
+            state.scissor_yh = rdp_bits(w,32,12);
+            state.scissor_xl = rdp_bits(w,12,12);
+            state.scissor_yl = rdp_bits(w,0,12);
+            break;
+        }
+
+        case RDP_SET_PRIM_DEPTH:
+        {
+            state.prim_z = rdp_bits(w,16,16);
+            state.prim_dz = rdp_bits(w,0,16);
+            break;
+        }
+
+        case RDP_SET_OTHER_MODES: state.other_modes = w; break;
+
+        case RDP_LOAD_TLUT: load_tlut(state,load_source(state,cmd,load_data),w); break;
+        case RDP_LOAD_BLOCK: load_block(state,load_source(state,cmd,load_data),w); break;
+        case RDP_LOAD_TILE: load_tile(state,load_source(state,cmd,load_data),w); break;
+
+        case RDP_SET_TILE_SIZE:
+        {
+            auto &tile = state.tiles[rdp_bits(w,24,3)];
+
+            tile.sl = rdp_bits(w,44,12);
+            tile.tl = rdp_bits(w,32,12);
+            tile.sh = rdp_bits(w,12,12);
+            tile.th = rdp_bits(w,0,12);
+            break;
+        }
+
+        case RDP_SET_TILE: set_tile(state,w); break;
+
+        case RDP_SET_FILL_COLOR: state.fill_color = u32(w); break;
+        case RDP_SET_FOG_COLOR: state.fog_color = u32(w); break;
+        case RDP_SET_BLEND_COLOR: state.blend_color = u32(w); break;
+
+        case RDP_SET_PRIM_COLOR:
+        {
+            state.prim_color = u32(w);
+            state.prim_lod_frac = rdp_bits(w,32,8);
+            break;
+        }
+
+        case RDP_SET_ENV_COLOR: state.env_color = u32(w); break;
+        case RDP_SET_COMBINE: state.combine = w; break;
+        case RDP_SET_TEXTURE_IMAGE: state.texture_image = decode_image(w); break;
+        case RDP_SET_Z_IMAGE: state.z_addr = rdp_bits(w,0,26); break;
+        case RDP_SET_COLOR_IMAGE: state.color_image = decode_image(w); break;
+
+        // syncs and chroma key dont do anything here
+        default: break;
+    }
+}
+
+Rasterizer::Rasterizer()
+{
+    workers.resize(1);
+}
+
+Rasterizer::~Rasterizer()
+{
+    stop();
+}
+
+void Rasterizer::set_threads(u32 threads)
+{
+    stop();
+
+    // every worker has replayed the same commands so any of them has the current state
+    const RdpState state = workers[0].state;
+
+    const u32 count = std::max(threads,1u);
+    workers.resize(count);
+
+    for(u32 i = 0; i < count; i++)
+    {
+        workers[i].state = state;
+        workers[i].id = i;
+        workers[i].count = count;
+    }
+
+    if(!threads)
+    {
+        return;
+    }
+
+    for(u32 i = 0; i < threads; i++)
+    {
+        this->threads.emplace_back(&Rasterizer::worker_main,this,i);
+    }
+}
+
+void Rasterizer::stop()
+{
+    if(threads.empty())
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock(mutex);
+        quit = true;
+    }
+
+    work_cv.notify_all();
+
+    for(auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    threads.clear();
+
+    quit = false;
+    error = nullptr;
+}
+
+void Rasterizer::reset()
+{
+    commands.clear();
+    load_data.clear();
+    partial_len = 0;
+
+    write_start = 0xffff'ffff;
+    write_end = 0;
+
+    color_image = {};
+    texture_image = {};
+    z_addr = 0;
+    scissor_yh = 0;
+    scissor_yl = 0;
+
+    for(auto &worker : workers)
+    {
+        worker.state = {};
+    }
+}
+
+void Rasterizer::run_worker(u32 id)
+{
+    auto &worker = workers[id];
+
+    for(size_t i = 0; i < commands.size(); i += queued_len(rdp_bits(commands[i],56,6)))
+    {
+        execute_command(worker,*job,&commands[i],load_data.data());
+    }
+}
+
+void Rasterizer::flush(N64 &n64)
+{
+    if(commands.empty())
+    {
+        return;
+    }
+
+    job = &n64;
+
+    std::exception_ptr ex = nullptr;
+
+    if(threads.empty())
+    {
+        try
+        {
+            run_worker(0);
+        }
+
+        catch(...)
+        {
+            ex = std::current_exception();
+        }
+    }
+
+    else
+    {
+        {
+            std::scoped_lock lock(mutex);
+            generation++;
+            done = 0;
+        }
+
+        work_cv.notify_all();
+
+        std::unique_lock lock(mutex);
+
+        done_cv.wait(lock,[this]()
+        {
+            return done == threads.size();
+        });
+
+        ex = error;
+        error = nullptr;
+    }
+
+    // workers wrote straight into rdram, drop any code decoded out of it
+    for(u32 addr = write_start & ~(InstrCache::PAGE_SIZE - 1); addr < write_end; addr += InstrCache::PAGE_SIZE)
+    {
+        invalidate_instr_cache(n64,addr & RDRAM_MASK);
+    }
+
+    commands.clear();
+    load_data.clear();
+
+    write_start = 0xffff'ffff;
+    write_end = 0;
+
+    if(ex)
+    {
+        std::rethrow_exception(ex);
+    }
+}
+
+void Rasterizer::worker_main(u32 id)
+{
+    u32 seen = 0;
+
+    std::unique_lock lock(mutex);
+
+    for(;;)
+    {
+        work_cv.wait(lock,[this,seen]()
+        {
+            return quit || generation != seen;
+        });
+
+        if(quit)
+        {
+            return;
+        }
+
+        seen = generation;
+
+        lock.unlock();
+
+        std::exception_ptr ex = nullptr;
+
+        try
+        {
+            run_worker(id);
+        }
+
+        catch(...)
+        {
+            ex = std::current_exception();
+        }
+
+        lock.lock();
+
+        if(ex && !error)
+        {
+            error = ex;
+        }
+
+        done++;
+
+        if(done == threads.size())
+        {
+            done_cv.notify_all();
+        }
+    }
+}
+
+inline b32 overlaps(u32 start, u32 end, u32 other_start, u32 other_end)
+{
+    return start < other_end && other_start < end;
+}
+
+void Rasterizer::push(N64 &n64, const u64 *cmd, u32 len)
+{
+    const u64 w = cmd[0];
+    const u32 id = rdp_bits(w,56,6);
+
+    const b32 draw = (id >= RDP_TRIANGLE && id < RDP_TRIANGLE + 8) || id == RDP_TEX_RECT || id == RDP_TEX_RECT_FLIP || id == RDP_FILL_RECT;
+    const b32 load = is_load(id);
+
+    if(draw)
+    {
+        const u32 stride = image_bytes(color_image,color_image.width);
+
+        u32 start = color_image.addr + ((scissor_yh >> 2) * stride);
+        u32 end = color_image.addr + (((scissor_yl >> 2) + 1) * stride);
+
+        // z image is the same size as the color one
+        if(z_addr)
+        {
+            const u32 z_stride = color_image.width * 2;
+
+            start = std::min(start,z_addr + ((scissor_yh >> 2) * z_stride));
+            end = std::max(end,z_addr + (((scissor_yl >> 2) + 1) * z_stride));
+        }
+
+        write_start = std::min(write_start,start);
+        write_end = std::max(write_end,end);
+    }
+
+    // the source is copied now, so later cpu or dma writes cant change what the load sees
+    // every band has to be drawn first if the load reads back what they draw
+    else if(load)
+    {
+        u32 start = 0;
+        u32 end = 0;
+        load_range(texture_image,w,start,end);
+
+        if(overlaps(start,end,write_start,write_end))
+        {
+            flush(n64);
+        }
+
+        const u8 *rdram = n64.mem.rd_ram.data();
+        const size_t offset = load_data.size();
+
+        for(u32 addr = start; addr < end; addr++)
+        {
+            load_data.push_back(rdram[(addr & RDRAM_MASK) ^ 3]);
+        }
+
+        commands.insert(commands.end(),cmd,cmd + len);
+        commands.push_back(offset);
+        return;
+    }
+
+    switch(id)
+    {
+        case RDP_SET_SCISSOR:
+        {
+            scissor_yh = rdp_bits(w,32,12);
+            scissor_yl = rdp_bits(w,0,12);
+            break;
+        }
+
+        case RDP_SET_TEXTURE_IMAGE: texture_image = decode_image(w); break;
+        case RDP_SET_Z_IMAGE: z_addr = rdp_bits(w,0,26); break;
+        case RDP_SET_COLOR_IMAGE: color_image = decode_image(w); break;
+    }
+
+    commands.insert(commands.end(),cmd,cmd + len);
+
+    if(id == RDP_SYNC_FULL)
+    {
+        flush(n64);
+        set_mi_interrupt(n64,DP_INTR_BIT);
+    }
+}
+
+void process_dp_commands(N64 &n64)
+{
+    auto &dp = n64.mem.dp_regs;
+    auto &raster = n64.rdp.raster;
+
+    while(dp.current < dp.end)
+    {
+        const u64 v = dp.xbus? handle_read_n64<u64>(n64.mem.sp_dmem,dp.current & 0xff8) : handle_read_n64<u64>(n64.mem.rd_ram,dp.current & 0x7f'fff8);
+        dp.current += 8;
+
+        // a command can be split across submissions
+        raster.partial[raster.partial_len++] = v;
+
+        const u32 len = rdp_command_len(rdp_bits(raster.partial[0],56,6));
+
+        if(raster.partial_len == len)
+        {
+            raster.push(n64,raster.partial,len);
+            raster.partial_len = 0;
+        }
+    }
+}
+
+void set_rdp_threads(N64 &n64, u32 threads)
+{
+    n64.rdp.raster.set_threads(threads);
+}
+
+}
@@ -19,6 +19,8 @@ void reset_rdp(N64 &n64)
     n64.rdp.line_cycles = N64_CLOCK_CYCLES_FRAME / n64.rdp.scan_lines;
     n64.rdp.ly = 0;
 
+    n64.rdp.raster.reset();
+
     insert_line_event(n64);
 }
 
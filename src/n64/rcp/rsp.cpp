@@ -0,0 +1,308 @@
+#include <n64/n64.h>
+
+#include <n64/rcp/rsp_vector.cpp>
+
+namespace nintendo64
+{
+
+void reset_rsp(N64 &n64)
+{
+    n64.rsp = {};
+}
+
+void insert_rsp_event(N64 &n64)
+{
+    const auto event = n64.scheduler.create_event(RSP_SLICE,n64_event::rsp);
+    n64.scheduler.insert(event,false);
+}
+
+void start_rsp(N64 &n64)
+{
+    // always a fresh slice, time spent halted must not be run
+    n64.rsp.cycle_frac = 0;
+    insert_rsp_event(n64);
+}
+
+void stop_rsp(N64 &n64)
+{
+    // when the rsp halts itself the slice just ends early
+    if(!n64.rsp.running)
+    {
+        n64.scheduler.remove(n64_event::rsp,true);
+    }
+}
+
+template<typename access_type>
+access_type read_rsp_dmem(N64 &n64, u32 addr)
+{
+    addr &= 0xfff;
+
+    if((addr & (sizeof(access_type) - 1)) == 0)
+    {
+        return handle_read_n64<access_type>(n64.mem.sp_dmem,addr);
+    }
+
+    // unaligned accesses are fine and wrap around dmem
+    access_type v = 0;
+
+    for(u32 i = 0; i < sizeof(access_type); i++)
+    {
+        v = (v << 8) | read_dmem_u8(n64.mem.sp_dmem.data(),addr + i);
+    }
+
+    return v;
+}
+
+template<typename access_type>
+void write_rsp_dmem(N64 &n64, u32 addr, access_type v)
+{
+    addr &= 0xfff;
+
+    if((addr & (sizeof(access_type) - 1)) == 0)
+    {
+        handle_write_n64<access_type>(n64.mem.sp_dmem,addr,v);
+        return;
+    }
+
+    for(u32 i = 0; i < sizeof(access_type); i++)
+    {
+        const u32 shift = (sizeof(access_type) - 1 - i) * 8;
+        write_dmem_u8(n64.mem.sp_dmem.data(),addr + i,v >> shift);
+    }
+}
+
+// status and dma regs are mapped over cop0 0-7, the dp command regs over 8-15
+u32 read_rsp_cop0(N64 &n64, u32 reg)
+{
+    reg &= 0xf;
+
+    if(reg < 8)
+    {
+        return read_sp_regs(n64,0x0404'0000 + (reg * 4));
+    }
+
+    return read_physical<u32>(n64,0x0410'0000 + ((reg - 8) * 4));
+}
+
+void write_rsp_cop0(N64 &n64, u32 reg, u32 v)
+{
+    reg &= 0xf;
+
+    if(reg < 8)
+    {
+        write_sp_regs(n64,0x0404'0000 + (reg * 4),v);
+    }
+
+    else
+    {
+        write_physical<u32>(n64,0x0410'0000 + ((reg - 8) * 4),v);
+    }
+}
+
+void rsp_branch(Rsp &rsp, u32 op, b32 cond)
+{
+    if(cond)
+    {
+        // relative to the delay slot
+        rsp.pc_next = (rsp.pc + (s32(s16(op)) << 2)) & 0xffc;
+    }
+}
+
+void rsp_link(Rsp &rsp, u32 reg)
+{
+    rsp.regs[reg] = (rsp.pc + 4) & 0xffc;
+}
+
+void rsp_unknown_opcode(Rsp &rsp, u32 op)
+{
+    const auto err = fmt::format("[rsp {:03x}] unknown opcode {:08x}\n",(rsp.pc - 4) & 0xffc,op);
+    throw std::runtime_error(err);
+}
+
+void rsp_break(N64 &n64)
+{
+    auto &sp = n64.mem.sp_regs;
+
+    sp.halt = true;
+    sp.broke = true;
+
+    if(sp.intr_on_break)
+    {
+        set_mi_interrupt(n64,SP_INTR_BIT);
+    }
+}
+
+void instr_rsp_special(N64 &n64, u32 op)
+{
+    auto &rsp = n64.rsp;
+    auto &regs = rsp.regs;
+
+    const u32 rs = (op >> 21) & 0x1f;
+    const u32 rt = (op >> 16) & 0x1f;
+    const u32 rd = (op >> 11) & 0x1f;
+    const u32 sa = (op >> 6) & 0x1f;
+
+    switch(op & 0x3f)
+    {
+        case 0x00: regs[rd] = regs[rt] << sa; break;
+        case 0x02: regs[rd] = regs[rt] >> sa; break;
+        case 0x03: regs[rd] = s32(regs[rt]) >> sa; break;
+        case 0x04: regs[rd] = regs[rt] << (regs[rs] & 0x1f); break;
+        case 0x06: regs[rd] = regs[rt] >> (regs[rs] & 0x1f); break;
+        case 0x07: regs[rd] = s32(regs[rt]) >> (regs[rs] & 0x1f); break;
+
+        case 0x08: rsp.pc_next = regs[rs] & 0xffc; break;
+
+        case 0x09:
+        {
+            const u32 target = regs[rs] & 0xffc;
+            rsp_link(rsp,rd);
+            rsp.pc_next = target;
+            break;
+        }
+
+        case 0x0d: rsp_break(n64); break;
+
+        // no overflow exceptions on the rsp
+        case 0x20: case 0x21: regs[rd] = regs[rs] + regs[rt]; break;
+        case 0x22: case 0x23: regs[rd] = regs[rs] - regs[rt]; break;
+        case 0x24: regs[rd] = regs[rs] & regs[rt]; break;
+        case 0x25: regs[rd] = regs[rs] | regs[rt]; break;
+        case 0x26: regs[rd] = regs[rs] ^ regs[rt]; break;
+        case 0x27: regs[rd] = ~(regs[rs] | regs[rt]); break;
+        case 0x2a: regs[rd] = s32(regs[rs]) < s32(regs[rt]); break;
+        case 0x2b: regs[rd] = regs[rs] < regs[rt]; break;
+
+        default: rsp_unknown_opcode(rsp,op); break;
+    }
+}
+
+void instr_rsp_regimm(N64 &n64, u32 op)
+{
+    auto &rsp = n64.rsp;
+
+    const u32 rs = (op >> 21) & 0x1f;
+    const s32 v = s32(rsp.regs[rs]);
+
+    switch((op >> 16) & 0x1f)
+    {
+        case 0x00: rsp_branch(rsp,op,v < 0); break;
+        case 0x01: rsp_branch(rsp,op,v >= 0); break;
+        case 0x10: rsp_link(rsp,31); rsp_branch(rsp,op,v < 0); break;
+        case 0x11: rsp_link(rsp,31); rsp_branch(rsp,op,v >= 0); break;
+
+        default: rsp_unknown_opcode(rsp,op); break;
+    }
+}
+
+void instr_rsp_cop0(N64 &n64, u32 op)
+{
+    auto &rsp = n64.rsp;
+
+    const u32 rt = (op >> 16) & 0x1f;
+    const u32 rd = (op >> 11) & 0x1f;
+
+    switch((op >> 21) & 0x1f)
+    {
+        case 0x0: rsp.regs[rt] = read_rsp_cop0(n64,rd); break;
+        case 0x4: write_rsp_cop0(n64,rd,rsp.regs[rt]); break;
+
+        default: rsp_unknown_opcode(rsp,op); break;
+    }
+}
+
+void step_rsp(N64 &n64)
+{
+    auto &rsp = n64.rsp;
+    auto &regs = rsp.regs;
+
+    const u32 op = handle_read_n64<u32>(n64.mem.sp_imem,rsp.pc);
+
+    rsp.pc = rsp.pc_next;
+    rsp.pc_next = (rsp.pc_next + 4) & 0xffc;
+
+    const u32 rs = (op >> 21) & 0x1f;
+    const u32 rt = (op >> 16) & 0x1f;
+    const u32 imm = u16(op);
+    const u32 simm = s32(s16(op));
+
+    const u32 addr = regs[rs] + simm;
+
+    switch(op >> 26)
+    {
+        case 0x00: instr_rsp_special(n64,op); break;
+        case 0x01: instr_rsp_regimm(n64,op); break;
+
+        case 0x02: rsp.pc_next = (op << 2) & 0xffc; break;
+        case 0x03: rsp_link(rsp,31); rsp.pc_next = (op << 2) & 0xffc; break;
+
+        case 0x04: rsp_branch(rsp,op,regs[rs] == regs[rt]); break;
+        case 0x05: rsp_branch(rsp,op,regs[rs] != regs[rt]); break;
+        case 0x06: rsp_branch(rsp,op,s32(regs[rs]) <= 0); break;
+        case 0x07: rsp_branch(rsp,op,s32(regs[rs]) > 0); break;
+
+        case 0x08: case 0x09: regs[rt] = regs[rs] + simm; break;
+        case 0x0a: regs[rt] = s32(regs[rs]) < s32(simm); break;
+        case 0x0b: regs[rt] = regs[rs] < simm; break;
+        case 0x0c: regs[rt] = regs[rs] & imm; break;
+        case 0x0d: regs[rt] = regs[rs] | imm; break;
+        case 0x0e: regs[rt] = regs[rs] ^ imm; break;
+        case 0x0f: regs[rt] = imm << 16; break;
+
+        case 0x10: instr_rsp_cop0(n64,op); break;
+        case 0x12: instr_rsp_cop2(rsp,op); break;
+
+        case 0x20: regs[rt] = s32(s8(read_rsp_dmem<u8>(n64,addr))); break;
+        case 0x21: regs[rt] = s32(s16(read_rsp_dmem<u16>(n64,addr))); break;
+        case 0x23: case 0x27: regs[rt] = read_rsp_dmem<u32>(n64,addr); break;
+        case 0x24: regs[rt] = read_rsp_dmem<u8>(n64,addr); break;
+        case 0x25: regs[rt] = read_rsp_dmem<u16>(n64,addr); break;
+
+        case 0x28: write_rsp_dmem<u8>(n64,addr,regs[rt]); break;
+        case 0x29: write_rsp_dmem<u16>(n64,addr,regs[rt]); break;
+        case 0x2b: write_rsp_dmem<u32>(n64,addr,regs[rt]); break;
+
+        case 0x32: instr_rsp_lwc2(rsp,n64.mem.sp_dmem.data(),op); break;
+        case 0x3a: instr_rsp_swc2(rsp,n64.mem.sp_dmem.data(),op); break;
+
+        default: rsp_unknown_opcode(rsp,op); break;
+    }
+
+    regs[0] = 0;
+}
+
+void run_rsp(N64 &n64, u32 cycles)
+{
+    auto &sp = n64.mem.sp_regs;
+
+    // assume 1 CPI
+    for(u32 i = 0; i < cycles && !sp.halt; i++)
+    {
+        step_rsp(n64);
+
+        if(sp.single_step)
+        {
+            sp.halt = true;
+        }
+    }
+}
+
+void rsp_event(N64 &n64, u32 cycles)
+{
+    auto &rsp = n64.rsp;
+
+    // rsp is clocked at 2/3 of the cpu
+    const u32 total = (cycles * 2) + rsp.cycle_frac;
+    rsp.cycle_frac = total % 3;
+
+    rsp.running = true;
+    run_rsp(n64,total / 3);
+    rsp.running = false;
+
+    if(!n64.mem.sp_regs.halt)
+    {
+        insert_rsp_event(n64);
+    }
+}
+
+}
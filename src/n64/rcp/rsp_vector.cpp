@@ -0,0 +1,1710 @@
+#ifdef RSP_SIMD
+#include <smmintrin.h>
+#endif
+
+namespace nintendo64
+{
+
+// lanes read for each element select of a computational op
+static constexpr u8 ELEMENT_SELECT[16][8] =
+{
+    {0,1,2,3,4,5,6,7},
+    {0,1,2,3,4,5,6,7},
+    {0,0,2,2,4,4,6,6},
+    {1,1,3,3,5,5,7,7},
+    {0,0,0,0,4,4,4,4},
+    {1,1,1,1,5,5,5,5},
+    {2,2,2,2,6,6,6,6},
+    {3,3,3,3,7,7,7,7},
+    {0,0,0,0,0,0,0,0},
+    {1,1,1,1,1,1,1,1},
+    {2,2,2,2,2,2,2,2},
+    {3,3,3,3,3,3,3,3},
+    {4,4,4,4,4,4,4,4},
+    {5,5,5,5,5,5,5,5},
+    {6,6,6,6,6,6,6,6},
+    {7,7,7,7,7,7,7,7},
+};
+
+u8 read_dmem_u8(const u8 *dmem, u32 addr)
+{
+    return dmem[(addr & 0xfff) ^ 3];
+}
+
+void write_dmem_u8(u8 *dmem, u32 addr, u8 v)
+{
+    dmem[(addr & 0xfff) ^ 3] = v;
+}
+
+// bytes of a vector reg as they appear in memory, byte 0 is the top of element 0
+u8 get_vbyte(const VReg &reg, u32 idx)
+{
+    const u16 v = reg.e[(idx >> 1) & 7];
+    return is_set(idx,0)? u8(v) : u8(v >> 8);
+}
+
+void set_vbyte(VReg &reg, u32 idx, u8 v)
+{
+    u16 &e = reg.e[(idx >> 1) & 7];
+    e = is_set(idx,0)? ((e & 0xff00) | v) : ((e & 0x00ff) | (v << 8));
+}
+
+inline u16 vflag(b32 cond)
+{
+    return cond? 0xffff : 0;
+}
+
+inline u16 clamp_s16(s32 v)
+{
+    return u16(std::clamp(v,-32768,32767));
+}
+
+// accumulator as a signed 48 bit value
+s64 get_acc(const Rsp &rsp, u32 n)
+{
+    const u64 v = (u64(rsp.acc_hi.e[n]) << 32) | (u64(rsp.acc_md.e[n]) << 16) | rsp.acc_lo.e[n];
+    return s64(v << 16) >> 16;
+}
+
+void set_acc(Rsp &rsp, u32 n, s64 v)
+{
+    rsp.acc_hi.e[n] = u16(v >> 32);
+    rsp.acc_md.e[n] = u16(v >> 16);
+    rsp.acc_lo.e[n] = u16(v);
+}
+
+// the md or lo slice when the accumulator fits in 16 bits, else the clamp for its sign
+u16 saturate_acc(const Rsp &rsp, u32 n, b32 md, u16 negative, u16 positive)
+{
+    const s16 hi = rsp.acc_hi.e[n];
+    const s16 mid = rsp.acc_md.e[n];
+
+    if(hi != (mid >> 15))
+    {
+        return hi < 0? negative : positive;
+    }
+
+    return md? rsp.acc_md.e[n] : rsp.acc_lo.e[n];
+}
+
+u16 saturate_acc_unsigned(const Rsp &rsp, u32 n)
+{
+    const s16 hi = rsp.acc_hi.e[n];
+    const s16 mid = rsp.acc_md.e[n];
+
+    if(hi < 0)
+    {
+        return 0;
+    }
+
+    if(hi != 0 || mid < 0)
+    {
+        return 0xffff;
+    }
+
+    return rsp.acc_md.e[n];
+}
+
+#ifdef RSP_SIMD
+
+// a vector reg fits a single sse reg, so every lane op is one instr
+// wider extensions dont buy anything here
+using Vec = __m128i;
+
+inline Vec load_vec(const VReg &reg)
+{
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(reg.e));
+}
+
+inline void store_vec(VReg &reg, Vec v)
+{
+    _mm_store_si128(reinterpret_cast<__m128i*>(reg.e),v);
+}
+
+struct SelectShuffle
+{
+    constexpr SelectShuffle() : mask()
+    {
+        for(u32 e = 0; e < 16; e++)
+        {
+            for(u32 i = 0; i < 8; i++)
+            {
+                mask[e][(i * 2) + 0] = (ELEMENT_SELECT[e][i] * 2) + 0;
+                mask[e][(i * 2) + 1] = (ELEMENT_SELECT[e][i] * 2) + 1;
+            }
+        }
+    }
+
+    alignas(16) u8 mask[16][16];
+};
+
+static constexpr SelectShuffle SELECT_SHUFFLE;
+
+inline Vec select_element(Vec v, u32 e)
+{
+    return _mm_shuffle_epi8(v,_mm_load_si128(reinterpret_cast<const __m128i*>(SELECT_SHUFFLE.mask[e])));
+}
+
+inline Vec ones()
+{
+    return _mm_set1_epi16(-1);
+}
+
+// 1 in each lane where a + b carried out of 16 bits
+inline Vec carry_out(Vec a, Vec b, Vec sum)
+{
+    const Vec carry = _mm_or_si128(_mm_and_si128(a,b),_mm_andnot_si128(sum,_mm_or_si128(a,b)));
+    return _mm_srli_epi16(carry,15);
+}
+
+void set_acc(Rsp &rsp, Vec hi, Vec md, Vec lo)
+{
+    store_vec(rsp.acc_hi,hi);
+    store_vec(rsp.acc_md,md);
+    store_vec(rsp.acc_lo,lo);
+}
+
+// add a 48 bit product to the accumulator
+void add_acc(Rsp &rsp, Vec hi, Vec md, Vec lo)
+{
+    const Vec acc_lo = load_vec(rsp.acc_lo);
+    const Vec acc_md = load_vec(rsp.acc_md);
+    const Vec acc_hi = load_vec(rsp.acc_hi);
+
+    const Vec sum_lo = _mm_add_epi16(acc_lo,lo);
+    const Vec carry_lo = carry_out(acc_lo,lo,sum_lo);
+
+    const Vec sum_md = _mm_add_epi16(acc_md,md);
+    const Vec carry_md = carry_out(acc_md,md,sum_md);
+
+    // the carry in only ripples through when the md sum is all ones
+    const Vec carry_ripple = _mm_and_si128(carry_lo,_mm_cmpeq_epi16(sum_md,ones()));
+
+    const Vec sum_hi = _mm_add_epi16(_mm_add_epi16(acc_hi,hi),_mm_add_epi16(carry_md,carry_ripple));
+
+    set_acc(rsp,sum_hi,_mm_add_epi16(sum_md,carry_lo),sum_lo);
+}
+
+// signed clamp of hi:md
+inline Vec clamp_md(Vec hi, Vec md)
+{
+    return _mm_packs_epi32(_mm_unpacklo_epi16(md,hi),_mm_unpackhi_epi16(md,hi));
+}
+
+// lo when hi:md:lo fits in 16 bits, else 0 or 0xffff by sign
+inline Vec clamp_lo(Vec hi, Vec md, Vec lo)
+{
+    const Vec fits = _mm_cmpeq_epi16(hi,_mm_srai_epi16(md,15));
+    const Vec outside = _mm_xor_si128(_mm_srai_epi16(hi,15),ones());
+
+    return _mm_blendv_epi8(outside,lo,fits);
+}
+
+inline Vec clamp_unsigned(Vec hi, Vec md)
+{
+    const Vec negative = _mm_srai_epi16(hi,15);
+    const Vec over = _mm_or_si128(_mm_xor_si128(_mm_cmpeq_epi16(hi,_mm_setzero_si128()),ones()),_mm_srai_epi16(md,15));
+
+    return _mm_andnot_si128(negative,_mm_or_si128(md,over));
+}
+
+Vec acc_clamp_md(const Rsp &rsp)
+{
+    return clamp_md(load_vec(rsp.acc_hi),load_vec(rsp.acc_md));
+}
+
+Vec acc_clamp_lo(const Rsp &rsp)
+{
+    return clamp_lo(load_vec(rsp.acc_hi),load_vec(rsp.acc_md),load_vec(rsp.acc_lo));
+}
+
+// signed 32 bit product of signed vs and unsigned vt, as md:lo
+inline Vec mul_hi_su(Vec vs, Vec vt)
+{
+    return _mm_sub_epi16(_mm_mulhi_epu16(vs,vt),_mm_and_si128(_mm_srai_epi16(vs,15),vt));
+}
+
+template<const b32 accumulate, const b32 clamp_unsigned_result>
+Vec vmulf(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec lo = _mm_mullo_epi16(vs,vt);
+    const Vec hi = _mm_mulhi_epi16(vs,vt);
+
+    // double the product
+    const Vec lo2 = _mm_slli_epi16(lo,1);
+    const Vec md2 = _mm_or_si128(_mm_slli_epi16(hi,1),_mm_srli_epi16(lo,15));
+    const Vec hi2 = _mm_srai_epi16(hi,15);
+
+    if constexpr(accumulate)
+    {
+        add_acc(rsp,hi2,md2,lo2);
+    }
+
+    // round by adding 0x8000
+    else
+    {
+        const Vec carry_lo = _mm_srli_epi16(lo2,15);
+        const Vec carry_md = _mm_and_si128(carry_lo,_mm_cmpeq_epi16(md2,ones()));
+
+        set_acc(rsp,_mm_add_epi16(hi2,carry_md),_mm_add_epi16(md2,carry_lo),_mm_xor_si128(lo2,_mm_set1_epi16(-0x8000)));
+    }
+
+    if constexpr(clamp_unsigned_result)
+    {
+        return clamp_unsigned(load_vec(rsp.acc_hi),load_vec(rsp.acc_md));
+    }
+
+    return acc_clamp_md(rsp);
+}
+
+template<const b32 accumulate>
+Vec vmudl(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec lo = _mm_mulhi_epu16(vs,vt);
+    const Vec zero = _mm_setzero_si128();
+
+    if constexpr(accumulate)
+    {
+        add_acc(rsp,zero,zero,lo);
+        return acc_clamp_lo(rsp);
+    }
+
+    set_acc(rsp,zero,zero,lo);
+    return lo;
+}
+
+template<const b32 accumulate>
+Vec vmudm(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec lo = _mm_mullo_epi16(vs,vt);
+    const Vec md = mul_hi_su(vs,vt);
+    const Vec hi = _mm_srai_epi16(md,15);
+
+    if constexpr(accumulate)
+    {
+        add_acc(rsp,hi,md,lo);
+        return acc_clamp_md(rsp);
+    }
+
+    set_acc(rsp,hi,md,lo);
+    return md;
+}
+
+template<const b32 accumulate>
+Vec vmudn(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec lo = _mm_mullo_epi16(vs,vt);
+    const Vec md = mul_hi_su(vt,vs);
+    const Vec hi = _mm_srai_epi16(md,15);
+
+    if constexpr(accumulate)
+    {
+        add_acc(rsp,hi,md,lo);
+    }
+
+    else
+    {
+        set_acc(rsp,hi,md,lo);
+    }
+
+    return acc_clamp_lo(rsp);
+}
+
+template<const b32 accumulate>
+Vec vmudh(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec md = _mm_mullo_epi16(vs,vt);
+    const Vec hi = _mm_mulhi_epi16(vs,vt);
+    const Vec zero = _mm_setzero_si128();
+
+    if constexpr(accumulate)
+    {
+        add_acc(rsp,hi,md,zero);
+    }
+
+    else
+    {
+        set_acc(rsp,hi,md,zero);
+    }
+
+    return acc_clamp_md(rsp);
+}
+
+
+Vec vadd(Rsp &rsp, Vec vs, Vec vt)
+{
+    // carry flag is a mask, subtracting it adds one
+    const Vec carry = load_vec(rsp.vco_lo);
+
+    // add the carry to the smaller side first, it can only overflow when the result saturates anyway
+    const Vec min = _mm_subs_epi16(_mm_min_epi16(vs,vt),carry);
+    const Vec max = _mm_max_epi16(vs,vt);
+
+    store_vec(rsp.acc_lo,_mm_sub_epi16(_mm_add_epi16(vs,vt),carry));
+    store_vec(rsp.vco_lo,_mm_setzero_si128());
+    store_vec(rsp.vco_hi,_mm_setzero_si128());
+
+    return _mm_adds_epi16(min,max);
+}
+
+Vec vsub(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec carry = load_vec(rsp.vco_lo);
+
+    const Vec udiff = _mm_sub_epi16(vt,carry);
+    const Vec sdiff = _mm_subs_epi16(vt,carry);
+
+    store_vec(rsp.acc_lo,_mm_sub_epi16(vs,udiff));
+    store_vec(rsp.vco_lo,_mm_setzero_si128());
+    store_vec(rsp.vco_hi,_mm_setzero_si128());
+
+    // vt + carry saturated, take the lost one off afterwards
+    const Vec overflow = _mm_cmpgt_epi16(sdiff,udiff);
+
+    return _mm_adds_epi16(_mm_subs_epi16(vs,sdiff),overflow);
+}
+
+Vec vabs(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec sign = _mm_srai_epi16(vs,15);
+    const Vec zero = _mm_cmpeq_epi16(vs,_mm_setzero_si128());
+    const Vec flip = _mm_xor_si128(vt,sign);
+
+    // negating -0x8000 clamps in the result but wraps in the accumulator
+    store_vec(rsp.acc_lo,_mm_andnot_si128(zero,_mm_sub_epi16(flip,sign)));
+
+    return _mm_andnot_si128(zero,_mm_subs_epi16(flip,sign));
+}
+
+Vec vaddc(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec sum = _mm_add_epi16(vs,vt);
+    const Vec carry = _mm_xor_si128(_mm_cmpeq_epi16(sum,_mm_adds_epu16(vs,vt)),ones());
+
+    store_vec(rsp.acc_lo,sum);
+    store_vec(rsp.vco_lo,carry);
+    store_vec(rsp.vco_hi,_mm_setzero_si128());
+
+    return sum;
+}
+
+Vec vsubc(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec diff = _mm_sub_epi16(vs,vt);
+
+    // unsigned vs < vt
+    const Vec borrow = _mm_xor_si128(_mm_cmpeq_epi16(_mm_subs_epu16(vt,vs),_mm_setzero_si128()),ones());
+    const Vec ne = _mm_xor_si128(_mm_cmpeq_epi16(vs,vt),ones());
+
+    store_vec(rsp.acc_lo,diff);
+    store_vec(rsp.vco_lo,borrow);
+    store_vec(rsp.vco_hi,ne);
+
+    return diff;
+}
+
+// vcc_lo selects vs over vt
+Vec merge_compare(Rsp &rsp, Vec vs, Vec vt, Vec cond)
+{
+    const Vec result = _mm_blendv_epi8(vt,vs,cond);
+
+    store_vec(rsp.vcc_lo,cond);
+    store_vec(rsp.vcc_hi,_mm_setzero_si128());
+    store_vec(rsp.vco_lo,_mm_setzero_si128());
+    store_vec(rsp.vco_hi,_mm_setzero_si128());
+    store_vec(rsp.acc_lo,result);
+
+    return result;
+}
+
+Vec vlt(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec eq = _mm_cmpeq_epi16(vs,vt);
+    const Vec carry_ne = _mm_and_si128(load_vec(rsp.vco_lo),load_vec(rsp.vco_hi));
+
+    return merge_compare(rsp,vs,vt,_mm_or_si128(_mm_cmplt_epi16(vs,vt),_mm_and_si128(eq,carry_ne)));
+}
+
+Vec veq(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec eq = _mm_cmpeq_epi16(vs,vt);
+
+    return merge_compare(rsp,vs,vt,_mm_andnot_si128(load_vec(rsp.vco_hi),eq));
+}
+
+Vec vne(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec ne = _mm_xor_si128(_mm_cmpeq_epi16(vs,vt),ones());
+
+    return merge_compare(rsp,vs,vt,_mm_or_si128(ne,load_vec(rsp.vco_hi)));
+}
+
+Vec vge(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec eq = _mm_cmpeq_epi16(vs,vt);
+    const Vec carry_ne = _mm_and_si128(load_vec(rsp.vco_lo),load_vec(rsp.vco_hi));
+
+    return merge_compare(rsp,vs,vt,_mm_or_si128(_mm_cmpgt_epi16(vs,vt),_mm_andnot_si128(carry_ne,eq)));
+}
+
+Vec vmrg(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec result = _mm_blendv_epi8(vt,vs,load_vec(rsp.vcc_lo));
+
+    store_vec(rsp.acc_lo,result);
+    store_vec(rsp.vco_lo,_mm_setzero_si128());
+    store_vec(rsp.vco_hi,_mm_setzero_si128());
+
+    return result;
+}
+
+Vec vch(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec zero = _mm_setzero_si128();
+
+    // signs differ, clip against -vt
+    const Vec sign = _mm_srai_epi16(_mm_xor_si128(vs,vt),15);
+    const Vec vt_sign = _mm_sub_epi16(_mm_xor_si128(vt,sign),sign);
+
+    const Vec diff = _mm_sub_epi16(vs,vt_sign);
+    const Vec diff_zero = _mm_cmpeq_epi16(diff,zero);
+    const Vec diff_gtz = _mm_cmpgt_epi16(diff,zero);
+    const Vec vt_neg = _mm_cmplt_epi16(vt,zero);
+
+    const Vec ge = _mm_blendv_epi8(_mm_or_si128(diff_gtz,diff_zero),vt_neg,sign);
+    const Vec le = _mm_blendv_epi8(vt_neg,_mm_xor_si128(diff_gtz,ones()),sign);
+
+    const Vec vce = _mm_and_si128(_mm_cmpeq_epi16(diff,sign),sign);
+    const Vec ne = _mm_xor_si128(_mm_or_si128(diff_zero,vce),ones());
+
+    const Vec result = _mm_blendv_epi8(vs,vt_sign,_mm_blendv_epi8(ge,le,sign));
+
+    store_vec(rsp.vcc_lo,le);
+    store_vec(rsp.vcc_hi,ge);
+    store_vec(rsp.vco_lo,sign);
+    store_vec(rsp.vco_hi,ne);
+    store_vec(rsp.vce,vce);
+    store_vec(rsp.acc_lo,result);
+
+    return result;
+}
+
+Vec vcl(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec zero = _mm_setzero_si128();
+
+    // low half of a double precision clip, flags are from the vch on the high half
+    const Vec sign = load_vec(rsp.vco_lo);
+    const Vec ne = load_vec(rsp.vco_hi);
+    const Vec vce = load_vec(rsp.vce);
+
+    const Vec sum = _mm_add_epi16(vs,vt);
+    const Vec sum_zero = _mm_cmpeq_epi16(sum,zero);
+    const Vec no_carry = _mm_cmpeq_epi16(sum,_mm_adds_epu16(vs,vt));
+
+    const Vec le_value = _mm_blendv_epi8(_mm_and_si128(sum_zero,no_carry),_mm_or_si128(sum_zero,no_carry),vce);
+    const Vec ge_value = _mm_cmpeq_epi16(_mm_subs_epu16(vt,vs),zero);
+
+    // only recompute the flag when the high halves were equal
+    const Vec le = _mm_blendv_epi8(load_vec(rsp.vcc_lo),le_value,_mm_andnot_si128(ne,sign));
+    const Vec ge = _mm_blendv_epi8(load_vec(rsp.vcc_hi),ge_value,_mm_xor_si128(_mm_or_si128(ne,sign),ones()));
+
+    const Vec vt_sign = _mm_sub_epi16(_mm_xor_si128(vt,sign),sign);
+    const Vec result = _mm_blendv_epi8(vs,vt_sign,_mm_blendv_epi8(ge,le,sign));
+
+    store_vec(rsp.vcc_lo,le);
+    store_vec(rsp.vcc_hi,ge);
+    store_vec(rsp.vco_lo,zero);
+    store_vec(rsp.vco_hi,zero);
+    store_vec(rsp.vce,zero);
+    store_vec(rsp.acc_lo,result);
+
+    return result;
+}
+
+Vec vcr(Rsp &rsp, Vec vs, Vec vt)
+{
+    const Vec zero = _mm_setzero_si128();
+
+    // ones complement clip
+    const Vec sign = _mm_srai_epi16(_mm_xor_si128(vs,vt),15);
+    const Vec vt_neg = _mm_cmplt_epi16(vt,zero);
+
+    const Vec le = _mm_blendv_epi8(vt_neg,_mm_cmplt_epi16(_mm_add_epi16(vs,vt),zero),sign);
+    const Vec ge = _mm_blendv_epi8(_mm_xor_si128(_mm_cmplt_epi16(_mm_sub_epi16(vs,vt),zero),ones()),vt_neg,sign);
+
+    const Vec result = _mm_blendv_epi8(vs,_mm_xor_si128(vt,sign),_mm_blendv_epi8(ge,le,sign));
+
+    store_vec(rsp.vcc_lo,le);
+    store_vec(rsp.vcc_hi,ge);
+    store_vec(rsp.vco_lo,zero);
+    store_vec(rsp.vco_hi,zero);
+    store_vec(rsp.vce,zero);
+    store_vec(rsp.acc_lo,result);
+
+    return result;
+}
+
+inline Vec vand(Vec vs, Vec vt)
+{
+    return _mm_and_si128(vs,vt);
+}
+
+inline Vec vor(Vec vs, Vec vt)
+{
+    return _mm_or_si128(vs,vt);
+}
+
+inline Vec vxor(Vec vs, Vec vt)
+{
+    return _mm_xor_si128(vs,vt);
+}
+
+inline Vec vnot(Vec v)
+{
+    return _mm_xor_si128(v,ones());
+}
+
+// qword of dmem as a vector, memory is word swapped so each pair of elements is backwards
+inline Vec load_dmem_vec(const u8 *dmem, u32 addr)
+{
+    const Vec v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&dmem[addr]));
+    return _mm_or_si128(_mm_slli_epi32(v,16),_mm_srli_epi32(v,16));
+}
+
+inline void store_dmem_vec(u8 *dmem, u32 addr, Vec v)
+{
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&dmem[addr]),_mm_or_si128(_mm_slli_epi32(v,16),_mm_srli_epi32(v,16)));
+}
+
+#else
+
+using Vec = VReg;
+
+inline Vec load_vec(const VReg &reg)
+{
+    return reg;
+}
+
+inline void store_vec(VReg &reg, const Vec &v)
+{
+    reg = v;
+}
+
+inline Vec select_element(const Vec &v, u32 e)
+{
+    Vec out;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        out.e[n] = v.e[ELEMENT_SELECT[e][n]];
+    }
+
+    return out;
+}
+
+template<const b32 accumulate, const b32 clamp_unsigned_result>
+Vec vmulf(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s64 product = s64(s32(s16(vs.e[n])) * s16(vt.e[n])) * 2;
+
+        set_acc(rsp,n,accumulate? get_acc(rsp,n) + product : product + 0x8000);
+
+        vd.e[n] = clamp_unsigned_result? saturate_acc_unsigned(rsp,n) : saturate_acc(rsp,n,true,0x8000,0x7fff);
+    }
+
+    return vd;
+}
+
+template<const b32 accumulate>
+Vec vmudl(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s64 product = (u32(vs.e[n]) * u32(vt.e[n])) >> 16;
+
+        set_acc(rsp,n,accumulate? get_acc(rsp,n) + product : product);
+        vd.e[n] = saturate_acc(rsp,n,false,0,0xffff);
+    }
+
+    return vd;
+}
+
+template<const b32 accumulate>
+Vec vmudm(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s64 product = s32(s16(vs.e[n])) * s32(vt.e[n]);
+
+        set_acc(rsp,n,accumulate? get_acc(rsp,n) + product : product);
+        vd.e[n] = saturate_acc(rsp,n,true,0x8000,0x7fff);
+    }
+
+    return vd;
+}
+
+template<const b32 accumulate>
+Vec vmudn(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s64 product = s32(vs.e[n]) * s32(s16(vt.e[n]));
+
+        set_acc(rsp,n,accumulate? get_acc(rsp,n) + product : product);
+        vd.e[n] = saturate_acc(rsp,n,false,0,0xffff);
+    }
+
+    return vd;
+}
+
+template<const b32 accumulate>
+Vec vmudh(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s64 product = s64(s32(s16(vs.e[n])) * s16(vt.e[n])) << 16;
+
+        set_acc(rsp,n,accumulate? get_acc(rsp,n) + product : product);
+        vd.e[n] = saturate_acc(rsp,n,true,0x8000,0x7fff);
+    }
+
+    return vd;
+}
+
+Vec vadd(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s32 result = s16(vs.e[n]) + s16(vt.e[n]) + (rsp.vco_lo.e[n] & 1);
+
+        rsp.acc_lo.e[n] = u16(result);
+        vd.e[n] = clamp_s16(result);
+    }
+
+    rsp.vco_lo = {};
+    rsp.vco_hi = {};
+
+    return vd;
+}
+
+Vec vsub(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s32 result = s16(vs.e[n]) - s16(vt.e[n]) - (rsp.vco_lo.e[n] & 1);
+
+        rsp.acc_lo.e[n] = u16(result);
+        vd.e[n] = clamp_s16(result);
+    }
+
+    rsp.vco_lo = {};
+    rsp.vco_hi = {};
+
+    return vd;
+}
+
+Vec vabs(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s16 s = s16(vs.e[n]);
+        const s16 t = s16(vt.e[n]);
+
+        if(s < 0)
+        {
+            // negating -0x8000 clamps in the result but wraps in the accumulator
+            rsp.acc_lo.e[n] = u16(-t);
+            vd.e[n] = clamp_s16(-s32(t));
+        }
+
+        else
+        {
+            rsp.acc_lo.e[n] = s == 0? 0 : u16(t);
+            vd.e[n] = rsp.acc_lo.e[n];
+        }
+    }
+
+    return vd;
+}
+
+Vec vaddc(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const u32 result = u32(vs.e[n]) + u32(vt.e[n]);
+
+        rsp.acc_lo.e[n] = u16(result);
+        rsp.vco_lo.e[n] = vflag(result >> 16);
+        vd.e[n] = u16(result);
+    }
+
+    rsp.vco_hi = {};
+
+    return vd;
+}
+
+Vec vsubc(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s32 result = s32(vs.e[n]) - s32(vt.e[n]);
+
+        rsp.acc_lo.e[n] = u16(result);
+        rsp.vco_lo.e[n] = vflag(result < 0);
+        rsp.vco_hi.e[n] = vflag(result != 0);
+        vd.e[n] = u16(result);
+    }
+
+    return vd;
+}
+
+enum class vector_compare
+{
+    lt,
+    eq,
+    ne,
+    ge,
+};
+
+template<const vector_compare compare>
+Vec vcompare(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s16 s = s16(vs.e[n]);
+        const s16 t = s16(vt.e[n]);
+
+        const b32 carry_ne = rsp.vco_lo.e[n] && rsp.vco_hi.e[n];
+
+        b32 cond = false;
+
+        switch(compare)
+        {
+            case vector_compare::lt: cond = s < t || (s == t && carry_ne); break;
+            case vector_compare::eq: cond = s == t && !rsp.vco_hi.e[n]; break;
+            case vector_compare::ne: cond = s != t || rsp.vco_hi.e[n]; break;
+            case vector_compare::ge: cond = s > t || (s == t && !carry_ne); break;
+        }
+
+        rsp.vcc_lo.e[n] = vflag(cond);
+        rsp.acc_lo.e[n] = cond? vs.e[n] : vt.e[n];
+        vd.e[n] = rsp.acc_lo.e[n];
+    }
+
+    rsp.vcc_hi = {};
+    rsp.vco_lo = {};
+    rsp.vco_hi = {};
+
+    return vd;
+}
+
+Vec vlt(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    return vcompare<vector_compare::lt>(rsp,vs,vt);
+}
+
+Vec veq(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    return vcompare<vector_compare::eq>(rsp,vs,vt);
+}
+
+Vec vne(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    return vcompare<vector_compare::ne>(rsp,vs,vt);
+}
+
+Vec vge(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    return vcompare<vector_compare::ge>(rsp,vs,vt);
+}
+
+Vec vmrg(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        rsp.acc_lo.e[n] = rsp.vcc_lo.e[n]? vs.e[n] : vt.e[n];
+        vd.e[n] = rsp.acc_lo.e[n];
+    }
+
+    rsp.vco_lo = {};
+    rsp.vco_hi = {};
+
+    return vd;
+}
+
+Vec vch(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s16 s = s16(vs.e[n]);
+        const s16 t = s16(vt.e[n]);
+
+        // signs differ, clip against -vt
+        const b32 sign = (s ^ t) < 0;
+        const u16 t_sign = sign? u16(-t) : u16(t);
+        const s16 diff = s16(s - t_sign);
+
+        const b32 ge = sign? t < 0 : diff >= 0;
+        const b32 le = sign? diff <= 0 : t < 0;
+        const b32 vce = sign && diff == -1;
+
+        rsp.vcc_lo.e[n] = vflag(le);
+        rsp.vcc_hi.e[n] = vflag(ge);
+        rsp.vco_lo.e[n] = vflag(sign);
+        rsp.vco_hi.e[n] = vflag(!(diff == 0 || vce));
+        rsp.vce.e[n] = vflag(vce);
+
+        rsp.acc_lo.e[n] = (sign? le : ge)? t_sign : u16(s);
+        vd.e[n] = rsp.acc_lo.e[n];
+    }
+
+    return vd;
+}
+
+Vec vcl(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const u16 s = vs.e[n];
+        const u16 t = vt.e[n];
+
+        // low half of a double precision clip, flags are from the vch on the high half
+        const b32 sign = rsp.vco_lo.e[n];
+        const b32 ne = rsp.vco_hi.e[n];
+
+        b32 le = rsp.vcc_lo.e[n];
+        b32 ge = rsp.vcc_hi.e[n];
+
+        // only recompute the flag when the high halves were equal
+        if(sign && !ne)
+        {
+            const u32 sum = u32(s) + u32(t);
+            const b32 zero = u16(sum) == 0;
+            const b32 carry = sum > 0xffff;
+
+            le = rsp.vce.e[n]? (zero || !carry) : (zero && !carry);
+        }
+
+        else if(!sign && !ne)
+        {
+            ge = s >= t;
+        }
+
+        rsp.vcc_lo.e[n] = vflag(le);
+        rsp.vcc_hi.e[n] = vflag(ge);
+
+        rsp.acc_lo.e[n] = (sign? le : ge)? (sign? u16(-t) : t) : s;
+        vd.e[n] = rsp.acc_lo.e[n];
+    }
+
+    rsp.vco_lo = {};
+    rsp.vco_hi = {};
+    rsp.vce = {};
+
+    return vd;
+}
+
+Vec vcr(Rsp &rsp, const Vec &vs, const Vec &vt)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        const s16 s = s16(vs.e[n]);
+        const s16 t = s16(vt.e[n]);
+
+        // ones complement clip
+        const b32 sign = (s ^ t) < 0;
+
+        const b32 le = sign? (s32(s) + t + 1) <= 0 : t < 0;
+        const b32 ge = sign? t < 0 : (s32(s) - t) >= 0;
+
+        rsp.vcc_lo.e[n] = vflag(le);
+        rsp.vcc_hi.e[n] = vflag(ge);
+
+        rsp.acc_lo.e[n] = (sign? le : ge)? (sign? u16(~t) : u16(t)) : u16(s);
+        vd.e[n] = rsp.acc_lo.e[n];
+    }
+
+    rsp.vco_lo = {};
+    rsp.vco_hi = {};
+    rsp.vce = {};
+
+    return vd;
+}
+
+template<typename FUNC>
+Vec lane_op(const Vec &vs, const Vec &vt, FUNC func)
+{
+    Vec vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        vd.e[n] = func(vs.e[n],vt.e[n]);
+    }
+
+    return vd;
+}
+
+inline Vec vand(const Vec &vs, const Vec &vt)
+{
+    return lane_op(vs,vt,[](u16 s, u16 t) { return u16(s & t); });
+}
+
+inline Vec vor(const Vec &vs, const Vec &vt)
+{
+    return lane_op(vs,vt,[](u16 s, u16 t) { return u16(s | t); });
+}
+
+inline Vec vxor(const Vec &vs, const Vec &vt)
+{
+    return lane_op(vs,vt,[](u16 s, u16 t) { return u16(s ^ t); });
+}
+
+inline Vec vnot(const Vec &v)
+{
+    return lane_op(v,v,[](u16 s, u16 t) { UNUSED(t); return u16(~s); });
+}
+
+#endif
+
+// vrndp / vrndn, the vs field picks if vt is shifted up into the md slice
+template<const b32 positive>
+VReg vrnd(Rsp &rsp, u32 shift, const VReg &vt)
+{
+    VReg vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        s64 product = s16(vt.e[n]);
+
+        if(is_set(shift,0))
+        {
+            product <<= 16;
+        }
+
+        const s64 acc = get_acc(rsp,n);
+
+        if(positive? acc >= 0 : acc < 0)
+        {
+            set_acc(rsp,n,acc + product);
+        }
+
+        vd.e[n] = saturate_acc(rsp,n,true,0x8000,0x7fff);
+    }
+
+    return vd;
+}
+
+VReg vmulq(Rsp &rsp, const VReg &vs, const VReg &vt)
+{
+    VReg vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        s64 product = s64(s32(s16(vs.e[n])) * s16(vt.e[n])) << 16;
+
+        // round towards zero
+        if(product < 0)
+        {
+            product += 31 << 16;
+        }
+
+        set_acc(rsp,n,product);
+
+        // same output stage as vmacq, the acc hi / md pair halved
+        vd.e[n] = clamp_s16(s32(product >> 16) >> 1) & ~15;
+    }
+
+    return vd;
+}
+
+VReg vmacq(Rsp &rsp)
+{
+    VReg vd;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        s32 product = s32((u32(rsp.acc_hi.e[n]) << 16) | rsp.acc_md.e[n]);
+
+        if(product < 0 && !is_set(product,5))
+        {
+            product += 32;
+        }
+
+        else if(product >= 32 && !is_set(product,5))
+        {
+            product -= 32;
+        }
+
+        rsp.acc_hi.e[n] = u16(product >> 16);
+        rsp.acc_md.e[n] = u16(product);
+
+        vd.e[n] = clamp_s16(product >> 1) & ~15;
+    }
+
+    return vd;
+}
+
+VReg vsar(const Rsp &rsp, u32 e)
+{
+    switch(e)
+    {
+        case 8: return rsp.acc_hi;
+        case 9: return rsp.acc_md;
+        case 10: return rsp.acc_lo;
+
+        default: return VReg{};
+    }
+}
+
+struct DivideTables
+{
+    DivideTables()
+    {
+        for(u32 i = 0; i < 512; i++)
+        {
+            // the first entry would need a 17th bit, the rom holds it as all ones
+            const u64 a = i + 512;
+            rcp[i] = u16(std::min((((u64(1) << 34) / a) + 1) >> 8,u64(0x1ffff)));
+        }
+
+        for(u32 i = 0; i < 512; i++)
+        {
+            // largest b where a * b^2 < 2^44
+            const u64 a = (i + 512) >> (i & 1);
+            const u64 limit = u64(1) << 44;
+
+            u64 b = u64(std::sqrt(f64(limit) / f64(a)));
+
+            while(a * b * b >= limit)
+            {
+                b--;
+            }
+
+            while(a * (b + 1) * (b + 1) < limit)
+            {
+                b++;
+            }
+
+            rsq[i] = u16(b >> 1);
+        }
+    }
+
+    u16 rcp[512];
+    u16 rsq[512];
+};
+
+static const DivideTables DIVIDE_TABLES;
+
+// vrcp, vrcpl, vrsq and vrsql
+template<const b32 sqrt, const b32 low>
+void vdivide(Rsp &rsp, VReg &vd, u32 de, u16 in)
+{
+    const s32 input = (low && rsp.div_dp)? s32((u32(u16(rsp.div_in)) << 16) | in) : s32(s16(in));
+    const s32 mask = input >> 31;
+
+    s32 data = input ^ mask;
+
+    if(input > -32768)
+    {
+        data -= mask;
+    }
+
+    u32 result = 0;
+
+    if(data == 0)
+    {
+        result = 0x7fff'ffff;
+    }
+
+    else if(input == -32768)
+    {
+        result = 0xffff'0000;
+    }
+
+    else
+    {
+        const u32 shift = std::countl_zero(u32(data));
+        const u32 idx = ((u64(u32(data)) << shift) & 0x7fc0'0000) >> 22;
+
+        if constexpr(sqrt)
+        {
+            result = (0x10000 | DIVIDE_TABLES.rsq[(idx & 0x1fe) | (shift & 1)]) << 14;
+            result = (result >> ((31 - shift) >> 1)) ^ mask;
+        }
+
+        else
+        {
+            result = (0x10000 | DIVIDE_TABLES.rcp[idx]) << 14;
+            result = (result >> (31 - shift)) ^ mask;
+        }
+    }
+
+    rsp.div_dp = false;
+    rsp.div_out = s16(result >> 16);
+    vd.e[de] = u16(result);
+}
+
+// vrcph and vrsqh, latch the high half for the next low op
+void vdivide_high(Rsp &rsp, VReg &vd, u32 de, u16 in)
+{
+    rsp.div_in = s16(in);
+    rsp.div_dp = true;
+    vd.e[de] = u16(rsp.div_out);
+}
+
+void rsp_unknown_vector_op(u32 op)
+{
+    const auto err = fmt::format("[rsp] unknown vector opcode {:08x}, funct {:x}\n",op,op & 0x3f);
+    throw std::runtime_error(err);
+}
+
+void instr_rsp_vector(Rsp &rsp, u32 op)
+{
+    const u32 e = (op >> 21) & 0xf;
+    const u32 vt_idx = (op >> 16) & 0x1f;
+    const u32 vs_idx = (op >> 11) & 0x1f;
+    const u32 vd_idx = (op >> 6) & 0x1f;
+
+    const Vec vs = load_vec(rsp.vr[vs_idx]);
+    const Vec vt = select_element(load_vec(rsp.vr[vt_idx]),e);
+
+    switch(op & 0x3f)
+    {
+        case 0x00: store_vec(rsp.vr[vd_idx],vmulf<false,false>(rsp,vs,vt)); break;
+        case 0x01: store_vec(rsp.vr[vd_idx],vmulf<false,true>(rsp,vs,vt)); break;
+        case 0x04: store_vec(rsp.vr[vd_idx],vmudl<false>(rsp,vs,vt)); break;
+        case 0x05: store_vec(rsp.vr[vd_idx],vmudm<false>(rsp,vs,vt)); break;
+        case 0x06: store_vec(rsp.vr[vd_idx],vmudn<false>(rsp,vs,vt)); break;
+        case 0x07: store_vec(rsp.vr[vd_idx],vmudh<false>(rsp,vs,vt)); break;
+        case 0x08: store_vec(rsp.vr[vd_idx],vmulf<true,false>(rsp,vs,vt)); break;
+        case 0x09: store_vec(rsp.vr[vd_idx],vmulf<true,true>(rsp,vs,vt)); break;
+        case 0x0c: store_vec(rsp.vr[vd_idx],vmudl<true>(rsp,vs,vt)); break;
+        case 0x0d: store_vec(rsp.vr[vd_idx],vmudm<true>(rsp,vs,vt)); break;
+        case 0x0e: store_vec(rsp.vr[vd_idx],vmudn<true>(rsp,vs,vt)); break;
+        case 0x0f: store_vec(rsp.vr[vd_idx],vmudh<true>(rsp,vs,vt)); break;
+        case 0x10: store_vec(rsp.vr[vd_idx],vadd(rsp,vs,vt)); break;
+        case 0x11: store_vec(rsp.vr[vd_idx],vsub(rsp,vs,vt)); break;
+        case 0x13: store_vec(rsp.vr[vd_idx],vabs(rsp,vs,vt)); break;
+        case 0x14: store_vec(rsp.vr[vd_idx],vaddc(rsp,vs,vt)); break;
+        case 0x15: store_vec(rsp.vr[vd_idx],vsubc(rsp,vs,vt)); break;
+        case 0x20: store_vec(rsp.vr[vd_idx],vlt(rsp,vs,vt)); break;
+        case 0x21: store_vec(rsp.vr[vd_idx],veq(rsp,vs,vt)); break;
+        case 0x22: store_vec(rsp.vr[vd_idx],vne(rsp,vs,vt)); break;
+        case 0x23: store_vec(rsp.vr[vd_idx],vge(rsp,vs,vt)); break;
+        case 0x24: store_vec(rsp.vr[vd_idx],vcl(rsp,vs,vt)); break;
+        case 0x25: store_vec(rsp.vr[vd_idx],vch(rsp,vs,vt)); break;
+        case 0x26: store_vec(rsp.vr[vd_idx],vcr(rsp,vs,vt)); break;
+        case 0x27: store_vec(rsp.vr[vd_idx],vmrg(rsp,vs,vt)); break;
+
+        // logical ops, the accumulator gets the result
+        case 0x28: store_vec(rsp.acc_lo,vand(vs,vt)); rsp.vr[vd_idx] = rsp.acc_lo; break;
+        case 0x29: store_vec(rsp.acc_lo,vnot(vand(vs,vt))); rsp.vr[vd_idx] = rsp.acc_lo; break;
+        case 0x2a: store_vec(rsp.acc_lo,vor(vs,vt)); rsp.vr[vd_idx] = rsp.acc_lo; break;
+        case 0x2b: store_vec(rsp.acc_lo,vnot(vor(vs,vt))); rsp.vr[vd_idx] = rsp.acc_lo; break;
+        case 0x2c: store_vec(rsp.acc_lo,vxor(vs,vt)); rsp.vr[vd_idx] = rsp.acc_lo; break;
+        case 0x2d: store_vec(rsp.acc_lo,vnot(vxor(vs,vt))); rsp.vr[vd_idx] = rsp.acc_lo; break;
+
+        // rare enough to not bother with sse for
+        case 0x02: case 0x0a: case 0x03: case 0x0b: case 0x1d:
+        {
+            VReg vs_reg;
+            VReg vt_reg;
+
+            store_vec(vs_reg,vs);
+            store_vec(vt_reg,vt);
+
+            switch(op & 0x3f)
+            {
+                case 0x02: rsp.vr[vd_idx] = vrnd<true>(rsp,vs_idx,vt_reg); break;
+                case 0x0a: rsp.vr[vd_idx] = vrnd<false>(rsp,vs_idx,vt_reg); break;
+                case 0x03: rsp.vr[vd_idx] = vmulq(rsp,vs_reg,vt_reg); break;
+                case 0x0b: rsp.vr[vd_idx] = vmacq(rsp); break;
+                case 0x1d: rsp.vr[vd_idx] = vsar(rsp,e); break;
+            }
+            break;
+        }
+
+        // single lane ops, the vs field is the lane of vd written
+        case 0x30: case 0x31: case 0x32: case 0x33:
+        case 0x34: case 0x35: case 0x36:
+        {
+            const u32 de = vs_idx & 7;
+            const u16 in = rsp.vr[vt_idx].e[e & 7];
+
+            auto &vd = rsp.vr[vd_idx];
+
+            switch(op & 0x3f)
+            {
+                case 0x30: vdivide<false,false>(rsp,vd,de,in); break;
+                case 0x31: vdivide<false,true>(rsp,vd,de,in); break;
+                case 0x32: vdivide_high(rsp,vd,de,in); break;
+                case 0x34: vdivide<true,false>(rsp,vd,de,in); break;
+                case 0x35: vdivide<true,true>(rsp,vd,de,in); break;
+                case 0x36: vdivide_high(rsp,vd,de,in); break;
+            }
+
+            store_vec(rsp.acc_lo,vt);
+
+            // vmov
+            if((op & 0x3f) == 0x33)
+            {
+                vd.e[de] = rsp.acc_lo.e[de];
+            }
+            break;
+        }
+
+        // vnop, vnull
+        case 0x37: case 0x3f: break;
+
+        default: rsp_unknown_vector_op(op); break;
+    }
+}
+
+// mfc2, element is a byte offset and can straddle two lanes
+u32 read_vector_element(const Rsp &rsp, u32 vs, u32 e)
+{
+    const auto &reg = rsp.vr[vs];
+    return sign_extend_type<s32,s16>((get_vbyte(reg,e) << 8) | get_vbyte(reg,(e + 1) & 15));
+}
+
+void write_vector_element(Rsp &rsp, u32 vs, u32 e, u32 v)
+{
+    auto &reg = rsp.vr[vs];
+
+    set_vbyte(reg,e,v >> 8);
+
+    if(e != 15)
+    {
+        set_vbyte(reg,e + 1,v);
+    }
+}
+
+// flag regs pack lane n into bit n, and the hi flag into bit n + 8
+u32 pack_flags(const VReg &lo, const VReg &hi)
+{
+    u32 v = 0;
+
+    for(u32 n = 0; n < 8; n++)
+    {
+        v |= (lo.e[n] & 1) << n;
+        v |= (hi.e[n] & 1) << (n + 8);
+    }
+
+    return v;
+}
+
+void unpack_flags(VReg &lo, VReg &hi, u32 v)
+{
+    for(u32 n = 0; n < 8; n++)
+    {
+        lo.e[n] = vflag(is_set(v,n));
+        hi.e[n] = vflag(is_set(v,n + 8));
+    }
+}
+
+u32 read_vector_control(const Rsp &rsp, u32 rd)
+{
+    switch(rd & 3)
+    {
+        case 0: return sign_extend_type<s32,s16>(pack_flags(rsp.vco_lo,rsp.vco_hi));
+        case 1: return sign_extend_type<s32,s16>(pack_flags(rsp.vcc_lo,rsp.vcc_hi));
+
+        // vce is only 8 bits
+        default: return pack_flags(rsp.vce,VReg{});
+    }
+}
+
+void write_vector_control(Rsp &rsp, u32 rd, u32 v)
+{
+    switch(rd & 3)
+    {
+        case 0: unpack_flags(rsp.vco_lo,rsp.vco_hi,v); break;
+        case 1: unpack_flags(rsp.vcc_lo,rsp.vcc_hi,v); break;
+
+        default:
+        {
+            VReg unused;
+            unpack_flags(rsp.vce,unused,v & 0xff);
+            break;
+        }
+    }
+}
+
+void instr_rsp_cop2(Rsp &rsp, u32 op)
+{
+    // computational ops
+    if(is_set(op,25))
+    {
+        instr_rsp_vector(rsp,op);
+        return;
+    }
+
+    const u32 rt = (op >> 16) & 0x1f;
+    const u32 rd = (op >> 11) & 0x1f;
+    const u32 e = (op >> 7) & 0xf;
+
+    switch((op >> 21) & 0x1f)
+    {
+        case 0x0: rsp.regs[rt] = read_vector_element(rsp,rd,e); break;
+        case 0x2: rsp.regs[rt] = read_vector_control(rsp,rd); break;
+        case 0x4: write_vector_element(rsp,rd,e,rsp.regs[rt]); break;
+        case 0x6: write_vector_control(rsp,rd,rsp.regs[rt]); break;
+
+        default: rsp_unknown_vector_op(op); break;
+    }
+}
+
+// lwc2, the offset is scaled by the access size
+void instr_rsp_lwc2(Rsp &rsp, u8 *dmem, u32 op)
+{
+    const u32 base = rsp.regs[(op >> 21) & 0x1f];
+    const u32 vt = (op >> 16) & 0x1f;
+    const u32 e = (op >> 7) & 0xf;
+    const s32 offset = s32(op << 25) >> 25;
+
+    auto &reg = rsp.vr[vt];
+
+    switch((op >> 11) & 0x1f)
+    {
+        // lbv, lsv, llv, ldv
+        case 0x0: case 0x1: case 0x2: case 0x3:
+        {
+            const u32 size = 1 << ((op >> 11) & 0x1f);
+            const u32 addr = base + (offset * size);
+
+            for(u32 i = 0; i < size && e + i < 16; i++)
+            {
+                set_vbyte(reg,e + i,read_dmem_u8(dmem,addr + i));
+            }
+            break;
+        }
+
+        // lqv, up to the end of the qword
+        case 0x4:
+        {
+            const u32 addr = base + (offset * 16);
+
+#ifdef RSP_SIMD
+            if((addr & 15) == 0 && e == 0)
+            {
+                store_vec(reg,load_dmem_vec(dmem,addr & 0xff0));
+                break;
+            }
+#endif
+
+            const u32 end = 16 - (addr & 15);
+
+            for(u32 i = 0; i < end && e + i < 16; i++)
+            {
+                set_vbyte(reg,e + i,read_dmem_u8(dmem,addr + i));
+            }
+            break;
+        }
+
+        // lrv, from the start of the qword up to addr
+        case 0x5:
+        {
+            u32 addr = base + (offset * 16);
+            const u32 start = e + (16 - (addr & 15));
+
+            addr &= ~15;
+
+            for(u32 i = start; i < 16; i++)
+            {
+                set_vbyte(reg,i,read_dmem_u8(dmem,addr++));
+            }
+            break;
+        }
+
+        // lpv, luv, bytes into the top of each lane
+        case 0x6: case 0x7:
+        {
+            const u32 addr = base + (offset * 8);
+            const u32 idx = (addr & 7) - e;
+            const u32 aligned = addr & ~7;
+            const u32 shift = ((op >> 11) & 0x1f) == 0x6? 8 : 7;
+
+            for(u32 n = 0; n < 8; n++)
+            {
+                reg.e[n] = read_dmem_u8(dmem,aligned + ((idx + n) & 15)) << shift;
+            }
+            break;
+        }
+
+        // lhv, every other byte
+        case 0x8:
+        {
+            const u32 addr = base + (offset * 16);
+            const u32 idx = (addr & 7) - e;
+            const u32 aligned = addr & ~7;
+
+            for(u32 n = 0; n < 8; n++)
+            {
+                reg.e[n] = read_dmem_u8(dmem,aligned + ((idx + (n * 2)) & 15)) << 7;
+            }
+            break;
+        }
+
+        // lfv, every fourth byte into half the reg
+        case 0x9:
+        {
+            const u32 addr = base + (offset * 16);
+            const u32 idx = (addr & 7) - e;
+            const u32 aligned = addr & ~7;
+
+            VReg tmp;
+
+            for(u32 n = 0; n < 4; n++)
+            {
+                tmp.e[n] = read_dmem_u8(dmem,aligned + ((idx + (n * 4)) & 15)) << 7;
+                tmp.e[n + 4] = read_dmem_u8(dmem,aligned + ((idx + (n * 4) + 8) & 15)) << 7;
+            }
+
+            const u32 end = std::min(e + 8,u32(16));
+
+            for(u32 i = e; i < end; i++)
+            {
+                set_vbyte(reg,i,get_vbyte(tmp,i));
+            }
+            break;
+        }
+
+        // lwv, wraps around the reg
+        case 0xa:
+        {
+            u32 addr = base + (offset * 16);
+
+            for(u32 i = 16 - e; i < e + 16; i++)
+            {
+                set_vbyte(reg,i,read_dmem_u8(dmem,addr));
+                addr += 4;
+            }
+            break;
+        }
+
+        // ltv, transposes across a group of 8 regs
+        case 0xb:
+        {
+            u32 addr = base + (offset * 16);
+            const u32 begin = addr & ~7;
+
+            addr = begin + ((e + (addr & 8)) & 15);
+
+            const u32 group = vt & ~7;
+            u32 idx = e >> 1;
+
+            for(u32 n = 0; n < 8; n++)
+            {
+                auto &dst = rsp.vr[group + idx];
+
+                for(u32 b = 0; b < 2; b++)
+                {
+                    set_vbyte(dst,(n * 2) + b,read_dmem_u8(dmem,addr++));
+
+                    if(addr == begin + 16)
+                    {
+                        addr = begin;
+                    }
+                }
+
+                idx = (idx + 1) & 7;
+            }
+            break;
+        }
+
+        default: rsp_unknown_vector_op(op); break;
+    }
+}
+
+void instr_rsp_swc2(Rsp &rsp, u8 *dmem, u32 op)
+{
+    const u32 base = rsp.regs[(op >> 21) & 0x1f];
+    const u32 vt = (op >> 16) & 0x1f;
+    const u32 e = (op >> 7) & 0xf;
+    const s32 offset = s32(op << 25) >> 25;
+
+    const auto &reg = rsp.vr[vt];
+
+    switch((op >> 11) & 0x1f)
+    {
+        // sbv, ssv, slv, sdv
+        case 0x0: case 0x1: case 0x2: case 0x3:
+        {
+            const u32 size = 1 << ((op >> 11) & 0x1f);
+            const u32 addr = base + (offset * size);
+
+            for(u32 i = 0; i < size; i++)
+            {
+                write_dmem_u8(dmem,addr + i,get_vbyte(reg,e + i));
+            }
+            break;
+        }
+
+        // sqv
+        case 0x4:
+        {
+            const u32 addr = base + (offset * 16);
+
+#ifdef RSP_SIMD
+            if((addr & 15) == 0 && e == 0)
+            {
+                store_dmem_vec(dmem,addr & 0xff0,load_vec(reg));
+                break;
+            }
+#endif
+
+            const u32 end = 16 - (addr & 15);
+
+            for(u32 i = 0; i < end; i++)
+            {
+                write_dmem_u8(dmem,addr + i,get_vbyte(reg,e + i));
+            }
+            break;
+        }
+
+        // srv
+        case 0x5:
+        {
+            u32 addr = base + (offset * 16);
+            const u32 len = addr & 15;
+            const u32 shift = 16 - len;
+
+            addr &= ~15;
+
+            for(u32 i = 0; i < len; i++)
+            {
+                write_dmem_u8(dmem,addr + i,get_vbyte(reg,e + i + shift));
+            }
+            break;
+        }
+
+        // spv, suv, top of each lane, lanes past the 8th go the other way
+        case 0x6: case 0x7:
+        {
+            const u32 addr = base + (offset * 8);
+            const b32 packed = ((op >> 11) & 0x1f) == 0x6;
+
+            for(u32 i = 0; i < 8; i++)
+            {
+                const u32 idx = e + i;
+
+                const u8 v = ((idx & 15) < 8) == packed? get_vbyte(reg,(idx & 7) << 1) : u8(reg.e[idx & 7] >> 7);
+                write_dmem_u8(dmem,addr + i,v);
+            }
+            break;
+        }
+
+        // shv
+        case 0x8:
+        {
+            const u32 addr = base + (offset * 16);
+            const u32 idx = addr & 7;
+            const u32 aligned = addr & ~7;
+
+            for(u32 n = 0; n < 8; n++)
+            {
+                const u32 b = e + (n * 2);
+                const u8 v = (get_vbyte(reg,b) << 1) | (get_vbyte(reg,b + 1) >> 7);
+
+                write_dmem_u8(dmem,aligned + ((idx + (n * 2)) & 15),v);
+            }
+            break;
+        }
+
+        // sfv, only some elements select lanes, the rest store zero
+        case 0x9:
+        {
+            const u32 addr = base + (offset * 16);
+            const u32 idx = addr & 7;
+            const u32 aligned = addr & ~7;
+
+            static constexpr s8 SFV_LANES[16][4] =
+            {
+                {0,1,2,3}, {6,7,4,5}, {-1,-1,-1,-1}, {-1,-1,-1,-1},
+                {1,2,3,0}, {7,4,5,6}, {-1,-1,-1,-1}, {-1,-1,-1,-1},
+                {4,5,6,7}, {-1,-1,-1,-1}, {-1,-1,-1,-1}, {3,0,1,2},
+                {5,6,7,4}, {-1,-1,-1,-1}, {-1,-1,-1,-1}, {0,1,2,3},
+            };
+
+            for(u32 n = 0; n < 4; n++)
+            {
+                const s8 lane = SFV_LANES[e][n];
+                const u8 v = lane < 0? 0 : u8(reg.e[lane] >> 7);
+
+                write_dmem_u8(dmem,aligned + ((idx + (n * 4)) & 15),v);
+            }
+            break;
+        }
+
+        // swv, rotated across the qword
+        case 0xa:
+        {
+            const u32 addr = base + (offset * 16);
+            const u32 idx = addr & 7;
+            const u32 aligned = addr & ~7;
+
+            for(u32 i = 0; i < 16; i++)
+            {
+                write_dmem_u8(dmem,aligned + ((idx + i) & 15),get_vbyte(reg,e + i));
+            }
+            break;
+        }
+
+        // stv, transposes out of a group of 8 regs
+        case 0xb:
+        {
+            const u32 addr = base + (offset * 16);
+            const u32 aligned = addr & ~7;
+            const u32 group = vt & ~7;
+
+            u32 b = 16 - (e & ~1);
+            u32 idx = (addr & 7) - (e & ~1);
+
+            for(u32 n = 0; n < 8; n++)
+            {
+                const auto &src = rsp.vr[group + n];
+
+                write_dmem_u8(dmem,aligned + (idx++ & 15),get_vbyte(src,b++));
+                write_dmem_u8(dmem,aligned + (idx++ & 15),get_vbyte(src,b++));
+            }
+            break;
+        }
+
+        default: rsp_unknown_vector_op(op); break;
+    }
+}
+
+}
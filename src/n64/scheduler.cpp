@@ -44,6 +44,12 @@ void N64Scheduler::service_event(const EventNode<n64_event> & node)
             pi_dma_finished(n64);
             break;
         }
+
+        case n64_event::rsp:
+        {
+            rsp_event(n64,cycles_to_tick);
+            break;
+        }
     }
 }
 
@@ -1,5 +1,10 @@
 #include <destoer.h>
 #include <albion/lib.h>
+
+#ifdef FRONTEND_HEADLESS
+#include <frontend/headless/headless.h>
+#endif
+
 #ifndef FRONTEND_HEADLESS 
 
 #ifdef GB_ENABLED
@@ -228,8 +233,615 @@ void n64_run_tests()
 }
 #endif
 
+#endif
+
+// regression tests for fixed bugs
+// these dont need any test roms so they are built under every frontend
+
+struct RegressionTest
+{
+    const char* name;
+    bool (*func)();
+};
+
+#ifdef FRONTEND_HEADLESS
+bool headless_negative_threads_test()
+{
+    // a readable manifest with a single job no core claims
+    // so a run that gets past argument parsing returns 0 without starting a core
+    const auto filename = (std::filesystem::temp_directory_path() / "regression_manifest.txt").string();
+
+    {
+        std::ofstream fp(filename);
+        fp << "regression_unsupported.rom 1\n";
+    }
+
+    const auto run = [&](const char* flag, const char* count)
+    {
+        std::string prog = "emu";
+        std::string flag_str = flag;
+        std::string count_str = count;
+        std::string manifest = filename;
+        char* argv[] = {prog.data(),flag_str.data(),count_str.data(),manifest.data()};
+
+        return headless_main(4,argv);
+    };
+
+    // must be rejected before they are ever converted into a count
+    const bool passed = run("-j","1") == 0 && run("-j","-1") == 1 && run("-j","abc") == 1 && run("-f","-5") == 1;
+
+    std::filesystem::remove(filename);
+
+    return passed;
+}
+#endif
+
+#ifdef GB_ENABLED
+#include <gb/gb.h>
+
+bool gb_rewind_frame_start_test()
+{
+    gameboy::GB gb;
+    gb.reset("",false,false);
+    gb.apu.playback.stop();
+    gb.throttle_emu = false;
+    gb.enable_rewind(1);
+
+    std::vector<u64> frame_start;
+
+    for(int i = 0; i < 5; i++)
+    {
+        frame_start.push_back(gb.scheduler.get_timestamp());
+        gb.run();
+    }
+
+    // each rewind must land back on the start of the frame before it
+    for(int i = 4; i >= 0; i--)
+    {
+        if(!gb.rewind_frame() || gb.scheduler.get_timestamp() != frame_start[i])
+        {
+            return false;
+        }
+    }
+
+    // nothing older than the first frame was recorded
+    return !gb.rewind_frame();
+}
+#endif
+
+#ifdef GBA_ENABLED
+#include <gba/gba.h>
+
+// immediate word dma3 of count words through board wram
+void gba_dma3_words(gameboyadvance::GBA &gba, u32 src, u32 dst, u16 count)
+{
+    gba.mem.write_mem<u32>(0x040000D4,src);
+    gba.mem.write_mem<u32>(0x040000D8,dst);
+    gba.mem.write_mem<u16>(0x040000DC,count);
+    gba.mem.write_mem<u16>(0x040000DE,0x8400);
+}
+
+bool gba_dma_overlap_test()
+{
+    auto gba = std::make_unique<gameboyadvance::GBA>();
+    gba->reset("");
+    gba->apu.playback.stop();
+
+    constexpr u32 BASE = 0x02000000;
+
+    const auto fill = [&]()
+    {
+        for(u32 i = 0; i < 8; i++)
+        {
+            gba->mem.write_mem<u32>(BASE + (i * 4),i + 1);
+        }
+    };
+
+    // a forward copy onto itself keeps reading back what it just wrote
+    // so the first word is smeared across the whole transfer
+    fill();
+    gba_dma3_words(*gba,BASE,BASE + 4,4);
+
+    for(u32 i = 0; i < 5; i++)
+    {
+        if(gba->mem.read_mem<u32>(BASE + (i * 4)) != 1)
+        {
+            return false;
+        }
+    }
+
+    if(gba->mem.read_mem<u32>(BASE + (5 * 4)) != 6)
+    {
+        return false;
+    }
+
+    // copying down over itself is a plain shift
+    fill();
+    gba_dma3_words(*gba,BASE + 4,BASE,4);
+
+    for(u32 i = 0; i < 8; i++)
+    {
+        const u32 expected = i < 4? i + 2 : i + 1;
+
+        if(gba->mem.read_mem<u32>(BASE + (i * 4)) != expected)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+#ifdef N64_ENABLED
+#include <n64/n64.h>
+
+// reset needs a rom to load, a blank one is enough when nothing is run from it
+void n64_reset_blank(nintendo64::N64 &n64)
+{
+    const auto filename = (std::filesystem::temp_directory_path() / "regression_blank.z64").string();
+
+    {
+        std::ofstream fp(filename,std::ios::binary);
+        const std::vector<char> rom(0x1000,0);
+        fp.write(rom.data(),rom.size());
+    }
+
+    nintendo64::reset(n64,filename);
+    std::filesystem::remove(filename);
+}
+
+bool n64_tlb_refill_vector_test()
+{
+    auto n64 = std::make_unique<nintendo64::N64>();
+    n64_reset_blank(*n64);
+
+    auto &cpu = n64->cpu;
+    auto &cop0 = cpu.cop0;
+
+    // 32 bit kernel mode, bev off
+    cop0.status.exl = false;
+    cop0.status.ksu = nintendo64::KERNEL_MODE;
+    cop0.status.kx = false;
+    cop0.status.ds = deset_bit(cop0.status.ds,6);
+
+    // the tlb is empty after reset so any kuseg addr misses
+    const auto miss = [&]()
+    {
+        try
+        {
+            nintendo64::translate_tlb(*n64,0x1000'0000,false);
+        }
+
+        catch(const nintendo64::TlbException &ex)
+        {
+            return ex;
+        }
+
+        return nintendo64::TlbException{};
+    };
+
+    constexpr u64 PC = 0xFFFF'FFFF'8000'1000;
+
+    auto ex = miss();
+
+    if(!ex.refill)
+    {
+        return false;
+    }
+
+    // a miss goes to the refill vector
+    nintendo64::tlb_exception(*n64,ex,PC,PC + 4);
+
+    if(cpu.pc != 0xFFFF'FFFF'8000'0000 || !cop0.status.exl || cop0.epc != PC || cop0.cause.exception_code != ex.code)
+    {
+        return false;
+    }
+
+    // a miss inside the handler goes to the general vector and keeps epc
+    ex = miss();
+    nintendo64::tlb_exception(*n64,ex,PC + 0x100,PC + 0x104);
+
+    if(cpu.pc != 0xFFFF'FFFF'8000'0180 || cop0.epc != PC)
+    {
+        return false;
+    }
+
+    // 64 bit addressing has its own refill vector
+    cop0.status.exl = false;
+    cop0.status.kx = true;
+    ex = miss();
+    nintendo64::tlb_exception(*n64,ex,PC,PC + 4);
+
+    return cpu.pc == 0xFFFF'FFFF'8000'0080;
+}
+
+bool n64_rsp_halt_slice_test()
+{
+    auto n64 = std::make_unique<nintendo64::N64>();
+    n64_reset_blank(*n64);
+
+    // addiu r1, r1, 1; j 0; nop
+    const u32 PROGRAM[] = {0x24210001,0x08000000,0x00000000};
+
+    // words are kept in host order so a plain write is enough
+    for(u32 i = 0; i < 3; i++)
+    {
+        handle_write<u32>(n64->mem.sp_imem,i * 4,PROGRAM[i]);
+    }
+
+    nintendo64::write_sp_regs(*n64,SP_PC,0);
+    nintendo64::write_sp_regs(*n64,SP_STATUS,1);
+
+    // halting part way through a slice runs only what had elapsed
+    // 300 cpu cycles are 200 rsp ones, 67 passes of the loop
+    n64->scheduler.tick(300);
+    nintendo64::write_sp_regs(*n64,SP_STATUS,2);
+
+    if(n64->rsp.regs[1] != 67 || n64->scheduler.get_event_ticks(nintendo64::n64_event::rsp))
+    {
+        return false;
+    }
+
+    // time spent halted must not be run once it starts again
+    n64->scheduler.tick(1000);
+    nintendo64::write_sp_regs(*n64,SP_STATUS,1);
+    n64->scheduler.tick(nintendo64::RSP_SLICE);
+
+    // a full slice is 341 rsp cycles, resuming on the nop leaves 114 more passes
+    return n64->rsp.regs[1] == 67 + 114;
+}
+
+u32 rsp_vector_op(u32 funct, u32 vd, u32 vs, u32 vt, u32 e)
+{
+    return (0x12 << 26) | (1 << 25) | (e << 21) | (vt << 16) | (vs << 11) | (vd << 6) | funct;
+}
+
+bool vreg_equal(const nintendo64::VReg &reg, const nintendo64::VReg &expected)
+{
+    return memcmp(reg.e,expected.e,sizeof(reg.e)) == 0;
+}
+
+// fixed vectors for the multiply ops, the expected outputs were worked out from
+// the hardware rules rather than taken from this core, so both the sse and the scalar
+// path have to match them (build without sse4.1 to run the scalar one)
+bool n64_rsp_vector_mul_test()
+{
+    using nintendo64::VReg;
+
+    nintendo64::Rsp rsp;
+
+    // lanes 0 - 3 are the clamp edges, 0x8000 * 0x8000 is the one product that overflows
+    rsp.vr[1] = VReg{{0x8000,0x8000,0x7fff,0x7fff,0xffff,0x0040,0x1234,0xffe0}};
+    rsp.vr[2] = VReg{{0x8000,0x7fff,0x7fff,0xffff,0xffff,0x0040,0x0010,0x0123}};
+
+    const auto run = [&](u32 funct)
+    {
+        instr_rsp_vector(rsp,rsp_vector_op(funct,3,1,2,0));
+        return rsp.vr[3];
+    };
+
+    // vmulf
+    if(!vreg_equal(run(0x00),VReg{{0x7fff,0x8001,0x7ffe,0xffff,0x0000,0x0000,0x0002,0x0000}})
+        || !vreg_equal(rsp.acc_hi,VReg{{0x0000,0xffff,0x0000,0xffff,0x0000,0x0000,0x0000,0x0000}})
+        || !vreg_equal(rsp.acc_md,VReg{{0x8000,0x8001,0x7ffe,0xffff,0x0000,0x0000,0x0002,0x0000}})
+        || !vreg_equal(rsp.acc_lo,VReg{{0x8000,0x8000,0x8002,0x8002,0x8002,0xa000,0xc680,0x3740}}))
+    {
+        return false;
+    }
+
+    // vmulu, negative goes to zero and 0x8000 * 0x8000 to all ones
+    if(!vreg_equal(run(0x01),VReg{{0xffff,0x0000,0x7ffe,0x0000,0x0000,0x0000,0x0002,0x0000}}))
+    {
+        return false;
+    }
+
+    // vmudh
+    if(!vreg_equal(run(0x07),VReg{{0x7fff,0x8000,0x7fff,0x8001,0x0001,0x1000,0x7fff,0xdba0}}))
+    {
+        return false;
+    }
+
+    // vmacf twice from a clear acc, the second pushes lanes 0 and 1 past 32 bits
+    rsp.acc_hi = {};
+    rsp.acc_md = {};
+    rsp.acc_lo = {};
+
+    if(!vreg_equal(run(0x08),VReg{{0x7fff,0x8001,0x7ffe,0xffff,0x0000,0x0000,0x0002,0xffff}}))
+    {
+        return false;
+    }
+
+    if(!vreg_equal(run(0x08),VReg{{0x7fff,0x8000,0x7fff,0xfffe,0x0000,0x0000,0x0004,0xffff}})
+        || !vreg_equal(rsp.acc_hi,VReg{{0x0001,0xffff,0x0000,0xffff,0x0000,0x0000,0x0000,0xffff}})
+        || !vreg_equal(rsp.acc_md,VReg{{0x0000,0x0002,0xfffc,0xfffe,0x0000,0x0000,0x0004,0xffff}})
+        || !vreg_equal(rsp.acc_lo,VReg{{0x0000,0x0000,0x0004,0x0004,0x0004,0x4000,0x8d00,0x6e80}}))
+    {
+        return false;
+    }
+
+    // vmulq rounds negative products towards zero
+    if(!vreg_equal(run(0x03),VReg{{0x7ff0,0x8000,0x7ff0,0xc010,0x0000,0x0800,0x7ff0,0xedd0}})
+        || !vreg_equal(rsp.acc_hi,VReg{{0x4000,0xc000,0x3fff,0xffff,0x0000,0x0000,0x0001,0xffff}})
+        || !vreg_equal(rsp.acc_md,VReg{{0x0000,0x801f,0x0001,0x8020,0x0001,0x1000,0x2340,0xdbbf}}))
+    {
+        return false;
+    }
+
+    // vmacq only reads the acc vmulq left behind
+    return vreg_equal(run(0x0b),VReg{{0x7ff0,0x8000,0x7ff0,0xc010,0x0000,0x07f0,0x7ff0,0xedd0}})
+        && vreg_equal(rsp.acc_hi,VReg{{0x3fff,0xc000,0x3ffe,0xffff,0x0000,0x0000,0x0001,0xffff}})
+        && vreg_equal(rsp.acc_md,VReg{{0xffe0,0x803f,0xffe1,0x8020,0x0001,0x0fe0,0x2320,0xdbbf}});
+}
+
+bool n64_rsp_vrcp_test()
+{
+    struct Case
+    {
+        u16 in;
+        u16 out_lo;
+        u16 out_hi;
+    };
+
+    // 0 and 0x8000 are special cased, 1 and 3 read rom entries 0 (0xffff) and 256 (0x5555)
+    constexpr Case CASES[] =
+    {
+        {0x0000,0xffff,0x7fff},
+        {0x0001,0xc000,0x7fff},
+        {0x0002,0xe000,0x3fff},
+        {0x0003,0xa000,0x2aaa},
+        {0x0100,0xffc0,0x007f},
+        {0x4000,0xffff,0x0001},
+        {0xffff,0x3fff,0x8000},
+        {0xfffe,0x1fff,0xc000},
+        {0x8000,0x0000,0xffff},
+    };
+
+    for(const auto &test : CASES)
+    {
+        nintendo64::Rsp rsp;
+        rsp.vr[2].e[5] = test.in;
+
+        // vrcp vd[3] = 1 / vt[5], then vrcph vd[4] to read the high half back
+        instr_rsp_vector(rsp,rsp_vector_op(0x30,1,3,2,5));
+        instr_rsp_vector(rsp,rsp_vector_op(0x32,1,4,2,5));
+
+        if(rsp.vr[1].e[3] != test.out_lo || rsp.vr[1].e[4] != test.out_hi)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// rdram is kept word swapped, these take big endian bytes like the rdp sees them
+void n64_write_rdram(nintendo64::N64 &n64, u32 addr, u64 v, u32 size)
+{
+    for(u32 i = 0; i < size; i++)
+    {
+        n64.mem.rd_ram[(addr + i) ^ 3] = u8(v >> ((size - 1 - i) * 8));
+    }
+}
+
+u16 n64_read_rdram_u16(const nintendo64::N64 &n64, u32 addr)
+{
+    return (n64.mem.rd_ram[addr ^ 3] << 8) | n64.mem.rd_ram[(addr + 1) ^ 3];
+}
+
+constexpr u32 RDP_FB_ADDR = 0x10'0000;
+constexpr u32 RDP_TEX_ADDR = 0x20'0000;
+constexpr u32 RDP_LIST_ADDR = 0x30'0000;
+constexpr u32 RDP_FB_SIZE = 64 * 64 * 2;
+constexpr u32 RDP_FILL = 0x1234;
+
+u16 rdp_test_texel(u32 i)
+{
+    return u16((i * 0x1357) ^ 0xa5a5);
+}
+
+// fill a 64x64 16 bit framebuffer then copy a 16x16 texture into the middle of it
+// the sync full is left off so the caller can submit it separately
+std::vector<u64> rdp_test_list()
+{
+    return
+    {
+        // set color image, rgba16 64 wide
+        (u64(0x3f) << 56) | (u64(2) << 51) | (u64(64 - 1) << 32) | RDP_FB_ADDR,
+
+        // set scissor, whole image
+        (u64(0x2d) << 56) | (u64(64 << 2) << 12) | (64 << 2),
+
+        // set other modes, fill
+        (u64(0x2f) << 56) | (u64(3) << 52),
+
+        // set fill color, fill rect
+        (u64(0x37) << 56) | (RDP_FILL << 16) | RDP_FILL,
+        (u64(0x36) << 56) | (u64(63 << 2) << 44) | (u64(63 << 2) << 32),
+
+        // set texture image, rgba16 16 wide
+        (u64(0x3d) << 56) | (u64(2) << 51) | (u64(16 - 1) << 32) | RDP_TEX_ADDR,
+
+        // set tile 0, rgba16 four words a line, then load all of it
+        (u64(0x35) << 56) | (u64(2) << 51) | (u64(4) << 41),
+        (u64(0x34) << 56) | (u64(15 << 2) << 12) | (15 << 2),
+
+        // set other modes, copy
+        (u64(0x2f) << 56) | (u64(2) << 52),
+
+        // tex rect (8,8) to (23,23) from s,t 0 with copy mode's four times dsdx
+        (u64(0x24) << 56) | (u64(23 << 2) << 44) | (u64(23 << 2) << 32) | ((8 << 2) << 12) | (8 << 2),
+        (u64(4 << 10) << 16) | (1 << 10),
+    };
+}
+
+// submit words from rdram the same way a dpc end write does
+void rdp_test_submit(nintendo64::N64 &n64, const std::vector<u64> &list, u32 offset)
+{
+    auto &dp = n64.mem.dp_regs;
+
+    dp.xbus = false;
+    dp.current = RDP_LIST_ADDR + (offset * 8);
+    dp.end = RDP_LIST_ADDR + ((offset + list.size()) * 8);
+
+    for(u32 i = 0; i < list.size(); i++)
+    {
+        n64_write_rdram(n64,dp.current + (i * 8),list[i],8);
+    }
+
+    nintendo64::process_dp_commands(n64);
+}
+
+// draw the test list with this many rdp threads
+// scribble overwrites the texture after it is loaded but before the sync full
+std::vector<u8> rdp_test_draw(u32 threads, bool scribble)
+{
+    auto n64 = std::make_unique<nintendo64::N64>();
+    n64_reset_blank(*n64);
+    nintendo64::set_rdp_threads(*n64,threads);
+
+    for(u32 i = 0; i < 16 * 16; i++)
+    {
+        n64_write_rdram(*n64,RDP_TEX_ADDR + (i * 2),rdp_test_texel(i),2);
+    }
+
+    const auto list = rdp_test_list();
+    rdp_test_submit(*n64,list,0);
+
+    if(scribble)
+    {
+        for(u32 i = 0; i < 16 * 16 * 2; i++)
+        {
+            n64_write_rdram(*n64,RDP_TEX_ADDR + i,0xff,1);
+        }
+    }
+
+    // sync full
+    rdp_test_submit(*n64,{u64(0x29) << 56},list.size());
+
+    std::vector<u8> fb(RDP_FB_SIZE);
+
+    for(u32 i = 0; i < RDP_FB_SIZE; i++)
+    {
+        fb[i] = n64->mem.rd_ram[(RDP_FB_ADDR + i) ^ 3];
+    }
+
+    // sanity check the list actually drew, outside the rect and both texture corners
+    const auto pixel = [&](u32 x, u32 y)
+    {
+        return n64_read_rdram_u16(*n64,RDP_FB_ADDR + (((y * 64) + x) * 2));
+    };
+
+    if(pixel(0,0) != RDP_FILL || pixel(63,63) != RDP_FILL || pixel(8,8) != rdp_test_texel(0) || pixel(23,23) != rdp_test_texel(255))
+    {
+        return {};
+    }
+
+    return fb;
+}
+
+bool n64_rdp_threads_test()
+{
+    const auto serial = rdp_test_draw(0,false);
+
+    if(serial.empty())
+    {
+        return false;
+    }
+
+    // bands are split between workers, so any thread count must draw the same bytes
+    for(const u32 threads : {1,3})
+    {
+        if(rdp_test_draw(threads,false) != serial)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool n64_rdp_load_snapshot_test()
+{
+    const auto serial = rdp_test_draw(0,false);
+
+    // loads copy their source when pushed, so writes before the flush must not show up
+    for(const u32 threads : {0,1,3})
+    {
+        if(serial.empty() || rdp_test_draw(threads,true) != serial)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+#endif
+
+void run_regression_tests()
+{
+    const RegressionTest TESTS[] = 
+    {
+#ifdef FRONTEND_HEADLESS
+        {"headless_negative_threads",headless_negative_threads_test},
+#endif
+
+#ifdef GB_ENABLED
+        {"gb_rewind_frame_start",gb_rewind_frame_start_test},
+#endif
+
+#ifdef GBA_ENABLED
+        {"gba_dma_overlap",gba_dma_overlap_test},
+#endif
+
+#ifdef N64_ENABLED
+        {"n64_tlb_refill_vector",n64_tlb_refill_vector_test},
+        {"n64_rsp_halt_slice",n64_rsp_halt_slice_test},
+        {"n64_rsp_vector_mul",n64_rsp_vector_mul_test},
+        {"n64_rsp_vrcp",n64_rsp_vrcp_test},
+        {"n64_rdp_threads",n64_rdp_threads_test},
+        {"n64_rdp_load_snapshot",n64_rdp_load_snapshot_test},
+#endif
+        {nullptr,nullptr},
+    };
+
+    puts("regression tests:");
+
+    int fail = 0;
+    int pass = 0;
+
+    for(const auto &test : TESTS)
+    {
+        if(!test.func)
+        {
+            break;
+        }
+
+        bool passed = false;
+
+        try
+        {
+            passed = test.func();
+        }
+
+        catch(std::exception &ex)
+        {
+            std::cout << fmt::format("{}: aborted {}\n",test.name,ex.what());
+        }
+
+        std::cout << fmt::format("{}: {}\n",test.name,passed? "pass" : "fail");
+        passed? pass++ : fail++;
+    }
+
+    printf("pass: %d\n",pass);
+    printf("fail: %d\n",fail);
+}
+
 void run_tests()
 {
+    run_regression_tests();
+
+#ifndef FRONTEND_HEADLESS
 #ifdef GB_ENABLED
     gb_run_tests();    
 #endif
@@ -237,7 +849,5 @@ void run_tests()
 #ifdef N64_ENABLED 
     n64_run_tests();
 #endif
-
+#endif
 }
-
-#endif
\ No newline at end of file